@@ -0,0 +1,402 @@
+#include "booking_analytics.h"
+#include "flight_system.h"
+#include "month_partitions.h"
+#include "work_stealing_pool.h"
+#include "time_core.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+const size_t ROWS_PER_TASK = 65536;  ///< Extract rows folded by one pool task
+
+int classOfSeat(int seatNumber) {
+    if (seatNumber >= Flight::seatClassFirstSeat(2)) return 2;
+    if (seatNumber >= Flight::seatClassFirstSeat(1)) return 1;
+    return 0;
+}
+
+const char* columnText(sqlite3_stmt* stmt, int column) {
+    const unsigned char* text = sqlite3_column_text(stmt, column);
+    return text ? reinterpret_cast<const char*>(text) : "";
+}
+
+/// Runs a read-only statement, calling row(stmt) for every result
+template <typename RowFn>
+bool scan(sqlite3* db, const char* sql, RowFn row) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return false;
+    }
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        row(stmt);
+    }
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return false;
+    }
+    return true;
+}
+
+void sortByKey(vector<RollupRow>& rows) {
+    sort(rows.begin(), rows.end(), [](const RollupRow& a, const RollupRow& b) { return a.key < b.key; });
+}
+
+/// One worker's rollups, flat as [key * 3 + class]
+struct PartialRollup {
+    vector<RollupTotals> route;
+    vector<RollupTotals> day;
+    vector<RollupTotals> carrier;
+};
+
+} // namespace
+
+void RollupTotals::add(const RollupTotals& other) {
+    revenuePaise += other.revenuePaise;
+    bookings += other.bookings;
+    seatsBooked += other.seatsBooked;
+    seatsOffered += other.seatsOffered;
+}
+
+RollupTotals RollupRow::total() const {
+    RollupTotals sum;
+    for (const RollupTotals& c : byClass) {
+        sum.add(c);
+    }
+    return sum;
+}
+
+uint32_t BookingAnalytics::Dimension::intern(const string& name) {
+    auto found = ids.find(name);
+    if (found != ids.end()) return found->second;
+    uint32_t id = (uint32_t)rows.size();
+    ids.emplace(name, id);
+    rows.emplace_back();
+    rows.back().key = name;
+    return id;
+}
+
+const uint32_t BookingAnalytics::FlightColumns::NO_ROW;
+
+string_view BookingAnalytics::FlightColumns::number(uint32_t row) const {
+    uint32_t begin = row == 0 ? 0 : numberEnd[row - 1];
+    return string_view(numberText).substr(begin, numberEnd[row] - begin);
+}
+
+size_t BookingAnalytics::FlightColumns::hash(string_view number, int32_t date) {
+    return std::hash<string_view>()(number) ^ ((uint64_t)(uint32_t)date * 0x9E3779B97F4A7C15ULL);
+}
+
+uint32_t BookingAnalytics::FlightColumns::find(string_view flightNumber, int32_t date) const {
+    if (slots.empty()) return NO_ROW;
+    size_t mask = slots.size() - 1;
+    for (size_t slot = hash(flightNumber, date) & mask; ; slot = (slot + 1) & mask) {
+        uint32_t row = slots[slot];
+        if (row == NO_ROW) return NO_ROW;
+        if (dayNumber[row] == date && number(row) == flightNumber) return row;
+    }
+}
+
+void BookingAnalytics::FlightColumns::grow() {
+    // Power of two at least twice the rows, so probes stay short
+    slots.assign(max<size_t>(1024, slots.size() * 2), NO_ROW);
+    size_t mask = slots.size() - 1;
+    for (uint32_t row = 0; row < (uint32_t)size(); row++) {
+        size_t slot = hash(number(row), dayNumber[row]) & mask;
+        while (slots[slot] != NO_ROW) slot = (slot + 1) & mask;
+        slots[slot] = row;
+    }
+}
+
+uint32_t BookingAnalytics::FlightColumns::add(string_view flightNumber, int32_t date, uint32_t routeId,
+                                              uint32_t dayId, uint32_t carrierId) {
+    uint32_t existing = find(flightNumber, date);
+    if (existing != NO_ROW) return existing;
+    if ((size() + 1) * 2 > slots.size()) grow();
+
+    uint32_t row = (uint32_t)size();
+    numberText.append(flightNumber.data(), flightNumber.size());
+    numberEnd.push_back((uint32_t)numberText.size());
+    dayNumber.push_back(date);
+    route.push_back(routeId);
+    day.push_back(dayId);
+    carrier.push_back(carrierId);
+
+    size_t mask = slots.size() - 1;
+    size_t slot = hash(flightNumber, date) & mask;
+    while (slots[slot] != NO_ROW) slot = (slot + 1) & mask;
+    slots[slot] = row;
+    return row;
+}
+
+bool BookingAnalytics::load(sqlite3* db, long long generation, int threads, MonthPartitions* partitions) {
+    if (!db) return false;
+
+    Dimension newRoutes;
+    Dimension newDays;
+    Dimension newCarriers;
+    FlightColumns newFlights;
+
+    // Rows come grouped by day and route, so consecutive rows mostly repeat the last key
+    struct LastKey {
+        string text;
+        uint32_t id = UINT32_MAX;
+    };
+    auto internCached = [](Dimension& dimension, LastKey& last, const string& text) {
+        if (last.id == UINT32_MAX || last.text != text) {
+            last.text = text;
+            last.id = dimension.intern(text);
+        }
+        return last.id;
+    };
+    LastKey lastRoute;
+    LastKey lastDay;
+    LastKey lastCarrier;
+    string text;
+
+    // Live flights first: a re-imported flight overrides its archived copy
+    const char* flightSql =
+        "SELECT flight_number, date, source, destination, flight_name FROM flights "
+        "UNION ALL "
+        "SELECT flight_number, date, source, destination, flight_name FROM flights_archive;";
+    auto addFlightRow = [&](sqlite3_stmt* stmt) {
+        const char* date = columnText(stmt, 1);
+        int32_t dayNumber = parseDayNumber(date);
+        if (dayNumber == INT32_MIN) return;
+        text.assign(columnText(stmt, 2));
+        text += '|';
+        text += columnText(stmt, 3);
+        uint32_t routeId = internCached(newRoutes, lastRoute, text);
+        uint32_t dayId = internCached(newDays, lastDay, text.assign(date));
+        uint32_t carrierId = internCached(newCarriers, lastCarrier, text.assign(columnText(stmt, 4)));
+        newFlights.add(columnText(stmt, 0), dayNumber, routeId, dayId, carrierId);
+    };
+    bool ok = scan(db, flightSql, addFlightRow);
+
+    // Sealed months hold the rest of the history, one attached file at a time
+    vector<string> months = partitions ? MonthPartitions::sealedMonths(db) : vector<string>();
+    for (size_t i = 0; ok && i < months.size(); i++) {
+        string schema;
+        if (!partitions->attach(db, months[i], schema)) continue;
+        ok = scan(db, ("SELECT flight_number, date, source, destination, flight_name FROM " + schema +
+                       ".flights;").c_str(), addFlightRow);
+    }
+
+    // Bookings and seats of flights that no longer exist anywhere are left out
+    vector<uint32_t> bookingFlight;
+    vector<uint8_t> bookingClass;
+    vector<int64_t> bookingPaise;
+    ok = ok && scan(db, "SELECT flight_number, flight_date, seat_class, price FROM bookings "
+                        "UNION ALL SELECT flight_number, flight_date, seat_class, price FROM bookings_archive;",
+                    [&](sqlite3_stmt* stmt) {
+        uint32_t row = newFlights.find(columnText(stmt, 0), parseDayNumber(columnText(stmt, 1)));
+        if (row == FlightColumns::NO_ROW) return;
+        bookingFlight.push_back(row);
+        bookingClass.push_back((uint8_t)Flight::seatClassIndex(columnText(stmt, 2)));
+        bookingPaise.push_back(llround(sqlite3_column_double(stmt, 3) * 100.0));
+    });
+
+    vector<uint32_t> seatFlight;
+    vector<uint8_t> seatClass;
+    auto addSeatRow = [&](sqlite3_stmt* stmt) {
+        uint32_t row = newFlights.find(columnText(stmt, 0), parseDayNumber(columnText(stmt, 1)));
+        if (row == FlightColumns::NO_ROW) return;
+        seatFlight.push_back(row);
+        seatClass.push_back((uint8_t)classOfSeat(sqlite3_column_int(stmt, 2)));
+    };
+    ok = ok && scan(db, "SELECT flight_number, flight_date, seat_number FROM booked_seats;", addSeatRow);
+    for (size_t i = 0; ok && i < months.size(); i++) {
+        string schema;
+        if (!partitions->attach(db, months[i], schema)) continue;
+        ok = scan(db, ("SELECT flight_number, flight_date, seat_number FROM " + schema + ".booked_seats;").c_str(),
+                  addSeatRow);
+    }
+    if (!ok) return false;
+
+    // One task per slice of each extract: flights add capacity, bookings revenue, seats occupancy
+    size_t flightCount = newFlights.size();
+    size_t flightTasks = (flightCount + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    size_t bookingTasks = (bookingFlight.size() + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    size_t seatTasks = (seatFlight.size() + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+
+    WorkStealingPool pool(threads);
+    vector<PartialRollup> partial(pool.size());
+    pool.run(flightTasks + bookingTasks + seatTasks, [&](size_t task, int worker) {
+        PartialRollup& p = partial[worker];
+        if (p.route.empty()) {
+            p.route.resize(newRoutes.rows.size() * 3);
+            p.day.resize(newDays.rows.size() * 3);
+            p.carrier.resize(newCarriers.rows.size() * 3);
+        }
+        auto fold = [&](uint32_t flight, int c, const RollupTotals& delta) {
+            p.route[newFlights.route[flight] * 3 + c].add(delta);
+            p.day[newFlights.day[flight] * 3 + c].add(delta);
+            p.carrier[newFlights.carrier[flight] * 3 + c].add(delta);
+        };
+
+        if (task < flightTasks) {
+            size_t end = min(flightCount, (task + 1) * ROWS_PER_TASK);
+            for (size_t flight = task * ROWS_PER_TASK; flight < end; flight++) {
+                for (int c = 0; c < 3; c++) {
+                    RollupTotals delta;
+                    delta.seatsOffered = Flight::seatClassCapacity(c);
+                    fold((uint32_t)flight, c, delta);
+                }
+            }
+        } else if (task < flightTasks + bookingTasks) {
+            size_t begin = (task - flightTasks) * ROWS_PER_TASK;
+            size_t end = min(bookingFlight.size(), begin + ROWS_PER_TASK);
+            for (size_t i = begin; i < end; i++) {
+                RollupTotals delta;
+                delta.revenuePaise = bookingPaise[i];
+                delta.bookings = 1;
+                fold(bookingFlight[i], bookingClass[i], delta);
+            }
+        } else {
+            size_t begin = (task - flightTasks - bookingTasks) * ROWS_PER_TASK;
+            size_t end = min(seatFlight.size(), begin + ROWS_PER_TASK);
+            for (size_t i = begin; i < end; i++) {
+                RollupTotals delta;
+                delta.seatsBooked = 1;
+                fold(seatFlight[i], seatClass[i], delta);
+            }
+        }
+    });
+
+    RollupRow newClasses;
+    newClasses.key = "All";
+    auto merge = [&newClasses](Dimension& dimension, const vector<RollupTotals>& cells, bool countClasses) {
+        for (size_t cell = 0; cell < cells.size(); cell++) {
+            dimension.rows[cell / 3].byClass[cell % 3].add(cells[cell]);
+            if (countClasses) newClasses.byClass[cell % 3].add(cells[cell]);
+        }
+    };
+    for (const PartialRollup& p : partial) {
+        merge(newRoutes, p.route, true);
+        merge(newDays, p.day, false);
+        merge(newCarriers, p.carrier, false);
+    }
+
+    lock_guard<mutex> guard(lock);
+    routes = move(newRoutes);
+    days = move(newDays);
+    carriers = move(newCarriers);
+    classes = newClasses;
+    flights = move(newFlights);
+    loaded = true;
+    scheduleGeneration = generation;
+    cout << "Booking analytics loaded " << flights.size() << " flights, " << bookingFlight.size()
+         << " bookings and " << seatFlight.size() << " booked seats on " << pool.size() << " threads" << endl;
+    return true;
+}
+
+bool BookingAnalytics::addFlight(sqlite3* db, const string& flightNumber, const string& date, uint32_t& row) {
+    int32_t dayNumber = parseDayNumber(date);
+    if (!db || dayNumber == INT32_MIN) return false;
+    const char* sql =
+        "SELECT source, destination, flight_name FROM flights WHERE flight_number = ?1 AND date = ?2 "
+        "UNION ALL "
+        "SELECT source, destination, flight_name FROM flights_archive WHERE flight_number = ?1 AND date = ?2 "
+        "LIMIT 1;";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, flightNumber.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, date.c_str(), -1, SQLITE_STATIC);
+    bool found = sqlite3_step(stmt) == SQLITE_ROW;
+    if (found) {
+        string route = string(columnText(stmt, 0)) + "|" + columnText(stmt, 1);
+        row = flights.add(flightNumber, dayNumber, routes.intern(route), days.intern(date),
+                          carriers.intern(columnText(stmt, 2)));
+        // Added since the last load, so its capacity is not counted yet
+        for (int c = 0; c < 3; c++) {
+            RollupTotals capacity;
+            capacity.seatsOffered = Flight::seatClassCapacity(c);
+            apply(row, c, capacity);
+        }
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+void BookingAnalytics::apply(uint32_t row, int seatClass, const RollupTotals& delta) {
+    routes.rows[flights.route[row]].byClass[seatClass].add(delta);
+    days.rows[flights.day[row]].byClass[seatClass].add(delta);
+    carriers.rows[flights.carrier[row]].byClass[seatClass].add(delta);
+    classes.byClass[seatClass].add(delta);
+}
+
+void BookingAnalytics::recordBooking(sqlite3* db, const string& flightNumber, const string& date,
+                                     const string& seatClass, int seats, double revenue) {
+    RollupTotals delta;
+    delta.revenuePaise = llround(revenue * 100.0);
+    delta.bookings = seats;
+    delta.seatsBooked = seats;
+
+    lock_guard<mutex> guard(lock);
+    if (!loaded) return;
+    uint32_t row = flights.find(flightNumber, parseDayNumber(date));
+    if (row == FlightColumns::NO_ROW && !addFlight(db, flightNumber, date, row)) {
+        return;
+    }
+    apply(row, Flight::seatClassIndex(seatClass), delta);
+}
+
+vector<RollupRow> BookingAnalytics::byRoute() const {
+    vector<RollupRow> rows;
+    {
+        lock_guard<mutex> guard(lock);
+        rows = routes.rows;
+    }
+    sortByKey(rows);
+    return rows;
+}
+
+vector<RollupRow> BookingAnalytics::byDay(const string& from, const string& to) const {
+    vector<RollupRow> rows;
+    {
+        lock_guard<mutex> guard(lock);
+        for (const RollupRow& row : days.rows) {
+            // ISO dates order as text
+            if ((from.empty() || row.key >= from) && (to.empty() || row.key <= to)) {
+                rows.push_back(row);
+            }
+        }
+    }
+    sortByKey(rows);
+    return rows;
+}
+
+vector<RollupRow> BookingAnalytics::byCarrier() const {
+    vector<RollupRow> rows;
+    {
+        lock_guard<mutex> guard(lock);
+        rows = carriers.rows;
+    }
+    sortByKey(rows);
+    return rows;
+}
+
+vector<RollupRow> BookingAnalytics::byClass() const {
+    lock_guard<mutex> guard(lock);
+    vector<RollupRow> rows(3);
+    for (int c = 0; c < 3; c++) {
+        rows[c].key = Flight::seatClassName(c);
+        rows[c].byClass[c] = classes.byClass[c];
+    }
+    return rows;
+}
+
+RollupRow BookingAnalytics::overall() const {
+    lock_guard<mutex> guard(lock);
+    return classes;
+}
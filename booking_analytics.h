@@ -0,0 +1,195 @@
+/**
+ * @file booking_analytics.h
+ * @brief Revenue and load-factor rollups per route, day, carrier and seat class
+ *
+ * load() extracts flights and bookings (live and archived) and booked_seats
+ * into columns with three plain table scans, then sums them in parallel on
+ * a WorkStealingPool: each worker folds a slice of rows into its own
+ * partial rollups, which are merged at the end. Revenue is summed in paise,
+ * so totals do not depend on the thread count or merge order.
+ *
+ * Afterwards the rollups are kept current by recordBooking(), called on
+ * every booking and cancellation of the owning ReservationSystem. Queries
+ * read only the in-memory rollups under a short internal lock, so
+ * dashboards never run SQL against the live tables and may query from any
+ * thread while bookings continue.
+ *
+ * Sealed month partitions (month_partitions.h) are scanned along with the
+ * main tables when load() is given the connection's MonthPartitions.
+ *
+ * Seats sold (load factor) come from booked_seats, revenue and booking
+ * counts from bookings; load-test occupancy has seats without bookings.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef BOOKING_ANALYTICS_H
+#define BOOKING_ANALYTICS_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+struct sqlite3;  // Forward declaration for SQLite database handle
+class MonthPartitions;
+
+using namespace std;
+
+/**
+ * @struct RollupTotals
+ * @brief Sums for one cell of a rollup
+ */
+struct RollupTotals {
+    int64_t revenuePaise = 0;  ///< Booked fares in paise
+    int64_t bookings = 0;      ///< Bookings (passengers)
+    int64_t seatsBooked = 0;   ///< Occupied seats, including those without a booking record
+    int64_t seatsOffered = 0;  ///< Seat capacity of the flights
+
+    double revenue() const { return revenuePaise / 100.0; }
+    double loadFactor() const { return seatsOffered > 0 ? (double)seatsBooked / seatsOffered : 0.0; }
+    double averageFare() const { return bookings > 0 ? revenuePaise / 100.0 / bookings : 0.0; }
+
+    void add(const RollupTotals& other);
+};
+
+/**
+ * @struct RollupRow
+ * @brief One route, day, carrier or class with its totals per seat class
+ */
+struct RollupRow {
+    string key;                ///< "Source|Destination", "YYYY-MM-DD", carrier name or class name
+    RollupTotals byClass[3];   ///< First (0), Business (1), Economy (2)
+
+    RollupTotals total() const;
+};
+
+/**
+ * @class BookingAnalytics
+ * @brief In-memory rollups built in parallel and maintained on each booking
+ */
+class BookingAnalytics {
+public:
+    BookingAnalytics() : loaded(false), scheduleGeneration(-1) {}
+    BookingAnalytics(const BookingAnalytics&) = delete;
+    BookingAnalytics& operator=(const BookingAnalytics&) = delete;
+
+    /**
+     * @brief Rebuilds every rollup from the database
+     * @param db Open database connection; only read
+     * @param generation Schedule generation the rollups reflect, see getScheduleGeneration()
+     * @param threads Aggregation threads; 0 uses every hardware thread
+     * @param partitions Attaches sealed months of db so their history is included; nullptr reads only db
+     * @return false if the tables cannot be read; the previous rollups are kept
+     *
+     * Queries keep answering from the previous rollups until the new ones
+     * are swapped in. Must not run concurrently with recordBooking().
+     */
+    bool load(sqlite3* db, long long generation, int threads = 0, MonthPartitions* partitions = nullptr);
+
+    bool isLoaded() const { return loaded; }
+
+    /**
+     * @brief Schedule generation passed to the last load()
+     *
+     * Flights added or removed since then are missing from seatsOffered
+     * until the next load.
+     */
+    long long getScheduleGeneration() const { return scheduleGeneration; }
+
+    /**
+     * @brief Applies bookings (seats > 0) or cancellations (seats < 0) of one flight and class
+     * @param db Used to look up a flight that was not in the last load
+     * @param flightNumber Flight number
+     * @param date Flight date (YYYY-MM-DD)
+     * @param seatClass "Economy", "Business", or "First"
+     * @param seats Passengers booked (+) or cancelled (-); each holds one seat
+     * @param revenue Sum of their fares, negative for cancellations
+     */
+    void recordBooking(sqlite3* db, const string& flightNumber, const string& date, const string& seatClass,
+                       int seats, double revenue);
+
+    /// Routes, keyed "Source|Destination", in key order
+    vector<RollupRow> byRoute() const;
+
+    /**
+     * @brief Flight days in date order, optionally limited to [from, to]
+     * @param from First date (YYYY-MM-DD), or empty for no lower bound
+     * @param to Last date (YYYY-MM-DD), or empty for no upper bound
+     */
+    vector<RollupRow> byDay(const string& from = "", const string& to = "") const;
+
+    /// Carriers (flight names) in key order
+    vector<RollupRow> byCarrier() const;
+
+    /// The three seat classes, First to Economy; only byClass[i] of row i is set
+    vector<RollupRow> byClass() const;
+
+    /// Totals over every flight
+    RollupRow overall() const;
+
+private:
+    /// Distinct values of one rollup key and their totals
+    struct Dimension {
+        unordered_map<string, uint32_t> ids;  ///< Key -> index into rows
+        vector<RollupRow> rows;
+
+        uint32_t intern(const string& name);
+    };
+
+    /**
+     * @brief Flight keys and rollup ids, by flight row, with an open-addressing index on (number, date)
+     *
+     * Schedules give every flight its own number, so a node-based map would
+     * allocate per flight; numbers are packed into one buffer instead and
+     * the index is a flat array of rows.
+     */
+    struct FlightColumns {
+        static const uint32_t NO_ROW = UINT32_MAX;
+
+        string numberText;          ///< Flight numbers back to back
+        vector<uint32_t> numberEnd; ///< End of each row's number in numberText
+        vector<int32_t> dayNumber;  ///< Flight date as parseDayNumber()
+        vector<uint32_t> route;
+        vector<uint32_t> day;
+        vector<uint32_t> carrier;
+        vector<uint32_t> slots;     ///< Rows by hash, linear probing; NO_ROW when free
+
+        size_t size() const { return route.size(); }
+
+        /// Row of a flight, or NO_ROW
+        uint32_t find(string_view number, int32_t date) const;
+
+        /// Adds a flight unless it is already present; returns its row
+        uint32_t add(string_view number, int32_t date, uint32_t routeId, uint32_t dayId, uint32_t carrierId);
+
+    private:
+        string_view number(uint32_t row) const;
+        static size_t hash(string_view number, int32_t date);
+        void grow();
+    };
+
+    mutable mutex lock;  ///< Guards everything below against concurrent queries
+    Dimension routes;
+    Dimension days;
+    Dimension carriers;
+    RollupRow classes;   ///< Totals per class over all flights
+    FlightColumns flights;
+    bool loaded;
+    long long scheduleGeneration;
+
+    /**
+     * @brief Adds a flight missing from the last load by reading it from db; returns false if unknown
+     */
+    bool addFlight(sqlite3* db, const string& flightNumber, const string& date, uint32_t& row);
+
+    /**
+     * @brief Adds one delta to the route, day, carrier and class totals of a flight row
+     */
+    void apply(uint32_t row, int seatClass, const RollupTotals& delta);
+};
+
+#endif // BOOKING_ANALYTICS_H
@@ -0,0 +1,806 @@
+#include "booking_log.h"
+#include "time_core.h"
+#include "work_stealing_pool.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+const char LOG_MAGIC[8] = {'S', 'P', 'Z', 'E', 'V', 'L', 'O', 'G'};
+const uint32_t LOG_VERSION = 1;
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+const uint32_t RECORD_MAGIC = 0x56455053;      ///< "SPEV" in a little-endian file
+const uint32_t MAX_RECORD_SIZE = 4096;
+const size_t MAX_NAME_LENGTH = 1024;           ///< Longer passenger names are cut in the log
+const size_t READ_CHUNK = 1 << 20;
+const size_t RECORDS_PER_TASK = 4096;          ///< Replay verification slice
+const size_t BASELINE_WRITE_CHUNK = 1 << 20;   ///< Baseline bytes per write()
+
+struct FileHeader {
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t byteOrderMark;
+};
+
+/**
+ * Fixed part of every record, followed by flight number, date and
+ * passenger name and zero padding to a multiple of 8 bytes. Records start
+ * 8-byte aligned; integers are in host byte order (checked by the BOM).
+ */
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t length;     ///< Whole record in bytes
+    uint64_t checksum;   ///< Hash of every byte after this field
+    int64_t sequence;
+    int64_t time;
+    int64_t id;
+    double price;
+    uint8_t type;
+    uint8_t seatNumber;
+    uint8_t numberLength;
+    uint8_t dateLength;
+    uint16_t nameLength;
+    uint16_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 16 && sizeof(RecordHeader) == 56, "log layout must not depend on padding");
+
+const size_t CHECKSUM_START = offsetof(RecordHeader, sequence);
+
+/// FNV-1a style hash mixed 8 bytes at a time, as for the schedule snapshot
+uint64_t recordChecksum(const unsigned char* data, size_t length) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        hash ^= word;
+        hash *= 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+size_t alignUp(size_t value) {
+    return (value + 7) & ~(size_t)7;
+}
+
+void appendRecord(string& out, const BookingEvent& event) {
+    RecordHeader header;
+    memset(&header, 0, sizeof(header));
+    size_t numberLength = min<size_t>(event.flightNumber.size(), 255);
+    size_t dateLength = min<size_t>(event.date.size(), 255);
+    size_t nameLength = min(event.passengerName.size(), MAX_NAME_LENGTH);
+    size_t length = alignUp(sizeof(header) + numberLength + dateLength + nameLength);
+
+    header.magic = RECORD_MAGIC;
+    header.length = (uint32_t)length;
+    header.sequence = event.sequence;
+    header.time = event.time;
+    header.id = event.id;
+    header.price = event.price;
+    header.type = event.type;
+    header.seatNumber = (uint8_t)max(0, min(event.seatNumber, 255));
+    header.numberLength = (uint8_t)numberLength;
+    header.dateLength = (uint8_t)dateLength;
+    header.nameLength = (uint16_t)nameLength;
+
+    size_t start = out.size();
+    out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.append(event.flightNumber, 0, numberLength);
+    out.append(event.date, 0, dateLength);
+    out.append(event.passengerName, 0, nameLength);
+    out.resize(start + length, '\0');
+
+    unsigned char* record = reinterpret_cast<unsigned char*>(&out[start]);
+    uint64_t checksum = recordChecksum(record + CHECKSUM_START, length - CHECKSUM_START);
+    memcpy(record + offsetof(RecordHeader, checksum), &checksum, sizeof(checksum));
+}
+
+/**
+ * @brief Checks the fixed part of a record
+ * @return 1 if a whole record of plausible length is there, 0 if its end is
+ *         not written yet, -1 if these bytes are no record start
+ */
+int checkHeader(const unsigned char* data, size_t available, uint32_t& length) {
+    if (available < sizeof(RecordHeader)) return 0;
+    RecordHeader header;
+    memcpy(&header, data, sizeof(header));
+    size_t strings = (size_t)header.numberLength + header.dateLength + header.nameLength;
+    if (header.magic != RECORD_MAGIC || header.length % 8 != 0 || header.length > MAX_RECORD_SIZE ||
+        header.length != alignUp(sizeof(header) + strings)) {
+        return -1;
+    }
+    length = header.length;
+    return available < length ? 0 : 1;
+}
+
+bool verifyRecord(const unsigned char* data, uint32_t length) {
+    uint64_t checksum;
+    memcpy(&checksum, data + offsetof(RecordHeader, checksum), sizeof(checksum));
+    return checksum == recordChecksum(data + CHECKSUM_START, length - CHECKSUM_START);
+}
+
+void decodeRecord(const unsigned char* data, uint64_t offset, BookingEvent& event) {
+    RecordHeader header;
+    memcpy(&header, data, sizeof(header));
+    const char* text = reinterpret_cast<const char*>(data + sizeof(header));
+    event.offset = offset;
+    event.type = header.type;
+    event.sequence = header.sequence;
+    event.time = (time_t)header.time;
+    event.id = header.id;
+    event.price = header.price;
+    event.seatNumber = header.seatNumber;
+    event.flightNumber.assign(text, header.numberLength);
+    event.date.assign(text + header.numberLength, header.dateLength);
+    event.passengerName.assign(text + header.numberLength + header.dateLength, header.nameLength);
+}
+
+/**
+ * @brief First aligned position at or after from where a whole, intact record starts
+ * @return size if there is none
+ */
+size_t findRecord(const unsigned char* data, size_t size, size_t from) {
+    for (size_t pos = alignUp(from); pos + sizeof(RecordHeader) <= size; pos += 8) {
+        uint32_t length;
+        if (checkHeader(data + pos, size - pos, length) == 1 && verifyRecord(data + pos, length)) {
+            return pos;
+        }
+    }
+    return size;
+}
+
+/// booking_log_state.sequence, or -1
+int64_t currentSequence(sqlite3* db) {
+    sqlite3_stmt* stmt = nullptr;
+    int64_t sequence = -1;
+    if (sqlite3_prepare_v2(db, "SELECT sequence FROM booking_log_state WHERE id = 1;", -1, &stmt, nullptr) ==
+            SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        sequence = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return sequence;
+}
+
+} // namespace
+
+const char* BookingEvent::typeName(uint8_t type) {
+    switch (type) {
+        case BOOKED: return "booked";
+        case CANCELLED: return "cancelled";
+        case HELD: return "held";
+        case RELEASED: return "released";
+        case BASELINE_BEGIN: return "baseline-begin";
+        case BASELINE_SEAT: return "baseline-seat";
+        case BASELINE_END: return "baseline-end";
+        default: return "unknown";
+    }
+}
+
+BookingLog::BookingLog()
+    : fd(-1), stagingActive(false), appliedThrough(0), tailOffset(0), uncovered(false), gapAfter(0),
+      baselineRefusedAt(0), dirty(false), stopping(false) {}
+
+BookingLog::~BookingLog() {
+    close();
+}
+
+bool BookingLog::open(const char* logPath) {
+    close();
+#ifndef _WIN32
+    int file = ::open(logPath, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (file < 0) {
+        cerr << "Cannot open booking log " << logPath << endl;
+        return false;
+    }
+    struct stat info;
+    bool ok = fstat(file, &info) == 0;
+    FileHeader header;
+    if (ok && info.st_size < (off_t)sizeof(header)) {
+        // New (or torn while being created): start over with a header
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, LOG_MAGIC, sizeof(header.magic));
+        header.formatVersion = LOG_VERSION;
+        header.byteOrderMark = BYTE_ORDER_MARK;
+        ok = ftruncate(file, 0) == 0 && ::write(file, &header, sizeof(header)) == (ssize_t)sizeof(header);
+    } else if (ok) {
+        ok = pread(file, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+             memcmp(header.magic, LOG_MAGIC, sizeof(header.magic)) == 0 && header.formatVersion == LOG_VERSION &&
+             header.byteOrderMark == BYTE_ORDER_MARK;
+    }
+    if (!ok) {
+        cerr << "Booking log " << logPath << " is unusable; events are not logged" << endl;
+        ::close(file);
+        return false;
+    }
+
+    fd = file;
+    path = logPath;
+    tailOffset = sizeof(FileHeader);
+    stopping = false;
+    dirty = false;
+    flusher = thread(&BookingLog::flushLoop, this);
+    return true;
+#else
+    (void)logPath;
+    return false;
+#endif
+}
+
+void BookingLog::close() {
+    if (fd < 0) return;
+    {
+        lock_guard<mutex> guard(flushLock);
+        stopping = true;
+    }
+    flushWake.notify_all();
+    if (flusher.joinable()) flusher.join();
+#ifndef _WIN32
+    ::close(fd);
+#endif
+    fd = -1;
+}
+
+void BookingLog::flushLoop() {
+#ifndef _WIN32
+    unique_lock<mutex> guard(flushLock);
+    while (true) {
+        flushWake.wait(guard, [this] { return dirty || stopping; });
+        if (!dirty) break;
+        // Let records of concurrent bookings gather so one sync covers them all
+        flushWake.wait_for(guard, chrono::milliseconds(SYNC_INTERVAL_MS), [this] { return stopping; });
+        dirty = false;
+        guard.unlock();
+        fsync(fd);
+        guard.lock();
+    }
+#endif
+}
+
+bool BookingLog::appendBytes(const string& bytes) {
+#ifndef _WIN32
+    // One write() per call: O_APPEND keeps it whole against other processes' appends
+    size_t done = 0;
+    while (done < bytes.size()) {
+        ssize_t written = ::write(fd, bytes.data() + done, bytes.size() - done);
+        if (written <= 0) {
+            cerr << "Booking log write failed" << endl;
+            return false;
+        }
+        done += (size_t)written;
+    }
+    {
+        lock_guard<mutex> guard(flushLock);
+        dirty = true;
+    }
+    flushWake.notify_one();
+    return true;
+#else
+    (void)bytes;
+    return false;
+#endif
+}
+
+void BookingLog::record(const BookingEvent& event) {
+    if (fd < 0) return;
+    string bytes;
+    appendRecord(bytes, event);
+    appendBytes(bytes);
+    // Reading it back later applies it a second time, which changes nothing
+    apply(event);
+}
+
+uint64_t BookingLog::size() const {
+#ifndef _WIN32
+    struct stat info;
+    if (fd >= 0 && fstat(fd, &info) == 0) return (uint64_t)info.st_size;
+#endif
+    return 0;
+}
+
+uint64_t BookingLog::read(uint64_t from, size_t maxEvents, vector<BookingEvent>& events) const {
+#ifndef _WIN32
+    if (fd < 0) return from;
+    uint64_t end = size();
+    uint64_t pos = alignUp(max<uint64_t>(from, sizeof(FileHeader)));
+    vector<unsigned char> buffer;
+    size_t found = 0;
+    while (found < maxEvents && pos + sizeof(RecordHeader) <= end) {
+        size_t want = (size_t)min<uint64_t>(end - pos, READ_CHUNK);
+        buffer.resize(want);
+        ssize_t got = pread(fd, buffer.data(), want, (off_t)pos);
+        if (got <= 0) break;
+        size_t available = (size_t)got;
+        bool atEnd = pos + available >= end;
+
+        size_t used = 0;
+        bool stalled = false;
+        while (found < maxEvents) {
+            uint32_t length = 0;
+            int check = checkHeader(buffer.data() + used, available - used, length);
+            if (check == 1 && verifyRecord(buffer.data() + used, length)) {
+                events.emplace_back();
+                decodeRecord(buffer.data() + used, pos + used, events.back());
+                found++;
+                used += length;
+                continue;
+            }
+            if (check == 0 && !atEnd && used > 0) break;  // Continues in the next chunk
+            // Torn or corrupt: step to the next intact record. Nothing intact after it at the
+            // end of the file may be a record still being written; wait for it.
+            size_t next = findRecord(buffer.data(), available, used + 8);
+            if (next < available) {
+                used = next;
+            } else if (atEnd) {
+                stalled = true;
+                break;
+            } else {
+                used = max(used + 8, (available - MAX_RECORD_SIZE) & ~(size_t)7);
+                break;
+            }
+        }
+        pos += used;
+        if (stalled || used == 0) break;
+    }
+    return pos;
+#else
+    (void)maxEvents;
+    (void)events;
+    return from;
+#endif
+}
+
+size_t BookingLog::shardCount() {
+    return 64;
+}
+
+string BookingLog::flightKey(string_view flightNumber, string_view date) {
+    string key;
+    key.reserve(flightNumber.size() + 1 + date.size());
+    key.append(flightNumber);
+    key += '|';
+    key.append(date);
+    return key;
+}
+
+size_t BookingLog::shardOf(string_view flightNumber, string_view date, size_t shards) {
+    // FNV-1a over "number|date"
+    uint64_t h = 1469598103934665603ULL;
+    auto mix = [&h](string_view text) {
+        for (unsigned char c : text) {
+            h ^= c;
+            h *= 1099511628211ULL;
+        }
+    };
+    mix(flightNumber);
+    mix("|");
+    mix(date);
+    return (size_t)(h % shards);
+}
+
+bool BookingLog::applyTo(SeatState& target, const BookingEvent& event) {
+    bool baselineSeat = event.type == BookingEvent::BASELINE_SEAT;
+    if (!baselineSeat && event.type != BookingEvent::BOOKED && event.type != BookingEvent::CANCELLED) return false;
+    // The baseline already holds every change up to its own number
+    if (!baselineSeat && event.sequence <= target.baselineSequence) return false;
+
+    string key = flightKey(event.flightNumber, event.date);
+    LoggedFlight& flight = target.shards[shardOf(event.flightNumber, event.date, target.shards.size())][key];
+    auto seat = find_if(flight.seats.begin(), flight.seats.end(),
+                        [&event](const LoggedSeat& s) { return s.seatNumber == event.seatNumber; });
+    if (seat == flight.seats.end()) {
+        flight.seats.push_back(LoggedSeat{event.seatNumber, false, -1, string()});
+        seat = flight.seats.end() - 1;
+    }
+    // Processes append in their own order; the later change wins however its record is placed
+    if (seat->sequence >= event.sequence) return true;
+    seat->sequence = event.sequence;
+    seat->booked = event.type != BookingEvent::CANCELLED;
+    if (seat->booked) {
+        seat->passengerName = event.passengerName;
+    } else {
+        seat->passengerName.clear();
+    }
+    return true;
+}
+
+void BookingLog::markApplied(int64_t sequence) {
+    if (sequence > appliedThrough + 1) {
+        appliedAhead.insert(sequence);
+        return;
+    }
+    appliedThrough = max(appliedThrough, sequence);
+    while (!appliedAhead.empty() && *appliedAhead.begin() <= appliedThrough + 1) {
+        appliedThrough = max(appliedThrough, *appliedAhead.begin());
+        appliedAhead.erase(appliedAhead.begin());
+    }
+}
+
+void BookingLog::apply(const BookingEvent& event) {
+    switch (event.type) {
+        case BookingEvent::BASELINE_BEGIN:
+            staging = SeatState();
+            staging.shards.resize(shardCount());
+            staging.baselineSequence = event.sequence;
+            staging.firstDay = parseDayNumber(event.date);
+            staging.expectedSeats = event.id;
+            stagingActive = staging.firstDay != INT32_MIN;
+            return;
+        case BookingEvent::BASELINE_SEAT:
+            if (stagingActive && event.sequence == staging.baselineSequence) {
+                applyTo(staging, event);
+                staging.seenSeats++;
+            }
+            return;
+        case BookingEvent::BASELINE_END:
+            if (stagingActive && event.sequence == staging.baselineSequence &&
+                staging.seenSeats == staging.expectedSeats) {
+                // Changes past the baseline follow it in the log: its writer held the write lock meanwhile
+                state = move(staging);
+                appliedThrough = state.baselineSequence;
+                appliedAhead.swap(state.appliedPastBaseline);
+                state.appliedPastBaseline.clear();
+                markApplied(appliedThrough);
+            }
+            staging = SeatState();
+            stagingActive = false;
+            return;
+        case BookingEvent::BOOKED:
+        case BookingEvent::CANCELLED:
+            if (stagingActive && applyTo(staging, event)) {
+                staging.appliedPastBaseline.insert(event.sequence);
+            }
+            if (state.baselineSequence >= 0 && applyTo(state, event)) {
+                markApplied(event.sequence);
+            }
+            return;
+        default:
+            return;
+    }
+}
+
+void BookingLog::replay(int threads) {
+#ifndef _WIN32
+    if (fd < 0) return;
+    auto started = chrono::steady_clock::now();
+    uint64_t end = size();
+    if (end <= sizeof(FileHeader)) return;
+    void* mapping = mmap(nullptr, (size_t)end, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        cerr << "Cannot map booking log for replay" << endl;
+        return;
+    }
+    const unsigned char* data = static_cast<const unsigned char*>(mapping);
+    madvise(mapping, (size_t)end, MADV_SEQUENTIAL);
+
+    // Pass 1, sequential: hop from header to header. Only lengths are trusted here;
+    // a bad header is stepped over to the next intact record.
+    vector<uint64_t> offsets;
+    vector<uint8_t> types;
+    uint64_t pos = sizeof(FileHeader);
+    while (pos + sizeof(RecordHeader) <= end) {
+        uint32_t length = 0;
+        int check = checkHeader(data + pos, (size_t)(end - pos), length);
+        if (check == 1) {
+            offsets.push_back(pos);
+            types.push_back(data[pos + offsetof(RecordHeader, type)]);
+            pos += length;
+            continue;
+        }
+        uint64_t next = findRecord(data, (size_t)end, (size_t)pos + 8);
+        if (next >= end) break;  // A torn tail, or a record still being written: catchUp() retries it
+        stats.skippedBytes += next - pos;
+        pos = next;
+    }
+    tailOffset = pos;
+
+    // The last baseline with an end; everything before it is history
+    size_t first = offsets.size();
+    bool endSeen = false;
+    for (size_t i = offsets.size(); i-- > 0;) {
+        if (types[i] == BookingEvent::BASELINE_END) endSeen = true;
+        if (types[i] == BookingEvent::BASELINE_BEGIN && endSeen) {
+            first = i;
+            break;
+        }
+    }
+    if (first == offsets.size()) {
+        munmap(mapping, (size_t)end);
+        cout << "Booking log has no baseline; one is written from the database" << endl;
+        return;
+    }
+
+    // Pass 2, parallel: verify checksums and assign records to flight shards
+    size_t count = offsets.size() - first;
+    size_t shards = shardCount();
+    const uint16_t INVALID = UINT16_MAX;
+    vector<uint16_t> shardOfRecord(count, INVALID);
+    WorkStealingPool pool(threads);
+    pool.run((count + RECORDS_PER_TASK - 1) / RECORDS_PER_TASK, [&](size_t task, int) {
+        size_t last = min(count, (task + 1) * RECORDS_PER_TASK);
+        for (size_t i = task * RECORDS_PER_TASK; i < last; i++) {
+            const unsigned char* record = data + offsets[first + i];
+            uint32_t length;
+            memcpy(&length, record + offsetof(RecordHeader, length), sizeof(length));
+            if (!verifyRecord(record, length)) continue;
+            uint8_t type = types[first + i];
+            if (type != BookingEvent::BOOKED && type != BookingEvent::CANCELLED &&
+                type != BookingEvent::BASELINE_SEAT) {
+                shardOfRecord[i] = (uint16_t)shards;  // Intact, but no seat change
+                continue;
+            }
+            RecordHeader header;
+            memcpy(&header, record, sizeof(header));
+            const char* text = reinterpret_cast<const char*>(record + sizeof(header));
+            shardOfRecord[i] = (uint16_t)shardOf(string_view(text, header.numberLength),
+                                                 string_view(text + header.numberLength, header.dateLength), shards);
+        }
+    });
+
+    // The baseline must be whole to be trusted
+    BookingEvent begin;
+    const unsigned char* beginRecord = data + offsets[first];
+    bool baselineOk = shardOfRecord[0] != INVALID;
+    if (baselineOk) {
+        decodeRecord(beginRecord, offsets[first], begin);
+        baselineOk = parseDayNumber(begin.date) != INT32_MIN;
+    }
+    int64_t baselineSeats = 0;
+    vector<int64_t> sequences;
+    vector<vector<uint32_t>> perShard(shards);
+    for (size_t i = 1; baselineOk && i < count; i++) {
+        uint8_t type = types[first + i];
+        if (shardOfRecord[i] == INVALID) {
+            uint32_t length;
+            memcpy(&length, data + offsets[first + i] + offsetof(RecordHeader, length), sizeof(length));
+            stats.skippedBytes += length;
+            continue;
+        }
+        if (shardOfRecord[i] == shards) continue;
+        int64_t sequence;
+        memcpy(&sequence, data + offsets[first + i] + offsetof(RecordHeader, sequence), sizeof(sequence));
+        if (type == BookingEvent::BASELINE_SEAT) {
+            if (sequence != begin.sequence) continue;  // Seat of an unfinished later baseline
+            baselineSeats++;
+        } else if (sequence > begin.sequence) {
+            sequences.push_back(sequence);
+        }
+        perShard[shardOfRecord[i]].push_back((uint32_t)i);
+    }
+    if (!baselineOk || baselineSeats != begin.id) {
+        munmap(mapping, (size_t)end);
+        cerr << "Booking log baseline is damaged; a new one is written from the database" << endl;
+        return;
+    }
+
+    // Pass 3, parallel: each shard applies its flights' records in log order
+    state = SeatState();
+    state.shards.resize(shards);
+    state.baselineSequence = begin.sequence;
+    state.firstDay = parseDayNumber(begin.date);
+    state.expectedSeats = begin.id;
+    state.seenSeats = baselineSeats;
+    pool.run(shards, [&](size_t shard, int) {
+        BookingEvent event;
+        for (uint32_t i : perShard[shard]) {
+            decodeRecord(data + offsets[first + i], offsets[first + i], event);
+            if (event.type == BookingEvent::BASELINE_SEAT && event.sequence != state.baselineSequence) continue;
+            applyTo(state, event);
+        }
+    });
+
+    appliedThrough = state.baselineSequence;
+    appliedAhead.clear();
+    sort(sequences.begin(), sequences.end());
+    for (int64_t sequence : sequences) {
+        markApplied(sequence);
+    }
+
+    // A baseline begun after this one but not finished is picked up by catchUp()
+    for (size_t i = count; i-- > 1;) {
+        if (types[first + i] == BookingEvent::BASELINE_END) break;
+        if (types[first + i] == BookingEvent::BASELINE_BEGIN) {
+            tailOffset = offsets[first + i];
+            break;
+        }
+    }
+    munmap(mapping, (size_t)end);
+
+    stats.replayedRecords = count;
+    stats.replayedBytes = end - offsets[first];
+    stats.replayThreads = pool.size();
+    stats.replayMilliseconds =
+        chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - started).count();
+    cout << "Booking log replayed " << count << " records (" << stats.replayedBytes / 1024 << " KB) in "
+         << stats.replayMilliseconds << " ms on " << stats.replayThreads << " threads" << endl;
+#else
+    (void)threads;
+#endif
+}
+
+bool BookingLog::catchUp(sqlite3* db, vector<BookingEvent>* tailed) {
+    if (fd < 0 || !db) return false;
+    const size_t batch = 4096;
+    vector<BookingEvent> events;
+    do {
+        events.clear();
+        tailOffset = read(tailOffset, batch, events);
+        for (const BookingEvent& event : events) {
+            apply(event);
+            if (tailed && event.type >= BookingEvent::BOOKED && event.type <= BookingEvent::RELEASED) {
+                tailed->push_back(event);
+            }
+        }
+        stats.tailedRecords += events.size();
+    } while (events.size() == batch);
+
+    // Covered when every change the database numbered is applied, and nothing beyond
+    int64_t current = currentSequence(db);
+    stats.covered = state.baselineSequence >= 0 && current >= 0 && appliedThrough == current;
+    if (stats.covered || current < 0) {
+        uncovered = false;
+        return stats.covered;
+    }
+
+    // A gap that does not close soon is a lost event or a bulk write; start over from the database
+    auto now = chrono::steady_clock::now();
+    if (!uncovered || appliedThrough != gapAfter) {
+        uncovered = true;
+        uncoveredSince = now;
+        gapAfter = appliedThrough;
+    }
+    bool due = state.baselineSequence < 0 || now - uncoveredSince >= chrono::seconds(BASELINE_AFTER_SECONDS);
+    bool refused = baselineRefusedAt != 0 && currentTime() - baselineRefusedAt < BASELINE_RETRY_SECONDS;
+    if (!due || refused) return false;
+
+    uncovered = false;
+    if (!writeBaseline(db)) {
+        baselineRefusedAt = currentTime();
+        return false;
+    }
+    return catchUp(db, tailed);
+}
+
+bool BookingLog::writeBaseline(sqlite3* db) {
+    // The write lock keeps every later change's record behind the baseline in the log
+    if (sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return false;
+    }
+    string today = formatDate(localDayNumber(currentTime()));
+    int64_t sequence = currentSequence(db);
+    int64_t seats = -1;
+    sqlite3_stmt* stmt = nullptr;
+    const char* countSql =
+        "SELECT COUNT(*) FROM (SELECT 1 FROM booked_seats WHERE flight_date >= ?1 LIMIT ?2);";
+    if (sequence >= 0 && sqlite3_prepare_v2(db, countSql, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, today.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt, 2, (sqlite3_int64)MAX_BASELINE_SEATS + 1);
+        if (sqlite3_step(stmt) == SQLITE_ROW) seats = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    if (seats < 0 || seats > (int64_t)MAX_BASELINE_SEATS) {
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        if (seats > 0) {
+            cout << "Over " << MAX_BASELINE_SEATS << " booked seats; seat maps keep reading the database" << endl;
+        }
+        return false;
+    }
+
+    BookingEvent event;
+    event.type = BookingEvent::BASELINE_BEGIN;
+    event.sequence = sequence;
+    event.time = currentTime();
+    event.id = seats;
+    event.date = today;
+    string bytes;
+    appendRecord(bytes, event);
+
+    bool ok = true;
+    const char* seatSql =
+        "SELECT flight_number, flight_date, seat_number, passenger_name FROM booked_seats WHERE flight_date >= ?1;";
+    int64_t written = 0;
+    if (sqlite3_prepare_v2(db, seatSql, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, today.c_str(), -1, SQLITE_TRANSIENT);
+        event.type = BookingEvent::BASELINE_SEAT;
+        event.id = 0;
+        while (ok && sqlite3_step(stmt) == SQLITE_ROW) {
+            auto text = [stmt](int column) {
+                const unsigned char* value = sqlite3_column_text(stmt, column);
+                return value ? reinterpret_cast<const char*>(value) : "";
+            };
+            event.flightNumber = text(0);
+            event.date = text(1);
+            event.seatNumber = sqlite3_column_int(stmt, 2);
+            event.passengerName = text(3);
+            appendRecord(bytes, event);
+            written++;
+            if (bytes.size() >= BASELINE_WRITE_CHUNK) {
+                ok = appendBytes(bytes);
+                bytes.clear();
+            }
+        }
+    } else {
+        ok = false;
+    }
+    sqlite3_finalize(stmt);
+
+    // A short baseline (rows changed between count and scan cannot, under the lock) is never adopted
+    event = BookingEvent();
+    event.type = BookingEvent::BASELINE_END;
+    event.sequence = sequence;
+    event.time = currentTime();
+    event.id = written;
+    appendRecord(bytes, event);
+    ok = ok && written == seats && appendBytes(bytes);
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+    if (ok) {
+        stats.baselines++;
+        cout << "Booking log baseline: " << written << " booked seats at change " << sequence << endl;
+    }
+    return ok;
+}
+
+bool BookingLog::findBookedSeats(const string& flightNumber, const string& date,
+                                 vector<pair<int, string>>& seats) const {
+    seats.clear();
+    if (!stats.covered || state.baselineSequence < 0) return false;
+    int32_t day = parseDayNumber(date);
+    if (day == INT32_MIN || day < state.firstDay) return false;
+
+    const auto& shard = state.shards[shardOf(flightNumber, date, state.shards.size())];
+    auto flight = shard.find(flightKey(flightNumber, date));
+    if (flight == shard.end()) return true;
+    for (const LoggedSeat& seat : flight->second.seats) {
+        if (seat.booked) seats.emplace_back(seat.seatNumber, seat.passengerName);
+    }
+    return true;
+}
+
+BookingLogStats BookingLog::getStats() const {
+    BookingLogStats result = stats;
+    result.baselineSequence = state.baselineSequence;
+    result.appliedThrough = appliedThrough;
+    result.bookedSeats = 0;
+    for (const auto& shard : state.shards) {
+        for (const auto& flight : shard) {
+            for (const LoggedSeat& seat : flight.second.seats) {
+                result.bookedSeats += seat.booked ? 1 : 0;
+            }
+        }
+    }
+    return result;
+}
+
+int64_t BookingLog::takeSequence(sqlite3* db, int count) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "UPDATE booking_log_state SET sequence = sequence + ? WHERE id = 1;", -1, &stmt,
+                           nullptr) != SQLITE_OK) {
+        return -1;
+    }
+    sqlite3_bind_int(stmt, 1, count);
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) == 1;
+    sqlite3_finalize(stmt);
+    return ok ? currentSequence(db) : -1;
+}
+
+int64_t BookingLog::lastSequence(sqlite3* db) {
+    return currentSequence(db);
+}
+
+bool BookingLog::invalidate(sqlite3* db) {
+    // A number nobody logs: the gap stays open until the next baseline
+    return takeSequence(db, 1) >= 0;
+}
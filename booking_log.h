@@ -0,0 +1,263 @@
+/**
+ * @file booking_log.h
+ * @brief Append-only event log of bookings, cancellations and seat holds
+ *
+ * Every process appends one checksummed binary record per seat change to a
+ * shared file, right after the change commits in SQLite. Records go out
+ * with one write() each and reach the disk in batches: a flusher thread
+ * syncs the file every SYNC_INTERVAL_MS while anything is unsynced.
+ *
+ * The log also rebuilds the booked seats of live flights without touching
+ * booked_seats. A baseline - every booked seat at one instant - is written
+ * when needed; later events are applied on top. At startup the file is
+ * mapped and replayed from its last baseline in parallel: record headers
+ * are walked once, then checksums, decoding and per-flight application
+ * run on all cores, so recovery time follows the log's size, not the
+ * number of flights.
+ *
+ * SQLite stays authoritative. Each booked_seats change takes the next
+ * number of booking_log_state.sequence in its own transaction, and the
+ * replayed seats are used only while they account for every number up to
+ * the database's current one. An event lost to a crash, or booked seats
+ * written by a tool that does not log, leave a gap; the seats are then
+ * read from SQLite until a new baseline closes it.
+ *
+ * Reading with read() is safe from any thread, also while this process or
+ * others append. Everything else must come from one thread at a time.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef BOOKING_LOG_H
+#define BOOKING_LOG_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <ctime>
+#include <cstdint>
+
+struct sqlite3;
+
+using namespace std;
+
+/**
+ * @struct BookingEvent
+ * @brief One record of the booking log
+ */
+struct BookingEvent {
+    static const uint8_t BOOKED = 1;          ///< Seat booked; id is the booking id
+    static const uint8_t CANCELLED = 2;       ///< Booking cancelled and its seat freed
+    static const uint8_t HELD = 3;            ///< Seat held for a booking form; id is the hold id
+    static const uint8_t RELEASED = 4;        ///< Hold released or expired without a booking
+    static const uint8_t BASELINE_BEGIN = 5;  ///< Baseline follows; id is its seat count, date its first day
+    static const uint8_t BASELINE_SEAT = 6;   ///< One booked seat of the baseline
+    static const uint8_t BASELINE_END = 7;
+
+    uint64_t offset = 0;      ///< Position in the log; set when read
+    uint8_t type = 0;
+    int64_t sequence = 0;     ///< booked_seats change number; 0 for holds
+    time_t time = 0;
+    int64_t id = 0;
+    string flightNumber;
+    string date;
+    int seatNumber = 0;
+    string passengerName;
+    double price = 0;         ///< Fare paid, for BOOKED
+
+    /**
+     * @brief Lower-case name of the type, e.g. "booked" or "baseline-seat"
+     */
+    static const char* typeName(uint8_t type);
+};
+
+/**
+ * @struct BookingLogStats
+ * @brief Startup replay and catch-up counters
+ */
+struct BookingLogStats {
+    uint64_t replayedRecords = 0;  ///< Records applied by the startup replay
+    uint64_t replayedBytes = 0;    ///< Bytes from the baseline to the end of the log
+    uint64_t skippedBytes = 0;     ///< Torn or corrupt bytes stepped over
+    long long replayMilliseconds = 0;
+    int replayThreads = 0;
+    uint64_t tailedRecords = 0;    ///< Records applied by catchUp() since startup
+    uint64_t baselines = 0;        ///< Baselines written by this process
+    uint64_t bookedSeats = 0;      ///< Booked seats currently in memory
+    int64_t baselineSequence = 0;
+    int64_t appliedThrough = 0;    ///< Every change up to this number is applied
+    bool covered = false;          ///< Replayed seats matched the database at the last catchUp()
+};
+
+/**
+ * @class BookingLog
+ * @brief Writer, tail reader and replayed seat state of the booking log
+ */
+class BookingLog {
+public:
+    static const int SYNC_INTERVAL_MS = 20;             ///< Longest a record stays unsynced
+    static const size_t MAX_BASELINE_SEATS = 5000000;   ///< Larger databases keep reading seats from SQLite
+    static const int BASELINE_AFTER_SECONDS = 2;        ///< A gap older than this is closed by a new baseline
+    static const int BASELINE_RETRY_SECONDS = 600;      ///< Wait after a baseline was refused as too large
+
+    BookingLog();
+    ~BookingLog();
+    BookingLog(const BookingLog&) = delete;
+    BookingLog& operator=(const BookingLog&) = delete;
+
+    /**
+     * @brief Opens or creates the log and starts the flusher
+     * @return false if the file cannot be used; appends and reads then do nothing
+     */
+    bool open(const char* path);
+
+    /**
+     * @brief Syncs what is pending and closes the file
+     */
+    void close();
+
+    bool isOpen() const { return fd >= 0; }
+
+    /**
+     * @brief Appends an event and applies it to the replayed seats
+     */
+    void record(const BookingEvent& event);
+
+    /**
+     * @brief Reads events from a position on, for consumers tailing the log
+     * @param from Offset of a record, or 0 for the start; torn bytes are skipped
+     * @param maxEvents Most events to return
+     * @param events Receives the events
+     * @return Offset to continue from; equal to from when nothing new is complete
+     */
+    uint64_t read(uint64_t from, size_t maxEvents, vector<BookingEvent>& events) const;
+
+    /**
+     * @brief Current size of the log in bytes
+     */
+    uint64_t size() const;
+
+    /**
+     * @brief Rebuilds the booked seats from the last baseline, in parallel
+     * @param threads Replay threads; 0 uses every hardware thread
+     */
+    void replay(int threads = 0);
+
+    /**
+     * @brief Applies records appended since the last call, by any process
+     * @param tailed If given, receives the bookings, cancellations, holds and releases read, in log order
+     * @return true if the replayed seats account for every change in the database
+     *
+     * Writes a new baseline when the seats have not matched the database
+     * for BASELINE_AFTER_SECONDS, or at once if there is no baseline yet.
+     * Records appended by this object come back too.
+     */
+    bool catchUp(sqlite3* db, vector<BookingEvent>* tailed = nullptr);
+
+    /**
+     * @brief Booked seats of a flight as of the last catchUp()
+     * @param seats Receives seat number and passenger name of every booked seat
+     * @return false if the replayed seats do not cover the flight; read booked_seats then
+     */
+    bool findBookedSeats(const string& flightNumber, const string& date, vector<pair<int, string>>& seats) const;
+
+    BookingLogStats getStats() const;
+
+    /**
+     * @brief Takes sequence numbers for booked_seats changes in the caller's transaction
+     * @param count Rows inserted or deleted
+     * @return The last of the count numbers taken, or -1 on error
+     */
+    static int64_t takeSequence(sqlite3* db, int count);
+
+    /**
+     * @brief Last sequence number taken; every change numbered up to it has committed
+     * @return The number, or -1 on error
+     */
+    static int64_t lastSequence(sqlite3* db);
+
+    /**
+     * @brief Marks booked_seats as changed outside the log, so replayed seats stop matching
+     *
+     * For bulk writers that do not append events; the next catchUp()
+     * of a running system then writes a new baseline.
+     */
+    static bool invalidate(sqlite3* db);
+
+private:
+    /// Seat state of one seat that has events since the baseline
+    struct LoggedSeat {
+        int seatNumber;
+        bool booked;
+        int64_t sequence;  ///< Change that set this state
+        string passengerName;
+    };
+
+    struct LoggedFlight {
+        vector<LoggedSeat> seats;
+    };
+
+    /// Flights by "number|date", split by hash so shards replay in parallel
+    struct SeatState {
+        vector<unordered_map<string, LoggedFlight>> shards;
+        int64_t baselineSequence = -1;  ///< -1: no baseline
+        int32_t firstDay = 0;           ///< Flights before this day are not covered
+        int64_t expectedSeats = 0;      ///< Seat count announced by the baseline
+        int64_t seenSeats = 0;
+        set<int64_t> appliedPastBaseline;  ///< Changes applied while the baseline was read
+    };
+
+    int fd;
+    string path;
+    SeatState state;
+    SeatState staging;            ///< Baseline being read; swapped in at its end
+    bool stagingActive;
+    int64_t appliedThrough;
+    set<int64_t> appliedAhead;    ///< Applied numbers past a gap
+    uint64_t tailOffset;          ///< Where catchUp() continues
+    chrono::steady_clock::time_point uncoveredSince;
+    bool uncovered;
+    int64_t gapAfter;             ///< appliedThrough when the current gap was first seen
+    time_t baselineRefusedAt;
+    BookingLogStats stats;
+
+    thread flusher;
+    mutex flushLock;
+    condition_variable flushWake;
+    bool dirty;
+    bool stopping;
+
+    void flushLoop();
+    bool appendBytes(const string& bytes);
+
+    static size_t shardCount();
+    static size_t shardOf(string_view flightNumber, string_view date, size_t shards);
+    static string flightKey(string_view flightNumber, string_view date);
+
+    /**
+     * @brief Applies one event to a seat state; false if it is older than the state's baseline
+     */
+    static bool applyTo(SeatState& target, const BookingEvent& event);
+
+    /**
+     * @brief Applies an event read from the log, tracking baselines and gaps
+     */
+    void apply(const BookingEvent& event);
+
+    void markApplied(int64_t sequence);
+
+    /**
+     * @brief Writes every booked seat of today and later as a new baseline
+     * @return false if the database could not be read or has more than MAX_BASELINE_SEATS
+     */
+    bool writeBaseline(sqlite3* db);
+};
+
+#endif // BOOKING_LOG_H
@@ -1,146 +1,187 @@
 #include "flight_system.h"
+#include "waitlist.h"
 #include <sqlite3.h>
 #include <iostream>
+#include <atomic>
 
 using namespace std;
 
+namespace {
+
+atomic<uint64_t> occupancyEpochCounter(0);
+
+uint64_t nextOccupancyEpoch() {
+    return ++occupancyEpochCounter;
+}
+
+} // namespace
+
 // ==================== SEAT IMPLEMENTATION ====================
 
-Seat::Seat(int number, string sClass) : seatNumber(number), seatClass(sClass), isBooked(false), passengerName("") {}
+Seat::Seat(int number, string_view sClass)
+    : seatNumber(number), seatClass(intern(sClass)), isBooked(false), holdId(0) {}
+
+Seat::Seat(int number, InternId sClass) : seatNumber(number), seatClass(sClass), isBooked(false), holdId(0) {}
 
-void Seat::bookSeat(string name) {
+void Seat::bookSeat(string_view name) {
     isBooked = true;
-    passengerName = name;
+    passengerName.assign(name.data(), name.size());
 }
 
 void Seat::cancelBooking() {
     isBooked = false;
-    passengerName = "";
+    passengerName.clear();
 }
 
 // ==================== FLIGHT IMPLEMENTATION ====================
 
 void Flight::initializeSeats() {
+    static const InternId first = intern("First");
+    static const InternId business = intern("Business");
+    static const InternId economy = intern("Economy");
+
+    seats.reserve(totalSeats);
     for (int i = 1; i <= 10; i++) {
-        seats.push_back(new Seat(i, "First"));
+        seats.emplace_back(i, first);
     }
     for (int i = 11; i <= 30; i++) {
-        seats.push_back(new Seat(i, "Business"));
+        seats.emplace_back(i, business);
     }
     for (int i = 31; i <= 100; i++) {
-        seats.push_back(new Seat(i, "Economy"));
+        seats.emplace_back(i, economy);
     }
-}
 
-Flight::Flight(string fNumber, string fName, string src, string dest, string depTime, double price, time_t depTimestamp)
-    : flightNumber(fNumber), flightName(fName), source(src), destination(dest), 
-      departureTime(depTime), basePrice(price), totalSeats(100), departureTimestamp(depTimestamp) {
-    initializeSeats();
+    freeSeatBits[0] = ~0ULL;
+    freeSeatBits[1] = (1ULL << (totalSeats - 64)) - 1;
 }
 
-Flight::~Flight() {
-    for (auto seat : seats) {
-        delete seat;
+uint64_t Flight::freeBits(int firstSeat, int count) const {
+    int start = firstSeat - 1;
+    int word = start / 64;
+    int shift = start % 64;
+    uint64_t bits = freeSeatBits[word] >> shift;
+    if (shift != 0 && word == 0) {
+        bits |= freeSeatBits[1] << (64 - shift);
     }
+    return count >= 64 ? bits : bits & ((1ULL << count) - 1);
 }
 
-double Flight::calculatePrice(string seatClass, time_t bookingTime) const {
-    double price = basePrice;
-    
-    // Class multiplier
-    if (seatClass == "First") {
-        price *= 3.0;
-    } else if (seatClass == "Business") {
-        price *= 2.0;
+bool Flight::classSlice(string_view seatClass, size_t& first, size_t& last) {
+    if (seatClass != "First" && seatClass != "Business" && seatClass != "Economy") {
+        return false;
     }
-    
-    // Demand-based pricing
-    int bookedSeats = getBookedSeatsCount();
-    double occupancyRate = (double)bookedSeats / totalSeats;
-    price *= (1.0 + occupancyRate *  0.5);
-    
-    // Days until departure pricing
-    double daysUntilDeparture = difftime(departureTimestamp, bookingTime) / (60 * 60 * 24);
-    if (daysUntilDeparture < 1) {
-        price *= 1.5;
-    } else if (daysUntilDeparture < 3) {
-        price *= 1.3;
-    } else if (daysUntilDeparture < 7) {
-        price *= 1.15;
-    } else if (daysUntilDeparture > 30) {
-        price *= 0.85;
+    int index = seatClassIndex(seatClass);
+    first = 0;
+    for (int c = 0; c < index; c++) {
+        first += seatClassCapacity(c);
     }
-    
-    // Time-of-day pricing (extract hour from departure time)
-    struct tm* timeinfo = localtime(&departureTimestamp);
-    int hour = timeinfo->tm_hour;
-    
-    if (hour >= 6 && hour < 9) {
-        // Early morning peak (6 AM - 9 AM)
-        price *= 1.25;
-    } else if (hour >= 9 && hour < 12) {
-        // Mid-morning (9 AM - 12 PM)
-        price *= 1.10;
-    } else if (hour >= 12 && hour < 15) {
-        // Afternoon off-peak (12 PM - 3 PM)
-        price *= 0.95;
-    } else if (hour >= 15 && hour < 18) {
-        // Late afternoon (3 PM - 6 PM)
-        price *= 1.05;
-    } else if (hour >= 18 && hour < 21) {
-        // Evening peak (6 PM - 9 PM)
-        price *= 1.30;
-    } else {
-        // Night/Late night (9 PM - 6 AM)
-        price *= 0.90;
+    last = first + seatClassCapacity(index);
+    return true;
+}
+
+Flight::Flight(string_view fNumber, string_view fName, string_view src, string_view dest, string_view depTime,
+               double price, time_t depTimestamp)
+    : flightNumber(intern(fNumber)), flightName(intern(fName)), source(intern(src)), destination(intern(dest)),
+      departureTime(intern(depTime)), date(intern(depTime.substr(0, 10))), basePrice(price), totalSeats(100),
+      bookedCount(0), heldCount(0), occupancyEpoch(nextOccupancyEpoch()) {
+    if (!parseCivilFields(depTime, departure)) {
+        departure = civilTimeFromTimestamp(depTimestamp);
     }
-    
-    return price;
+    departure.timestamp = depTimestamp;
+    initializeSeats();
+}
+
+double Flight::calculatePrice(string_view seatClass, time_t bookingTime) const {
+    // Departure hour was parsed once at construction; pricing is pure arithmetic
+    return computePrice(basePrice, seatClass, getBookedSeatsCount(), totalSeats,
+                        departure.timestamp, departure.hour, bookingTime);
+}
+
+double Flight::computePrice(double basePrice, string_view seatClass, int bookedSeats, int totalSeats,
+                            time_t departureTimestamp, int departureHour, time_t bookingTime) {
+    // Factors come from the active pricing rules (see pricing_rules.h)
+    return PricingRules::active().quote(basePrice, seatClassIndex(seatClass), bookedSeats, totalSeats,
+                                        departureTimestamp - bookingTime, departureHour);
+}
+
+int Flight::seatClassIndex(string_view seatClass) {
+    if (seatClass == "First") return 0;
+    if (seatClass == "Business") return 1;
+    return 2;
+}
+
+const char* Flight::seatClassName(int index) {
+    static const char* names[3] = {"First", "Business", "Economy"};
+    return names[index];
+}
+
+int Flight::seatClassCapacity(int index) {
+    static const int capacity[3] = {10, 20, 70};
+    return capacity[index];
+}
+
+int Flight::seatClassFirstSeat(int index) {
+    static const int firstSeat[3] = {1, 11, 31};
+    return firstSeat[index];
+}
+
+int Flight::seatClassOfSeat(int seatNumber) {
+    if (seatNumber >= seatClassFirstSeat(2)) return 2;
+    if (seatNumber >= seatClassFirstSeat(1)) return 1;
+    return 0;
+}
+
+int Flight::seatsPerRow(int index) {
+    static const int width[3] = {5, 5, 10};
+    return width[index];
 }
 
 int Flight::getBookedSeatsCount() const {
-    int count = 0;
-    for (const auto& seat : seats) {
-        if (seat->getIsBooked()) count++;
-    }
-    return count;
+    return bookedCount;
 }
 
 int Flight::getAvailableSeatsCount() const {
-    return totalSeats - getBookedSeatsCount();
+    return totalSeats - bookedCount - heldCount;
 }
 
-vector<Seat*> Flight::getAvailableSeatsByClass(string seatClass) const {
-    vector<Seat*> available;
-    for (auto seat : seats) {
-        if (!seat->getIsBooked() && seat->getSeatClass() == seatClass) {
-            available.push_back(seat);
-        }
-    }
-    return available;
+SeatRange Flight::getAvailableSeatsByClass(string_view seatClass) {
+    size_t first, last;
+    if (!classSlice(seatClass, first, last)) return SeatRange();
+    return SeatRange(seats.data() + first, seats.data() + last, true);
 }
 
-vector<Seat*> Flight::getSeatsByClass(string seatClass) const {
-    vector<Seat*> classSeats;
-    for (auto seat : seats) {
-        if (seat->getSeatClass() == seatClass) {
-            classSeats.push_back(seat);
-        }
-    }
-    return classSeats;
+ConstSeatRange Flight::getAvailableSeatsByClass(string_view seatClass) const {
+    size_t first, last;
+    if (!classSlice(seatClass, first, last)) return ConstSeatRange();
+    return ConstSeatRange(seats.data() + first, seats.data() + last, true);
+}
+
+SeatRange Flight::getSeatsByClass(string_view seatClass) {
+    size_t first, last;
+    if (!classSlice(seatClass, first, last)) return SeatRange();
+    return SeatRange(seats.data() + first, seats.data() + last, false);
+}
+
+ConstSeatRange Flight::getSeatsByClass(string_view seatClass) const {
+    size_t first, last;
+    if (!classSlice(seatClass, first, last)) return ConstSeatRange();
+    return ConstSeatRange(seats.data() + first, seats.data() + last, false);
 }
 
 Seat* Flight::getSeatByNumber(int seatNumber) {
     if (seatNumber >= 1 && seatNumber <= totalSeats) {
-        return seats[seatNumber - 1];
+        return &seats[seatNumber - 1];
     }
     return nullptr;
 }
 
-bool Flight::bookSeat(int seatNumber, string passengerName) {
+bool Flight::bookSeat(int seatNumber, string_view passengerName) {
     Seat* seat = getSeatByNumber(seatNumber);
-    if (seat && !seat->getIsBooked()) {
+    if (seat && seat->isAvailable()) {
         seat->bookSeat(passengerName);
+        freeSeatBits[(seatNumber - 1) / 64] &= ~(1ULL << ((seatNumber - 1) % 64));
+        bookedCount++;
+        occupancyEpoch = nextOccupancyEpoch();
         return true;
     }
     return false;
@@ -150,35 +191,199 @@ bool Flight::cancelSeat(int seatNumber) {
     Seat* seat = getSeatByNumber(seatNumber);
     if (seat && seat->getIsBooked()) {
         seat->cancelBooking();
+        freeSeatBits[(seatNumber - 1) / 64] |= 1ULL << ((seatNumber - 1) % 64);
+        bookedCount--;
+        occupancyEpoch = nextOccupancyEpoch();
+        return true;
+    }
+    return false;
+}
+
+bool Flight::holdSeat(int seatNumber, uint64_t holdId) {
+    Seat* seat = getSeatByNumber(seatNumber);
+    if (!seat || holdId == 0 || !seat->isAvailable()) return false;
+    seat->setHold(holdId);
+    freeSeatBits[(seatNumber - 1) / 64] &= ~(1ULL << ((seatNumber - 1) % 64));
+    heldCount++;
+    return true;
+}
+
+bool Flight::releaseSeatHold(int seatNumber, uint64_t holdId) {
+    Seat* seat = getSeatByNumber(seatNumber);
+    if (!seat || holdId == 0 || seat->getHoldId() != holdId) return false;
+    seat->setHold(0);
+    freeSeatBits[(seatNumber - 1) / 64] |= 1ULL << ((seatNumber - 1) % 64);
+    heldCount--;
+    return true;
+}
+
+bool Flight::bookHeldSeat(int seatNumber, uint64_t holdId, string_view passengerName) {
+    return releaseSeatHold(seatNumber, holdId) && bookSeat(seatNumber, passengerName);
+}
+
+bool Flight::findAdjacentSeats(string_view seatClass, int count, vector<int>& seatNumbers) const {
+    seatNumbers.clear();
+    size_t first, last;
+    if (!classSlice(seatClass, first, last)) return false;
+    int c = seatClassIndex(seatClass);
+    if (count < 1 || count > seatClassCapacity(c)) return false;
+
+    int width = seatsPerRow(c);
+    int rows = seatClassCapacity(c) / width;
+    int firstSeat = seatClassFirstSeat(c);
+    uint64_t fullRow = (1ULL << width) - 1;
+
+    // Start positions of free runs of length n: AND the mask with itself shifted n-1 times
+    auto runStarts = [](uint64_t free, int n) {
+        for (int k = 1; k < n; k++) free &= free >> 1;
+        return free;
+    };
+    auto lowestBit = [](uint64_t bits) {
+        int bit = 0;
+        while (!(bits & 1)) {
+            bits >>= 1;
+            bit++;
+        }
+        return bit;
+    };
+    auto freeCount = [](uint64_t bits) {
+        int n = 0;
+        for (; bits; bits &= bits - 1) n++;
+        return n;
+    };
+    auto takeRun = [&](int row, int start, int n) {
+        for (int i = 0; i < n; i++) {
+            seatNumbers.push_back(firstSeat + row * width + start + i);
+        }
+    };
+
+    if (count <= width) {
+        int bestRow = -1;
+        int bestStart = 0;
+        int bestFree = width + 1;
+        for (int row = 0; row < rows; row++) {
+            uint64_t free = freeBits(firstSeat + row * width, width);
+            uint64_t starts = runStarts(free, count);
+            if (starts && freeCount(free) < bestFree) {
+                bestRow = row;
+                bestStart = lowestBit(starts);
+                bestFree = freeCount(free);
+            }
+        }
+        if (bestRow < 0) return false;
+        takeRun(bestRow, bestStart, count);
         return true;
     }
+
+    int wholeRows = count / width;
+    int remainder = count % width;
+    for (int row = 0; row + wholeRows <= rows; row++) {
+        bool blockFree = true;
+        for (int r = row; r < row + wholeRows && blockFree; r++) {
+            blockFree = freeBits(firstSeat + r * width, width) == fullRow;
+        }
+        if (!blockFree) continue;
+        if (remainder == 0) {
+            takeRun(row, 0, wholeRows * width);
+            return true;
+        }
+
+        // The remaining travellers sit in the row directly behind or in front of the block
+        int neighbours[2] = {row + wholeRows, row - 1};
+        for (int neighbour : neighbours) {
+            if (neighbour < 0 || neighbour >= rows) continue;
+            uint64_t starts = runStarts(freeBits(firstSeat + neighbour * width, width), remainder);
+            if (!starts) continue;
+            if (neighbour < row) takeRun(neighbour, lowestBit(starts), remainder);
+            takeRun(row, 0, wholeRows * width);
+            if (neighbour > row) takeRun(neighbour, lowestBit(starts), remainder);
+            return true;
+        }
+    }
     return false;
 }
 
+bool Flight::bookSeats(const vector<int>& seatNumbers, const vector<string>& passengerNames) {
+    if (seatNumbers.size() != passengerNames.size()) return false;
+
+    // Check the whole group against the bitmap before touching any seat
+    uint64_t wanted[2] = {0, 0};
+    for (int seatNumber : seatNumbers) {
+        if (seatNumber < 1 || seatNumber > totalSeats) return false;
+        uint64_t bit = 1ULL << ((seatNumber - 1) % 64);
+        uint64_t& word = wanted[(seatNumber - 1) / 64];
+        if (word & bit) return false;
+        word |= bit;
+    }
+    if ((wanted[0] & ~freeSeatBits[0]) || (wanted[1] & ~freeSeatBits[1])) return false;
+
+    for (size_t i = 0; i < seatNumbers.size(); i++) {
+        bookSeat(seatNumbers[i], passengerNames[i]);
+    }
+    return true;
+}
+
 // ==================== BOOKING IMPLEMENTATION ====================
 
 int Booking::bookingCounter = 1000;
 
-Booking::Booking(string name, string mail, string ph, string fNumber, string fDate, int seat, double p, string sClass)
-    : passengerName(name), email(mail), phone(ph), flightNumber(fNumber), flightDate(fDate), seatNumber(seat), price(p), seatClass(sClass) {
+void Booking::continueIdsAfter(int lastId) {
+    if (lastId > bookingCounter) bookingCounter = lastId;
+}
+
+Booking::Booking(string name, string mail, string ph, string_view fNumber, string_view fDate, int seat, double p,
+                 string_view sClass)
+    : passengerName(move(name)), email(move(mail)), phone(move(ph)), flightNumber(intern(fNumber)), flightDate(intern(fDate)),
+      seatNumber(seat), price(p), seatClass(intern(sClass)) {
     bookingId = ++bookingCounter;
-    bookingTime = time(nullptr);
+    bookingTime = currentTime();
+}
+
+Booking::Booking(int id, string name, string mail, string ph, string_view fNumber, string_view fDate, int seat,
+                 double p, string_view sClass, time_t bookedAt)
+    : bookingId(id), passengerName(move(name)), email(move(mail)), phone(move(ph)), flightNumber(intern(fNumber)),
+      flightDate(intern(fDate)), seatNumber(seat), price(p), bookingTime(bookedAt), seatClass(intern(sClass)) {
+    continueIdsAfter(id);
 }
 
 // ==================== RESERVATION SYSTEM IMPLEMENTATION ====================
 
-ReservationSystem::ReservationSystem() : db(nullptr) {
+const char* ReservationSystem::DATABASE_PATH = "spaazm_flights.db";
+const char* ReservationSystem::SCHEDULE_SNAPSHOT_PATH = "spaazm_flights.schedule";
+const char* ReservationSystem::BOOKING_LOG_PATH = "spaazm_flights.events";
+
+ReservationSystem::ReservationSystem()
+    : db(nullptr), plannerLoaded(false), analyticsStale(false), seenDataVersion(-1), seatsCovered(false),
+      seenBaselines(0), plannerThrough(0), lowestFaresThrough(0), analyticsThrough(0) {
     initDatabase();
+    if (db) {
+        pricingRules.start(DATABASE_PATH, PricingRules::DEFAULT_RULES_PATH);
+    }
+    // Booked seats of live flights come from the log from now on, once it matches the database
+    if (db && bookingLog.open(BOOKING_LOG_PATH)) {
+        bookingLog.replay();
+        seatsCovered = bookingLog.catchUp(db);
+    }
     loadFlights();
+    if (db) {
+        maintainer.start(DATABASE_PATH);
+    }
 }
 
 ReservationSystem::~ReservationSystem() {
+    seatHolds.releaseAll(db, [this](const SeatHold& hold) {
+        logHold(BookingEvent::RELEASED, hold.holdId, hold.flightNumber, hold.flightDate, hold.seatNumber);
+    });
+    sharedSeats.detach();
+    maintainer.stop();
+    pricingRules.stop();
     for (auto flight : flights) delete flight;
     for (auto booking : bookings) delete booking;
     if (db) sqlite3_close(db);
 }
 
 void ReservationSystem::searchFlights(const string& dateStr, const string& source, const string& destination) {
+    expireHolds();
     clearFlights();
     
     if (!db) {
@@ -186,44 +391,540 @@ void ReservationSystem::searchFlights(const string& dateStr, const string& sourc
         return;
     }
     
-    stringstream ss;
-    ss << "SELECT flight_number, flight_name, source, destination, departure_time, base_price "
-       << "FROM flights WHERE date = '" << dateStr << "' "
-       << "AND source = '" << source << "' AND destination = '" << destination << "';";
-    
-    cout << "SQL Query: " << ss.str() << endl;
-    
+    syncSchedule();
+    ScheduleStore::Range range = schedule.findRoute(source, destination, dateStr);
+    for (size_t row = range.begin; row < range.end; row++) {
+        Flight* flight = new Flight(schedule.getFlightNumber(row), schedule.getFlightName(row),
+                                    schedule.getSource(row), schedule.getDestination(row),
+                                    schedule.getDepartureTime(row), schedule.getBasePrice(row),
+                                    schedule.getDepartureTimestamp(row));
+        loadBookedSeats(flight);
+        flights.push_back(flight);
+        flightIndex[internPair(flight->getFlightNumberId(), flight->getDateId())] = flight;
+    }
+    if (range.begin < range.end) return;
+
+    // Departed days are no longer in the schedule window; read them from wherever the month lives
+    string table = departedFlightsTable(dateStr);
+    if (table.empty()) return;
+    sqlite3_stmt* stmt = nullptr;
+    string sql = "SELECT flight_number, flight_name, departure_time, base_price FROM " + table +
+                 " WHERE source = ? AND destination = ? AND date = ? ORDER BY departure_time;";
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return;
+    }
+    sqlite3_bind_text(stmt, 1, source.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, destination.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, dateStr.c_str(), -1, SQLITE_STATIC);
+    vector<Flight*> departed;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        string departureTime = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+        time_t timestamp = 0;
+        int hour = 0;
+        parseDepartureTime(departureTime, timestamp, hour);
+        departed.push_back(new Flight(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)),
+                                      reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)), source,
+                                      destination, departureTime, sqlite3_column_double(stmt, 3), timestamp));
+    }
+    sqlite3_finalize(stmt);
+    for (Flight* flight : departed) {
+        loadBookedSeats(flight);
+        flights.push_back(flight);
+        flightIndex[internPair(flight->getFlightNumberId(), flight->getDateId())] = flight;
+    }
+}
+
+string ReservationSystem::departedFlightsTable(const string& date) {
+    if (date >= formatDate(localDayNumber(currentTime()))) return "";
+    string schema = partitions.schemaFor(db, date, currentTime());
+    if (schema.empty()) return "";
+    return schema == "main" ? "main.flights_archive" : schema + ".flights";
+}
+
+Flight* ReservationSystem::loadFlight(const string& flightNumber, const string& date) {
+    expireHolds();
+    if (!db) return nullptr;
+
+    // Live flights first, then a departed day's archive or month partition
+    Flight* flight = nullptr;
+    for (int attempt = 0; attempt < 2 && !flight; attempt++) {
+        string table = attempt == 0 ? "main.flights" : departedFlightsTable(date);
+        if (table.empty()) break;
+        sqlite3_stmt* stmt = nullptr;
+        string sql = "SELECT flight_name, source, destination, departure_time, base_price FROM " + table +
+                     " WHERE flight_number = ? AND date = ?;";
+        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+            return nullptr;
+        }
+        sqlite3_bind_text(stmt, 1, flightNumber.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, date.c_str(), -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            string departureTime = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+            time_t timestamp = 0;
+            int hour = 0;
+            parseDepartureTime(departureTime, timestamp, hour);
+            flight = new Flight(flightNumber, reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)),
+                                reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                                reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)), departureTime,
+                                sqlite3_column_double(stmt, 4), timestamp);
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (!flight) return nullptr;
+
+    // Replace a stale copy; seat holds refer to flights by number and date, not by pointer
+    uint64_t key = internPair(flight->getFlightNumberId(), flight->getDateId());
+    auto loaded = flightIndex.find(key);
+    if (loaded != flightIndex.end()) {
+        flights.erase(find(flights.begin(), flights.end(), loaded->second));
+        delete loaded->second;
+        flightIndex.erase(loaded);
+    } else if (flights.size() >= MAX_LOADED_FLIGHTS) {
+        clearFlights();
+    }
+    loadBookedSeats(flight);
+    flights.push_back(flight);
+    flightIndex[key] = flight;
+    return flight;
+}
+
+bool ReservationSystem::parseDepartureTime(const string& depTime, time_t& timestamp, int& hour) {
+    CivilTime civil;
+    if (!parseCivilTime(depTime, civil)) {
+        return false;
+    }
+    timestamp = civil.timestamp;
+    hour = civil.hour;
+    return true;
+}
+
+string ReservationSystem::shiftDate(const string& dateStr, int days) {
+    int32_t day = parseDayNumber(dateStr);
+    return day == INT32_MIN ? dateStr : formatDate(day + days);
+}
+
+double ReservationSystem::quotePrice(const Flight* flight, const string& seatClass) {
+    return quotes.quote(*flight, seatClass, currentTime());
+}
+
+PriceLock ReservationSystem::lockPrice(const Flight* flight, const string& seatClass) {
+    return quotes.lockPrice(*flight, seatClass, currentTime());
+}
+
+bool ReservationSystem::redeemPriceLock(uint64_t token, const Flight* flight, const string& seatClass,
+                                        double& price) {
+    return quotes.redeemPriceLock(token, *flight, seatClass, currentTime(), price);
+}
+
+void ReservationSystem::releasePriceLock(uint64_t token) {
+    quotes.releasePriceLock(token);
+}
+
+uint64_t ReservationSystem::holdSeat(Flight* flight, int seatNumber) {
+    expireHolds();
+    Seat* seat = flight->getSeatByNumber(seatNumber);
+    if (!db || !seat || !seat->isAvailable()) return 0;
+
+    // Of two attached processes picking this seat, the one losing the claim stops here
+    int claim = sharedSeats.claim(flight->getFlightNumber(), flight->getDate(), seatNumber);
+    if (claim == SharedSeatMap::TAKEN) {
+        loadBookedSeats(flight);
+        return 0;
+    }
+    uint64_t holdId = seatHolds.acquire(db, flight->getFlightNumberId(), flight->getDateId(), seatNumber,
+                                        currentTime());
+    if (holdId == 0) {
+        // Booked or held by another session since the search
+        if (claim == SharedSeatMap::CLAIMED) {
+            sharedSeats.markReleased(flight->getFlightNumber(), flight->getDate(), seatNumber);
+        }
+        loadBookedSeats(flight);
+        return 0;
+    }
+    flight->holdSeat(seatNumber, holdId);
+    seatInventory.publish(*flight);
+    logHold(BookingEvent::HELD, holdId, flight->getFlightNumberId(), flight->getDateId(), seatNumber);
+    return holdId;
+}
+
+void ReservationSystem::releaseHold(uint64_t holdId) {
+    const SeatHold* hold = seatHolds.find(holdId);
+    if (!hold || !hold->own) return;
+    auto loaded = flightIndex.find(internPair(hold->flightNumber, hold->flightDate));
+    if (loaded != flightIndex.end()) {
+        loaded->second->releaseSeatHold(hold->seatNumber, holdId);
+        seatInventory.publish(*loaded->second);
+    }
+    logHold(BookingEvent::RELEASED, holdId, hold->flightNumber, hold->flightDate, hold->seatNumber);
+    seatHolds.release(db, holdId);
+}
+
+Booking* ReservationSystem::bookHeldSeat(uint64_t holdId, string passengerName, string email, string phone,
+                                         double price) {
+    expireHolds();
+    const SeatHold* hold = seatHolds.find(holdId);
+    if (!db || !hold || !hold->own) return nullptr;
+    auto loaded = flightIndex.find(internPair(hold->flightNumber, hold->flightDate));
+    if (loaded == flightIndex.end()) return nullptr;
+
+    Flight* flight = loaded->second;
+    int seatNumber = hold->seatNumber;
+    const string& seatClass = flight->getSeatByNumber(seatNumber)->getSeatClass();
+    if (!flight->bookHeldSeat(seatNumber, holdId, passengerName)) return nullptr;
+
+    Booking* booking = new Booking(move(passengerName), move(email), move(phone), flight->getFlightNumber(),
+                                   flight->getDate(), seatNumber, price, seatClass);
+    if (!saveGroup({booking}, holdId)) {
+        flight->cancelSeat(seatNumber);
+        sharedSeats.markReleased(flight->getFlightNumber(), flight->getDate(), seatNumber);
+        seatHolds.release(db, holdId);
+        seatInventory.publish(*flight);
+        delete booking;
+        return nullptr;
+    }
+    seatHolds.forget(holdId);
+    seatInventory.publish(*flight);
+
+    bookings.push_back(booking);
+    if (plannerLoaded) {
+        planner.adjustOccupancy(flight->getFlightNumber(), flight->getDate(), seatClass, +1);
+    }
+    if (lowestFares.isLoaded()) {
+        lowestFares.recordBooking(db, flight->getFlightNumber(), flight->getDate(), seatClass, +1);
+    }
+    if (analytics.isLoaded()) {
+        analytics.recordBooking(db, flight->getFlightNumber(), flight->getDate(), seatClass, +1, price);
+    }
+    return booking;
+}
+
+void ReservationSystem::expireHolds() {
+    // Tickets before the log is read, so a map filled from what it says is not older than it
+    vector<pair<Flight*, uint32_t>> refill;
+    if (sharedSeats.isAttached()) {
+        sharedSeats.heartbeat(currentTime());
+        for (const auto& loaded : flightIndex) {
+            const string& number = loaded.second->getFlightNumber();
+            const string& date = loaded.second->getDate();
+            if (!sharedSeats.isPublished(number, date)) {
+                refill.push_back({loaded.second, sharedSeats.fillTicket(number, date)});
+            }
+        }
+    }
+    vector<BookingEvent> changes;
+    bool covered = bookingLog.catchUp(db, &changes);
+    syncSeatInventory(covered);
+    applySeatChanges(changes, covered);
+    if (sharedSeats.isAttached()) {
+        syncSharedSeats(changes, covered, refill);
+    }
+    seatHolds.expire(db, currentTime(), [this](const SeatHold& hold) {
+        auto loaded = flightIndex.find(internPair(hold.flightNumber, hold.flightDate));
+        if (loaded != flightIndex.end()) {
+            loaded->second->releaseSeatHold(hold.seatNumber, hold.holdId);
+            seatInventory.publish(*loaded->second);
+        }
+        if (hold.own) {
+            logHold(BookingEvent::RELEASED, hold.holdId, hold.flightNumber, hold.flightDate, hold.seatNumber);
+        } else {
+            sharedSeats.markReleased(internedText(hold.flightNumber), internedText(hold.flightDate),
+                                     hold.seatNumber, false);
+        }
+    });
+}
+
+bool ReservationSystem::attachSharedSeats() {
+    // Flights loaded before attaching get their maps on the next expireHolds()
+    if (!db || !sharedSeats.attach(DATABASE_PATH)) return false;
+    seenBaselines = bookingLog.getStats().baselines;
+    return true;
+}
+
+void ReservationSystem::syncSharedSeats(const vector<BookingEvent>& events, bool covered,
+                                        const vector<pair<Flight*, uint32_t>>& refill) {
+    // A baseline means booked_seats changed outside the log, and so outside the maps
+    uint64_t baselines = bookingLog.getStats().baselines;
+    if (baselines != seenBaselines) {
+        seenBaselines = baselines;
+        sharedSeats.clear();
+    }
+    // Own changes come back too; each seat keeps its latest sequence, so applying them twice is harmless
+    for (const BookingEvent& event : events) {
+        if (event.type == BookingEvent::BOOKED) {
+            sharedSeats.markBooked(event.flightNumber, event.date, event.seatNumber, event.sequence);
+        } else if (event.type == BookingEvent::CANCELLED) {
+            sharedSeats.markCancelled(event.flightNumber, event.date, event.seatNumber, event.sequence);
+        } else if (event.type == BookingEvent::RELEASED) {
+            sharedSeats.markReleased(event.flightNumber, event.date, event.seatNumber, false);
+        }
+    }
+    if (!covered) return;
+    time_t holdsExpireBy = currentTime() + SeatHolds::HOLD_SECONDS;
+    for (const auto& flight : refill) {
+        sharedSeats.publish(*flight.first, flight.second, holdsExpireBy);
+    }
+}
+
+void ReservationSystem::logBooking(uint8_t type, const Booking* booking, int64_t sequence) {
+    BookingEvent event;
+    event.type = type;
+    event.sequence = sequence;
+    event.time = type == BookingEvent::BOOKED ? booking->getBookingTime() : currentTime();
+    event.id = booking->getBookingId();
+    event.flightNumber = booking->getFlightNumber();
+    event.date = booking->getFlightDate();
+    event.seatNumber = booking->getSeatNumber();
+    event.passengerName = booking->getPassengerName();
+    event.price = booking->getPrice();
+    bookingLog.record(event);
+    if (bookingLog.isOpen()) {
+        // Applied to the derived indexes already; skipped when applySeatChanges() reads it back
+        ownBookingEvents.insert(ownEventKey(type, event.id));
+    }
+    if (type == BookingEvent::BOOKED) {
+        sharedSeats.markBooked(event.flightNumber, event.date, event.seatNumber, sequence);
+    } else {
+        sharedSeats.markCancelled(event.flightNumber, event.date, event.seatNumber, sequence);
+    }
+}
+
+void ReservationSystem::logHold(uint8_t type, uint64_t holdId, InternId flightNumber, InternId flightDate,
+                                int seatNumber) {
+    BookingEvent event;
+    event.type = type;
+    event.time = currentTime();
+    event.id = (int64_t)holdId;
+    event.flightNumber = internedText(flightNumber);
+    event.date = internedText(flightDate);
+    event.seatNumber = seatNumber;
+    bookingLog.record(event);
+    if (type == BookingEvent::HELD) {
+        sharedSeats.markHeld(event.flightNumber, event.date, seatNumber);
+    } else {
+        sharedSeats.markReleased(event.flightNumber, event.date, seatNumber);
+    }
+}
+
+void ReservationSystem::syncSeatInventory(bool covered) {
+    if (!db) return;
+    // data_version moves only when another connection commits: another process, or this
+    // process's maintainer. Snapshots may then be stale and are withdrawn until republished,
+    // unless the booking log accounted for every booked seat and applySeatChanges() follows.
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "PRAGMA data_version;", -1, &stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        long long version = sqlite3_column_int64(stmt, 0);
+        if (seenDataVersion >= 0 && version != seenDataVersion && !covered) {
+            seatInventory.clear();
+        }
+        seenDataVersion = version;
+    }
+    sqlite3_finalize(stmt);
+}
+
+void ReservationSystem::applySeatChanges(const vector<BookingEvent>& events, bool covered) {
+    // Once the log covers booked_seats again after a gap, any loaded flight may have missed a change
+    unordered_map<Flight*, vector<int>> changed;
+    if (covered && !seatsCovered) {
+        for (const auto& loaded : flightIndex) changed[loaded.second];
+        // So may the derived indexes; they rebuild on next use
+        lowestFares.reset();
+        plannerLoaded = false;
+        analyticsStale = true;
+    }
+    seatsCovered = covered;
+
+    vector<pair<Flight*, const BookingEvent*>> holdEvents;
+    for (const BookingEvent& event : events) {
+        if ((event.type == BookingEvent::BOOKED || event.type == BookingEvent::CANCELLED) &&
+            ownBookingEvents.erase(ownEventKey(event.type, event.id)) == 0) {
+            applyOtherBooking(event);
+        }
+        // A flight or date never interned here cannot be loaded; find() keeps them out of the interner
+        InternId flightNumber = StringInterner::global().find(event.flightNumber);
+        InternId flightDate = StringInterner::global().find(event.date);
+        if (flightNumber == StringInterner::NO_ID || flightDate == StringInterner::NO_ID) continue;
+        auto loaded = flightIndex.find(internPair(flightNumber, flightDate));
+        if (loaded == flightIndex.end()) continue;
+        if (event.type == BookingEvent::BOOKED || event.type == BookingEvent::CANCELLED) {
+            changed[loaded->second];
+        } else {
+            holdEvents.push_back({loaded->second, &event});
+        }
+    }
+
+    // Booked seats go straight to their latest state, so the log order of one seat's events does not matter
+    vector<pair<int, string>> booked;
+    for (auto& entry : changed) {
+        Flight* flight = entry.first;
+        booked.clear();
+        if (!readBookedSeats(flight, booked)) continue;
+        vector<const string*> names(flight->getTotalSeats() + 1, nullptr);
+        for (const auto& seat : booked) {
+            if (seat.first >= 1 && seat.first <= flight->getTotalSeats()) names[seat.first] = &seat.second;
+        }
+        for (int seatNumber = 1; seatNumber <= flight->getTotalSeats(); seatNumber++) {
+            Seat* seat = flight->getSeatByNumber(seatNumber);
+            if (names[seatNumber] && !seat->getIsBooked()) {
+                // Booked from a hold placed elsewhere; the hold ended with the booking
+                uint64_t holdId = seat->getHoldId();
+                const SeatHold* hold = seatHolds.find(holdId);
+                if (hold && hold->own) continue;
+                flight->releaseSeatHold(seatNumber, holdId);
+                seatHolds.forget(holdId);
+                flight->bookSeat(seatNumber, *names[seatNumber]);
+                entry.second.push_back(seatNumber);
+            } else if (!names[seatNumber] && seat->getIsBooked()) {
+                flight->cancelSeat(seatNumber);
+                entry.second.push_back(seatNumber);
+            }
+        }
+    }
+
+    // Holds of other sessions; this session's own come back from the log too and are skipped
+    time_t now = currentTime();
+    for (const auto& entry : holdEvents) {
+        Flight* flight = entry.first;
+        const BookingEvent& event = *entry.second;
+        uint64_t holdId = (uint64_t)event.id;
+        const SeatHold* hold = seatHolds.find(holdId);
+        if (event.type == BookingEvent::HELD) {
+            time_t expiresAt = event.time + SeatHolds::HOLD_SECONDS;
+            if (hold || expiresAt <= now || !flight->holdSeat(event.seatNumber, holdId)) continue;
+            seatHolds.track(holdId, flight->getFlightNumberId(), flight->getDateId(), event.seatNumber, expiresAt,
+                            now);
+        } else {
+            if (hold && hold->own) continue;
+            seatHolds.forget(holdId);
+            if (!flight->releaseSeatHold(event.seatNumber, holdId)) continue;
+        }
+        changed[flight].push_back(event.seatNumber);
+    }
+
+    for (auto& entry : changed) {
+        if (entry.second.empty()) continue;
+        seatInventory.publish(*entry.first);
+        if (seatChangeListener) {
+            sort(entry.second.begin(), entry.second.end());
+            entry.second.erase(unique(entry.second.begin(), entry.second.end()), entry.second.end());
+            seatChangeListener(entry.first, entry.second);
+        }
+    }
+}
+
+void ReservationSystem::applyOtherBooking(const BookingEvent& event) {
+    int seats = event.type == BookingEvent::BOOKED ? 1 : -1;
+    string seatClass = Flight::seatClassName(Flight::seatClassOfSeat(event.seatNumber));
+    if (plannerLoaded && event.sequence > plannerThrough) {
+        planner.adjustOccupancy(event.flightNumber, event.date, seatClass, seats);
+    }
+    if (lowestFares.isLoaded() && event.sequence > lowestFaresThrough) {
+        lowestFares.recordBooking(db, event.flightNumber, event.date, seatClass, seats);
+    }
+    if (analytics.isLoaded() && event.sequence > analyticsThrough) {
+        analytics.recordBooking(db, event.flightNumber, event.date, seatClass, seats, seats * event.price);
+    }
+}
+
+void ReservationSystem::publishSeats(InternId flightNumber, InternId flightDate) {
+    auto loaded = flightIndex.find(internPair(flightNumber, flightDate));
+    if (loaded != flightIndex.end()) {
+        seatInventory.publish(*loaded->second);
+    } else {
+        // Changed in the database without a loaded copy to publish from
+        seatInventory.remove(internedText(flightNumber), internedText(flightDate));
+    }
+}
+
+DayFare ReservationSystem::getLowestFare(const string& dateStr, const string& source, const string& destination) {
+    syncSchedule();
+    if (db && !lowestFares.isLoaded()) {
+        lowestFaresThrough = BookingLog::lastSequence(db);
+        lowestFares.load(db, schedule);
+    }
+    return lowestFares.lookup(db, source, destination, dateStr, currentTime());
+}
+
+const BookingAnalytics& ReservationSystem::getAnalytics() {
+    syncSchedule();
+    if (db && (!analytics.isLoaded() || analyticsStale ||
+               analytics.getScheduleGeneration() != schedule.getGeneration())) {
+        analyticsThrough = BookingLog::lastSequence(db);
+        analyticsStale = !analytics.load(db, schedule.getGeneration(), 0, &partitions);
+    }
+    return analytics;
+}
+
+vector<DayFare> ReservationSystem::searchFlexibleDates(const string& dateStr, const string& source,
+                                                       const string& destination, int windowDays) {
+    vector<DayFare> days;
+    for (int offset = -windowDays; offset <= windowDays; offset++) {
+        days.push_back(getLowestFare(shiftDate(dateStr, offset), source, destination));
+    }
+    return days;
+}
+
+vector<Itinerary> ReservationSystem::searchItineraries(const string& dateStr, const string& source,
+                                                       const string& destination, const string& seatClass,
+                                                       const ItineraryOptions& options) {
+    if (!db) {
+        cerr << "Database not initialized!" << endl;
+        return {};
+    }
+    syncSchedule();
+    if (!plannerLoaded) {
+        loadPlanner();
+    }
+
+    // Earliest departure is the start of the requested day (or now, if that is later)
+    int32_t day = parseDayNumber(dateStr);
+    if (day == INT32_MIN) {
+        return {};
+    }
+    time_t dayStart = localTimestamp(day, 0);
+    time_t now = currentTime();
+    return planner.plan(source, destination, max(dayStart, now), seatClass, now, options);
+}
+
+void ReservationSystem::loadPlanner() {
+    planner.clear();
+    plannerThrough = BookingLog::lastSequence(db);
+
+    for (size_t row = 0; row < schedule.size(); row++) {
+        planner.addFlight(schedule.getFlightNumber(row), schedule.getFlightName(row), schedule.getSource(row),
+                          schedule.getDestination(row), schedule.getDate(row), schedule.getDepartureTime(row),
+                          schedule.getDepartureTimestamp(row), schedule.getDepartureHour(row),
+                          schedule.getBasePrice(row));
+    }
+
     sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, ss.str().c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+    // Occupancy per flight and class in one aggregate pass
+    const char* occupancySql =
+        "SELECT flight_number, flight_date, "
+        "CASE WHEN seat_number <= 10 THEN 'First' WHEN seat_number <= 30 THEN 'Business' ELSE 'Economy' END, "
+        "COUNT(*) FROM booked_seats GROUP BY 1, 2, 3;";
+    if (sqlite3_prepare_v2(db, occupancySql, -1, &stmt, nullptr) == SQLITE_OK) {
         while (sqlite3_step(stmt) == SQLITE_ROW) {
-            string flightNum = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-            string flightName = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-            string src = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-            string dest = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-            string depTime = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-            double basePrice = sqlite3_column_double(stmt, 5);
-            
-            struct tm tm = {};
-            int y, mon, d, h, m;
-            if (sscanf(depTime.c_str(), "%d-%d-%d %d:%d", &y, &mon, &d, &h, &m) == 5) {
-                tm.tm_year = y - 1900;
-                tm.tm_mon = mon - 1;
-                tm.tm_mday = d;
-                tm.tm_hour = h;
-                tm.tm_min = m;
-                tm.tm_isdst = -1;
-                time_t timestamp = mktime(&tm);
-                
-                Flight* flight = new Flight(flightNum, flightName, src, dest, depTime, basePrice, timestamp);
-                loadBookedSeats(flight);
-                flights.push_back(flight);
-            }
+            planner.adjustOccupancy(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)),
+                                    reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                                    reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)),
+                                    sqlite3_column_int(stmt, 3));
         }
         sqlite3_finalize(stmt);
     }
+
+    planner.finalize();
+    plannerLoaded = true;
+    cout << "Itinerary planner loaded " << planner.size() << " connections" << endl;
 }
 
 vector<string> ReservationSystem::getUniqueCities() const {
+    if (!schedule.empty()) {
+        return schedule.getCities();
+    }
+
     vector<string> cities;
     if (!db) {
         // Fallback to hardcoded cities if database is not available
@@ -255,54 +956,274 @@ void ReservationSystem::clearFlights() {
         delete flight;
     }
     flights.clear();
+    flightIndex.clear();
+    seatInventory.clear();
 }
 
-Flight* ReservationSystem::findFlight(string flightNumber) {
+Flight* ReservationSystem::findFlight(string_view flightNumber) {
+    InternId numberId = StringInterner::global().find(flightNumber);
+    if (numberId == StringInterner::NO_ID) return nullptr;
     for (auto flight : flights) {
-        if (flight->getFlightNumber() == flightNumber) {
+        if (flight->getFlightNumberId() == numberId) {
             return flight;
         }
     }
     return nullptr;
 }
 
-Booking* ReservationSystem::addBooking(string passengerName, string email, string phone, string flightNumber, string flightDate, int seatNumber, double price, string seatClass) {
-    Booking* booking = new Booking(passengerName, email, phone, flightNumber, flightDate, seatNumber, price, seatClass);
+Flight* ReservationSystem::findFlight(string_view flightNumber, string_view date) {
+    InternId numberId = StringInterner::global().find(flightNumber);
+    InternId dateId = StringInterner::global().find(date);
+    if (numberId == StringInterner::NO_ID || dateId == StringInterner::NO_ID) return nullptr;
+    auto it = flightIndex.find(internPair(numberId, dateId));
+    return it == flightIndex.end() ? nullptr : it->second;
+}
+
+Booking* ReservationSystem::addBooking(string passengerName, string email, string phone, const string& flightNumber,
+                                      const string& flightDate, int seatNumber, double price, const string& seatClass) {
+    Booking* booking = new Booking(move(passengerName), move(email), move(phone), flightNumber, flightDate,
+                                   seatNumber, price, seatClass);
+    if (db && !saveGroup({booking})) {
+        delete booking;
+        return nullptr;
+    }
     bookings.push_back(booking);
-    saveBooking(booking);
+    publishSeats(booking->getFlightNumberId(), booking->getFlightDateId());
+    if (plannerLoaded) {
+        planner.adjustOccupancy(flightNumber, flightDate, seatClass, +1);
+    }
+    if (lowestFares.isLoaded()) {
+        lowestFares.recordBooking(db, flightNumber, flightDate, seatClass, +1);
+    }
+    if (analytics.isLoaded()) {
+        analytics.recordBooking(db, flightNumber, flightDate, seatClass, +1, price);
+    }
     return booking;
 }
 
-bool ReservationSystem::cancelBooking(int bookingId) {
-    for (size_t i = 0; i < bookings.size(); i++) {
-        if (bookings[i]->getBookingId() == bookingId) {
-            Flight* flight = findFlight(bookings[i]->getFlightNumber());
-            if (flight) {
-                flight->cancelSeat(bookings[i]->getSeatNumber());
-            }
-            
-            if (db) {
-                string sql = "DELETE FROM bookings WHERE id = " + to_string(bookingId) + ";";
-                sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
-                
-                stringstream ss;
-                ss << "DELETE FROM booked_seats WHERE flight_number = '" 
-                   << bookings[i]->getFlightNumber() << "' AND flight_date = '" 
-                   << bookings[i]->getFlightDate() << "' AND seat_number = " 
-                   << bookings[i]->getSeatNumber() << ";";
-                sqlite3_exec(db, ss.str().c_str(), nullptr, nullptr, nullptr);
-            }
-            
-            delete bookings[i];
-            bookings.erase(bookings.begin() + i);
-            return true;
+vector<Booking*> ReservationSystem::bookGroup(Flight* flight, const string& seatClass,
+                                              const vector<string>& passengerNames, const string& email,
+                                              const string& phone) {
+    vector<int> seatNumbers;
+    if (!db || passengerNames.empty() ||
+        !flight->findAdjacentSeats(seatClass, (int)passengerNames.size(), seatNumbers)) {
+        return {};
+    }
+
+    // One fare for the whole group, quoted before its seats raise the occupancy
+    double price = quotes.quote(*flight, seatClass, currentTime());
+    if (!flight->bookSeats(seatNumbers, passengerNames)) {
+        return {};
+    }
+
+    vector<Booking*> group;
+    for (size_t i = 0; i < seatNumbers.size(); i++) {
+        group.push_back(new Booking(passengerNames[i], email, phone, flight->getFlightNumber(), flight->getDate(),
+                                    seatNumbers[i], price, seatClass));
+    }
+
+    if (!saveGroup(group)) {
+        for (size_t i = 0; i < group.size(); i++) {
+            flight->cancelSeat(seatNumbers[i]);
+            delete group[i];
         }
+        return {};
     }
-    return false;
+    seatInventory.publish(*flight);
+
+    bookings.insert(bookings.end(), group.begin(), group.end());
+    int seatsBooked = (int)group.size();
+    if (plannerLoaded) {
+        planner.adjustOccupancy(flight->getFlightNumber(), flight->getDate(), seatClass, seatsBooked);
+    }
+    if (lowestFares.isLoaded()) {
+        lowestFares.recordBooking(db, flight->getFlightNumber(), flight->getDate(), seatClass, seatsBooked);
+    }
+    if (analytics.isLoaded()) {
+        analytics.recordBooking(db, flight->getFlightNumber(), flight->getDate(), seatClass, seatsBooked,
+                                price * seatsBooked);
+    }
+    return group;
+}
+
+bool ReservationSystem::cancelBooking(int bookingId, Booking** promoted) {
+    if (promoted) *promoted = nullptr;
+    size_t i = 0;
+    while (i < bookings.size() && bookings[i]->getBookingId() != bookingId) i++;
+    if (i == bookings.size()) {
+        Booking* saved = db ? loadBooking(bookingId) : nullptr;
+        if (!saved) return false;
+        bookings.push_back(saved);
+    }
+
+    Booking* cancelled = bookings[i];
+    Booking* next = nullptr;
+    // The rows are still there after a failed write, so memory keeps the booking too
+    if (db && !releaseBookedSeat(cancelled, &next)) return false;
+
+    auto loaded = flightIndex.find(internPair(cancelled->getFlightNumberId(), cancelled->getFlightDateId()));
+    if (loaded != flightIndex.end()) {
+        loaded->second->cancelSeat(cancelled->getSeatNumber());
+        if (next) {
+            loaded->second->bookSeat(next->getSeatNumber(), next->getPassengerName());
+        }
+    }
+    publishSeats(cancelled->getFlightNumberId(), cancelled->getFlightDateId());
+    // A promotion refills the seat, so the flight's occupancy is unchanged
+    if (!next && plannerLoaded) {
+        planner.adjustOccupancy(cancelled->getFlightNumber(), cancelled->getFlightDate(),
+                                cancelled->getSeatClass(), -1);
+    }
+    if (!next && lowestFares.isLoaded()) {
+        lowestFares.recordBooking(db, cancelled->getFlightNumber(), cancelled->getFlightDate(),
+                                  cancelled->getSeatClass(), -1);
+    }
+    // A promotion keeps the seat sold but replaces the fare
+    if (analytics.isLoaded()) {
+        analytics.recordBooking(db, cancelled->getFlightNumber(), cancelled->getFlightDate(),
+                                cancelled->getSeatClass(), -1, -cancelled->getPrice());
+        if (next) {
+            analytics.recordBooking(db, next->getFlightNumber(), next->getFlightDate(), next->getSeatClass(), +1,
+                                    next->getPrice());
+        }
+    }
+
+    delete cancelled;
+    bookings.erase(bookings.begin() + i);
+    if (next) {
+        bookings.push_back(next);
+        if (promoted) *promoted = next;
+    }
+    return true;
+}
+
+Booking* ReservationSystem::loadBooking(int bookingId) {
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql =
+        "SELECT passenger_name, passenger_email, passenger_phone, flight_number, flight_date, seat_number, "
+        "seat_class, price, booking_time FROM bookings WHERE id = ?;";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return nullptr;
+    }
+    sqlite3_bind_int(stmt, 1, bookingId);
+    Booking* booking = nullptr;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        auto text = [stmt](int column) {
+            const unsigned char* value = sqlite3_column_text(stmt, column);
+            return string(value ? reinterpret_cast<const char*>(value) : "");
+        };
+        booking = new Booking(bookingId, text(0), text(1), text(2), text(3), text(4), sqlite3_column_int(stmt, 5),
+                              sqlite3_column_double(stmt, 7), text(6), sqlite3_column_int64(stmt, 8));
+    }
+    sqlite3_finalize(stmt);
+    return booking;
+}
+
+bool ReservationSystem::releaseBookedSeat(const Booking* booking, Booking** promoted) {
+    *promoted = nullptr;
+    const string& flightNumber = booking->getFlightNumber();
+    const string& flightDate = booking->getFlightDate();
+    const string& seatClass = booking->getSeatClass();
+    // The seat row of a sealed month is in its partition file, and it is history by then
+    if (isSealedDate(flightDate)) {
+        cerr << "Cancellation refused: " << flightNumber << " " << flightDate << " is in a sealed month" << endl;
+        return false;
+    }
+    sharedSeats.beginWrite(flightNumber, flightDate);
+    if (sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        sharedSeats.endWrite();
+        return false;
+    }
+
+    sqlite3_stmt* bookingStmt = nullptr;
+    sqlite3_stmt* seatStmt = nullptr;
+    bool ok = sqlite3_prepare_v2(db, "DELETE FROM bookings WHERE id = ?;", -1, &bookingStmt, nullptr) == SQLITE_OK &&
+              sqlite3_prepare_v2(db, "DELETE FROM booked_seats WHERE flight_number = ? AND flight_date = ? "
+                                     "AND seat_number = ?;", -1, &seatStmt, nullptr) == SQLITE_OK;
+    if (ok) {
+        sqlite3_bind_int(bookingStmt, 1, booking->getBookingId());
+        sqlite3_bind_text(seatStmt, 1, flightNumber.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(seatStmt, 2, flightDate.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(seatStmt, 3, booking->getSeatNumber());
+        ok = sqlite3_step(bookingStmt) == SQLITE_DONE && sqlite3_step(seatStmt) == SQLITE_DONE;
+    }
+    sqlite3_finalize(bookingStmt);
+    sqlite3_finalize(seatStmt);
+    int64_t cancelSequence = 0;
+    if (ok && sqlite3_changes(db) == 1) {
+        cancelSequence = BookingLog::takeSequence(db, 1);
+        ok = cancelSequence >= 0;
+    }
+
+    // The freed seat goes straight to the head of the class's waitlist, at the fare they were quoted
+    Booking* next = nullptr;
+    int64_t nextSequence = 0;
+    WaitlistEntry waiting;
+    int popped = ok ? Waitlist::popNext(db, flightNumber, flightDate, seatClass, waiting) : 0;
+    if (popped > 0) {
+        next = new Booking(move(waiting.passengerName), move(waiting.email), move(waiting.phone), flightNumber,
+                           flightDate, booking->getSeatNumber(), waiting.price, seatClass);
+        ok = writeBookings({next}, 0, nextSequence);
+    } else if (popped < 0) {
+        ok = false;
+    }
+
+    if (!ok || sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        cerr << "Cancellation failed: " << sqlite3_errmsg(db) << endl;
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        sharedSeats.endWrite();
+        delete next;
+        return false;
+    }
+    logBooking(BookingEvent::CANCELLED, booking, cancelSequence);
+    if (next) {
+        logBooking(BookingEvent::BOOKED, next, nextSequence);
+    }
+    sharedSeats.endWrite();
+    if (next) {
+        cout << "Seat " << next->getSeatNumber() << " on " << flightNumber << " " << flightDate
+             << " passed to waitlisted passenger " << next->getPassengerName() << endl;
+    }
+    *promoted = next;
+    return true;
+}
+
+bool ReservationSystem::isSealedDate(const string& date) {
+    return db && partitions.schemaFor(db, date, currentTime()) != "main";
+}
+
+int64_t ReservationSystem::joinWaitlist(const Flight* flight, const string& seatClass, string passengerName,
+                                        string email, string phone) {
+    if (!db) return 0;
+
+    WaitlistEntry entry;
+    entry.flightNumber = flight->getFlightNumber();
+    entry.flightDate = flight->getDate();
+    entry.seatClass = Flight::seatClassName(Flight::seatClassIndex(seatClass));
+    entry.passengerName = move(passengerName);
+    entry.email = move(email);
+    entry.phone = move(phone);
+    entry.requestedAt = currentTime();
+    entry.price = quotes.quote(*flight, seatClass, entry.requestedAt);
+    return Waitlist::join(db, entry) ? entry.id : 0;
+}
+
+bool ReservationSystem::leaveWaitlist(int64_t entryId) {
+    return Waitlist::leave(db, entryId);
+}
+
+int ReservationSystem::getWaitlistPosition(int64_t entryId) const {
+    return Waitlist::position(db, entryId);
+}
+
+int ReservationSystem::getWaitlistLength(const Flight* flight, const string& seatClass) const {
+    return Waitlist::length(db, flight->getFlightNumber(), flight->getDate(), seatClass);
 }
 
 void ReservationSystem::initDatabase() {
-    int rc = sqlite3_open("spaazm_flights.db", &db);
+    int rc = sqlite3_open(DATABASE_PATH, &db);
     if (rc) {
         cerr << "Failed to open database: " << sqlite3_errmsg(db) << endl;
         db = nullptr;
@@ -311,6 +1232,36 @@ void ReservationSystem::initDatabase() {
     
     cout << "Database opened successfully" << endl;
     
+    // Takes effect only on a new file; free pages are then returned in slices by the compactor
+    sqlite3_exec(db, "PRAGMA auto_vacuum = INCREMENTAL;", nullptr, nullptr, nullptr);
+
+    // The schedule maintainer writes on its own connection; WAL keeps readers
+    // unblocked and the busy timeout lets bookings wait out its short transactions
+    sqlite3_exec(db, "PRAGMA journal_mode = WAL;", nullptr, nullptr, nullptr);
+    sqlite3_busy_timeout(db, 5000);
+    
+    if (createSchema(db)) {
+        cout << "Tables created successfully" << endl;
+    }
+    
+    // Bookings written here (waitlist promotions, groups) must not reuse IDs of earlier runs,
+    // including those already moved to the archive
+    sqlite3_stmt* lastId = nullptr;
+    const char* lastIdSql =
+        "SELECT MAX((SELECT IFNULL(MAX(id), 0) FROM bookings), (SELECT IFNULL(MAX(id), 0) FROM bookings_archive));";
+    if (sqlite3_prepare_v2(db, lastIdSql, -1, &lastId, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(lastId) == SQLITE_ROW) {
+            Booking::continueIdsAfter(sqlite3_column_int(lastId, 0));
+        }
+        sqlite3_finalize(lastId);
+    }
+    
+    populateFlights();
+}
+
+bool ReservationSystem::createSchema(sqlite3* db) {
+    if (!db) return false;
+    
     const char* sql = 
         "CREATE TABLE IF NOT EXISTS flights ("
         "flight_number TEXT,"
@@ -322,6 +1273,19 @@ void ReservationSystem::initDatabase() {
         "base_price REAL,"
         "PRIMARY KEY (flight_number, date));"
         
+        "CREATE INDEX IF NOT EXISTS idx_flights_route_date ON flights (source, destination, date);"
+        "CREATE INDEX IF NOT EXISTS idx_flights_date ON flights (date);"
+        
+        "CREATE TABLE IF NOT EXISTS flights_archive ("
+        "flight_number TEXT,"
+        "flight_name TEXT,"
+        "source TEXT,"
+        "destination TEXT,"
+        "date TEXT,"
+        "departure_time TEXT,"
+        "base_price REAL,"
+        "PRIMARY KEY (flight_number, date));"
+        
         "CREATE TABLE IF NOT EXISTS bookings ("
         "id INTEGER PRIMARY KEY,"
         "passenger_name TEXT,"
@@ -334,6 +1298,18 @@ void ReservationSystem::initDatabase() {
         "price REAL,"
         "booking_time INTEGER);"
         
+        "CREATE TABLE IF NOT EXISTS bookings_archive ("
+        "id INTEGER PRIMARY KEY,"
+        "passenger_name TEXT,"
+        "passenger_email TEXT,"
+        "passenger_phone TEXT,"
+        "flight_number TEXT,"
+        "flight_date TEXT,"
+        "seat_number INTEGER,"
+        "seat_class TEXT,"
+        "price REAL,"
+        "booking_time INTEGER);"
+        
         "CREATE TABLE IF NOT EXISTS booked_seats ("
         "flight_number TEXT,"
         "flight_date TEXT,"
@@ -341,6 +1317,90 @@ void ReservationSystem::initDatabase() {
         "passenger_name TEXT,"
         "PRIMARY KEY (flight_number, flight_date, seat_number));"
         
+        "CREATE TABLE IF NOT EXISTS seat_holds ("
+        "flight_number TEXT,"
+        "flight_date TEXT,"
+        "seat_number INTEGER,"
+        "hold_id INTEGER NOT NULL,"
+        "expires_at INTEGER NOT NULL,"
+        "PRIMARY KEY (flight_number, flight_date, seat_number));"
+        
+        "CREATE INDEX IF NOT EXISTS idx_seat_holds_expiry ON seat_holds (expires_at);"
+        "CREATE INDEX IF NOT EXISTS idx_seat_holds_id ON seat_holds (hold_id);"
+        
+        "CREATE TABLE IF NOT EXISTS waitlist ("
+        "id INTEGER PRIMARY KEY,"
+        "flight_number TEXT NOT NULL,"
+        "flight_date TEXT NOT NULL,"
+        "seat_class TEXT NOT NULL,"
+        "requested_at INTEGER NOT NULL,"
+        "passenger_name TEXT,"
+        "passenger_email TEXT,"
+        "passenger_phone TEXT,"
+        "price REAL);"
+        
+        "CREATE INDEX IF NOT EXISTS idx_waitlist_queue ON waitlist (flight_number, flight_date, seat_class, requested_at);"
+        
+        "CREATE TABLE IF NOT EXISTS lowest_fares ("
+        "source TEXT,"
+        "destination TEXT,"
+        "date TEXT,"
+        "seat_class TEXT,"
+        "flight_number TEXT,"
+        "price REAL,"
+        "valid_until INTEGER,"
+        "PRIMARY KEY (source, destination, date, seat_class));"
+        
+        "CREATE TABLE IF NOT EXISTS schedule_meta ("
+        "id INTEGER PRIMARY KEY CHECK (id = 1),"
+        "generation INTEGER);"
+        
+        "CREATE TABLE IF NOT EXISTS schedule_window ("
+        "id INTEGER PRIMARY KEY CHECK (id = 1),"
+        "version INTEGER,"
+        "anchor_day INTEGER,"
+        "first_day INTEGER,"
+        "last_day INTEGER,"
+        "horizon_days INTEGER,"
+        "city_count INTEGER,"
+        "carriers TEXT,"
+        "departure_times TEXT,"
+        "seed INTEGER,"
+        "first_flight_number INTEGER,"
+        "flight_prefix TEXT,"
+        "generated INTEGER NOT NULL DEFAULT 1);"
+        
+        "CREATE TABLE IF NOT EXISTS imported_days ("
+        "date TEXT PRIMARY KEY);"
+        
+        "CREATE TABLE IF NOT EXISTS pricing_rules ("
+        "id INTEGER PRIMARY KEY,"
+        "kind TEXT NOT NULL,"
+        "arg1 TEXT,"
+        "arg2 TEXT,"
+        "value REAL NOT NULL);"
+        
+        "CREATE TABLE IF NOT EXISTS pricing_meta ("
+        "id INTEGER PRIMARY KEY CHECK (id = 1),"
+        "version INTEGER);"
+        
+        "CREATE TRIGGER IF NOT EXISTS pricing_rules_insert AFTER INSERT ON pricing_rules BEGIN "
+        "INSERT OR REPLACE INTO pricing_meta VALUES (1, COALESCE((SELECT version FROM pricing_meta), 0) + 1); END;"
+        "CREATE TRIGGER IF NOT EXISTS pricing_rules_update AFTER UPDATE ON pricing_rules BEGIN "
+        "INSERT OR REPLACE INTO pricing_meta VALUES (1, COALESCE((SELECT version FROM pricing_meta), 0) + 1); END;"
+        "CREATE TRIGGER IF NOT EXISTS pricing_rules_delete AFTER DELETE ON pricing_rules BEGIN "
+        "INSERT OR REPLACE INTO pricing_meta VALUES (1, COALESCE((SELECT version FROM pricing_meta), 0) + 1); END;"
+        
+        "CREATE TABLE IF NOT EXISTS booking_log_state ("
+        "id INTEGER PRIMARY KEY CHECK (id = 1),"
+        "sequence INTEGER NOT NULL);"
+        "INSERT OR IGNORE INTO booking_log_state VALUES (1, 0);"
+        
+        "CREATE TABLE IF NOT EXISTS partition_months ("
+        "month TEXT PRIMARY KEY,"
+        "sealed_at INTEGER,"
+        "archived INTEGER NOT NULL DEFAULT 0);"
+        
         "CREATE TABLE IF NOT EXISTS db_version ("
         "version INTEGER PRIMARY KEY,"
         "expected_routes INTEGER,"
@@ -348,15 +1408,28 @@ void ReservationSystem::initDatabase() {
         "created_at INTEGER);";
     
     char* errMsg = nullptr;
-    rc = sqlite3_exec(db, sql, nullptr, nullptr, &errMsg);
-    if (rc != SQLITE_OK) {
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
         cerr << "SQL error: " << errMsg << endl;
         sqlite3_free(errMsg);
-    } else {
-        cout << "Tables created successfully" << endl;
+        return false;
     }
-    
-    populateFlights();
+
+    // Windows recorded before imports were tracked were all generated
+    sqlite3_stmt* column = nullptr;
+    bool hasGenerated = false;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM pragma_table_info('schedule_window') WHERE name = 'generated';",
+                           -1, &column, nullptr) == SQLITE_OK) {
+        hasGenerated = sqlite3_step(column) == SQLITE_ROW;
+    }
+    sqlite3_finalize(column);
+    if (!hasGenerated &&
+        sqlite3_exec(db, "ALTER TABLE schedule_window ADD COLUMN generated INTEGER NOT NULL DEFAULT 1;",
+                     nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        cerr << "SQL error: " << errMsg << endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+    return true;
 }
 
 void ReservationSystem::populateFlights() {
@@ -365,234 +1438,205 @@ void ReservationSystem::populateFlights() {
         return;
     }
     
-    const int DB_VERSION = 2;  // Increment when flight generation logic changes
-    const int EXPECTED_ROUTES = 90;  // 10 cities, 9 destinations each
-    const int EXPECTED_FLIGHTS = 27000;  // 90 routes × 5 carriers × 60 days
-    
-    // Check database version and validate data integrity
-    sqlite3_stmt* versionCheck = nullptr;
-    int rc = sqlite3_prepare_v2(db, "SELECT version, expected_routes, expected_flights FROM db_version WHERE version = ?;", -1, &versionCheck, nullptr);
-    bool needsRegeneration = true;
-    
-    if (rc == SQLITE_OK) {
-        sqlite3_bind_int(versionCheck, 1, DB_VERSION);
-        if (sqlite3_step(versionCheck) == SQLITE_ROW) {
-            int storedRoutes = sqlite3_column_int(versionCheck, 1);
-            int storedFlights = sqlite3_column_int(versionCheck, 2);
-            
-            if (storedRoutes == EXPECTED_ROUTES && storedFlights == EXPECTED_FLIGHTS) {
-                // Version matches, now verify actual data
-                sqlite3_stmt* countCheck = nullptr;
-                int rc2 = sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM flights;", -1, &countCheck, nullptr);
-                if (rc2 == SQLITE_OK) {
-                    if (sqlite3_step(countCheck) == SQLITE_ROW) {
-                        int actualCount = sqlite3_column_int(countCheck, 0);
-                        if (actualCount == EXPECTED_FLIGHTS) {
-                            cout << "Database already has " << actualCount << " flights (version " << DB_VERSION << ")" << endl;
-                            needsRegeneration = false;
-                        }
-                    }
-                    sqlite3_finalize(countCheck);
-                }
-            }
-        }
-        sqlite3_finalize(versionCheck);
-    }
-    
-    if (!needsRegeneration) {
+    // A recorded window is kept current by the background maintainer
+    GeneratorConfig config;
+    ScheduleWindow window;
+    if (ScheduleGenerator::loadWindow(db, config, window)) {
+        cout << "Schedule window " << ScheduleStore::dateFromDayNumber(window.firstDay) << " - "
+             << ScheduleStore::dateFromDayNumber(window.lastDay) << " (version " << window.version << ")" << endl;
         return;
     }
     
-    // Clear old data if regenerating
-    cout << "Regenerating flight database (version " << DB_VERSION << ")..." << endl;
-    sqlite3_exec(db, "DELETE FROM flights;", nullptr, nullptr, nullptr);
-    sqlite3_exec(db, "DELETE FROM db_version;", nullptr, nullptr, nullptr);
-    
-    // All 10 cities
-    vector<string> cities = {
-        "Mumbai", "Delhi", "Bangalore", "Chennai", "Kolkata",
-        "Hyderabad", "Pune", "Goa", "Jaipur", "Kochi"
-    };
-    
-    // Generate ALL possible city pairs (both directions)
-    // 10 cities × 9 other cities = 90 directional routes
-    vector<pair<string, string>> routes;
-    for (size_t i = 0; i < cities.size(); i++) {
-        for (size_t j = 0; j < cities.size(); j++) {
-            if (i != j) {  // Don't create routes from city to itself
-                routes.push_back({cities[i], cities[j]});
-            }
+    // Schedules written before the rolling window existed are adopted in place:
+    // their first date is day 0 of the flight numbering. An older version is
+    // rewritten day by day by the maintainer instead of being deleted here.
+    sqlite3_stmt* existing = nullptr;
+    const char* sql =
+        "SELECT MIN(date), MAX(date), COUNT(*), "
+        "(SELECT COUNT(*) FROM db_version WHERE version = ?) FROM flights;";
+    if (sqlite3_prepare_v2(db, sql, -1, &existing, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int(existing, 1, ScheduleGenerator::SCHEDULE_VERSION);
+        if (sqlite3_step(existing) == SQLITE_ROW && sqlite3_column_int64(existing, 2) > 0) {
+            string firstDate = reinterpret_cast<const char*>(sqlite3_column_text(existing, 0));
+            string lastDate = reinterpret_cast<const char*>(sqlite3_column_text(existing, 1));
+            config.anchorDay = ScheduleStore::dayNumberFromDate(firstDate);
+            window.firstDay = config.anchorDay;
+            window.lastDay = ScheduleStore::dayNumberFromDate(lastDate);
+            window.version = sqlite3_column_int(existing, 3) > 0 ? ScheduleGenerator::SCHEDULE_VERSION : 0;
+            window.generated = true;
+            ScheduleGenerator(config).saveWindow(db, window);
+            cout << "Adopted existing schedule " << firstDate << " - " << lastDate << endl;
+            sqlite3_finalize(existing);
+            return;
         }
+        sqlite3_finalize(existing);
     }
     
-    string names[] = {"Sky Express", "Cloud Nine", "Wind Jet", "Star Flight", "Thunder Express"};
-    string times[] = {"06:00", "10:00", "14:00", "18:00", "21:00"};
-    
-    // Generate flights for next 60 days (through January 2026)
-    time_t now = time(nullptr);
-    
-    cout << "Generating flights for all " << routes.size() << " routes..." << endl;
-    
-    sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
-    
-    int flightCounter = 1001;
-    
-    for (int day = 0; day < 60; day++) {
-        time_t futureTime = now + (day * 86400);
-        struct tm* tm = localtime(&futureTime);
-        char dateStr[11];
-        strftime(dateStr, sizeof(dateStr), "%Y-%m-%d", tm);
-        
-        for (size_t r = 0; r < routes.size(); r++) {
-            string source = routes[r].first;
-            string destination = routes[r].second;
-            
-            // Calculate route-based pricing (distance approximation)
-            // Popular/longer routes cost more
-            int routeMultiplier = 100;
-            if (source == "Mumbai" || destination == "Mumbai" ||
-                source == "Delhi" || destination == "Delhi" ||
-                source == "Bangalore" || destination == "Bangalore") {
-                routeMultiplier = 150; // Metro cities cost more
-            }
-            if ((source == "Goa" && destination == "Mumbai") || 
-                (source == "Mumbai" && destination == "Goa") ||
-                (source == "Delhi" && destination == "Bangalore") ||
-                (source == "Bangalore" && destination == "Delhi")) {
-                routeMultiplier = 180; // Popular tourist/business routes
-            }
-            
-            // Base price varies by route with some pseudo-randomness
-            int routeBase = 2000 + (r * 47) % 3000;
-            
-            for (int i = 0; i < 5; i++) {
-                stringstream flightNum;
-                flightNum << "SP" << flightCounter;
-                
-                // Time-based pricing variation
-                double timeMultiplier = 1.0;
-                if (i == 0) timeMultiplier = 0.85;      // Early morning: cheaper
-                else if (i == 1) timeMultiplier = 1.1;  // Mid-morning: expensive
-                else if (i == 2) timeMultiplier = 1.0;  // Afternoon: normal
-                else if (i == 3) timeMultiplier = 1.15; // Evening: most expensive
-                else if (i == 4) timeMultiplier = 0.95; // Night: slightly cheaper
-                
-                // Add carrier-specific variation
-                double carrierMultiplier = 1.0;
-                if (names[i] == "Sky Express") carrierMultiplier = 0.9;      // Budget
-                else if (names[i] == "Cloud Nine") carrierMultiplier = 1.1;  // Premium
-                else if (names[i] == "Wind Jet") carrierMultiplier = 0.95;   // Low-cost
-                else if (names[i] == "Star Flight") carrierMultiplier = 1.05; // Mid-range
-                else if (names[i] == "Thunder Express") carrierMultiplier = 1.0; // Standard
-                
-                // Day-of-week variation (weekends slightly more expensive)
-                double dayMultiplier = 1.0;
-                if (tm->tm_wday == 0 || tm->tm_wday == 6) {
-                    dayMultiplier = 1.08; // Weekend surcharge
-                }
-                
-                // Calculate final base price with all factors
-                int basePrice = (int)(routeBase + routeMultiplier) * 
-                                timeMultiplier * carrierMultiplier * dayMultiplier;
-                
-                // Add small random variation (±5%)
-                int randomVar = ((flightCounter * 17 + day * 13 + i * 7) % 11) - 5;
-                basePrice = basePrice + (basePrice * randomVar / 100);
-                
-                // Ensure minimum price
-                if (basePrice < 1500) basePrice = 1500;
-                
-                stringstream sql;
-                sql << "INSERT OR IGNORE INTO flights VALUES ('"
-                    << flightNum.str() << "','"
-                    << names[i] << "','"
-                    << source << "','"
-                    << destination << "','"
-                    << dateStr << "','"
-                    << dateStr << " " << times[i] << "',"
-                    << basePrice << ");";
-                sqlite3_exec(db, sql.str().c_str(), nullptr, nullptr, nullptr);
-                
-                flightCounter++;
-            }
-        }
+    // Empty database: generate the default window now so the first search has flights
+    cout << "Generating flight database (version " << ScheduleGenerator::SCHEDULE_VERSION << ")..." << endl;
+    ScheduleGenerator generator(config);
+    generator.generate(db);
+}
+
+void ReservationSystem::loadFlights() {
+    if (!db) return;
+
+    // Map the shared snapshot when it reflects the current schedule generation;
+    // otherwise rebuild from SQLite and refresh the snapshot for the next process.
+    // Pages are faulted in as searches touch them, so the payload is not checksummed here.
+    if (schedule.openSnapshot(SCHEDULE_SNAPSHOT_PATH, false) &&
+        schedule.getGeneration() == ScheduleStore::readGeneration(db)) {
+        return;
     }
-    
-    char* errMsg = nullptr;
-    rc = sqlite3_exec(db, "COMMIT;", nullptr, nullptr, &errMsg);
-    if (rc != SQLITE_OK) {
-        cerr << "Failed to commit transaction: " << errMsg << endl;
-        sqlite3_free(errMsg);
-        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-    } else {
-        int totalFlights = flightCounter - 1001;
-        cout << "Successfully populated " << totalFlights << " flights" << endl;
-        cout << "Routes: " << routes.size() << " (all city pairs)" << endl;
-        cout << "Days covered: 60 (November 2025 - January 2026)" << endl;
-        cout << "Expected: " << (routes.size() * 5 * 60) << " flights" << endl;
-        
-        // Store version info
-        const int DB_VERSION = 2;
-        stringstream versionSql;
-        versionSql << "INSERT OR REPLACE INTO db_version VALUES (" 
-                   << DB_VERSION << ", " 
-                   << routes.size() << ", " 
-                   << totalFlights << ", " 
-                   << time(nullptr) << ");";
-        sqlite3_exec(db, versionSql.str().c_str(), nullptr, nullptr, nullptr);
-        
-        cout << "Database version " << DB_VERSION << " set successfully" << endl;
+    if (schedule.load(db)) {
+        schedule.writeSnapshot(SCHEDULE_SNAPSHOT_PATH);
     }
 }
 
-void ReservationSystem::loadFlights() {
-    // Flights loaded on-demand via searchFlights
+void ReservationSystem::syncSchedule() {
+    if (schedule.refreshIfStale(db)) {
+        schedule.writeSnapshot(SCHEDULE_SNAPSHOT_PATH);
+        plannerLoaded = false;
+        lowestFares.reset();
+    }
+}
+
+bool ReservationSystem::readBookedSeats(const Flight* flight, vector<pair<int, string>>& seats) {
+    // Replayed from the booking log while it accounts for every change in booked_seats
+    if (bookingLog.findBookedSeats(flight->getFlightNumber(), flight->getDate(), seats)) return true;
+
+    // Sealed months read from their partition; an archived month has no seats to show
+    string schema = partitions.schemaFor(db, flight->getDate(), currentTime());
+    if (schema.empty()) return false;
+
+    // The schema is a name from MonthPartitions, not input; the flight is bound
+    sqlite3_stmt* stmt;
+    string sql = "SELECT seat_number, passenger_name FROM " + schema + ".booked_seats "
+                 "WHERE flight_number = ? AND flight_date = ?;";
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, flight->getFlightNumber().c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, flight->getDate().c_str(), -1, SQLITE_STATIC);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            seats.emplace_back(sqlite3_column_int(stmt, 0),
+                               reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)));
+        }
+        sqlite3_finalize(stmt);
+    }
+    return true;
 }
 
 void ReservationSystem::loadBookedSeats(Flight* flight) {
     if (!db) return;
-    
-    stringstream ss;
-    ss << "SELECT seat_number, passenger_name FROM booked_seats "
-       << "WHERE flight_number = '" << flight->getFlightNumber() << "' "
-       << "AND flight_date = '" << flight->getDepartureTime().substr(0, 10) << "';";
-    
+
+    uint32_t ticket = sharedSeats.fillTicket(flight->getFlightNumber(), flight->getDate());
     sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, ss.str().c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+    vector<pair<int, string>> booked;
+    if (!readBookedSeats(flight, booked)) return;
+    for (const auto& seat : booked) {
+        flight->bookSeat(seat.first, seat.second);
+    }
+
+    // Live holds of every session, so seats in someone's booking form show as taken
+    time_t now = currentTime();
+    const char* holdSql =
+        "SELECT hold_id, seat_number, expires_at FROM seat_holds "
+        "WHERE flight_number = ? AND flight_date = ? AND expires_at > ?;";
+    if (sqlite3_prepare_v2(db, holdSql, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, flight->getFlightNumber().c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, flight->getDate().c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 3, now);
         while (sqlite3_step(stmt) == SQLITE_ROW) {
-            int seatNum = sqlite3_column_int(stmt, 0);
-            string passengerName = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-            flight->bookSeat(seatNum, passengerName);
+            uint64_t holdId = (uint64_t)sqlite3_column_int64(stmt, 0);
+            int seatNum = sqlite3_column_int(stmt, 1);
+            if (flight->holdSeat(seatNum, holdId)) {
+                seatHolds.track(holdId, flight->getFlightNumberId(), flight->getDateId(), seatNum,
+                                sqlite3_column_int64(stmt, 2), now);
+            }
         }
         sqlite3_finalize(stmt);
     }
+    seatInventory.publish(*flight);
+    if (sharedSeats.isAttached()) {
+        sharedSeats.publish(*flight, ticket, now + SeatHolds::HOLD_SECONDS);
+    }
 }
 
-void ReservationSystem::saveBooking(Booking* booking) {
-    if (!db) return;
-    
-    stringstream ss;
-    ss << "INSERT INTO bookings VALUES (" 
-       << booking->getBookingId() << ",'"
-       << booking->getPassengerName() << "','"
-       << booking->getEmail() << "','"
-       << booking->getPhone() << "','"
-       << booking->getFlightNumber() << "','"
-       << booking->getFlightDate() << "',"
-       << booking->getSeatNumber() << ",'" 
-       << booking->getSeatClass() << "',"
-       << booking->getPrice() << ","
-       << booking->getBookingTime() << ");";
-    
-    sqlite3_exec(db, ss.str().c_str(), nullptr, nullptr, nullptr);
-    
-    // Save to booked_seats
-    stringstream ss2;
-    ss2 << "INSERT INTO booked_seats VALUES ('"
-        << booking->getFlightNumber() << "','"
-        << booking->getFlightDate() << "',"
-        << booking->getSeatNumber() << ",'" 
-        << booking->getPassengerName() << "');";
-    
-    sqlite3_exec(db, ss2.str().c_str(), nullptr, nullptr, nullptr);
+bool ReservationSystem::saveGroup(const vector<Booking*>& group, uint64_t holdId) {
+    if (!db) return false;
+
+    if (!group.empty()) {
+        sharedSeats.beginWrite(group[0]->getFlightNumber(), group[0]->getFlightDate());
+    }
+    if (sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        sharedSeats.endWrite();
+        return false;
+    }
+    int64_t lastSequence = 0;
+    if (!writeBookings(group, holdId, lastSequence) ||
+        sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        sharedSeats.endWrite();
+        return false;
+    }
+    for (size_t i = 0; i < group.size(); i++) {
+        logBooking(BookingEvent::BOOKED, group[i], lastSequence - (int64_t)(group.size() - 1 - i));
+    }
+    sharedSeats.endWrite();
+    return true;
+}
+
+bool ReservationSystem::writeBookings(const vector<Booking*>& group, uint64_t holdId, int64_t& lastSequence) {
+    sqlite3_stmt* bookingStmt = nullptr;
+    sqlite3_stmt* seatStmt = nullptr;
+    const char* bookingSql = "INSERT INTO bookings VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
+    const char* seatSql = "INSERT INTO booked_seats VALUES (?, ?, ?, ?);";
+
+    // booked_seats is keyed by seat, so a seat taken by another process fails the whole group
+    bool ok = sqlite3_prepare_v2(db, bookingSql, -1, &bookingStmt, nullptr) == SQLITE_OK &&
+              sqlite3_prepare_v2(db, seatSql, -1, &seatStmt, nullptr) == SQLITE_OK;
+    if (ok && holdId != 0) {
+        // The hold must still be live: once expired, another session may have taken the seat over
+        sqlite3_stmt* holdStmt = nullptr;
+        ok = sqlite3_prepare_v2(db, "DELETE FROM seat_holds WHERE hold_id = ? AND expires_at > ?;", -1, &holdStmt,
+                                nullptr) == SQLITE_OK;
+        if (ok) {
+            sqlite3_bind_int64(holdStmt, 1, (sqlite3_int64)holdId);
+            sqlite3_bind_int64(holdStmt, 2, currentTime());
+            ok = sqlite3_step(holdStmt) == SQLITE_DONE && sqlite3_changes(db) == 1;
+        }
+        sqlite3_finalize(holdStmt);
+    }
+    for (size_t i = 0; ok && i < group.size(); i++) {
+        const Booking* booking = group[i];
+        sqlite3_bind_int(bookingStmt, 1, booking->getBookingId());
+        sqlite3_bind_text(bookingStmt, 2, booking->getPassengerName().c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(bookingStmt, 3, booking->getEmail().c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(bookingStmt, 4, booking->getPhone().c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(bookingStmt, 5, booking->getFlightNumber().c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(bookingStmt, 6, booking->getFlightDate().c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(bookingStmt, 7, booking->getSeatNumber());
+        sqlite3_bind_text(bookingStmt, 8, booking->getSeatClass().c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_double(bookingStmt, 9, booking->getPrice());
+        sqlite3_bind_int64(bookingStmt, 10, booking->getBookingTime());
+        ok = sqlite3_step(bookingStmt) == SQLITE_DONE;
+        sqlite3_reset(bookingStmt);
+
+        sqlite3_bind_text(seatStmt, 1, booking->getFlightNumber().c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(seatStmt, 2, booking->getFlightDate().c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(seatStmt, 3, booking->getSeatNumber());
+        sqlite3_bind_text(seatStmt, 4, booking->getPassengerName().c_str(), -1, SQLITE_STATIC);
+        ok = ok && sqlite3_step(seatStmt) == SQLITE_DONE;
+        sqlite3_reset(seatStmt);
+    }
+    if (ok) {
+        lastSequence = BookingLog::takeSequence(db, (int)group.size());
+        ok = lastSequence >= 0;
+    }
+    if (!ok) {
+        cerr << "Booking write failed: " << sqlite3_errmsg(db) << endl;
+    }
+    sqlite3_finalize(bookingStmt);
+    sqlite3_finalize(seatStmt);
+    return ok;
 }
@@ -19,6 +19,26 @@
 #include <iomanip>
 #include <cmath>
 #include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <string_view>
+#include <iterator>
+#include <functional>
+#include "string_interner.h"
+#include "time_core.h"
+#include "itinerary_planner.h"
+#include "lowest_fare_index.h"
+#include "schedule_store.h"
+#include "schedule_generator.h"
+#include "schedule_maintainer.h"
+#include "pricing_rules.h"
+#include "quote_cache.h"
+#include "seat_holds.h"
+#include "booking_analytics.h"
+#include "month_partitions.h"
+#include "seat_inventory.h"
+#include "booking_log.h"
+#include "shared_seat_map.h"
 
 struct sqlite3;  // Forward declaration for SQLite database handle
 
@@ -26,6 +46,67 @@ using namespace std;
 
 // ==================== BACKEND CLASSES ====================
 
+class Seat;
+
+/**
+ * @class BasicSeatRange
+ * @brief Non-allocating view over a contiguous run of seats
+ *
+ * Iterates as Seat pointers, so range-for code written against
+ * vector<Seat*> keeps working. With availableOnly set, booked and held
+ * seats are skipped; size() then counts instead of subtracting.
+ */
+template <typename SeatT>
+class BasicSeatRange {
+public:
+    class iterator {
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef SeatT* value_type;
+        typedef ptrdiff_t difference_type;
+        typedef SeatT* const* pointer;
+        typedef SeatT* reference;
+
+        iterator(SeatT* current, SeatT* last, bool availableOnly)
+            : current(current), last(last), availableOnly(availableOnly) { skipUnavailable(); }
+        SeatT* operator*() const { return current; }
+        iterator& operator++() { ++current; skipUnavailable(); return *this; }
+        iterator operator++(int) { iterator previous = *this; ++*this; return previous; }
+        bool operator==(const iterator& other) const { return current == other.current; }
+        bool operator!=(const iterator& other) const { return current != other.current; }
+
+    private:
+        SeatT* current;
+        SeatT* last;
+        bool availableOnly;
+        void skipUnavailable() {
+            while (availableOnly && current != last && !current->isAvailable()) ++current;
+        }
+    };
+
+    BasicSeatRange() : first(nullptr), last(nullptr), availableOnly(false) {}
+    BasicSeatRange(SeatT* first, SeatT* last, bool availableOnly)
+        : first(first), last(last), availableOnly(availableOnly) {}
+
+    iterator begin() const { return iterator(first, last, availableOnly); }
+    iterator end() const { return iterator(last, last, availableOnly); }
+    bool empty() const { return begin() == end(); }
+    SeatT* operator[](size_t i) const { return first + i; }  ///< Only meaningful without availableOnly
+    size_t size() const {
+        if (!availableOnly) return last - first;
+        size_t count = 0;
+        for (SeatT* seat = first; seat != last; ++seat) {
+            if (seat->isAvailable()) count++;
+        }
+        return count;
+    }
+
+private:
+    SeatT* first;
+    SeatT* last;
+    bool availableOnly;
+};
+
 /**
  * @class Seat
  * @brief Represents a single seat on a flight
@@ -36,8 +117,9 @@ using namespace std;
 class Seat {
 private:
     int seatNumber;        ///< Seat number (1-100)
-    string seatClass;      ///< "First", "Business", or "Economy"
+    InternId seatClass;    ///< "First", "Business", or "Economy"
     bool isBooked;         ///< Availability status
+    uint64_t holdId;       ///< Seat hold awaiting a booking, 0 if none
     string passengerName;  ///< Name of passenger if booked, empty otherwise
 
 public:
@@ -46,26 +128,40 @@ public:
      * @param number Seat number (1-100)
      * @param sClass Seat class ("First", "Business", or "Economy")
      */
-    Seat(int number, string sClass);
+    Seat(int number, string_view sClass);
+    Seat(int number, InternId sClass);
     
     // Getters
     int getSeatNumber() const { return seatNumber; }
-    string getSeatClass() const { return seatClass; }
+    const string& getSeatClass() const { return internedText(seatClass); }
     bool getIsBooked() const { return isBooked; }
-    string getPassengerName() const { return passengerName; }
+    uint64_t getHoldId() const { return holdId; }
+    bool isHeld() const { return holdId != 0; }
+    bool isAvailable() const { return !isBooked && holdId == 0; }  ///< Neither booked nor held
+    const string& getPassengerName() const { return passengerName; }
 
     /**
      * @brief Books this seat for a passenger
      * @param name Passenger's full name
+     *
+     * Reuses the name buffer, so rebooking a seat does not allocate.
      */
-    void bookSeat(string name);
+    void bookSeat(string_view name);
     
     /**
      * @brief Cancels booking and frees this seat
      */
     void cancelBooking();
+
+    /**
+     * @brief Sets or clears (0) the hold on this seat
+     */
+    void setHold(uint64_t id) { holdId = id; }
 };
 
+typedef BasicSeatRange<Seat> SeatRange;             ///< Mutable seat view
+typedef BasicSeatRange<const Seat> ConstSeatRange;  ///< Read-only seat view
+
 /**
  * @class Flight
  * @brief Represents a complete flight with 100 seats
@@ -75,21 +171,37 @@ public:
  */
 class Flight {
 private:
-    string flightNumber;        ///< Unique identifier (e.g., "SP1001")
-    string flightName;          ///< Display name (e.g., "Sky Express")
-    string source;              ///< Departure city
-    string destination;         ///< Arrival city
-    string departureTime;       ///< Full datetime string (YYYY-MM-DD HH:MM)
+    InternId flightNumber;      ///< Unique identifier (e.g., "SP1001")
+    InternId flightName;        ///< Display name (e.g., "Sky Express")
+    InternId source;            ///< Departure city
+    InternId destination;       ///< Arrival city
+    InternId departureTime;     ///< Full datetime string (YYYY-MM-DD HH:MM)
+    InternId date;              ///< Departure date (YYYY-MM-DD)
     double basePrice;           ///< Starting price in INR
     int totalSeats;             ///< Always 100
-    vector<Seat*> seats;        ///< Composition: Flight owns 100 Seat objects
-    time_t departureTimestamp;  ///< Unix timestamp for time calculations
+    vector<Seat> seats;         ///< Composition: 100 contiguous seats, grouped by class
+    CivilTime departure;        ///< Departure broken down once (timestamp, hour, weekday)
+    int bookedCount;            ///< Booked seats, kept in step by bookSeat()/cancelSeat()
+    int heldCount;              ///< Held seats, kept in step by holdSeat()/releaseSeatHold()
+    uint64_t occupancyEpoch;    ///< Changes with every booking or cancellation; unique process-wide
+    uint64_t freeSeatBits[2];   ///< Bit n-1 set while seat n is neither booked nor held; scanned for group blocks
 
     /**
      * @brief Initializes 100 seat objects with appropriate classes
      */
     void initializeSeats();
 
+    /**
+     * @brief Index range [first, last) of a class within seats
+     * @return false for an unknown class
+     */
+    static bool classSlice(string_view seatClass, size_t& first, size_t& last);
+
+    /**
+     * @brief Free-seat bits for count (at most 64) consecutive seats starting at firstSeat
+     */
+    uint64_t freeBits(int firstSeat, int count) const;
+
 public:
     /**
      * @brief Constructs a new Flight object
@@ -101,21 +213,33 @@ public:
      * @param price Base price in INR
      * @param depTimestamp Departure as Unix timestamp
      */
-    Flight(string fNumber, string fName, string src, string dest, string depTime, double price, time_t depTimestamp);
-    
-    /**
-     * @brief Destructor - frees all 100 Seat objects
-     */
-    ~Flight();
+    Flight(string_view fNumber, string_view fName, string_view src, string_view dest, string_view depTime,
+           double price, time_t depTimestamp);
 
     // Getters
-    string getFlightNumber() const { return flightNumber; }
-    string getFlightName() const { return flightName; }
-    string getSource() const { return source; }
-    string getDestination() const { return destination; }
-    string getDepartureTime() const { return departureTime; }
+    const string& getFlightNumber() const { return internedText(flightNumber); }
+    const string& getFlightName() const { return internedText(flightName); }
+    const string& getSource() const { return internedText(source); }
+    const string& getDestination() const { return internedText(destination); }
+    const string& getDepartureTime() const { return internedText(departureTime); }
+    const string& getDate() const { return internedText(date); }
+    InternId getFlightNumberId() const { return flightNumber; }
+    InternId getSourceId() const { return source; }
+    InternId getDestinationId() const { return destination; }
+    InternId getDateId() const { return date; }
     double getBasePrice() const { return basePrice; }
-    time_t getDepartureTimestamp() const { return departureTimestamp; }
+    time_t getDepartureTimestamp() const { return departure.timestamp; }
+    int getDepartureHour() const { return departure.hour; }
+    int getDepartureWeekday() const { return departure.weekday; }
+    int getTotalSeats() const { return totalSeats; }
+
+    /**
+     * @brief Tag for cached quotes; a different value means occupancy may have changed
+     *
+     * Epochs come from one process-wide counter, so a Flight reloaded from
+     * the database never reuses an epoch of an earlier copy.
+     */
+    uint64_t getOccupancyEpoch() const { return occupancyEpoch; }
 
     /**
      * @brief Calculates dynamic price based on multiple factors
@@ -125,31 +249,62 @@ public:
      * 
      * Factors: Class (1x-3x), Demand (1x-1.5x), Advance Booking (0.5x-1.15x), Time of Day (0.9x-1.3x)
      */
-    double calculatePrice(string seatClass, time_t bookingTime) const;
+    double calculatePrice(string_view seatClass, time_t bookingTime) const;
+
+    /**
+     * @brief Dynamic pricing formula shared by Flight and schedule-wide planners
+     * @param basePrice Base price in INR
+     * @param seatClass "Economy", "Business", or "First"
+     * @param bookedSeats Seats already booked on the flight
+     * @param totalSeats Seat capacity of the flight
+     * @param departureTimestamp Departure as Unix timestamp
+     * @param departureHour Local departure hour (0-23)
+     * @param bookingTime Current time as Unix timestamp
+     * @return Final price in INR after applying all multipliers
+     *
+     * Lets callers that already know the occupancy (e.g. from an aggregate
+     * query) price a flight without materializing its 100 Seat objects.
+     */
+    static double computePrice(double basePrice, string_view seatClass, int bookedSeats, int totalSeats,
+                               time_t departureTimestamp, int departureHour, time_t bookingTime);
+
+    /**
+     * @brief Seat class helpers; classes are indexed First (0), Business (1), Economy (2)
+     */
+    static int seatClassIndex(string_view seatClass);
+    static const char* seatClassName(int index);
+    static int seatClassCapacity(int index);
+    static int seatClassFirstSeat(int index);
+    static int seatClassOfSeat(int seatNumber);  ///< Class index of a seat number
+    static int seatsPerRow(int index);  ///< Cabin row width: 5 in First and Business, 10 in Economy
     
     /**
      * @brief Returns number of booked seats for demand pricing
+     *
+     * Constant time; seat state must change through bookSeat() and cancelSeat().
      */
     int getBookedSeatsCount() const;
     
     /**
-     * @brief Returns number of available seats
+     * @brief Returns number of seats still bookable: neither booked nor held
      */
     int getAvailableSeatsCount() const;
     
     /**
      * @brief Filters available seats by class
      * @param seatClass Target seat class
-     * @return Vector of available Seat pointers
+     * @return View of available seats (empty for an unknown class)
      */
-    vector<Seat*> getAvailableSeatsByClass(string seatClass) const;
+    SeatRange getAvailableSeatsByClass(string_view seatClass);
+    ConstSeatRange getAvailableSeatsByClass(string_view seatClass) const;
     
     /**
      * @brief Returns all seats by class (both booked and available)
      * @param seatClass Target seat class
-     * @return Vector of all Seat pointers in the class
+     * @return View of the class's seats (empty for an unknown class)
      */
-    vector<Seat*> getSeatsByClass(string seatClass) const;
+    SeatRange getSeatsByClass(string_view seatClass);
+    ConstSeatRange getSeatsByClass(string_view seatClass) const;
     
     /**
      * @brief Finds seat by number
@@ -164,7 +319,7 @@ public:
      * @param passengerName Passenger's name
      * @return true if successful, false if seat unavailable
      */
-    bool bookSeat(int seatNumber, string passengerName);
+    bool bookSeat(int seatNumber, string_view passengerName);
     
     /**
      * @brief Cancels a seat booking
@@ -172,8 +327,54 @@ public:
      * @return true if successful
      */
     bool cancelSeat(int seatNumber);
+
+    /**
+     * @brief Holds a free seat for a pending booking
+     * @param seatNumber Seat to hold (1-100)
+     * @param holdId Hold id, not 0
+     * @return false if the seat is booked, already held or invalid
+     *
+     * Held seats cannot be booked or grouped, but do not count toward
+     * demand pricing or change the occupancy epoch.
+     */
+    bool holdSeat(int seatNumber, uint64_t holdId);
+
+    /**
+     * @brief Frees a held seat
+     * @return false if the seat is not held by holdId
+     */
+    bool releaseSeatHold(int seatNumber, uint64_t holdId);
+
+    /**
+     * @brief Books a seat held by holdId, consuming the hold
+     * @return false if the seat is not held by holdId
+     */
+    bool bookHeldSeat(int seatNumber, uint64_t holdId, string_view passengerName);
+
+    /**
+     * @brief Finds count adjacent free seats in one class without booking them
+     * @param seatClass "Economy", "Business", or "First"
+     * @param count Group size
+     * @param seatNumbers Set to the chosen seats, ascending
+     * @return false if the class has no such block
+     *
+     * Groups that fit in a row get a contiguous run in a single row (the
+     * fullest row that still fits, keeping long runs free). Larger groups
+     * get consecutive whole rows plus a run in the row before or after.
+     * Works on row bit masks; no Seat objects are visited.
+     */
+    bool findAdjacentSeats(string_view seatClass, int count, vector<int>& seatNumbers) const;
+
+    /**
+     * @brief Books several seats, all or none
+     * @param seatNumbers Seats to book
+     * @param passengerNames One name per seat
+     * @return false (nothing booked) if any seat is taken, invalid or repeated
+     */
+    bool bookSeats(const vector<int>& seatNumbers, const vector<string>& passengerNames);
     
-    const vector<Seat*>& getAllSeats() const { return seats; }
+    SeatRange getAllSeats() { return SeatRange(seats.data(), seats.data() + seats.size(), false); }
+    ConstSeatRange getAllSeats() const { return ConstSeatRange(seats.data(), seats.data() + seats.size(), false); }
 };
 
 /**
@@ -190,12 +391,12 @@ private:
     string passengerName;       ///< Full name of passenger
     string email;               ///< Email address (validated)
     string phone;               ///< Phone number
-    string flightNumber;        ///< Associated flight number
-    string flightDate;          ///< Flight date (YYYY-MM-DD)
+    InternId flightNumber;      ///< Associated flight number
+    InternId flightDate;        ///< Flight date (YYYY-MM-DD)
     int seatNumber;             ///< Assigned seat (1-100)
     double price;               ///< Final price paid (after dynamic pricing)
     time_t bookingTime;         ///< When booking was made (Unix timestamp)
-    string seatClass;           ///< "Economy", "Business", or "First"
+    InternId seatClass;         ///< "Economy", "Business", or "First"
 
 public:
     /**
@@ -209,17 +410,31 @@ public:
      * @param p Price paid
      * @param sClass Seat class
      */
-    Booking(string name, string mail, string ph, string fNumber, string fDate, int seat, double p, string sClass);
+    Booking(string name, string mail, string ph, string_view fNumber, string_view fDate, int seat, double p,
+            string_view sClass);
+
+    /**
+     * @brief Restores a booking saved earlier, keeping its ID and booking time
+     */
+    Booking(int id, string name, string mail, string ph, string_view fNumber, string_view fDate, int seat, double p,
+            string_view sClass, time_t bookedAt);
+
+    /**
+     * @brief Makes new booking IDs continue after lastId (never moves them back)
+     */
+    static void continueIdsAfter(int lastId);
 
     int getBookingId() const { return bookingId; }
-    string getPassengerName() const { return passengerName; }
-    string getEmail() const { return email; }
-    string getPhone() const { return phone; }
-    string getFlightNumber() const { return flightNumber; }
-    string getFlightDate() const { return flightDate; }
+    const string& getPassengerName() const { return passengerName; }
+    const string& getEmail() const { return email; }
+    const string& getPhone() const { return phone; }
+    const string& getFlightNumber() const { return internedText(flightNumber); }
+    const string& getFlightDate() const { return internedText(flightDate); }
     int getSeatNumber() const { return seatNumber; }
     double getPrice() const { return price; }
-    string getSeatClass() const { return seatClass; }
+    const string& getSeatClass() const { return internedText(seatClass); }
+    InternId getFlightNumberId() const { return flightNumber; }
+    InternId getFlightDateId() const { return flightDate; }
     time_t getBookingTime() const { return bookingTime; }
 };
 
@@ -232,9 +447,37 @@ public:
  */
 class ReservationSystem {
 private:
+    static const char* DATABASE_PATH;           ///< SQLite database file
+    static const char* SCHEDULE_SNAPSHOT_PATH;  ///< mmap-able schedule shared by all processes
+    static const char* BOOKING_LOG_PATH;        ///< Event log of seat changes appended by all processes
+    static const size_t MAX_LOADED_FLIGHTS = 4096;  ///< loadFlight() bound on flights kept in memory
+
     vector<Flight*> flights;    ///< Currently loaded flights (from search)
+    unordered_map<uint64_t, Flight*> flightIndex;  ///< internPair(number, date) -> loaded flight
     vector<Booking*> bookings;  ///< All bookings (in-memory cache)
     sqlite3* db;                ///< Database connection handle
+    ScheduleStore schedule;     ///< Columnar copy of the flights table
+    ConnectionScanPlanner planner;  ///< Schedule-wide connections for itinerary search
+    bool plannerLoaded;             ///< True once planner holds the full schedule
+    LowestFareIndex lowestFares;    ///< Materialized cheapest fare per route/day/class
+    BookingAnalytics analytics;     ///< Revenue and load-factor rollups, loaded on first use
+    bool analyticsStale;            ///< Rollups may have missed seat changes; reloaded on next use
+    ScheduleMaintainer maintainer;  ///< Rolls the schedule window forward in the background
+    PricingRulesWatcher pricingRules;  ///< Hot-reloads fare factors from pricing_rules
+    QuoteCache quotes;              ///< Seat quotes tagged with occupancy epochs, plus price locks
+    SeatHolds seatHolds;            ///< Seats held for open booking forms, expired by a timing wheel
+    MonthPartitions partitions;     ///< Sealed months of departed flights and seats, attached on demand
+    SeatInventory seatInventory;    ///< Published seat snapshots of loaded flights, for lock-free readers
+    long long seenDataVersion;      ///< PRAGMA data_version at the last syncSeatInventory(); -1 before the first
+    BookingLog bookingLog;          ///< Seat change events; replays booked seats of live flights at startup
+    bool seatsCovered;              ///< The booking log matched booked_seats at the last expireHolds()
+    function<void(Flight*, const vector<int>&)> seatChangeListener;  ///< See setSeatChangeListener()
+    SharedSeatMap sharedSeats;      ///< Seat maps shared with processes on this machine; see attachSharedSeats()
+    uint64_t seenBaselines;         ///< Booking log baselines written when the shared maps were last cleared
+    unordered_set<uint64_t> ownBookingEvents;  ///< Own bookings and cancellations not yet read back from the log
+    int64_t plannerThrough;         ///< Booking log sequence read just before the planner loaded its occupancy
+    int64_t lowestFaresThrough;     ///< Same for the lowest fare index
+    int64_t analyticsThrough;       ///< Same for the analytics rollups
     
     /**
      * @brief Clears currently loaded flights from memory
@@ -249,27 +492,142 @@ private:
     
     /**
      * @brief Populates database with flight schedules
-     * Generates 5,400 flights (36 routes × 5 flights × 30 days)
-     * Only runs if database is empty
+     * Generates the default 60-day window on an empty database; an existing
+     * schedule is left to the ScheduleMaintainer to roll forward
      */
     void populateFlights();
     
     /**
-     * @brief Placeholder for on-demand flight loading
+     * @brief Loads the schedule store, preferring the mapped snapshot
+     * Falls back to the flights table and rewrites the snapshot if stale
      */
     void loadFlights();
+
+    /**
+     * @brief Reloads the schedule store if the flights table changed
+     * Drops schedule-derived indexes so they rebuild from the new copy
+     */
+    void syncSchedule();
     
     /**
-     * @brief Loads booked seats from database for a flight
+     * @brief Loads booked seats and live seat holds from database for a flight
      * @param flight Flight object to update with booking status
      */
     void loadBookedSeats(Flight* flight);
-    
+
+    /**
+     * @brief Booked seats of a flight from the replayed booking log, else from its database
+     * @param seats Receives seat number and passenger name of every booked seat
+     * @return false if the flight's month was archived and its seats are gone
+     */
+    bool readBookedSeats(const Flight* flight, vector<pair<int, string>>& seats);
+
+    /**
+     * @brief Brings loaded flights up to date with seat changes read from the booking log
+     * @param events Events tailed by BookingLog::catchUp(), from every session
+     * @param covered The replayed booked seats match the database
+     *
+     * Booked seats of each affected flight are compared with the replayed
+     * state (or the database while the log has a gap), then other sessions'
+     * holds and releases are applied in log order. Changed flights are
+     * republished and passed to the seat change listener. Other sessions'
+     * bookings and cancellations of any flight also go to the planner, the
+     * lowest fare index and the analytics rollups.
+     */
+    void applySeatChanges(const vector<BookingEvent>& events, bool covered);
+
+    /**
+     * @brief Applies another session's booking (+1) or cancellation (-1) to the derived indexes
+     *
+     * An index loaded after the change was committed already counts it and is skipped.
+     */
+    void applyOtherBooking(const BookingEvent& event);
+
+    /**
+     * @brief Key of an own booking log event in ownBookingEvents
+     */
+    static uint64_t ownEventKey(uint8_t type, int64_t bookingId) {
+        return (uint64_t)bookingId * 2 + (type == BookingEvent::CANCELLED ? 1 : 0);
+    }
+
+    /**
+     * @brief Republishes a loaded flight's seats, or withdraws the flight if it is not loaded
+     */
+    void publishSeats(InternId flightNumber, InternId flightDate);
+
+    /**
+     * @brief Withdraws every seat snapshot once another connection has written to the database
+     * @param covered The booking log accounts for every seat change, so applySeatChanges() republishes instead
+     */
+    void syncSeatInventory(bool covered);
+
+    /**
+     * @brief Brings the shared seat maps up to date after a catch-up of the booking log
+     * @param events Events tailed by BookingLog::catchUp(); bookings of processes not
+     *               attached to the maps reach them this way
+     * @param covered The booking log accounts for every seat change
+     * @param refill Loaded flights whose maps were dropped, with fill tickets taken before the catch-up
+     */
+    void syncSharedSeats(const vector<BookingEvent>& events, bool covered,
+                         const vector<pair<Flight*, uint32_t>>& refill);
+
+    /**
+     * @brief Table holding the flights of a departed date
+     * @return "main.flights_archive", a month partition's flights table, or "" if the
+     *         date has not departed or its month was archived
+     */
+    string departedFlightsTable(const string& date);
+
+    /**
+     * @brief Writes a group's bookings and booked seats in one transaction
+     * @param holdId If not 0, this live seat hold is deleted in the same transaction
+     * @return false (everything rolled back) if any row could not be written or the hold is gone
+     */
+    bool saveGroup(const vector<Booking*>& group, uint64_t holdId = 0);
+
+    /**
+     * @brief saveGroup() without the transaction, for callers that already opened one
+     * @param lastSequence Set to the booking log sequence number of the group's last seat
+     */
+    bool writeBookings(const vector<Booking*>& group, uint64_t holdId, int64_t& lastSequence);
+
     /**
-     * @brief Persists booking to database
-     * @param booking Booking object to save
+     * @brief Appends a committed booking or cancellation to the booking log
      */
-    void saveBooking(Booking* booking);
+    void logBooking(uint8_t type, const Booking* booking, int64_t sequence);
+
+    /**
+     * @brief Appends a seat hold placed or given up by this session to the booking log
+     */
+    void logHold(uint8_t type, uint64_t holdId, InternId flightNumber, InternId flightDate, int seatNumber);
+
+    /**
+     * @brief Reads a booking made by an earlier run or another process
+     * @return The booking (not yet in bookings), or nullptr if no such row exists
+     */
+    Booking* loadBooking(int bookingId);
+
+    /**
+     * @brief Deletes a booking's rows and hands its seat to the head of the waitlist, in one transaction
+     * @param promoted Set to the promoted passenger's new booking, or nullptr if nobody waits
+     * @return false if the transaction failed and was rolled back, or if the
+     *         flight's month is sealed into a partition; nothing changed then
+     */
+    bool releaseBookedSeat(const Booking* booking, Booking** promoted);
+
+    /**
+     * @brief Loads every scheduled flight and its occupancy into the planner
+     * Runs on the first itinerary search after each schedule load
+     */
+    void loadPlanner();
+
+    /**
+     * @brief Moves a YYYY-MM-DD date by a number of days
+     * @param dateStr Date in YYYY-MM-DD format
+     * @param days Days to add (may be negative)
+     * @return Shifted date, or dateStr unchanged if it cannot be parsed
+     */
+    static string shiftDate(const string& dateStr, int days);
 
 public:
     /**
@@ -282,21 +640,229 @@ public:
      */
     ~ReservationSystem();
 
+    /**
+     * @brief Parses a "YYYY-MM-DD HH:MM" departure string
+     * @param depTime Departure datetime string
+     * @param timestamp Receives the local Unix timestamp
+     * @param hour Receives the departure hour
+     * @return true if the string was well formed
+     */
+    static bool parseDepartureTime(const string& depTime, time_t& timestamp, int& hour);
+
+    /**
+     * @brief Database file shared by every process of the system
+     */
+    static const char* getDatabasePath() { return DATABASE_PATH; }
+
+    /**
+     * @brief Creates all tables and indexes if they do not exist
+     * @param db Open database connection
+     * @return true on success
+     */
+    static bool createSchema(sqlite3* db);
+
     /**
      * @brief Searches for flights matching criteria
      * @param dateStr Date in YYYY-MM-DD format
      * @param source Departure city
      * @param destination Arrival city
      * 
-     * Queries database, creates Flight objects, and loads booked seats
+     * Slices the schedule store, creates Flight objects, and loads booked seats
      */
     void searchFlights(const string& dateStr, const string& source, const string& destination);
     
+    /**
+     * @brief Loads one flight with its current seat map, without a route search
+     * @param flightNumber Flight number
+     * @param date Flight date (YYYY-MM-DD)
+     * @return The flight, or nullptr if it is not scheduled
+     *
+     * A copy loaded earlier is replaced, so seats booked or freed by other
+     * processes since then are seen. The flight joins getFlights() until the
+     * next search; past MAX_LOADED_FLIGHTS loaded flights the set is cleared first.
+     */
+    Flight* loadFlight(const string& flightNumber, const string& date);
+
+    /**
+     * @brief Gets the in-memory schedule store
+     */
+    const ScheduleStore& getSchedule() const { return schedule; }
+
     /**
      * @brief Gets all unique cities from database
      * @return Sorted list of city names for dropdown population
      */
     vector<string> getUniqueCities() const;
+
+    /**
+     * @brief Seats a group together and records all its bookings in one transaction
+     * @param flight A flight from the last search
+     * @param seatClass "Economy", "Business", or "First"
+     * @param passengerNames One name per traveller; the group size
+     * @param email Contact email for the group
+     * @param phone Contact phone for the group
+     * @return One booking per passenger, or empty if no adjacent block is free or
+     *         the write failed; nothing is booked in that case
+     *
+     * Every seat is charged the fare quoted for the class before the group
+     * was seated.
+     */
+    vector<Booking*> bookGroup(Flight* flight, const string& seatClass, const vector<string>& passengerNames,
+                               const string& email, const string& phone);
+
+    /**
+     * @brief Current fare for one seat, served from the quote cache
+     * @param flight A flight from the last search
+     * @param seatClass "Economy", "Business", or "First"
+     */
+    double quotePrice(const Flight* flight, const string& seatClass);
+
+    /**
+     * @brief Quotes a fare and holds it for QuoteCache::PRICE_LOCK_SECONDS
+     * @return The lock; show its price and redeem its token when booking
+     */
+    PriceLock lockPrice(const Flight* flight, const string& seatClass);
+
+    /**
+     * @brief Fare to charge for a locked quote
+     * @param price Set to the locked fare on success
+     * @return false if the lock expired or does not match; quote again in that case
+     */
+    bool redeemPriceLock(uint64_t token, const Flight* flight, const string& seatClass, double& price);
+
+    /**
+     * @brief Drops a price lock that will not be booked (token 0 is ignored)
+     */
+    void releasePriceLock(uint64_t token);
+
+    /**
+     * @brief Holds a seat for this session while its booking form is filled in
+     * @param flight A flight from the last search
+     * @param seatNumber Seat to hold
+     * @return Hold id, or 0 if the seat was taken meanwhile; the flight's seats
+     *         are then reloaded so the seat map shows who has it
+     *
+     * Other sessions see the hold through seat_holds. It lapses after
+     * SeatHolds::HOLD_SECONDS unless booked or released first.
+     */
+    uint64_t holdSeat(Flight* flight, int seatNumber);
+
+    /**
+     * @brief Gives up one of this session's seat holds (id 0 is ignored)
+     */
+    void releaseHold(uint64_t holdId);
+
+    /**
+     * @brief Books the seat of a live hold, deleting the hold in the same transaction
+     * @param holdId A hold from holdSeat()
+     * @param price Final price paid
+     * @return The booking, or nullptr if the hold expired or the write failed
+     */
+    Booking* bookHeldSeat(uint64_t holdId, string passengerName, string email, string phone, double price);
+
+    /**
+     * @brief Frees every seat whose hold is due and applies other sessions' seat changes from the
+     *        booking log to loaded flights; call about once a second
+     */
+    void expireHolds();
+
+    /**
+     * @brief Sets a callback for seat changes made by other sessions
+     * @param listener Called from expireHolds() with a loaded flight and the numbers of its seats that
+     *                 were booked, cancelled, held or released elsewhere; the flight is already updated
+     */
+    void setSeatChangeListener(function<void(Flight* flight, const vector<int>& seatNumbers)> listener) {
+        seatChangeListener = move(listener);
+    }
+
+    /**
+     * @brief Returns the cheapest bookable fare per class for a route and day
+     * @param dateStr Date in YYYY-MM-DD format
+     * @param source Departure city
+     * @param destination Arrival city
+     * @return Materialized fares; O(1) after the index is built
+     */
+    DayFare getLowestFare(const string& dateStr, const string& source, const string& destination);
+
+    /**
+     * @brief Finds the cheapest fare per day and class around a date
+     * @param dateStr Centre date in YYYY-MM-DD format
+     * @param source Departure city
+     * @param destination Arrival city
+     * @param windowDays Days to include on each side of dateStr
+     * @return One entry per day in [dateStr - windowDays, dateStr + windowDays]
+     *
+     * Reads the materialized lowest-fare index: O(1) per day.
+     */
+    vector<DayFare> searchFlexibleDates(const string& dateStr, const string& source, const string& destination,
+                                        int windowDays = 3);
+
+    /**
+     * @brief Revenue and load-factor rollups by route, day, carrier and class
+     * @return Rollups built on first use and rebuilt after the schedule changes
+     *
+     * Bookings and cancellations made through this object update the
+     * rollups as they happen. The returned object may be queried from any
+     * thread, also while this object is in use elsewhere.
+     */
+    const BookingAnalytics& getAnalytics();
+
+    /**
+     * @brief Booking retention and compaction progress of the background maintainer
+     */
+    CompactionStats getCompactionStats() const { return maintainer.getCompactionStats(); }
+
+    /**
+     * @brief Seat snapshots of the loaded flights, for readers on other threads
+     *
+     * Every seat change made through this object publishes the flight's new
+     * snapshot. Readers pin it with SeatInventory::Pin and need no lock, also
+     * while this object is in use elsewhere. Other sessions' changes are
+     * republished by expireHolds(). Snapshots are withdrawn when flights are
+     * unloaded, and after writes by other connections while the booking log
+     * does not account for them; a miss means "read the database".
+     */
+    const SeatInventory& getSeatInventory() const { return seatInventory; }
+
+    /**
+     * @brief Event log of bookings, cancellations and holds, for consumers tailing it
+     *
+     * BookingLog::read() may be called from any thread, also while this
+     * object is in use elsewhere.
+     */
+    const BookingLog& getBookingLog() const { return bookingLog; }
+
+    /**
+     * @brief Shares seat maps of loaded flights with other processes on this machine
+     * @return false if shared memory is unavailable; seats then work through the database alone
+     *
+     * From then on a seat is claimed in shared memory before its hold is
+     * written, so of two attached processes picking the same seat one is
+     * turned away without a database write, and every seat change made
+     * here is visible to the others at once.
+     */
+    bool attachSharedSeats();
+
+    /**
+     * @brief Seat maps shared with other processes, for readers on other threads
+     *
+     * SharedSeatMap::read() may be called from any thread, also while this
+     * object is in use elsewhere. A miss means "read the database".
+     */
+    const SharedSeatMap& getSharedSeats() const { return sharedSeats; }
+
+    /**
+     * @brief Finds direct and connecting itineraries (up to 3 legs)
+     * @param dateStr Travel date in YYYY-MM-DD format
+     * @param source Departure city
+     * @param destination Arrival city
+     * @param seatClass Seat class to price and check availability for
+     * @param options Leg limit, minimum connection time and scan window
+     * @return Pareto-optimal itineraries (arrival time, total price, legs)
+     */
+    vector<Itinerary> searchItineraries(const string& dateStr, const string& source, const string& destination,
+                                        const string& seatClass = "Economy",
+                                        const ItineraryOptions& options = ItineraryOptions());
     
     /**
      * @brief Gets currently loaded flights (from last search)
@@ -313,7 +879,15 @@ public:
      * @param flightNumber Flight number to search for
      * @return Pointer to Flight or nullptr if not found
      */
-    Flight* findFlight(string flightNumber);
+    Flight* findFlight(string_view flightNumber);
+
+    /**
+     * @brief Finds a loaded flight by number and date in O(1)
+     * @param flightNumber Flight number
+     * @param date Flight date (YYYY-MM-DD)
+     * @return Pointer to Flight or nullptr if not loaded
+     */
+    Flight* findFlight(string_view flightNumber, string_view date);
     
     /**
      * @brief Creates a new booking
@@ -326,17 +900,62 @@ public:
      * @param price Final price paid
      * @param seatClass Seat class
      * @return Pointer to created Booking or nullptr on failure
+     *
+     * Passenger strings are moved into the Booking; pass rvalues to avoid copies.
      */
-    Booking* addBooking(string passengerName, string email, string phone, string flightNumber, string flightDate, int seatNumber, double price, string seatClass);
+    Booking* addBooking(string passengerName, string email, string phone, const string& flightNumber,
+                        const string& flightDate, int seatNumber, double price, const string& seatClass);
     
     /**
      * @brief Cancels a booking
      * @param bookingId Unique booking ID
-     * @return true if successful, false if booking not found
+     * @param promoted If given, set to the booking of the waitlisted passenger who got the seat, or nullptr
+     * @return true if successful, false if booking not found, its flight's month
+     *         is sealed, or the database write failed
      * 
-     * Removes from database, frees seat, and deletes booking object
+     * Bookings of earlier runs and other processes are looked up in the
+     * database. Flights of sealed months (month_partitions.h) have long
+     * departed and their seats are read-only history, so those bookings
+     * cannot be cancelled. Removes from database, frees seat, and deletes booking object.
+     * If anyone waits for the flight and class, the first of them is booked
+     * into the seat in the same transaction.
+     */
+    bool cancelBooking(int bookingId, Booking** promoted = nullptr);
+
+    /**
+     * @brief Whether a flight date falls in a month sealed into a partition file
+     *
+     * Bookings on such dates cannot be cancelled; see cancelBooking().
+     */
+    bool isSealedDate(const string& date);
+
+    /**
+     * @brief Puts a passenger on the waitlist of a flight and class
+     * @param flight A flight from the last search
+     * @param seatClass "Economy", "Business", or "First"
+     * @return Waitlist entry id, or 0 if it could not be saved
+     *
+     * The fare is quoted now and charged if a cancellation promotes the
+     * passenger. Waiters are served first come, first served per class.
+     */
+    int64_t joinWaitlist(const Flight* flight, const string& seatClass, string passengerName, string email,
+                         string phone);
+
+    /**
+     * @brief Takes a passenger off the waitlist
+     * @return false if the entry is no longer waiting (left or promoted)
+     */
+    bool leaveWaitlist(int64_t entryId);
+
+    /**
+     * @brief 1-based queue position of a waitlist entry, 0 once it left or was promoted
+     */
+    int getWaitlistPosition(int64_t entryId) const;
+
+    /**
+     * @brief Passengers waiting for a flight and class
      */
-    bool cancelBooking(int bookingId);
+    int getWaitlistLength(const Flight* flight, const string& seatClass) const;
 };
 
 #endif // FLIGHT_SYSTEM_H
@@ -0,0 +1,116 @@
+/**
+ * @file generate_schedule.cpp
+ * @brief Command-line tool that builds large synthetic flight databases
+ *
+ * Usage:
+ *   generate_schedule --db scale.db --cities 60 --days 365 --times 06:00,09:00,13:00,17:00,21:00
+ *                     [--carriers "Sky Express,Cloud Nine"] [--seed 42] [--threads 8]
+ *                     [--load-factor 0.7]
+ *
+ * 60 cities x 5 departures x 365 days is about 6.5M flights. Point the GUI at
+ * the result by copying it to spaazm_flights.db; populateFlights() accepts any
+ * schedule written by the current generator version.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#include "schedule_generator.h"
+#include "flight_system.h"
+#include <sqlite3.h>
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+
+using namespace std;
+
+static vector<string> splitList(const string& value) {
+    vector<string> items;
+    stringstream ss(value);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+static void printUsage(const char* program) {
+    cerr << "Usage: " << program << " [options]\n"
+         << "  --db PATH            Output database (default spaazm_flights.db)\n"
+         << "  --cities N           Number of cities (default 10)\n"
+         << "  --days N             Days to generate (default 60)\n"
+         << "  --times LIST         Comma-separated daily departures (default 06:00,10:00,14:00,18:00,21:00)\n"
+         << "  --carriers LIST      Comma-separated carrier names\n"
+         << "  --seed N             Price variation seed; 0 keeps the original schedule (default 0)\n"
+         << "  --threads N          Generator threads (default: hardware threads)\n"
+         << "  --load-factor F      Fraction of seats to pre-book, 0..1 (default 0)\n";
+}
+
+int main(int argc, char* argv[]) {
+    GeneratorConfig config;
+    string dbPath = "spaazm_flights.db";
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            cerr << "Missing value for " << arg << endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+        string value = argv[++i];
+        if (arg == "--db") dbPath = value;
+        else if (arg == "--cities") config.cityCount = atoi(value.c_str());
+        else if (arg == "--days") config.horizonDays = atoi(value.c_str());
+        else if (arg == "--times") config.departureTimes = splitList(value);
+        else if (arg == "--carriers") config.carriers = splitList(value);
+        else if (arg == "--seed") config.seed = strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--threads") config.threads = atoi(value.c_str());
+        else if (arg == "--load-factor") config.loadFactor = atof(value.c_str());
+        else {
+            cerr << "Unknown option " << arg << endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // City ids are 16-bit in the schedule store
+    if (config.cityCount < 2 || config.cityCount > 65535) {
+        cerr << "--cities must be between 2 and 65535" << endl;
+        return 1;
+    }
+
+    sqlite3* db = nullptr;
+    if (sqlite3_open(dbPath.c_str(), &db) != SQLITE_OK) {
+        cerr << "Failed to open database: " << sqlite3_errmsg(db) << endl;
+        sqlite3_close(db);
+        return 1;
+    }
+
+    // Bulk load: the database can be regenerated if the machine crashes
+    sqlite3_exec(db, "PRAGMA journal_mode = WAL;", nullptr, nullptr, nullptr);
+    sqlite3_exec(db, "PRAGMA synchronous = OFF;", nullptr, nullptr, nullptr);
+    sqlite3_exec(db, "PRAGMA cache_size = -262144;", nullptr, nullptr, nullptr);
+
+    if (!ReservationSystem::createSchema(db)) {
+        sqlite3_close(db);
+        return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+    ScheduleGenerator generator(config);
+    long long inserted = generator.generate(db);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    sqlite3_close(db);
+    if (inserted < 0) return 1;
+
+    cout << "Wrote " << inserted << " flights to " << dbPath << " in " << seconds << " s ("
+         << (long long)(inserted / (seconds > 0 ? seconds : 1)) << " flights/s)" << endl;
+    return 0;
+}
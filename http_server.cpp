@@ -0,0 +1,614 @@
+#include "http_server.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <cctype>
+#include <cstdlib>
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+const uint64_t LISTEN_KEY = 0;  ///< epoll key of the listening socket
+const uint64_t WAKE_KEY = 1;    ///< epoll key of the eventfd; connection ids start after it
+const size_t READ_CHUNK = 64 * 1024;
+const int MAX_EVENTS = 256;
+
+bool equalsIgnoreCase(const string& a, const char* b) {
+    size_t length = strlen(b);
+    if (a.size() != length) return false;
+    for (size_t i = 0; i < length; i++) {
+        if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) return false;
+    }
+    return true;
+}
+
+/// True if a comma-separated header value lists token (case-insensitive)
+bool hasToken(const string& value, const char* token) {
+    size_t start = 0;
+    while (start < value.size()) {
+        size_t end = value.find(',', start);
+        if (end == string::npos) end = value.size();
+        size_t first = start;
+        size_t last = end;
+        while (first < last && (value[first] == ' ' || value[first] == '\t')) first++;
+        while (last > first && (value[last - 1] == ' ' || value[last - 1] == '\t')) last--;
+        if (equalsIgnoreCase(value.substr(first, last - first), token)) {
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/// Decodes %XX escapes, and '+' as space in query strings
+bool percentDecode(const char* text, size_t length, bool plusIsSpace, string& out) {
+    out.clear();
+    out.reserve(length);
+    for (size_t i = 0; i < length; i++) {
+        char c = text[i];
+        if (c == '%') {
+            int high = i + 2 < length ? hexValue(text[i + 1]) : -1;
+            int low = i + 2 < length ? hexValue(text[i + 2]) : -1;
+            if (high < 0 || low < 0) return false;
+            out += (char)(high * 16 + low);
+            i += 2;
+        } else if (c == '+' && plusIsSpace) {
+            out += ' ';
+        } else {
+            out += c;
+        }
+    }
+    return true;
+}
+
+bool parseQuery(const char* text, size_t length, unordered_map<string, string>& query) {
+    size_t start = 0;
+    string name, value;
+    while (start < length) {
+        const char* pair = text + start;
+        const char* end = (const char*)memchr(pair, '&', length - start);
+        size_t pairLength = end ? (size_t)(end - pair) : length - start;
+        const char* equals = (const char*)memchr(pair, '=', pairLength);
+        size_t nameLength = equals ? (size_t)(equals - pair) : pairLength;
+        if (nameLength > 0) {
+            if (!percentDecode(pair, nameLength, true, name)) return false;
+            if (equals) {
+                if (!percentDecode(equals + 1, pairLength - nameLength - 1, true, value)) return false;
+            } else {
+                value.clear();
+            }
+            query[name] = value;
+        }
+        start += pairLength + 1;
+    }
+    return true;
+}
+
+} // namespace
+
+const char* httpStatusText(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 202: return "Accepted";
+        case 204: return "No Content";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 411: return "Length Required";
+        case 413: return "Payload Too Large";
+        case 422: return "Unprocessable Entity";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        default: return "Unknown";
+    }
+}
+
+HttpServer::HttpServer(Handler handler, int threads)
+    : handler(move(handler)), threadCount(threads > 0 ? threads : (int)thread::hardware_concurrency()),
+      listenFd(-1), epollFd(-1), wakeFd(-1), port(0), stopping(false), requestCount(0),
+      nextConnectionId(WAKE_KEY + 1), workersStopping(false) {
+    if (threadCount < 1) threadCount = 1;
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) {
+        cerr << "HTTP server setup failed: " << strerror(errno) << endl;
+        return;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = WAKE_KEY;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+}
+
+HttpServer::~HttpServer() {
+    stopWorkers();
+    for (auto& entry : connections) {
+        close(entry.second.fd);
+    }
+    if (listenFd >= 0) close(listenFd);
+    if (wakeFd >= 0) close(wakeFd);
+    if (epollFd >= 0) close(epollFd);
+}
+
+bool HttpServer::listen(const string& host, int requestedPort) {
+    if (epollFd < 0 || wakeFd < 0 || listenFd >= 0) return false;
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)requestedPort);
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        cerr << "Invalid listen address: " << host << endl;
+        return false;
+    }
+
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int reuse = 1;
+    if (listenFd < 0 || setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+        bind(listenFd, (sockaddr*)&address, sizeof(address)) != 0 || ::listen(listenFd, SOMAXCONN) != 0) {
+        cerr << "Cannot listen on " << host << ":" << requestedPort << ": " << strerror(errno) << endl;
+        if (listenFd >= 0) close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    socklen_t length = sizeof(address);
+    getsockname(listenFd, (sockaddr*)&address, &length);
+    port = ntohs(address.sin_port);
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = LISTEN_KEY;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+    return true;
+}
+
+void HttpServer::run(const function<void()>& tick) {
+    if (listenFd < 0) return;
+    startWorkers();
+
+    epoll_event events[MAX_EVENTS];
+    auto lastTick = chrono::steady_clock::now();
+    while (!stopping.load()) {
+        int count = epoll_wait(epollFd, events, MAX_EVENTS, 250);
+        if (count < 0 && errno != EINTR) {
+            cerr << "epoll_wait failed: " << strerror(errno) << endl;
+            break;
+        }
+        for (int i = 0; i < count; i++) {
+            uint64_t key = events[i].data.u64;
+            uint32_t ready = events[i].events;
+            if (key == LISTEN_KEY) {
+                acceptConnections();
+            } else if (key == WAKE_KEY) {
+                drainCompletions();
+            } else if (ready & (EPOLLERR | EPOLLHUP)) {
+                // Reset by the peer: nothing more can be read or sent
+                closeConnection(key);
+            } else {
+                if (ready & EPOLLIN) onReadable(key);
+                if (ready & EPOLLOUT) onWritable(key);
+            }
+        }
+
+        auto now = chrono::steady_clock::now();
+        if (tick && now - lastTick >= chrono::seconds(1)) {
+            lastTick = now;
+            tick();
+        }
+    }
+
+    vector<uint64_t> open;
+    for (const auto& entry : connections) {
+        open.push_back(entry.first);
+    }
+    for (uint64_t id : open) {
+        closeConnection(id);
+    }
+    stopWorkers();
+}
+
+void HttpServer::stop() {
+    stopping.store(true);
+    uint64_t one = 1;
+    if (wakeFd >= 0) {
+        ssize_t written = write(wakeFd, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+void HttpServer::startWorkers() {
+    if (!workers.empty()) return;
+    workersStopping = false;
+    for (int i = 0; i < threadCount; i++) {
+        workers.emplace_back(&HttpServer::workerLoop, this, i);
+    }
+}
+
+void HttpServer::stopWorkers() {
+    {
+        lock_guard<mutex> guard(jobLock);
+        workersStopping = true;
+        jobs.clear();
+    }
+    jobReady.notify_all();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void HttpServer::workerLoop(int worker) {
+    while (true) {
+        Job job;
+        {
+            unique_lock<mutex> guard(jobLock);
+            jobReady.wait(guard, [this] { return workersStopping || !jobs.empty(); });
+            if (workersStopping) return;
+            job = move(jobs.front());
+            jobs.pop_front();
+        }
+
+        HttpResponse response;
+        try {
+            response = handler(job.request, worker);
+        } catch (const exception& e) {
+            cerr << "Request " << job.request.method << " " << job.request.path << " failed: " << e.what() << endl;
+            response = HttpResponse();
+            response.status = 500;
+            response.body = "{\"error\":\"internal error\"}";
+        }
+        Completion completion{job.connection, job.sequence, serialize(response, job.request.keepAlive)};
+        requestCount++;
+
+        // Only the first completion of a batch needs to wake the loop; it takes them all
+        bool wake;
+        {
+            lock_guard<mutex> guard(completionLock);
+            wake = completions.empty();
+            completions.push_back(move(completion));
+        }
+        if (wake) {
+            uint64_t one = 1;
+            ssize_t written = write(wakeFd, &one, sizeof(one));
+            (void)written;
+        }
+    }
+}
+
+void HttpServer::acceptConnections() {
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                cerr << "accept failed: " << strerror(errno) << endl;
+            }
+            return;
+        }
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        uint64_t id = nextConnectionId++;
+        Connection& connection = connections[id];
+        connection.fd = fd;
+        connection.events = EPOLLIN;
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u64 = id;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            connections.erase(id);
+        }
+    }
+}
+
+void HttpServer::onReadable(uint64_t id) {
+    auto it = connections.find(id);
+    if (it == connections.end()) return;
+    Connection& connection = it->second;
+
+    // One read per wakeup; the level-triggered loop returns for the rest, so busy clients take turns
+    size_t used = connection.input.size();
+    connection.input.resize(used + READ_CHUNK);
+    ssize_t received = recv(connection.fd, &connection.input[used], READ_CHUNK, 0);
+    connection.input.resize(used + (received > 0 ? received : 0));
+    if (received > 0) {
+        parseRequests(id, connection);
+    } else if (received == 0) {
+        connection.peerClosed = true;
+        flush(id, connection);
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        closeConnection(id);
+    }
+}
+
+void HttpServer::onWritable(uint64_t id) {
+    auto it = connections.find(id);
+    if (it != connections.end()) {
+        flush(id, it->second);
+    }
+}
+
+void HttpServer::drainCompletions() {
+    uint64_t signalled;
+    ssize_t drained = read(wakeFd, &signalled, sizeof(signalled));
+    (void)drained;
+
+    vector<Completion> batch;
+    {
+        lock_guard<mutex> guard(completionLock);
+        batch.swap(completions);
+    }
+
+    vector<uint64_t> touched;
+    for (Completion& completion : batch) {
+        auto it = connections.find(completion.connection);
+        if (it == connections.end()) continue;  // Closed while the request was running
+        it->second.ready[completion.sequence] = move(completion.bytes);
+        touched.push_back(completion.connection);
+    }
+    for (uint64_t id : touched) {
+        auto it = connections.find(id);
+        if (it == connections.end()) continue;
+        // Finished requests make room for pipelined ones still waiting in the input buffer
+        if (flush(id, it->second)) {
+            parseRequests(id, it->second);
+        }
+    }
+}
+
+bool HttpServer::parseRequests(uint64_t id, Connection& connection) {
+    vector<Job> parsed;
+    string& input = connection.input;
+
+    while (!connection.closeAfter && connection.nextSequence - connection.nextToSend < MAX_PIPELINED) {
+        // Tolerate empty lines between pipelined requests
+        while (connection.inputOffset + 1 < input.size() && input[connection.inputOffset] == '\r' &&
+               input[connection.inputOffset + 1] == '\n') {
+            connection.inputOffset += 2;
+        }
+        size_t start = connection.inputOffset;
+        size_t headerEnd = input.find("\r\n\r\n", start);
+        if (headerEnd == string::npos) {
+            if (input.size() - start > MAX_HEADER_BYTES) {
+                rejectRequest(connection, 431, "request header too large");
+            }
+            break;
+        }
+        if (headerEnd - start > MAX_HEADER_BYTES) {
+            rejectRequest(connection, 431, "request header too large");
+            break;
+        }
+
+        // Request line: METHOD SP target SP HTTP/1.x
+        size_t lineEnd = input.find("\r\n", start);
+        size_t firstSpace = input.find(' ', start);
+        size_t secondSpace = firstSpace < lineEnd ? input.find(' ', firstSpace + 1) : string::npos;
+        if (firstSpace >= lineEnd || secondSpace >= lineEnd || firstSpace == start ||
+            input.compare(secondSpace + 1, 7, "HTTP/1.") != 0 || lineEnd - secondSpace - 1 != 8 ||
+            input[firstSpace + 1] != '/') {
+            rejectRequest(connection, 400, "malformed request line");
+            break;
+        }
+        bool http10 = input[secondSpace + 8] == '0';
+
+        Job job;
+        job.connection = id;
+        HttpRequest& request = job.request;
+        request.method.assign(input, start, firstSpace - start);
+        const char* target = input.data() + firstSpace + 1;
+        size_t targetLength = secondSpace - firstSpace - 1;
+        const char* question = (const char*)memchr(target, '?', targetLength);
+        size_t pathLength = question ? (size_t)(question - target) : targetLength;
+        if (!percentDecode(target, pathLength, false, request.path) ||
+            (question && !parseQuery(question + 1, targetLength - pathLength - 1, request.query))) {
+            rejectRequest(connection, 400, "malformed request target");
+            break;
+        }
+
+        // Headers: only the framing and connection ones matter here
+        size_t contentLength = 0;
+        bool hasLength = false;
+        bool keepAlive = !http10;
+        bool valid = true;
+        int failure = 400;
+        const char* failureText = "malformed header";
+        string name, value;
+        for (size_t line = lineEnd + 2; line < headerEnd;) {
+            size_t end = input.find("\r\n", line);
+            size_t colon = input.find(':', line);
+            if (colon >= end || colon == line) {
+                valid = false;
+                break;
+            }
+            name.assign(input, line, colon - line);
+            size_t valueStart = input.find_first_not_of(" \t", colon + 1);
+            size_t valueEnd = input.find_last_not_of(" \t", end - 1);
+            if (valueStart == string::npos || valueStart >= end || valueEnd < valueStart) {
+                value.clear();
+            } else {
+                value.assign(input, valueStart, valueEnd - valueStart + 1);
+            }
+
+            if (equalsIgnoreCase(name, "Content-Length")) {
+                char* parsedEnd = nullptr;
+                unsigned long long length = strtoull(value.c_str(), &parsedEnd, 10);
+                if (value.empty() || *parsedEnd != '\0' || value[0] == '-' || (hasLength && length != contentLength)) {
+                    valid = false;
+                    break;
+                }
+                if (length > MAX_BODY_BYTES) {
+                    valid = false;
+                    failure = 413;
+                    failureText = "request body too large";
+                    break;
+                }
+                contentLength = (size_t)length;
+                hasLength = true;
+            } else if (equalsIgnoreCase(name, "Transfer-Encoding")) {
+                valid = false;
+                failure = 501;
+                failureText = "transfer encodings are not supported; send Content-Length";
+                break;
+            } else if (equalsIgnoreCase(name, "Connection")) {
+                if (hasToken(value, "close")) keepAlive = false;
+                else if (hasToken(value, "keep-alive")) keepAlive = true;
+            }
+            line = end + 2;
+        }
+        if (!valid) {
+            rejectRequest(connection, failure, failureText);
+            break;
+        }
+
+        size_t bodyStart = headerEnd + 4;
+        if (input.size() - bodyStart < contentLength) {
+            break;  // Body still arriving
+        }
+        request.body.assign(input, bodyStart, contentLength);
+        request.keepAlive = keepAlive;
+        connection.inputOffset = bodyStart + contentLength;
+        job.sequence = connection.nextSequence++;
+        if (!keepAlive) {
+            connection.closeAfter = true;
+        }
+        parsed.push_back(move(job));
+    }
+
+    // Drop the parsed prefix once it dominates the buffer, keeping the erase cost amortized
+    if (connection.inputOffset == input.size()) {
+        input.clear();
+        connection.inputOffset = 0;
+    } else if (connection.inputOffset > READ_CHUNK && connection.inputOffset * 2 > input.size()) {
+        input.erase(0, connection.inputOffset);
+        connection.inputOffset = 0;
+    }
+
+    if (!parsed.empty()) {
+        {
+            lock_guard<mutex> guard(jobLock);
+            for (Job& job : parsed) {
+                jobs.push_back(move(job));
+            }
+        }
+        if (parsed.size() == 1) {
+            jobReady.notify_one();
+        } else {
+            jobReady.notify_all();
+        }
+    }
+    return flush(id, connection);
+}
+
+void HttpServer::rejectRequest(Connection& connection, int status, const string& message) {
+    HttpResponse response;
+    response.status = status;
+    response.body = "{\"error\":\"" + message + "\"}";
+    connection.ready[connection.nextSequence++] = serialize(response, false);
+    connection.closeAfter = true;
+    connection.input.clear();
+    connection.inputOffset = 0;
+    requestCount++;
+}
+
+bool HttpServer::flush(uint64_t id, Connection& connection) {
+    while (!connection.ready.empty() && connection.ready.begin()->first == connection.nextToSend) {
+        auto first = connection.ready.begin();
+        if (connection.output.empty()) {
+            connection.output = move(first->second);
+        } else {
+            connection.output += first->second;
+        }
+        connection.ready.erase(first);
+        connection.nextToSend++;
+    }
+
+    while (connection.outputOffset < connection.output.size()) {
+        ssize_t sent = send(connection.fd, connection.output.data() + connection.outputOffset,
+                            connection.output.size() - connection.outputOffset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection.outputOffset += sent;
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            closeConnection(id);
+            return false;
+        }
+    }
+    if (connection.outputOffset == connection.output.size()) {
+        connection.output.clear();
+        connection.outputOffset = 0;
+    }
+
+    bool idle = connection.output.empty() && connection.nextToSend == connection.nextSequence;
+    if (idle && (connection.closeAfter || connection.peerClosed)) {
+        closeConnection(id);
+        return false;
+    }
+    updateEvents(id, connection);
+    return true;
+}
+
+void HttpServer::updateEvents(uint64_t id, Connection& connection) {
+    uint32_t wanted = 0;
+    if (!connection.closeAfter && !connection.peerClosed &&
+        connection.nextSequence - connection.nextToSend < MAX_PIPELINED) {
+        wanted |= EPOLLIN;
+    }
+    if (!connection.output.empty()) {
+        wanted |= EPOLLOUT;
+    }
+    if (wanted != connection.events) {
+        epoll_event event = {};
+        event.events = wanted;
+        event.data.u64 = id;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+        connection.events = wanted;
+    }
+}
+
+void HttpServer::closeConnection(uint64_t id) {
+    auto it = connections.find(id);
+    if (it == connections.end()) return;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    close(it->second.fd);
+    connections.erase(it);
+}
+
+string HttpServer::serialize(const HttpResponse& response, bool keepAlive) {
+    string out;
+    out.reserve(response.body.size() + 128);
+    out += "HTTP/1.1 ";
+    out += to_string(response.status);
+    out += ' ';
+    out += httpStatusText(response.status);
+    out += "\r\nContent-Type: ";
+    out += response.contentType;
+    out += "\r\nContent-Length: ";
+    out += to_string(response.body.size());
+    out += keepAlive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n";
+    out += response.body;
+    return out;
+}
@@ -0,0 +1,207 @@
+/**
+ * @file http_server.h
+ * @brief Minimal HTTP/1.1 server: one epoll event loop plus a worker pool
+ *
+ * The loop thread owns every socket. It accepts, reads and parses requests,
+ * hands complete ones to the workers through a shared queue and writes the
+ * serialized responses back. Workers only run the handler, so a slow
+ * request never stalls I/O on other connections. Connections stay open
+ * (keep-alive) and may pipeline: several requests of one connection can be
+ * handled in parallel, and their responses are still sent in request order.
+ * Chunked request bodies are not supported. Linux only.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * @struct HttpRequest
+ * @brief One parsed request
+ */
+struct HttpRequest {
+    string method;                        ///< "GET", "POST", ...
+    string path;                          ///< Percent-decoded, without the query string
+    unordered_map<string, string> query;  ///< Decoded query parameters; the last one of a name wins
+    string body;
+    bool keepAlive = true;                ///< The connection stays open after the response
+};
+
+/**
+ * @struct HttpResponse
+ * @brief What a handler returns; the server adds the status line and framing headers
+ */
+struct HttpResponse {
+    int status = 200;
+    string contentType = "application/json";
+    string body;
+};
+
+/**
+ * @class HttpServer
+ * @brief Serves one handler on one listening socket
+ */
+class HttpServer {
+public:
+    /// Called on a worker thread; worker is in [0, threads) and runs one request at a time
+    typedef function<HttpResponse(const HttpRequest& request, int worker)> Handler;
+
+    static const size_t MAX_HEADER_BYTES = 16 * 1024;  ///< Request line plus headers; larger gets 431
+    static const size_t MAX_BODY_BYTES = 1024 * 1024;  ///< Larger bodies get 413
+    static const size_t MAX_PIPELINED = 64;            ///< Requests in flight per connection before reading pauses
+
+    /**
+     * @param handler Request handler, shared by all workers
+     * @param threads Worker threads; 0 uses every hardware thread
+     */
+    HttpServer(Handler handler, int threads = 0);
+    ~HttpServer();
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    /**
+     * @brief Binds and listens
+     * @param host IPv4 address to bind, e.g. "127.0.0.1" or "0.0.0.0"
+     * @param port TCP port; 0 picks a free one (see getPort())
+     * @return false if the socket could not be set up
+     */
+    bool listen(const string& host, int port);
+
+    /**
+     * @brief The bound port, 0 before listen()
+     */
+    int getPort() const { return port; }
+
+    /**
+     * @brief Number of worker threads
+     */
+    int getThreadCount() const { return threadCount; }
+
+    /**
+     * @brief Runs the event loop on the calling thread until stop()
+     * @param tick Called on the loop thread about once a second, e.g. for housekeeping
+     */
+    void run(const function<void()>& tick = nullptr);
+
+    /**
+     * @brief Makes run() return; safe from any thread and from signal handlers
+     */
+    void stop();
+
+    /**
+     * @brief Requests answered since the server was created
+     */
+    uint64_t getRequestCount() const { return requestCount.load(); }
+
+private:
+    /// One client socket, touched by the loop thread only
+    struct Connection {
+        int fd;
+        string input;                 ///< Bytes received and not yet parsed
+        size_t inputOffset = 0;       ///< Parsed prefix of input
+        string output;                ///< Responses ready to send, in order
+        size_t outputOffset = 0;      ///< Sent prefix of output
+        uint64_t nextSequence = 0;    ///< Sequence number of the next request parsed
+        uint64_t nextToSend = 0;      ///< Sequence number of the next response to queue for sending
+        map<uint64_t, string> ready;  ///< Responses finished out of order, by sequence
+        bool closeAfter = false;      ///< No more requests: close once everything queued is sent
+        bool peerClosed = false;      ///< Read side hit end of file
+        uint32_t events = 0;          ///< Current epoll interest set
+    };
+
+    /// A request handed to the workers
+    struct Job {
+        uint64_t connection;
+        uint64_t sequence;
+        HttpRequest request;
+    };
+
+    /// A serialized response handed back to the loop
+    struct Completion {
+        uint64_t connection;
+        uint64_t sequence;
+        string bytes;
+    };
+
+    Handler handler;
+    int threadCount;
+    int listenFd;
+    int epollFd;
+    int wakeFd;  ///< eventfd: completions are waiting, or stop() was called
+    int port;
+    atomic<bool> stopping;
+    atomic<uint64_t> requestCount;
+
+    unordered_map<uint64_t, Connection> connections;  ///< Keyed by id; ids are never reused
+    uint64_t nextConnectionId;
+
+    vector<thread> workers;
+    mutex jobLock;
+    condition_variable jobReady;
+    deque<Job> jobs;
+    bool workersStopping;
+
+    mutex completionLock;
+    vector<Completion> completions;
+
+    void workerLoop(int worker);
+    void startWorkers();
+    void stopWorkers();
+
+    void acceptConnections();
+    void onReadable(uint64_t id);
+    void onWritable(uint64_t id);
+    void drainCompletions();
+
+    /**
+     * @brief Parses complete requests from the input buffer and queues them
+     * @return false if the connection was closed
+     */
+    bool parseRequests(uint64_t id, Connection& connection);
+
+    /**
+     * @brief Queues an error response in sequence and stops reading the connection
+     */
+    void rejectRequest(Connection& connection, int status, const string& message);
+
+    /**
+     * @brief Moves in-order responses to the output buffer, writes, and closes if done
+     * @return false if the connection was closed
+     */
+    bool flush(uint64_t id, Connection& connection);
+
+    /**
+     * @brief Sets the epoll interest set from the connection state
+     */
+    void updateEvents(uint64_t id, Connection& connection);
+
+    void closeConnection(uint64_t id);
+
+    /**
+     * @brief Status line, framing headers and body as sent on the wire
+     */
+    static string serialize(const HttpResponse& response, bool keepAlive);
+};
+
+/**
+ * @brief Reason phrase for an HTTP status code
+ */
+const char* httpStatusText(int status);
+
+#endif // HTTP_SERVER_H
@@ -0,0 +1,208 @@
+#include "itinerary_planner.h"
+#include "flight_system.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+
+struct CityCoordinate {
+    const char* name;
+    double latitude;
+    double longitude;
+};
+
+// Airport coordinates used to approximate block times
+const CityCoordinate CITY_COORDINATES[] = {
+    {"Mumbai", 19.09, 72.87},    {"Delhi", 28.56, 77.10},
+    {"Bangalore", 13.20, 77.71}, {"Chennai", 12.99, 80.17},
+    {"Kolkata", 22.65, 88.45},   {"Hyderabad", 17.24, 78.43},
+    {"Pune", 18.58, 73.92},      {"Goa", 15.38, 73.83},
+    {"Jaipur", 26.82, 75.81},    {"Kochi", 10.15, 76.40}
+};
+
+const CityCoordinate* findCoordinate(const string& city) {
+    for (const auto& c : CITY_COORDINATES) {
+        if (city == c.name) return &c;
+    }
+    return nullptr;
+}
+
+/// Search label: best known way to reach a city
+struct Label {
+    time_t arrival;
+    double price;
+    int legs;
+    int parent;         ///< Index of previous label in the pool, -1 at origin
+    uint32_t connection;
+};
+
+bool dominates(const Label& a, const Label& b) {
+    return a.arrival <= b.arrival && a.price <= b.price && a.legs <= b.legs;
+}
+
+} // namespace
+
+uint32_t ConnectionScanPlanner::cityId(const string& city) {
+    auto it = cityIds.find(city);
+    if (it != cityIds.end()) return it->second;
+    uint32_t id = cityNames.size();
+    cityNames.push_back(city);
+    cityIds[city] = id;
+    return id;
+}
+
+int ConnectionScanPlanner::estimateBlockMinutes(const string& source, const string& destination) {
+    const CityCoordinate* a = findCoordinate(source);
+    const CityCoordinate* b = findCoordinate(destination);
+    if (!a || !b) return 120;
+
+    // Haversine distance, then 750 km/h cruise plus 40 minutes taxi/climb/descent
+    const double toRad = M_PI / 180.0;
+    double dLat = (b->latitude - a->latitude) * toRad;
+    double dLon = (b->longitude - a->longitude) * toRad;
+    double h = sin(dLat / 2) * sin(dLat / 2) +
+               cos(a->latitude * toRad) * cos(b->latitude * toRad) * sin(dLon / 2) * sin(dLon / 2);
+    double distanceKm = 2 * 6371.0 * asin(sqrt(h));
+
+    int minutes = 40 + (int)ceil(distanceKm / 750.0 * 60.0);
+    return ((minutes + 4) / 5) * 5;  // Schedules are published in 5-minute steps
+}
+
+void ConnectionScanPlanner::addFlight(const string& flightNumber, const string& flightName, const string& source,
+                                      const string& destination, const string& date, const string& departureTime,
+                                      time_t departure, int departureHour, double basePrice) {
+    FlightInfo info;
+    info.flightNumber = flightNumber;
+    info.flightName = flightName;
+    info.departureTime = departureTime;
+    info.departure = departure;
+    info.arrival = departure + estimateBlockMinutes(source, destination) * 60;
+    info.departureHour = departureHour;
+    info.basePrice = basePrice;
+    info.booked[0] = info.booked[1] = info.booked[2] = 0;
+
+    uint32_t index = flightInfo.size();
+    flightIndex[flightNumber + "|" + date] = index;
+    connections.push_back({info.departure, info.arrival, cityId(source), cityId(destination), index});
+    flightInfo.push_back(info);
+}
+
+void ConnectionScanPlanner::finalize() {
+    sort(connections.begin(), connections.end(), [](const Connection& a, const Connection& b) {
+        return a.departure < b.departure;
+    });
+}
+
+void ConnectionScanPlanner::clear() {
+    connections.clear();
+    flightInfo.clear();
+    cityNames.clear();
+    cityIds.clear();
+    flightIndex.clear();
+}
+
+void ConnectionScanPlanner::adjustOccupancy(const string& flightNumber, const string& date,
+                                            const string& seatClass, int delta) {
+    auto it = flightIndex.find(flightNumber + "|" + date);
+    if (it == flightIndex.end()) return;
+    int& booked = flightInfo[it->second].booked[Flight::seatClassIndex(seatClass)];
+    booked = max(0, booked + delta);
+}
+
+vector<Itinerary> ConnectionScanPlanner::plan(const string& source, const string& destination, time_t earliestDeparture,
+                                              const string& seatClass, time_t bookingTime,
+                                              const ItineraryOptions& options) const {
+    vector<Itinerary> results;
+    auto srcIt = cityIds.find(source);
+    auto dstIt = cityIds.find(destination);
+    if (srcIt == cityIds.end() || dstIt == cityIds.end() || srcIt == dstIt) {
+        return results;
+    }
+    uint32_t origin = srcIt->second;
+    uint32_t target = dstIt->second;
+    int cls = Flight::seatClassIndex(seatClass);
+    time_t minConnection = (time_t)options.minConnectionMinutes * 60;
+    time_t latestDeparture = earliestDeparture + (time_t)options.maxTravelHours * 3600;
+
+    vector<Label> pool;
+    vector<vector<int>> bags(cityNames.size());
+    pool.push_back({earliestDeparture, 0.0, 0, -1, 0});
+    bags[origin].push_back(0);
+
+    // Binary search to the first connection departing at or after the query time
+    auto first = lower_bound(connections.begin(), connections.end(), earliestDeparture,
+                             [](const Connection& c, time_t t) { return c.departure < t; });
+
+    for (auto it = first; it != connections.end() && it->departure <= latestDeparture; ++it) {
+        const Connection& c = *it;
+        if (bags[c.from].empty() || c.to == origin) continue;
+
+        const FlightInfo& info = flightInfo[c.flight];
+        if (info.booked[cls] >= Flight::seatClassCapacity(cls)) continue;
+
+        bool priced = false;
+        double legPrice = 0.0;
+
+        // Iterate by index: the bag of c.to may grow while we scan c.from
+        const vector<int>& fromBag = bags[c.from];
+        for (size_t b = 0; b < fromBag.size(); b++) {
+            const Label& from = pool[fromBag[b]];
+            if (from.legs >= options.maxLegs) continue;
+            if (from.legs > 0 && from.arrival + minConnection > c.departure) continue;
+
+            if (!priced) {
+                int bookedTotal = info.booked[0] + info.booked[1] + info.booked[2];
+                legPrice = Flight::computePrice(info.basePrice, seatClass, bookedTotal, 100,
+                                                info.departure, info.departureHour, bookingTime);
+                priced = true;
+            }
+
+            Label candidate = {c.arrival, from.price + legPrice, from.legs + 1, fromBag[b],
+                               (uint32_t)(it - connections.begin())};
+
+            // Target pruning: anything dominated at the destination is useless elsewhere
+            bool dominated = false;
+            for (int t : bags[target]) {
+                if (dominates(pool[t], candidate)) { dominated = true; break; }
+            }
+            if (dominated) continue;
+
+            vector<int>& toBag = bags[c.to];
+            for (int l : toBag) {
+                if (dominates(pool[l], candidate)) { dominated = true; break; }
+            }
+            if (dominated) continue;
+
+            toBag.erase(remove_if(toBag.begin(), toBag.end(), [&](int l) {
+                return dominates(candidate, pool[l]);
+            }), toBag.end());
+            toBag.push_back(pool.size());
+            pool.push_back(candidate);
+        }
+    }
+
+    for (int l : bags[target]) {
+        Itinerary itinerary;
+        itinerary.totalPrice = pool[l].price;
+        for (int cur = l; pool[cur].parent != -1; cur = pool[cur].parent) {
+            const Connection& c = connections[pool[cur].connection];
+            const FlightInfo& info = flightInfo[c.flight];
+            double legPrice = pool[cur].price - pool[pool[cur].parent].price;
+            itinerary.legs.push_back({info.flightNumber, info.flightName, cityNames[c.from], cityNames[c.to],
+                                      info.departureTime, info.departure, info.arrival, legPrice});
+        }
+        reverse(itinerary.legs.begin(), itinerary.legs.end());
+        itinerary.departure = itinerary.legs.front().departure;
+        itinerary.arrival = itinerary.legs.back().arrival;
+        results.push_back(itinerary);
+    }
+
+    sort(results.begin(), results.end(), [](const Itinerary& a, const Itinerary& b) {
+        if (a.arrival != b.arrival) return a.arrival < b.arrival;
+        if (a.totalPrice != b.totalPrice) return a.totalPrice < b.totalPrice;
+        return a.legs.size() < b.legs.size();
+    });
+    return results;
+}
@@ -0,0 +1,161 @@
+/**
+ * @file itinerary_planner.h
+ * @brief Multi-leg itinerary search for Spaazm Flights
+ *
+ * Implements the Connection Scan Algorithm (CSA) over a time-sorted array of
+ * flight connections. Each query returns the Pareto-optimal itineraries with
+ * respect to arrival time, total dynamic price and number of legs.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef ITINERARY_PLANNER_H
+#define ITINERARY_PLANNER_H
+
+#include <vector>
+#include <string>
+#include <ctime>
+#include <cstdint>
+#include <unordered_map>
+
+using namespace std;
+
+/**
+ * @struct ItineraryLeg
+ * @brief One flight within a planned itinerary
+ */
+struct ItineraryLeg {
+    string flightNumber;    ///< Flight number (e.g., "SP1001")
+    string flightName;      ///< Carrier display name
+    string source;          ///< Departure city
+    string destination;     ///< Arrival city
+    string departureTime;   ///< Full datetime string (YYYY-MM-DD HH:MM)
+    time_t departure;       ///< Departure as Unix timestamp
+    time_t arrival;         ///< Estimated arrival as Unix timestamp
+    double price;           ///< Dynamic price of this leg in INR
+};
+
+/**
+ * @struct Itinerary
+ * @brief A complete journey of one or more connecting flights
+ */
+struct Itinerary {
+    vector<ItineraryLeg> legs;  ///< Flights in travel order
+    time_t departure;           ///< Departure of the first leg
+    time_t arrival;             ///< Arrival of the last leg
+    double totalPrice;          ///< Sum of all leg prices in INR
+};
+
+/**
+ * @struct ItineraryOptions
+ * @brief Tuning knobs for an itinerary query
+ */
+struct ItineraryOptions {
+    int maxLegs = 3;                 ///< Upper bound on flights per itinerary
+    int minConnectionMinutes = 45;   ///< Minimum layover between two legs
+    int maxTravelHours = 24;         ///< Only scan connections departing within this window
+};
+
+/**
+ * @class ConnectionScanPlanner
+ * @brief Pareto itinerary planner built on a departure-sorted connection array
+ *
+ * Connections are kept sorted by departure time, so a query binary-searches
+ * to its start time and scans a contiguous slice bounded by maxTravelHours.
+ * Each city holds a bag of non-dominated labels (arrival, price, legs).
+ */
+class ConnectionScanPlanner {
+public:
+    /**
+     * @brief Adds one scheduled flight to the planner
+     * @param flightNumber Flight number
+     * @param flightName Carrier display name
+     * @param source Departure city
+     * @param destination Arrival city
+     * @param date Flight date (YYYY-MM-DD)
+     * @param departureTime Full datetime string
+     * @param departure Departure as Unix timestamp
+     * @param departureHour Local departure hour used for pricing
+     * @param basePrice Base price in INR
+     *
+     * Call finalize() after the last flight has been added.
+     */
+    void addFlight(const string& flightNumber, const string& flightName, const string& source,
+                   const string& destination, const string& date, const string& departureTime,
+                   time_t departure, int departureHour, double basePrice);
+
+    /**
+     * @brief Sorts connections by departure time; required before plan()
+     */
+    void finalize();
+
+    /**
+     * @brief Removes all flights and occupancy data
+     */
+    void clear();
+
+    /**
+     * @brief Records booked seats for a flight so plans use current demand pricing
+     * @param flightNumber Flight number
+     * @param date Flight date (YYYY-MM-DD)
+     * @param seatClass "Economy", "Business", or "First"
+     * @param delta Seats booked (+) or released (-)
+     */
+    void adjustOccupancy(const string& flightNumber, const string& date, const string& seatClass, int delta);
+
+    /**
+     * @brief Finds Pareto-optimal itineraries between two cities
+     * @param source Departure city
+     * @param destination Arrival city
+     * @param earliestDeparture No leg departs before this Unix timestamp
+     * @param seatClass Seat class to price and check availability for
+     * @param bookingTime Current time for advance-purchase pricing
+     * @param options Leg limit, minimum connection time and scan window
+     * @return Non-dominated itineraries sorted by arrival, then price
+     */
+    vector<Itinerary> plan(const string& source, const string& destination, time_t earliestDeparture,
+                           const string& seatClass, time_t bookingTime,
+                           const ItineraryOptions& options = ItineraryOptions()) const;
+
+    /**
+     * @brief Estimates block time between two cities from great-circle distance
+     * @return Minutes from departure to arrival (120 for unknown cities)
+     */
+    static int estimateBlockMinutes(const string& source, const string& destination);
+
+    size_t size() const { return connections.size(); }
+    bool empty() const { return connections.empty(); }
+
+private:
+    /// One flight as seen by the scan (hot fields only)
+    struct Connection {
+        time_t departure;
+        time_t arrival;
+        uint32_t from;
+        uint32_t to;
+        uint32_t flight;    ///< Index into flightInfo
+    };
+
+    /// Cold per-flight data used for pricing and result reconstruction
+    struct FlightInfo {
+        string flightNumber;
+        string flightName;
+        string departureTime;
+        time_t departure;
+        time_t arrival;
+        int departureHour;
+        double basePrice;
+        int booked[3];      ///< Booked seats per class: First, Business, Economy
+    };
+
+    vector<Connection> connections;          ///< Sorted by departure after finalize()
+    vector<FlightInfo> flightInfo;
+    vector<string> cityNames;
+    unordered_map<string, uint32_t> cityIds;
+    unordered_map<string, uint32_t> flightIndex;  ///< "number|date" -> flightInfo index
+
+    uint32_t cityId(const string& city);
+};
+
+#endif // ITINERARY_PLANNER_H
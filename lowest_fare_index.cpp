@@ -0,0 +1,175 @@
+#include "lowest_fare_index.h"
+#include "flight_system.h"
+#include "schedule_store.h"
+#include "pricing_rules.h"
+#include "time_core.h"
+#include <sqlite3.h>
+#include <iostream>
+
+using namespace std;
+
+void LowestFareIndex::recompute(RouteDay& day, time_t now) {
+    const PricingTable& rules = PricingRules::active();
+
+    for (int c = 0; c < 3; c++) {
+        day.best.available[c] = false;
+        day.best.lowestFare[c] = 0.0;
+        day.best.flightNumber[c].clear();
+    }
+    day.validUntil = 0;
+    day.rulesVersion = rules.version;
+
+    for (const FlightFare& f : day.flights) {
+        if (f.departure <= now) continue;
+
+        // The advance-purchase factor changes one second after a bucket edge is passed,
+        // and the flight drops out when it departs
+        for (int i = 0; i <= PricingTable::MAX_ADVANCE_EDGES; i++) {
+            if (i < PricingTable::MAX_ADVANCE_EDGES && rules.advanceEdge[i] == INT64_MAX) continue;
+            time_t changeAt = i < PricingTable::MAX_ADVANCE_EDGES ? f.departure - rules.advanceEdge[i] + 1
+                                                                   : f.departure;
+            if (changeAt > now && (day.validUntil == 0 || changeAt < day.validUntil)) {
+                day.validUntil = changeAt;
+            }
+        }
+
+        int bookedTotal = f.booked[0] + f.booked[1] + f.booked[2];
+        for (int c = 0; c < 3; c++) {
+            if (f.booked[c] >= Flight::seatClassCapacity(c)) continue;
+            double price = Flight::computePrice(f.basePrice, Flight::seatClassName(c), bookedTotal, 100,
+                                                f.departure, f.departureHour, now);
+            if (!day.best.available[c] || price < day.best.lowestFare[c]) {
+                day.best.lowestFare[c] = price;
+                day.best.flightNumber[c] = f.flightNumber;
+                day.best.available[c] = true;
+            }
+        }
+    }
+}
+
+void LowestFareIndex::persist(sqlite3* db, const RouteDay& day) {
+    if (!db) return;
+
+    sqlite3_stmt* stmt;
+    const char* sql = "INSERT OR REPLACE INTO lowest_fares VALUES (?, ?, ?, ?, ?, ?, ?);";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return;
+    }
+    for (int c = 0; c < 3; c++) {
+        sqlite3_bind_text(stmt, 1, day.source.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, day.destination.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, day.best.date.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 4, Flight::seatClassName(c), -1, SQLITE_STATIC);
+        if (day.best.available[c]) {
+            sqlite3_bind_text(stmt, 5, day.best.flightNumber[c].c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_double(stmt, 6, day.best.lowestFare[c]);
+        } else {
+            sqlite3_bind_null(stmt, 5);
+            sqlite3_bind_null(stmt, 6);
+        }
+        sqlite3_bind_int64(stmt, 7, day.validUntil);
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+}
+
+void LowestFareIndex::reset() {
+    routeDays.clear();
+    flightIndex.clear();
+    loaded = false;
+}
+
+void LowestFareIndex::load(sqlite3* db, const ScheduleStore& schedule) {
+    reset();
+    if (!db) return;
+
+    for (size_t row = 0; row < schedule.size(); row++) {
+        FlightFare f;
+        f.flightNumber = schedule.getFlightNumber(row);
+        f.departure = schedule.getDepartureTimestamp(row);
+        f.departureHour = schedule.getDepartureHour(row);
+        f.basePrice = schedule.getBasePrice(row);
+        f.booked[0] = f.booked[1] = f.booked[2] = 0;
+        string date = schedule.getDate(row);
+
+        RouteDay& day = routeDays[schedule.getSource(row) + "|" + schedule.getDestination(row) + "|" + date];
+        if (day.flights.empty()) {
+            day.source = schedule.getSource(row);
+            day.destination = schedule.getDestination(row);
+            day.best.date = date;
+        }
+        flightIndex[f.flightNumber + "|" + date] = {&day, day.flights.size()};
+        day.flights.push_back(f);
+    }
+
+    // Occupancy per flight and class in one aggregate pass
+    const char* sql =
+        "SELECT flight_number, flight_date, "
+        "SUM(seat_number <= 10), SUM(seat_number BETWEEN 11 AND 30), SUM(seat_number > 30) "
+        "FROM booked_seats GROUP BY flight_number, flight_date;";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        string key = string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0))) + "|" +
+                     reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        auto it = flightIndex.find(key);
+        if (it == flightIndex.end()) continue;
+        FlightFare& f = it->second.first->flights[it->second.second];
+        for (int c = 0; c < 3; c++) {
+            f.booked[c] = sqlite3_column_int(stmt, 2 + c);
+        }
+    }
+    sqlite3_finalize(stmt);
+
+    time_t now = currentTime();
+    sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
+    sqlite3_exec(db, "DELETE FROM lowest_fares;", nullptr, nullptr, nullptr);
+    for (auto& entry : routeDays) {
+        recompute(entry.second, now);
+        persist(db, entry.second);
+    }
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+
+    loaded = true;
+    cout << "Lowest fare index built for " << routeDays.size() << " route-days" << endl;
+}
+
+void LowestFareIndex::recordBooking(sqlite3* db, const string& flightNumber, const string& date,
+                                    const string& seatClass, int delta) {
+    auto it = flightIndex.find(flightNumber + "|" + date);
+    if (it == flightIndex.end()) return;
+
+    RouteDay& day = *it->second.first;
+    int& booked = day.flights[it->second.second].booked[Flight::seatClassIndex(seatClass)];
+    booked = max(0, booked + delta);
+
+    recompute(day, currentTime());
+    persist(db, day);
+}
+
+DayFare LowestFareIndex::lookup(sqlite3* db, const string& source, const string& destination,
+                                const string& date, time_t now) {
+    auto it = routeDays.find(source + "|" + destination + "|" + date);
+    if (it == routeDays.end()) {
+        DayFare empty;
+        empty.date = date;
+        for (int c = 0; c < 3; c++) {
+            empty.lowestFare[c] = 0.0;
+            empty.available[c] = false;
+        }
+        return empty;
+    }
+
+    RouteDay& day = it->second;
+    bool anyAvailable = day.best.available[0] || day.best.available[1] || day.best.available[2];
+    if (anyAvailable && (now >= day.validUntil || day.rulesVersion != PricingRules::active().version)) {
+        recompute(day, now);
+        persist(db, day);
+    }
+    return day.best;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file lowest_fare_index.h
+ * @brief Materialized lowest fare per route, day and seat class
+ *
+ * Keeps the cheapest bookable dynamic fare for every (source, destination,
+ * date, class) in memory and mirrors it into the lowest_fares table.
+ * Bookings and cancellations update only the affected route/day; fares that
+ * depend on the clock are recomputed lazily when their time bucket expires.
+ * Other sessions' bookings arrive through the booking log and are applied
+ * and persisted the same way, so the table stays current while any process
+ * on the database has the index loaded.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef LOWEST_FARE_INDEX_H
+#define LOWEST_FARE_INDEX_H
+
+#include <vector>
+#include <string>
+#include <ctime>
+#include <cstdint>
+#include <unordered_map>
+
+struct sqlite3;  // Forward declaration for SQLite database handle
+class ScheduleStore;
+
+using namespace std;
+
+/**
+ * @struct DayFare
+ * @brief Cheapest available fare per class for one day of a route
+ *
+ * Classes are indexed First (0), Business (1), Economy (2). A class with no
+ * bookable seat on any flight that day has available[i] == false.
+ */
+struct DayFare {
+    string date;             ///< Flight date (YYYY-MM-DD)
+    double lowestFare[3];    ///< Cheapest dynamic price per class in INR
+    string flightNumber[3];  ///< Flight offering the cheapest fare per class
+    bool available[3];       ///< Whether any seat in the class is bookable
+};
+
+/**
+ * @class LowestFareIndex
+ * @brief O(1) lowest-fare lookups maintained incrementally on bookings
+ */
+class LowestFareIndex {
+public:
+    LowestFareIndex() : loaded(false) {}
+
+    /**
+     * @brief Builds the index from the schedule and booked_seats and persists it
+     * @param db Open database connection
+     * @param schedule In-memory schedule to index
+     *
+     * Reads per-class occupancy in one aggregate query, then rewrites
+     * lowest_fares in a single transaction.
+     */
+    void load(sqlite3* db, const ScheduleStore& schedule);
+
+    bool isLoaded() const { return loaded; }
+
+    /**
+     * @brief Drops the index; the next load() rebuilds it
+     */
+    void reset();
+
+    /**
+     * @brief Applies a booking (+1) or cancellation (-1) to one flight
+     * @param db Open database connection used to persist the changed rows
+     * @param flightNumber Flight number
+     * @param date Flight date (YYYY-MM-DD)
+     * @param seatClass "Economy", "Business", or "First"
+     * @param delta Seats booked (+) or released (-)
+     *
+     * Only the route/day containing the flight is re-evaluated.
+     */
+    void recordBooking(sqlite3* db, const string& flightNumber, const string& date,
+                       const string& seatClass, int delta);
+
+    /**
+     * @brief Returns the cheapest fares for a route on a day
+     * @param db Open database connection used if a lazy refresh is persisted
+     * @param source Departure city
+     * @param destination Arrival city
+     * @param date Flight date (YYYY-MM-DD)
+     * @param now Current time; expired time buckets are refreshed first
+     * @return Fares for the day (all classes unavailable if no flights)
+     */
+    DayFare lookup(sqlite3* db, const string& source, const string& destination, const string& date, time_t now);
+
+private:
+    /// Pricing inputs for one flight
+    struct FlightFare {
+        string flightNumber;
+        time_t departure;
+        int departureHour;
+        double basePrice;
+        int booked[3];
+    };
+
+    /// All flights of one route on one day plus their materialized minimum
+    struct RouteDay {
+        string source;
+        string destination;
+        vector<FlightFare> flights;
+        DayFare best;
+        time_t validUntil;      ///< Next time a time-based factor changes
+        uint64_t rulesVersion;  ///< PricingTable::version the fares were computed with
+    };
+
+    unordered_map<string, RouteDay> routeDays;                   ///< "src|dst|date" -> route/day
+    unordered_map<string, pair<RouteDay*, size_t>> flightIndex;  ///< "number|date" -> owning route/day
+    bool loaded;
+
+    /**
+     * @brief Recomputes the minimum fares of one route/day at time now
+     */
+    static void recompute(RouteDay& day, time_t now);
+
+    /**
+     * @brief Writes the three class rows of one route/day to lowest_fares
+     */
+    static void persist(sqlite3* db, const RouteDay& day);
+};
+
+#endif // LOWEST_FARE_INDEX_H
@@ -8,6 +8,7 @@
 #include <QPushButton>
 #include <QLineEdit>
 #include <QComboBox>
+#include <QSpinBox>
 #include <QListView>
 #include <QPalette>
 #include <QMessageBox>
@@ -20,6 +21,7 @@
 #include <QPropertyAnimation>
 #include <QParallelAnimationGroup>
 #include <QEasingCurve>
+#include <QTimer>
 #include <iostream>
 #include "flight_system.h"
 
@@ -88,18 +90,15 @@ public:
         QHBoxLayout* priceLayout = new QHBoxLayout();
         priceLayout->setContentsMargins(0, 10, 0, 0);
         
-        double economyPrice = flight->calculatePrice("Economy", time(nullptr));
-        QLabel* priceLabel = new QLabel(QString("From ₹%1").arg(economyPrice, 0, 'f', 0));
+        priceLabel = new QLabel();
         priceLabel->setStyleSheet("font-size: 18px; font-weight: 700; color: #059669;");
         priceLayout->addWidget(priceLabel);
         
         priceLayout->addStretch();
         
-        int availSeats = flight->getAvailableSeatsCount();
-        QString availColor = availSeats > 50 ? "#10b981" : (availSeats > 20 ? "#f59e0b" : "#ef4444");
-        QLabel* seatsLabel = new QLabel(QString("%1 seats").arg(availSeats));
-        seatsLabel->setStyleSheet(QString("font-size: 12px; color: %1;").arg(availColor));
+        seatsLabel = new QLabel();
         priceLayout->addWidget(seatsLabel);
+        refresh();
         
         layout->addLayout(priceLayout);
 
@@ -118,13 +117,30 @@ public:
 signals:
     void bookClicked(Flight* flight);
 
+public slots:
+    void onSeatsChanged(Flight* changed) {
+        if (changed == flight) refresh();
+    }
+
 private slots:
     void onBookClicked() {
         emit bookClicked(flight);
     }
 
 private:
+    void refresh() {
+        double economyPrice = flight->calculatePrice("Economy", currentTime());
+        priceLabel->setText(QString("From ₹%1").arg(economyPrice, 0, 'f', 0));
+
+        int availSeats = flight->getAvailableSeatsCount();
+        QString availColor = availSeats > 50 ? "#10b981" : (availSeats > 20 ? "#f59e0b" : "#ef4444");
+        seatsLabel->setText(QString("%1 seats").arg(availSeats));
+        seatsLabel->setStyleSheet(QString("font-size: 12px; color: %1;").arg(availColor));
+    }
+
     Flight* flight;
+    QLabel* priceLabel;
+    QLabel* seatsLabel;
 };
 
 class SeatButton : public QPushButton {
@@ -134,12 +150,7 @@ public:
         setText(QString::number(seat->getSeatNumber()));
         setFixedSize(50, 50);
         updateStyle();
-        
-        if (!seat->getIsBooked()) {
-            connect(this, &QPushButton::clicked, this, &SeatButton::onClicked);
-        } else {
-            setEnabled(false);
-        }
+        connect(this, &QPushButton::clicked, this, &SeatButton::onClicked);
     }
 
     Seat* getSeat() const { return seat; }
@@ -150,12 +161,17 @@ public:
         updateStyle();
     }
 
+    // Redraws after the seat was booked, held or released at another counter
+    void refresh() {
+        updateStyle();
+    }
+
 signals:
     void seatSelected(Seat* seat);
 
 private slots:
     void onClicked() {
-        if (!seat->getIsBooked()) {
+        if (seat->isAvailable()) {
             emit seatSelected(seat);
         }
     }
@@ -163,10 +179,13 @@ private slots:
 private:
     void updateStyle() {
         QString style;
+        setEnabled(selected || seat->isAvailable());
         if (seat->getIsBooked()) {
             style = "background: #e5e7eb; color: #9ca3af; border: 1px solid #d1d5db;";
         } else if (selected) {
             style = "background: #6366f1; color: white; border: 2px solid #4f46e5; font-weight: 600;";
+        } else if (seat->isHeld()) {
+            style = "background: #fef3c7; color: #b45309; border: 1px solid #fcd34d;";
         } else {
             style = "background: white; color: #1f2937; border: 1px solid #d1d5db;";
             style += "QPushButton:hover { background: #f3f4f6; border-color: #6366f1; }";
@@ -189,6 +208,10 @@ private:
     QWidget* createFlightsPage();
     QWidget* createBookingsPage();
     void updateBookingsList();
+    void updateFareCalendar(const QString& source, const QString& dest, const QDate& selected);
+
+signals:
+    void seatsChanged(Flight* flight);
 
 private slots:
     void searchFlights();
@@ -212,6 +235,7 @@ private:
     QWidget* flightsScrollContent;
     QComboBox* sourceSelector;
     QComboBox* destSelector;
+    QHBoxLayout* fareCalendarLayout;
 };
 
 MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
@@ -219,6 +243,17 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
     setMinimumSize(1280, 850);
 
     system = new ReservationSystem();
+    // Kiosks on one machine started with --shared-seats claim seats in shared memory before writing
+    if (QCoreApplication::arguments().contains("--shared-seats") && !system->attachSharedSeats()) {
+        cerr << "Running without shared seat maps" << endl;
+    }
+    // Other counters' bookings and holds reach open flight cards and seat maps on the next tick
+    system->setSeatChangeListener([this](Flight* flight, const vector<int>&) { emit seatsChanged(flight); });
+
+    // Abandoned seat holds lapse on the second, including while a dialog is open
+    QTimer* holdTimer = new QTimer(this);
+    connect(holdTimer, &QTimer::timeout, this, [this]() { system->expireHolds(); });
+    holdTimer->start(1000);
 
     QWidget* centralWidget = new QWidget(this);
     setCentralWidget(centralWidget);
@@ -510,6 +545,13 @@ QWidget* MainWindow::createFlightsPage() {
     resultsHeader->setStyleSheet("font-size: 20px; font-weight: 600; color: #1f2937; margin-top: 20px;");
     layout->addWidget(resultsHeader);
 
+    // Fare calendar strip: cheapest fare for the days around the searched date
+    QWidget* fareCalendar = new QWidget();
+    fareCalendarLayout = new QHBoxLayout(fareCalendar);
+    fareCalendarLayout->setSpacing(8);
+    fareCalendarLayout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(fareCalendar);
+
     QScrollArea* scrollArea = new QScrollArea();
     scrollArea->setWidgetResizable(true);
     scrollArea->setFrameShape(QFrame::NoFrame);
@@ -585,7 +627,7 @@ void MainWindow::updateBookingsList() {
             nameLabel->setStyleSheet("font-size: 18px; font-weight: 600; color: #1f2937;");
             infoLayout->addWidget(nameLabel);
 
-            Flight* flight = system->findFlight(booking->getFlightNumber());
+            Flight* flight = system->findFlight(booking->getFlightNumber(), booking->getFlightDate());
             if (flight) {
                 QLabel* routeLabel = new QLabel(QString::fromStdString(
                     flight->getSource() + " → " + flight->getDestination()
@@ -647,6 +689,8 @@ void MainWindow::searchFlights() {
     
     system->searchFlights(dateStr.toStdString(), source.toStdString(), dest.toStdString());
     
+    updateFareCalendar(source, dest, dateSelector->date());
+    
     // Debug output
     cout << "Flights found: " << system->getFlights().size() << endl;
     if (system->getFlights().empty()) {
@@ -671,6 +715,7 @@ void MainWindow::searchFlights() {
         for (Flight* flight : flights) {
             FlightCard* card = new FlightCard(flight);
             connect(card, &FlightCard::bookClicked, this, &MainWindow::showBookingDialog);
+            connect(this, &MainWindow::seatsChanged, card, &FlightCard::onSeatsChanged);
             flightsLayout->addWidget(card, row, col);
             
             col++;
@@ -682,6 +727,55 @@ void MainWindow::searchFlights() {
     }
 }
 
+void MainWindow::updateFareCalendar(const QString& source, const QString& dest, const QDate& selected) {
+    // deleteLater: the clicked day button triggers this rebuild from its own signal
+    QLayoutItem* item;
+    while ((item = fareCalendarLayout->takeAt(0)) != nullptr) {
+        if (item->widget()) item->widget()->deleteLater();
+        delete item;
+    }
+
+    vector<DayFare> fares = system->searchFlexibleDates(
+        selected.toString("yyyy-MM-dd").toStdString(), source.toStdString(), dest.toStdString(), 3);
+
+    for (const DayFare& fare : fares) {
+        QDate date = QDate::fromString(QString::fromStdString(fare.date), "yyyy-MM-dd");
+        bool bookable = fare.available[2] && date >= dateSelector->minimumDate() && date <= dateSelector->maximumDate();
+        QString priceText = bookable ? QString("₹%1").arg(fare.lowestFare[2], 0, 'f', 0) : QString("—");
+
+        QPushButton* dayBtn = new QPushButton(date.toString("ddd, MMM dd") + "\n" + priceText);
+        dayBtn->setCursor(Qt::PointingHandCursor);
+        dayBtn->setEnabled(bookable);
+        if (bookable) {
+            QString tip = QString("Economy ₹%1").arg(fare.lowestFare[2], 0, 'f', 0);
+            if (fare.available[1]) tip += QString("\nBusiness ₹%1").arg(fare.lowestFare[1], 0, 'f', 0);
+            if (fare.available[0]) tip += QString("\nFirst ₹%1").arg(fare.lowestFare[0], 0, 'f', 0);
+            dayBtn->setToolTip(tip);
+        }
+
+        if (date == selected) {
+            dayBtn->setStyleSheet(
+                "QPushButton { background: #eef2ff; color: #4f46e5; border: 2px solid #6366f1; "
+                "border-radius: 8px; padding: 8px 14px; font-size: 13px; font-weight: 700; }"
+            );
+        } else {
+            dayBtn->setStyleSheet(
+                "QPushButton { background: white; color: #374151; border: 1px solid #e5e7eb; "
+                "border-radius: 8px; padding: 8px 14px; font-size: 13px; }"
+                "QPushButton:hover { border-color: #a5b4fc; }"
+                "QPushButton:disabled { color: #9ca3af; background: #f9fafb; }"
+            );
+        }
+
+        connect(dayBtn, &QPushButton::clicked, this, [this, date]() {
+            dateSelector->setDate(date);
+            searchFlights();
+        });
+        fareCalendarLayout->addWidget(dayBtn);
+    }
+    fareCalendarLayout->addStretch();
+}
+
 void MainWindow::showFlights() {
     stackedWidget->setCurrentIndex(0);
     flightsBtn->setStyleSheet(
@@ -790,6 +884,19 @@ void MainWindow::showBookingDialog(Flight* flight) {
     );
     layout->addWidget(classCombo);
 
+    QLabel* groupLabel = new QLabel("Travellers (groups are seated together; enter one name or a comma-separated list):");
+    groupLabel->setStyleSheet("font-weight: 600; color: #374151; margin-top: 5px;");
+    layout->addWidget(groupLabel);
+
+    QSpinBox* groupSize = new QSpinBox();
+    groupSize->setRange(1, Flight::seatClassCapacity(Flight::seatClassIndex("Economy")));
+    groupSize->setValue(1);
+    groupSize->setStyleSheet(
+        "QSpinBox { padding: 8px; border: 1px solid #d1d5db; border-radius: 8px; "
+        "font-size: 14px; background: black; }"
+    );
+    layout->addWidget(groupSize);
+
     QLabel* seatLabel = new QLabel("Select Your Seat:");
     seatLabel->setStyleSheet("font-weight: 600; color: #374151; margin-top: 5px;");
     layout->addWidget(seatLabel);
@@ -799,8 +906,10 @@ void MainWindow::showBookingDialog(Flight* flight) {
     seatScroll->setFrameShape(QFrame::StyledPanel);
     seatScroll->setStyleSheet("QScrollArea { background: white; border-radius: 8px; border: 1px solid #e5e7eb; }");
 
-    // Store selected seat in dialog property
+    // Store selected seat, its hold and the token of the displayed fare in dialog properties
     dialog->setProperty("selectedSeat", QVariant::fromValue<void*>(nullptr));
+    dialog->setProperty("seatHold", QVariant::fromValue<qulonglong>(0));
+    dialog->setProperty("priceLock", QVariant::fromValue<qulonglong>(0));
 
     layout->addWidget(seatScroll, 1);
 
@@ -809,21 +918,32 @@ void MainWindow::showBookingDialog(Flight* flight) {
     layout->addWidget(priceLabel);
 
     auto updatePrice = [=]() {
+        // The fare on screen is locked so confirming charges exactly that amount
+        system->releasePriceLock(dialog->property("priceLock").toULongLong());
+        dialog->setProperty("priceLock", QVariant::fromValue<qulonglong>(0));
+
         Seat* selectedSeat = static_cast<Seat*>(dialog->property("selectedSeat").value<void*>());
-        if (selectedSeat) {
-            double price = flight->calculatePrice(
-                classCombo->currentText().toStdString(),
-                time(nullptr)
-            );
-            priceLabel->setText(QString("Total Price: ₹%1").arg(price, 0, 'f', 2));
+        if (groupSize->value() > 1) {
+            // Groups are seated automatically and pay the fare quoted when they book
+            double fare = system->quotePrice(flight, classCombo->currentText().toStdString());
+            priceLabel->setText(QString("%1 × ₹%2 = ₹%3")
+                .arg(groupSize->value())
+                .arg(fare, 0, 'f', 2)
+                .arg(fare * groupSize->value(), 0, 'f', 2));
+        } else if (selectedSeat) {
+            PriceLock quote = system->lockPrice(flight, classCombo->currentText().toStdString());
+            dialog->setProperty("priceLock", QVariant::fromValue<qulonglong>(quote.token));
+            priceLabel->setText(QString("Total Price: ₹%1").arg(quote.price, 0, 'f', 2));
         } else {
             priceLabel->setText("Select a seat to see the price");
         }
     };
 
     // Now define updateSeats with access to updatePrice
-    auto updateSeats = [dialog, flight, seatScroll, updatePrice](const QString& seatClass) {
-        // Clear the seat selection
+    auto updateSeats = [this, dialog, flight, seatScroll, updatePrice](const QString& seatClass) {
+        // Clear the seat selection and give its seat back
+        system->releaseHold(dialog->property("seatHold").toULongLong());
+        dialog->setProperty("seatHold", QVariant::fromValue<qulonglong>(0));
         dialog->setProperty("selectedSeat", QVariant::fromValue<void*>(nullptr));
         
         // Update price when seat selection is cleared
@@ -841,7 +961,7 @@ void MainWindow::showBookingDialog(Flight* flight) {
         newLayout->setSpacing(15);
         newLayout->setContentsMargins(20, 20, 20, 20);
 
-        vector<Seat*> allSeats = flight->getSeatsByClass(seatClass.toStdString());
+        SeatRange allSeats = flight->getSeatsByClass(seatClass.toStdString());
         
         if (allSeats.empty()) {
             QLabel* noSeats = new QLabel("No seats in this class");
@@ -855,11 +975,12 @@ void MainWindow::showBookingDialog(Flight* flight) {
         // Count available seats
         int availableCount = 0;
         for (auto seat : allSeats) {
-            if (!seat->getIsBooked()) availableCount++;
+            if (seat->isAvailable()) availableCount++;
         }
 
         QLabel* legendLabel = new QLabel(QString("%1 Class - %2/%3 seats available")
             .arg(seatClass).arg(availableCount).arg(allSeats.size()));
+        legendLabel->setObjectName("seatLegend");
         legendLabel->setStyleSheet("font-weight: 600; color: #1f2937; font-size: 14px;");
         newLayout->addWidget(legendLabel);
 
@@ -874,6 +995,10 @@ void MainWindow::showBookingDialog(Flight* flight) {
         bookedLegend->setStyleSheet("color: #9ca3af; font-size: 12px;");
         legendLayout->addWidget(bookedLegend);
         
+        QLabel* heldLegend = new QLabel("● Held at another counter");
+        heldLegend->setStyleSheet("color: #f59e0b; font-size: 12px;");
+        legendLayout->addWidget(heldLegend);
+        
         QLabel* selectedLegend = new QLabel("● Selected");
         selectedLegend->setStyleSheet("color: #6366f1; font-size: 12px;");
         legendLayout->addWidget(selectedLegend);
@@ -884,25 +1009,32 @@ void MainWindow::showBookingDialog(Flight* flight) {
         QGridLayout* seatsGrid = new QGridLayout();
         seatsGrid->setSpacing(10);
 
-        int seatsPerRow = (seatClass == "Economy") ? 10 : 5;
-        
-        // Store all buttons so we can update their selection state
-        QList<SeatButton*> allButtons;
+        int seatsPerRow = Flight::seatsPerRow(Flight::seatClassIndex(seatClass.toStdString()));
         
         for (size_t i = 0; i < allSeats.size(); i++) {
             SeatButton* btn = new SeatButton(allSeats[i]);
-            allButtons.append(btn);
             
-            QObject::connect(btn, &SeatButton::seatSelected, dialog, [dialog, allButtons, btn, updatePrice](Seat* seat) {
-                // Deselect all buttons
-                for (SeatButton* sb : allButtons) {
+            QObject::connect(btn, &SeatButton::seatSelected, dialog, [this, dialog, flight, newContainer, btn, updatePrice](Seat* seat) {
+                // Swap the hold: give the previous seat back, then hold this one
+                system->releaseHold(dialog->property("seatHold").toULongLong());
+                dialog->setProperty("seatHold", QVariant::fromValue<qulonglong>(0));
+                dialog->setProperty("selectedSeat", QVariant::fromValue<void*>(nullptr));
+                uint64_t hold = system->holdSeat(flight, seat->getSeatNumber());
+
+                // Deselect all buttons; a failed hold reloaded the seats, so redraw them all
+                for (SeatButton* sb : newContainer->findChildren<SeatButton*>()) {
                     sb->setSelected(false);
                 }
-                // Select this button
+                if (hold == 0) {
+                    updatePrice();
+                    QMessageBox::warning(dialog, "Seat Unavailable",
+                        QString("Seat %1 was just taken at another counter. Please choose another seat.")
+                        .arg(seat->getSeatNumber()));
+                    return;
+                }
                 btn->setSelected(true);
-                // Store the selected seat in dialog property
+                dialog->setProperty("seatHold", QVariant::fromValue<qulonglong>(hold));
                 dialog->setProperty("selectedSeat", QVariant::fromValue<void*>(seat));
-                // Update the price display
                 updatePrice();
             });
             
@@ -917,8 +1049,33 @@ void MainWindow::showBookingDialog(Flight* flight) {
 
     updateSeats(classCombo->currentText());
     connect(classCombo, &QComboBox::currentTextChanged, updateSeats);
+
+    // Seats taken or freed at another counter; the held seat and its locked fare stay as they are
+    connect(this, &MainWindow::seatsChanged, dialog, [=](Flight* changed) {
+        if (changed != flight || !seatScroll->widget()) return;
+        QList<SeatButton*> buttons = seatScroll->widget()->findChildren<SeatButton*>();
+        int availableCount = 0;
+        for (SeatButton* sb : buttons) {
+            sb->refresh();
+            if (sb->getSeat()->isAvailable()) availableCount++;
+        }
+        QLabel* legendLabel = seatScroll->widget()->findChild<QLabel*>("seatLegend");
+        if (legendLabel) {
+            legendLabel->setText(QString("%1 Class - %2/%3 seats available")
+                .arg(classCombo->currentText()).arg(availableCount).arg(buttons.size()));
+        }
+    });
     
     connect(classCombo, &QComboBox::currentTextChanged, updatePrice);
+    connect(groupSize, QOverload<int>::of(&QSpinBox::valueChanged), [=](int travellers) {
+        seatLabel->setText(travellers > 1 ? "Seats will be assigned together:" : "Select Your Seat:");
+        seatScroll->setEnabled(travellers == 1);
+        if (travellers > 1 && dialog->property("seatHold").toULongLong() != 0) {
+            // Groups are seated automatically; do not keep a single seat held meanwhile
+            updateSeats(classCombo->currentText());
+        }
+        updatePrice();
+    });
     updatePrice();
 
     QHBoxLayout* btnLayout = new QHBoxLayout();
@@ -953,9 +1110,85 @@ void MainWindow::showBookingDialog(Flight* flight) {
             return;
         }
         
+        if (groupSize->value() > 1) {
+            int travellers = groupSize->value();
+            QStringList names = nameInput->text().split(',', Qt::SkipEmptyParts);
+            vector<string> passengerNames;
+            if (names.size() == travellers) {
+                for (const QString& name : names) {
+                    passengerNames.push_back(name.trimmed().toStdString());
+                }
+            } else if (names.size() == 1) {
+                for (int k = 1; k <= travellers; k++) {
+                    passengerNames.push_back(QString("%1 (%2/%3)").arg(names[0].trimmed()).arg(k).arg(travellers).toStdString());
+                }
+            } else {
+                QMessageBox::warning(dialog, "Error",
+                    QString("Enter one lead name or exactly %1 comma-separated names").arg(travellers));
+                return;
+            }
+
+            string seatClass = classCombo->currentText().toStdString();
+            vector<Booking*> group = system->bookGroup(flight, seatClass, passengerNames,
+                                                       emailInput->text().toStdString(),
+                                                       phoneInput->text().toStdString());
+            if (group.empty()) {
+                QMessageBox::warning(dialog, "Error",
+                    QString("No block of %1 adjacent %2 seats is free on this flight.")
+                    .arg(travellers).arg(QString::fromStdString(seatClass)));
+                return;
+            }
+
+            QMessageBox::information(dialog, "Success",
+                QString("Group booking confirmed!\n\nFlight: %1 - %2\nSeats: %3-%4 (%5)\nTravellers: %6\nTotal: ₹%7")
+                .arg(QString::fromStdString(flight->getFlightNumber()))
+                .arg(QString::fromStdString(flight->getFlightName()))
+                .arg(group.front()->getSeatNumber())
+                .arg(group.back()->getSeatNumber())
+                .arg(QString::fromStdString(seatClass))
+                .arg(travellers)
+                .arg(group.front()->getPrice() * travellers, 0, 'f', 2));
+
+            dialog->accept();
+            updateBookingsList();
+            return;
+        }
+
         Seat* selectedSeat = static_cast<Seat*>(dialog->property("selectedSeat").value<void*>());
         if (!selectedSeat) {
-            QMessageBox::warning(dialog, "Error", "Please select a seat");
+            string seatClass = classCombo->currentText().toStdString();
+            bool soldOut = true;
+            for (Seat* seat : flight->getSeatsByClass(seatClass)) {
+                if (!seat->getIsBooked()) soldOut = false;
+            }
+            if (!soldOut) {
+                QMessageBox::warning(dialog, "Error", "Please select a seat");
+                return;
+            }
+
+            // Sold out: offer the class's waitlist instead of losing the sale
+            double fare = system->quotePrice(flight, seatClass);
+            QMessageBox::StandardButton join = QMessageBox::question(dialog, "Class Full",
+                QString("%1 is full on this flight (%2 already waiting).\n\nJoin the waitlist at ₹%3? "
+                        "You will be booked automatically when a seat is cancelled.")
+                .arg(classCombo->currentText())
+                .arg(system->getWaitlistLength(flight, seatClass))
+                .arg(fare, 0, 'f', 2),
+                QMessageBox::Yes | QMessageBox::No);
+            if (join != QMessageBox::Yes) return;
+
+            int64_t entry = system->joinWaitlist(flight, seatClass, nameInput->text().toStdString(),
+                                                 emailInput->text().toStdString(), phoneInput->text().toStdString());
+            if (!entry) {
+                QMessageBox::warning(dialog, "Error", "Could not join the waitlist. Please try again.");
+                return;
+            }
+            QMessageBox::information(dialog, "Waitlisted",
+                QString("You are number %1 on the %2 waitlist for flight %3.")
+                .arg(system->getWaitlistPosition(entry))
+                .arg(classCombo->currentText())
+                .arg(QString::fromStdString(flight->getFlightNumber())));
+            dialog->accept();
             return;
         }
 
@@ -964,12 +1197,36 @@ void MainWindow::showBookingDialog(Flight* flight) {
         string phone = phoneInput->text().toStdString();
         string seatClass = classCombo->currentText().toStdString();
         int seatNumber = selectedSeat->getSeatNumber();
-        double price = flight->calculatePrice(seatClass, time(nullptr));
-        string flightDate = flight->getDepartureTime().substr(0, 10);
+        double price;
+        if (!system->redeemPriceLock(dialog->property("priceLock").toULongLong(), flight, seatClass, price)) {
+            // The lock expired while the dialog was open; the passenger agrees to the current fare first
+            PriceLock quote = system->lockPrice(flight, seatClass);
+            dialog->setProperty("priceLock", QVariant::fromValue<qulonglong>(quote.token));
+            priceLabel->setText(QString("Total Price: ₹%1").arg(quote.price, 0, 'f', 2));
+            QMessageBox::StandardButton accept = QMessageBox::question(dialog, "Fare Changed",
+                QString("The quoted fare has expired. Seat %1 in %2 now costs ₹%3.\n\nBook at this fare?")
+                .arg(seatNumber)
+                .arg(QString::fromStdString(seatClass))
+                .arg(quote.price, 0, 'f', 2),
+                QMessageBox::Yes | QMessageBox::No);
+            // Declining keeps the dialog open with the new fare locked
+            if (accept != QMessageBox::Yes) return;
+            // Charged as shown even if the new lock ran out while the question was open
+            system->releasePriceLock(quote.token);
+            price = quote.price;
+        }
+        dialog->setProperty("priceLock", QVariant::fromValue<qulonglong>(0));
+
+        Booking* booking = system->bookHeldSeat(dialog->property("seatHold").toULongLong(), passengerName, email,
+                                                phone, price);
+        if (!booking) {
+            // The hold lapsed while the form was open; the seat may still be free
+            uint64_t hold = system->holdSeat(flight, seatNumber);
+            booking = hold ? system->bookHeldSeat(hold, passengerName, email, phone, price) : nullptr;
+        }
+        dialog->setProperty("seatHold", QVariant::fromValue<qulonglong>(0));
 
-        if (flight->bookSeat(seatNumber, passengerName)) {
-            system->addBooking(passengerName, email, phone, flight->getFlightNumber(), flightDate, seatNumber, price, seatClass);
-            
+        if (booking) {
             QMessageBox::information(dialog, "Success", 
                 QString("Booking confirmed!\n\nPassenger: %1\nFlight: %2 - %3\nSeat: %4 (%5)\nPrice: ₹%6")
                 .arg(QString::fromStdString(passengerName))
@@ -982,7 +1239,9 @@ void MainWindow::showBookingDialog(Flight* flight) {
             dialog->accept();
             updateBookingsList();
         } else {
-            QMessageBox::warning(dialog, "Error", "Failed to book seat. Please try again.");
+            QMessageBox::warning(dialog, "Error",
+                QString("Seat %1 is no longer available. Please choose another seat.").arg(seatNumber));
+            updateSeats(classCombo->currentText());
         }
     });
     btnLayout->addWidget(confirmBtn);
@@ -990,6 +1249,8 @@ void MainWindow::showBookingDialog(Flight* flight) {
     layout->addLayout(btnLayout);
 
     dialog->exec();
+    system->releasePriceLock(dialog->property("priceLock").toULongLong());
+    system->releaseHold(dialog->property("seatHold").toULongLong());
     delete dialog;
 }
 
@@ -1006,11 +1267,24 @@ void MainWindow::cancelBooking() {
     );
 
     if (reply == QMessageBox::Yes) {
-        if (system->cancelBooking(bookingId)) {
-            QMessageBox::information(this, "Success", "Booking cancelled successfully!\n\n10% cancellation fee applied.");
+        Booking* promoted = nullptr;
+        if (system->cancelBooking(bookingId, &promoted)) {
+            QString message = "Booking cancelled successfully!\n\n10% cancellation fee applied.";
+            if (promoted) {
+                message += QString("\n\nThe seat went to %1 from the waitlist.")
+                    .arg(QString::fromStdString(promoted->getPassengerName()));
+            }
+            QMessageBox::information(this, "Success", message);
             updateBookingsList();
         } else {
-            QMessageBox::warning(this, "Error", "Failed to cancel booking.");
+            QString reason = "Failed to cancel booking.";
+            for (const Booking* booking : system->getBookings()) {
+                if (booking->getBookingId() == bookingId && system->isSealedDate(booking->getFlightDate())) {
+                    reason = "This flight departed in a month that has been sealed into the archive, "
+                             "so the booking can no longer be cancelled.";
+                }
+            }
+            QMessageBox::warning(this, "Error", reason);
         }
     }
 }
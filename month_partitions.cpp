@@ -0,0 +1,359 @@
+#include "month_partitions.h"
+#include "time_core.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+bool validMonth(const string& month) {
+    return month.size() == 7 && parseDayNumber(month + "-01") != INT32_MIN;
+}
+
+/// "2025-10" -> "m2025_10"
+string schemaName(const string& month) {
+    string schema = "m" + month;
+    schema[5] = '_';
+    return schema;
+}
+
+bool fileExists(const string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file) fclose(file);
+    return file != nullptr;
+}
+
+bool exec(sqlite3* db, const string& sql) {
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return false;
+    }
+    return true;
+}
+
+/// Runs one statement whose ?1 and ?2 are the first and the day after the last date of a range
+bool execRange(sqlite3* db, const string& sql, const string& first, const string& next) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, first.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, next.c_str(), -1, SQLITE_STATIC);
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    if (!ok) cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+/// Rowids of a main table whose date column is in [first, next)
+bool collectRowids(sqlite3* db, const string& sql, const string& first, const string& next, vector<int64_t>& rowids) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, first.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, next.c_str(), -1, SQLITE_STATIC);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        rowids.push_back(sqlite3_column_int64(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+vector<string> queryMonths(sqlite3* db, const char* sql, const string& parameter) {
+    vector<string> months;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return months;
+    }
+    if (!parameter.empty()) {
+        sqlite3_bind_text(stmt, 1, parameter.c_str(), -1, SQLITE_STATIC);
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const unsigned char* text = sqlite3_column_text(stmt, 0);
+        if (text) months.push_back(reinterpret_cast<const char*>(text));
+    }
+    sqlite3_finalize(stmt);
+    return months;
+}
+
+} // namespace
+
+string MonthPartitions::monthOf(string_view date) {
+    if (parseDayNumber(date) == INT32_MIN) return "";
+    return string(date.substr(0, 7));
+}
+
+string MonthPartitions::shiftMonth(const string& month, int delta) {
+    int year = 0;
+    int monthNumber = 0;
+    if (!parseDigits(month, 0, 4, year) || !parseDigits(month, 5, 2, monthNumber)) return "";
+    int index = year * 12 + (monthNumber - 1) + delta;
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%04d-%02d", index / 12, index % 12 + 1);
+    return buffer;
+}
+
+string MonthPartitions::pathFor(sqlite3* db, const string& month) {
+    const char* mainPath = db ? sqlite3_db_filename(db, "main") : nullptr;
+    if (!mainPath || !*mainPath) return "";
+    string path = mainPath;
+    if (path.size() > 3 && path.compare(path.size() - 3, 3, ".db") == 0) {
+        path.resize(path.size() - 3);
+    }
+    return path + "." + month + ".db";
+}
+
+vector<string> MonthPartitions::sealedMonths(sqlite3* db, bool includeArchived) {
+    return queryMonths(db, includeArchived ? "SELECT month FROM partition_months ORDER BY month;"
+                                           : "SELECT month FROM partition_months WHERE archived = 0 ORDER BY month;",
+                       "");
+}
+
+string MonthPartitions::schemaFor(sqlite3* db, const string& date, time_t now) {
+    string month = monthOf(date);
+    // Only departed months are sealed, so the hot months never cost a lookup
+    if (month.empty() || month >= monthOf(formatDate(localDayNumber(now)))) return "main";
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT archived FROM partition_months WHERE month = ?;", -1, &stmt, nullptr) !=
+        SQLITE_OK) {
+        return "main";
+    }
+    sqlite3_bind_text(stmt, 1, month.c_str(), -1, SQLITE_STATIC);
+    int state = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : -1;
+    sqlite3_finalize(stmt);
+
+    if (state < 0) return "main";
+    if (state > 0) {
+        detach(db, month);
+        return "";
+    }
+    string schema;
+    return attach(db, month, schema) ? schema : "";
+}
+
+bool MonthPartitions::attach(sqlite3* db, const string& month, string& schema, bool create) {
+    for (Attachment& a : attachments) {
+        if (a.month == month) {
+            a.lastUse = ++useClock;
+            schema = a.schema;
+            return true;
+        }
+    }
+    string path = pathFor(db, month);
+    if (path.empty() || !validMonth(month) || (!create && !fileExists(path))) return false;
+
+    if (attachments.size() >= MAX_ATTACHED) {
+        auto oldest = min_element(attachments.begin(), attachments.end(),
+                                  [](const Attachment& a, const Attachment& b) { return a.lastUse < b.lastUse; });
+        detach(db, oldest->month);
+    }
+
+    schema = schemaName(month);
+    string sql = "ATTACH DATABASE ? AS " + schema + ";";
+    sqlite3_stmt* stmt = nullptr;
+    bool ok = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK;
+    if (ok) {
+        sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_STATIC);
+        ok = sqlite3_step(stmt) == SQLITE_DONE;
+    }
+    sqlite3_finalize(stmt);
+    if (!ok) {
+        cerr << "Cannot attach " << path << ": " << sqlite3_errmsg(db) << endl;
+        return false;
+    }
+    attachments.push_back(Attachment{month, schema, ++useClock});
+
+    // Same columns and keys as the main tables, so rows move with INSERT ... SELECT *
+    if (create &&
+        !exec(db, "CREATE TABLE IF NOT EXISTS " + schema + ".flights ("
+                  "flight_number TEXT, flight_name TEXT, source TEXT, destination TEXT, date TEXT, "
+                  "departure_time TEXT, base_price REAL, PRIMARY KEY (flight_number, date));"
+                  "CREATE INDEX IF NOT EXISTS " + schema + ".idx_flights_route_date "
+                  "ON flights (source, destination, date);"
+                  "CREATE TABLE IF NOT EXISTS " + schema + ".booked_seats ("
+                  "flight_number TEXT, flight_date TEXT, seat_number INTEGER, passenger_name TEXT, "
+                  "PRIMARY KEY (flight_number, flight_date, seat_number));")) {
+        detach(db, month);
+        return false;
+    }
+    return true;
+}
+
+void MonthPartitions::detach(sqlite3* db, const string& month) {
+    for (size_t i = 0; i < attachments.size(); i++) {
+        if (attachments[i].month != month) continue;
+        if (exec(db, "DETACH DATABASE " + attachments[i].schema + ";")) {
+            attachments.erase(attachments.begin() + i);
+        }
+        return;
+    }
+}
+
+void MonthPartitions::detachAll(sqlite3* db) {
+    vector<Attachment> attached = attachments;
+    for (const Attachment& a : attached) {
+        detach(db, a.month);
+    }
+}
+
+bool MonthPartitions::deleteRows(sqlite3* db, const char* table, const vector<int64_t>& rowids,
+                                 size_t rowsPerTransaction, const function<bool()>& between) {
+    string sql = string("DELETE FROM main.") + table + " WHERE rowid = ?;";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return false;
+    }
+
+    bool ok = true;
+    for (size_t begin = 0; ok && begin < rowids.size(); begin += rowsPerTransaction) {
+        if (begin > 0 && !between()) {
+            ok = false;
+            break;
+        }
+        ok = sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) == SQLITE_OK;
+        size_t end = min(rowids.size(), begin + rowsPerTransaction);
+        for (size_t i = begin; ok && i < end; i++) {
+            sqlite3_bind_int64(stmt, 1, rowids[i]);
+            ok = sqlite3_step(stmt) == SQLITE_DONE;
+            sqlite3_reset(stmt);
+        }
+        if (!ok || sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            cerr << "Partition cleanup of " << table << " failed: " << sqlite3_errmsg(db) << endl;
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            ok = false;
+        }
+    }
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+bool MonthPartitions::seal(sqlite3* db, const string& month, size_t rowsPerTransaction,
+                           const function<bool()>& between) {
+    if (!db || !validMonth(month) || rowsPerTransaction == 0) return false;
+    string first = month + "-01";
+    string next = shiftMonth(month, 1) + "-01";
+
+    string schema;
+    if (!attach(db, month, schema, true)) return false;
+
+    // 1. Copy in a deferred transaction: the main database is only read, so bookings keep writing
+    bool ok = exec(db, "BEGIN;") &&
+              execRange(db, "INSERT OR IGNORE INTO " + schema + ".flights SELECT * FROM main.flights_archive "
+                            "WHERE date >= ?1 AND date < ?2;", first, next) &&
+              execRange(db, "INSERT OR IGNORE INTO " + schema + ".booked_seats SELECT * FROM main.booked_seats "
+                            "WHERE flight_date >= ?1 AND flight_date < ?2;", first, next) &&
+              exec(db, "COMMIT;");
+    if (!ok) {
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        cerr << "Sealing " << month << " failed" << endl;
+        return false;
+    }
+
+    // 2. Register the partition; from here on reads of the month go to it
+    sqlite3_stmt* stmt = nullptr;
+    ok = sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO partition_months VALUES (?, ?, 0);", -1, &stmt, nullptr) ==
+         SQLITE_OK;
+    if (ok) {
+        sqlite3_bind_text(stmt, 1, month.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, currentTime());
+        ok = sqlite3_step(stmt) == SQLITE_DONE;
+    }
+    sqlite3_finalize(stmt);
+    if (!ok) {
+        cerr << "Registering partition " << month << " failed: " << sqlite3_errmsg(db) << endl;
+        return false;
+    }
+
+    // 3. Delete the copies from the main database in bounded transactions, by rowid
+    //    (neither table is indexed by date alone, so each range is scanned once)
+    vector<int64_t> flightRows;
+    vector<int64_t> seatRows;
+    return collectRowids(db, "SELECT rowid FROM main.flights_archive WHERE date >= ?1 AND date < ?2;", first, next,
+                         flightRows) &&
+           collectRowids(db, "SELECT rowid FROM main.booked_seats WHERE flight_date >= ?1 AND flight_date < ?2;",
+                         first, next, seatRows) &&
+           deleteRows(db, "flights_archive", flightRows, rowsPerTransaction, between) &&
+           deleteRows(db, "booked_seats", seatRows, rowsPerTransaction, between);
+}
+
+int MonthPartitions::sealDeparted(sqlite3* db, time_t now, size_t rowsPerTransaction,
+                                  const function<bool()>& between) {
+    if (!db) return -1;
+    string currentStart = monthOf(formatDate(localDayNumber(now))) + "-01";
+
+    vector<string> months = queryMonths(db,
+        "SELECT substr(date, 1, 7) FROM flights_archive WHERE date < ?1 "
+        "UNION SELECT substr(flight_date, 1, 7) FROM booked_seats WHERE flight_date < ?1;", currentStart);
+    vector<string> archived = queryMonths(db, "SELECT month FROM partition_months WHERE archived = 1;", "");
+
+    int sealed = 0;
+    for (const string& month : months) {
+        // An archived month's file is gone; stray rows stay rather than start a second file
+        if (!validMonth(month) || find(archived.begin(), archived.end(), month) != archived.end()) continue;
+        // Days still in the live window are archived first, by the schedule maintainer
+        sqlite3_stmt* stmt = nullptr;
+        bool live = true;
+        if (sqlite3_prepare_v2(db, "SELECT 1 FROM flights WHERE date >= ?1 AND date < ?2 LIMIT 1;", -1, &stmt,
+                               nullptr) == SQLITE_OK) {
+            string first = month + "-01";
+            string next = shiftMonth(month, 1) + "-01";
+            sqlite3_bind_text(stmt, 1, first.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, 2, next.c_str(), -1, SQLITE_TRANSIENT);
+            live = sqlite3_step(stmt) == SQLITE_ROW;
+        }
+        sqlite3_finalize(stmt);
+        if (live) continue;
+
+        if (!between() || !seal(db, month, rowsPerTransaction, between)) {
+            detachAll(db);
+            return -1;
+        }
+        sealed++;
+    }
+    detachAll(db);
+    return sealed;
+}
+
+int MonthPartitions::archiveBefore(sqlite3* db, const string& month, const string& directory) {
+    if (!db) return -1;
+    error_code error;
+    filesystem::create_directories(directory, error);
+    if (error) {
+        cerr << "Cannot create " << directory << ": " << error.message() << endl;
+        return -1;
+    }
+
+    int archived = 0;
+    for (const string& sealed : sealedMonths(db)) {
+        if (sealed >= month) break;
+        detach(db, sealed);
+
+        // The file moves first: a crash in between leaves a registered month without a file,
+        // which reads as archived
+        string path = pathFor(db, sealed);
+        string target = directory + "/" + path.substr(path.find_last_of("/\\") + 1);
+        if (fileExists(path) && rename(path.c_str(), target.c_str()) != 0) {
+            cerr << "Cannot move " << path << " to " << target << endl;
+            return -1;
+        }
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db, "UPDATE partition_months SET archived = 1 WHERE month = ?;", -1, &stmt,
+                               nullptr) == SQLITE_OK) {
+            sqlite3_bind_text(stmt, 1, sealed.c_str(), -1, SQLITE_STATIC);
+            sqlite3_step(stmt);
+        }
+        sqlite3_finalize(stmt);
+        archived++;
+    }
+    return archived;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file month_partitions.h
+ * @brief Departed months of flights and booked seats in per-month database files
+ *
+ * The main database keeps the live schedule window, the current month's
+ * departed flights and every booked seat not yet sealed. Once a month has
+ * fully departed, seal() moves its flights_archive and booked_seats rows to
+ * "<database>.YYYY-MM.db" beside the main file and records the month in
+ * partition_months, so the tables and indexes every booking writes to stay
+ * the size of a few months whatever the history.
+ *
+ * Reads are routed by flight date: schemaFor() answers "main" for months
+ * that are not sealed and otherwise attaches the month's file on demand,
+ * keeping at most MAX_ATTACHED partitions attached per connection. Old
+ * partitions are detached and moved into an archive directory as whole
+ * files; put a file back and clear its archived flag to query it again.
+ *
+ * One MonthPartitions tracks the attachments of one connection.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef MONTH_PARTITIONS_H
+#define MONTH_PARTITIONS_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ctime>
+#include <cstdint>
+#include <functional>
+
+struct sqlite3;  // Forward declaration for SQLite database handle
+
+using namespace std;
+
+/**
+ * @class MonthPartitions
+ * @brief Seals, attaches, routes to and archives monthly partition files
+ */
+class MonthPartitions {
+public:
+    static const size_t MAX_ATTACHED = 6;  ///< Partitions attached at once; SQLite allows 10 by default
+
+    MonthPartitions() : useClock(0) {}
+    MonthPartitions(const MonthPartitions&) = delete;
+    MonthPartitions& operator=(const MonthPartitions&) = delete;
+
+    /**
+     * @brief "YYYY-MM" of a date (YYYY-MM-DD), or "" if it is not a valid date
+     */
+    static string monthOf(string_view date);
+
+    /**
+     * @brief The month delta months after month ("2025-11", -2 -> "2025-09")
+     */
+    static string shiftMonth(const string& month, int delta);
+
+    /**
+     * @brief Partition file of a month, beside the main database of db; "" for in-memory databases
+     */
+    static string pathFor(sqlite3* db, const string& month);
+
+    /**
+     * @brief Sealed months in ascending order
+     * @param includeArchived Also list months whose files were archived
+     */
+    static vector<string> sealedMonths(sqlite3* db, bool includeArchived = false);
+
+    /**
+     * @brief Schema holding the flights and booked seats of a date
+     * @param db Connection to route on; must not be inside a transaction
+     * @param date Flight date (YYYY-MM-DD)
+     * @param now Current time; the current month and later are never sealed
+     * @return "main", the attached partition's schema, or "" if the month's file
+     *         was archived or cannot be opened
+     */
+    string schemaFor(sqlite3* db, const string& date, time_t now);
+
+    /**
+     * @brief Attaches a sealed month's file, detaching the least recently used one if needed
+     * @param schema Set to the schema name ("m2025_10")
+     * @param create Create the file and its tables if it does not exist
+     * @return false if the file is missing (and create is false) or cannot be attached
+     */
+    bool attach(sqlite3* db, const string& month, string& schema, bool create = false);
+
+    /**
+     * @brief Detaches every partition this object attached
+     */
+    void detachAll(sqlite3* db);
+
+    /**
+     * @brief Moves one departed month out of the main database
+     * @param db Connection to the main database, outside a transaction
+     * @param month Month to seal; must be before the current month with no live flights left
+     * @param rowsPerTransaction Rows deleted from the main database per transaction
+     * @param between Called between transactions; returning false stops early
+     * @return false on error or if stopped; a later call resumes where it stopped
+     *
+     * Rows are copied to the partition in one transaction, the month is
+     * registered so readers switch to the partition, and only then are the
+     * rows deleted from the main database.
+     */
+    bool seal(sqlite3* db, const string& month, size_t rowsPerTransaction, const function<bool()>& between);
+
+    /**
+     * @brief Seals every fully departed month still in the main database
+     * @return Months sealed, or -1 if one failed
+     */
+    int sealDeparted(sqlite3* db, time_t now, size_t rowsPerTransaction, const function<bool()>& between);
+
+    /**
+     * @brief Detaches partitions of months before a month and moves their files into a directory
+     * @param directory Archive directory, created if needed
+     * @return Files archived, or -1 if one could not be moved
+     */
+    int archiveBefore(sqlite3* db, const string& month, const string& directory);
+
+private:
+    /// One attached partition of this connection
+    struct Attachment {
+        string month;
+        string schema;
+        uint64_t lastUse;
+    };
+
+    vector<Attachment> attachments;
+    uint64_t useClock;
+
+    void detach(sqlite3* db, const string& month);
+
+    /**
+     * @brief Deletes rowids from a main table, rowsPerTransaction at a time
+     */
+    static bool deleteRows(sqlite3* db, const char* table, const vector<int64_t>& rowids, size_t rowsPerTransaction,
+                           const function<bool()>& between);
+};
+
+#endif // MONTH_PARTITIONS_H
@@ -0,0 +1,332 @@
+#include "pricing_rules.h"
+#include <sqlite3.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+
+const PricingTable defaultTable = PricingTable::defaults();
+atomic<const PricingTable*> activeTable(&defaultTable);
+
+mutex publishLock;
+vector<unique_ptr<PricingTable>> publishedTables;  ///< Never freed: readers may still hold any of them
+uint64_t nextVersion = 1;
+
+bool parseNumber(const string& text, double& value) {
+    char* end = nullptr;
+    value = strtod(text.c_str(), &end);
+    return !text.empty() && *end == '\0' && isfinite(value);
+}
+
+bool parseMultiplier(const string& text, double& value, string& error) {
+    if (!parseNumber(text, value) || value <= 0.0) {
+        error = "invalid multiplier '" + text + "'";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Applies the rules of one source (file or table) to a table. Advance
+ * rules are collected and compiled into sorted edges when the source ends.
+ */
+class RuleCompiler {
+public:
+    explicit RuleCompiler(PricingTable& t) : table(t), hoursReset(false) {}
+
+    bool apply(const vector<string>& tokens, string& error) {
+        const string& kind = tokens[0];
+        if (kind == "class" && tokens.size() == 3) {
+            static const char* names[3] = {"First", "Business", "Economy"};
+            for (int c = 0; c < 3; c++) {
+                if (tokens[1] == names[c]) return parseMultiplier(tokens[2], table.classMultiplier[c], error);
+            }
+            error = "unknown seat class '" + tokens[1] + "'";
+            return false;
+        }
+        if (kind == "demand" && tokens.size() == 2) {
+            if (!parseNumber(tokens[1], table.demandSlope)) {
+                error = "invalid demand slope '" + tokens[1] + "'";
+                return false;
+            }
+            return true;
+        }
+        if (kind == "advance" && tokens.size() == 3) {
+            bool strict = !tokens[1].empty() && tokens[1][0] == '>';
+            double hours;
+            double multiplier;
+            if (!parseNumber(tokens[1].substr(strict ? 1 : 0), hours) || hours < 0.0) {
+                error = "invalid advance threshold '" + tokens[1] + "'";
+                return false;
+            }
+            if (!parseMultiplier(tokens[2], multiplier, error)) return false;
+            advance.push_back({llround(hours * 3600.0) + (strict ? 1 : 0), multiplier});
+            return true;
+        }
+        if (kind == "hour" && tokens.size() == 4) {
+            double from, to, multiplier;
+            if (!parseNumber(tokens[1], from) || !parseNumber(tokens[2], to) || from != floor(from) ||
+                to != floor(to) || from < 0 || to > 24 || from >= to) {
+                error = "invalid hour range '" + tokens[1] + " " + tokens[2] + "'";
+                return false;
+            }
+            if (!parseMultiplier(tokens[3], multiplier, error)) return false;
+            if (!hoursReset) {
+                fill(begin(table.hourMultiplier), end(table.hourMultiplier), 1.0);
+                hoursReset = true;
+            }
+            for (int h = (int)from; h < (int)to; h++) {
+                table.hourMultiplier[h] = multiplier;
+            }
+            return true;
+        }
+        error = "unrecognized rule '" + kind + "'";
+        return false;
+    }
+
+    bool finish(string& error) {
+        if (advance.empty()) return true;
+        if (advance.size() > PricingTable::MAX_ADVANCE_EDGES + 1) {
+            error = "too many advance rules";
+            return false;
+        }
+        sort(advance.begin(), advance.end());
+        for (size_t i = 1; i < advance.size(); i++) {
+            if (advance[i].first == advance[i - 1].first) {
+                error = "duplicate advance threshold";
+                return false;
+            }
+        }
+        // The lowest rule has no edge of its own: it covers everything below the next one
+        table.advanceMultiplier[0] = advance[0].second;
+        for (int i = 0; i < PricingTable::MAX_ADVANCE_EDGES; i++) {
+            bool used = i + 1 < (int)advance.size();
+            table.advanceEdge[i] = used ? advance[i + 1].first : INT64_MAX;
+            table.advanceMultiplier[i + 1] = used ? advance[i + 1].second : 1.0;
+        }
+        return true;
+    }
+
+private:
+    PricingTable& table;
+    vector<pair<int64_t, double>> advance;
+    bool hoursReset;
+};
+
+string formatValue(double value) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.17g", value);
+    return buffer;
+}
+
+/// Modification time and size of the rules file, or {-1, -1} if it does not exist
+pair<long long, long long> fileSignature(const string& path) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) return {-1, -1};
+    return {(long long)info.st_mtime, (long long)info.st_size};
+}
+
+long long rulesVersion(sqlite3* db) {
+    sqlite3_stmt* stmt;
+    long long version = 0;
+    if (sqlite3_prepare_v2(db, "SELECT version FROM pricing_meta WHERE id = 1;", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) version = sqlite3_column_int64(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    return version;
+}
+
+} // namespace
+
+// ==================== PRICING TABLE ====================
+
+PricingTable PricingTable::defaults() {
+    const int64_t HOUR = 60 * 60;
+    PricingTable t;
+    t.classMultiplier[0] = 3.0;
+    t.classMultiplier[1] = 2.0;
+    t.classMultiplier[2] = 1.0;
+    t.demandSlope = 0.5;
+
+    // Under 1 day 1.5, under 3 days 1.3, under 7 days 1.15, over 30 days 0.85
+    const int64_t edges[] = {24 * HOUR, 72 * HOUR, 168 * HOUR, 720 * HOUR + 1};
+    const double multipliers[] = {1.5, 1.3, 1.15, 1.0, 0.85};
+    t.advanceMultiplier[0] = multipliers[0];
+    for (int i = 0; i < MAX_ADVANCE_EDGES; i++) {
+        t.advanceEdge[i] = i < 4 ? edges[i] : INT64_MAX;
+        t.advanceMultiplier[i + 1] = i < 4 ? multipliers[i + 1] : 1.0;
+    }
+
+    // Night 0.90, morning peak 1.25, mid-morning 1.10, afternoon 0.95, late afternoon 1.05, evening peak 1.30
+    const double hours[24] = {0.90, 0.90, 0.90, 0.90, 0.90, 0.90, 1.25, 1.25, 1.25, 1.10, 1.10, 1.10,
+                              0.95, 0.95, 0.95, 1.05, 1.05, 1.05, 1.30, 1.30, 1.30, 0.90, 0.90, 0.90};
+    copy(begin(hours), end(hours), t.hourMultiplier);
+    t.version = 0;
+    return t;
+}
+
+bool PricingTable::sameFactors(const PricingTable& other) const {
+    return equal(begin(classMultiplier), end(classMultiplier), other.classMultiplier) &&
+           demandSlope == other.demandSlope &&
+           equal(begin(advanceEdge), end(advanceEdge), other.advanceEdge) &&
+           equal(begin(advanceMultiplier), end(advanceMultiplier), other.advanceMultiplier) &&
+           equal(begin(hourMultiplier), end(hourMultiplier), other.hourMultiplier);
+}
+
+// ==================== PRICING RULES ====================
+
+const char* PricingRules::DEFAULT_RULES_PATH = "pricing_rules.conf";
+
+const PricingTable& PricingRules::active() {
+    return *activeTable.load(memory_order_acquire);
+}
+
+void PricingRules::install(const PricingTable& table) {
+    lock_guard<mutex> guard(publishLock);
+    publishedTables.emplace_back(new PricingTable(table));
+    publishedTables.back()->version = nextVersion++;
+    activeTable.store(publishedTables.back().get(), memory_order_release);
+}
+
+bool PricingRules::parse(istream& in, PricingTable& table, string& error) {
+    RuleCompiler compiler(table);
+    string line;
+    int lineNumber = 0;
+    while (getline(in, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != string::npos) line.erase(comment);
+
+        istringstream words(line);
+        vector<string> tokens;
+        string word;
+        while (words >> word) tokens.push_back(word);
+        if (tokens.empty()) continue;
+
+        if (!compiler.apply(tokens, error)) {
+            error = "line " + to_string(lineNumber) + ": " + error;
+            return false;
+        }
+    }
+    return compiler.finish(error);
+}
+
+bool PricingRules::loadDatabase(sqlite3* db, PricingTable& table, string& error) {
+    sqlite3_stmt* stmt;
+    const char* sql = "SELECT kind, arg1, arg2, value FROM pricing_rules ORDER BY id;";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        error = sqlite3_errmsg(db);
+        return false;
+    }
+
+    RuleCompiler compiler(table);
+    bool ok = true;
+    while (ok && sqlite3_step(stmt) == SQLITE_ROW) {
+        vector<string> tokens;
+        for (int col = 0; col < 3; col++) {
+            const unsigned char* text = sqlite3_column_text(stmt, col);
+            if (text) tokens.push_back(reinterpret_cast<const char*>(text));
+        }
+        tokens.push_back(formatValue(sqlite3_column_double(stmt, 3)));
+        if (!compiler.apply(tokens, error)) {
+            error = "pricing_rules id " + to_string(sqlite3_column_int64(stmt, 0)) + ": " + error;
+            ok = false;
+        }
+    }
+    sqlite3_finalize(stmt);
+    return ok && compiler.finish(error);
+}
+
+// ==================== PRICING RULES WATCHER ====================
+
+PricingRulesWatcher::PricingRulesWatcher() : stopping(false), initialLoadDone(false) {}
+
+PricingRulesWatcher::~PricingRulesWatcher() {
+    stop();
+}
+
+bool PricingRulesWatcher::reload(sqlite3* db, const string& rulesPath) {
+    PricingTable table = PricingTable::defaults();
+    string error;
+    if (db && !PricingRules::loadDatabase(db, table, error)) {
+        cerr << "Pricing rules table rejected: " << error << endl;
+        return false;
+    }
+    ifstream file(rulesPath);
+    if (file && !PricingRules::parse(file, table, error)) {
+        cerr << "Pricing rules file " << rulesPath << " rejected: " << error << endl;
+        return false;
+    }
+
+    if (table.sameFactors(PricingRules::active())) return false;
+    PricingRules::install(table);
+    cout << "Pricing rules version " << PricingRules::active().version << " active" << endl;
+    return true;
+}
+
+void PricingRulesWatcher::start(const string& dbPath, const string& rulesPath) {
+    if (worker.joinable()) return;
+    stopping = false;
+    initialLoadDone = false;
+    worker = thread(&PricingRulesWatcher::run, this, dbPath, rulesPath);
+
+    // Wait for the first load so no quote is priced with stale factors
+    unique_lock<mutex> guard(lock);
+    wakeup.wait(guard, [this]() { return initialLoadDone; });
+}
+
+void PricingRulesWatcher::stop() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+void PricingRulesWatcher::run(string dbPath, string rulesPath) {
+    sqlite3* db = nullptr;
+    if (sqlite3_open(dbPath.c_str(), &db) != SQLITE_OK) {
+        cerr << "Pricing rules watcher failed to open database: " << sqlite3_errmsg(db) << endl;
+        sqlite3_close(db);
+        db = nullptr;
+    } else {
+        sqlite3_busy_timeout(db, 5000);
+    }
+
+    long long lastVersion = -1;
+    pair<long long, long long> lastFile(-2, -2);
+
+    unique_lock<mutex> guard(lock);
+    while (!stopping) {
+        guard.unlock();
+        long long version = db ? rulesVersion(db) : 0;
+        pair<long long, long long> file = fileSignature(rulesPath);
+        if (version != lastVersion || file != lastFile) {
+            reload(db, rulesPath);
+            lastVersion = version;
+            lastFile = file;
+        }
+        guard.lock();
+        if (!initialLoadDone) {
+            initialLoadDone = true;
+            wakeup.notify_all();
+        }
+        wakeup.wait_for(guard, chrono::seconds(POLL_INTERVAL_SECONDS), [this]() { return stopping; });
+    }
+    guard.unlock();
+
+    sqlite3_close(db);
+}
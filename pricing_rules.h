@@ -0,0 +1,169 @@
+/**
+ * @file pricing_rules.h
+ * @brief Table-driven fare factors with hot reload
+ *
+ * The class, demand, advance-purchase and time-of-day factors are read from
+ * the pricing_rules table and an optional rules file, compiled into flat
+ * lookup arrays and published with a single atomic pointer store. Quotes
+ * read the active table without locks, so revenue management can change
+ * factors while searches and bookings keep running.
+ *
+ * Rules file syntax (one rule per line, '#' starts a comment):
+ * @code
+ * class First 3.0          # seat class multiplier
+ * demand 0.5               # price *= 1 + occupancy * slope
+ * advance 24 1.3           # from 24 hours before departure (inclusive)
+ * advance >720 0.85        # more than 720 hours before departure
+ * hour 6 9 1.25            # departures from 06:00 up to 09:00
+ * @endcode
+ * The lowest advance rule also applies below its threshold. Hours without
+ * an hour rule price at 1.0.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef PRICING_RULES_H
+#define PRICING_RULES_H
+
+#include <string>
+#include <istream>
+#include <ctime>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+struct sqlite3;  // Forward declaration for SQLite database handle
+
+using namespace std;
+
+/**
+ * @struct PricingTable
+ * @brief Compiled fare factors; immutable once published
+ */
+struct PricingTable {
+    static const int MAX_ADVANCE_EDGES = 8;
+
+    double classMultiplier[3];                          ///< Indexed by Flight::seatClassIndex()
+    double demandSlope;                                 ///< Demand factor is 1 + occupancy * slope
+    int64_t advanceEdge[MAX_ADVANCE_EDGES];             ///< Seconds before departure, ascending; unused = INT64_MAX
+    double advanceMultiplier[MAX_ADVANCE_EDGES + 1];    ///< [i] applies when i edges are reached
+    double hourMultiplier[24];                          ///< By local departure hour
+    uint64_t version;                                   ///< Assigned on publish; changes with every reload
+
+    /**
+     * @brief Fare for one seat; the same product as the legacy if/else chains
+     *
+     * No branches on the factor values: the advance bucket is the number of
+     * edges reached, so evaluation cost does not depend on the rules.
+     */
+    double quote(double basePrice, int classIndex, int bookedSeats, int totalSeats,
+                 time_t secondsUntilDeparture, int departureHour) const {
+        double occupancyRate = (double)bookedSeats / totalSeats;
+        return basePrice * classMultiplier[classIndex] * (1.0 + occupancyRate * demandSlope) *
+               advanceMultiplier[advanceBucket(secondsUntilDeparture)] *
+               hourMultiplier[(unsigned)departureHour % 24];
+    }
+
+    /**
+     * @brief Index into advanceMultiplier: the number of edges reached
+     */
+    int advanceBucket(time_t secondsUntilDeparture) const {
+        int bucket = 0;
+        for (int i = 0; i < MAX_ADVANCE_EDGES; i++) {
+            bucket += (int64_t)secondsUntilDeparture >= advanceEdge[i];
+        }
+        return bucket;
+    }
+
+    /**
+     * @brief True if both tables price every quote the same (version ignored)
+     */
+    bool sameFactors(const PricingTable& other) const;
+
+    /**
+     * @brief The factors that were hardcoded before the rules engine
+     */
+    static PricingTable defaults();
+};
+
+/**
+ * @class PricingRules
+ * @brief Process-wide active pricing table plus rule parsing and loading
+ */
+class PricingRules {
+public:
+    static const char* DEFAULT_RULES_PATH;  ///< Optional rules file read next to the database
+
+    /**
+     * @brief The table quotes currently use; lock-free, valid until exit
+     */
+    static const PricingTable& active();
+
+    /**
+     * @brief Publishes a copy of table under a new version
+     *
+     * Readers that already hold the previous table keep using it safely;
+     * retired tables are kept until exit (a few hundred bytes per reload).
+     */
+    static void install(const PricingTable& table);
+
+    /**
+     * @brief Applies every rule of a rules file on top of table
+     * @return false (table unspecified) if any line is malformed
+     */
+    static bool parse(istream& in, PricingTable& table, string& error);
+
+    /**
+     * @brief Applies the rows of the pricing_rules table on top of table
+     * @return false (table unspecified) if any row is malformed or the query fails
+     */
+    static bool loadDatabase(sqlite3* db, PricingTable& table, string& error);
+};
+
+/**
+ * @class PricingRulesWatcher
+ * @brief Reloads the active table when the rules file or pricing_rules table changes
+ *
+ * Polls the file modification time and pricing_meta.version (bumped by
+ * triggers on pricing_rules) on its own connection. Defaults are overlaid
+ * by the database rules and then by the file; a source that fails to parse
+ * leaves the active table untouched.
+ */
+class PricingRulesWatcher {
+public:
+    PricingRulesWatcher();
+    ~PricingRulesWatcher();
+    PricingRulesWatcher(const PricingRulesWatcher&) = delete;
+    PricingRulesWatcher& operator=(const PricingRulesWatcher&) = delete;
+
+    /**
+     * @brief Loads the rules now, then keeps polling on a worker thread
+     */
+    void start(const string& dbPath, const string& rulesPath);
+
+    /**
+     * @brief Stops the worker
+     */
+    void stop();
+
+    /**
+     * @brief Rebuilds the table from defaults, db and rulesPath and installs it if it differs
+     * @return true if a new table was published
+     */
+    static bool reload(sqlite3* db, const string& rulesPath);
+
+private:
+    static const int POLL_INTERVAL_SECONDS = 2;
+
+    thread worker;
+    mutex lock;
+    condition_variable wakeup;
+    bool stopping;
+    bool initialLoadDone;
+
+    void run(string dbPath, string rulesPath);
+};
+
+#endif // PRICING_RULES_H
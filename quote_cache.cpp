@@ -0,0 +1,99 @@
+#include "quote_cache.h"
+#include "flight_system.h"
+
+using namespace std;
+
+QuoteCache::QuoteCache() : tokenSource(random_device{}()), hits(0), misses(0) {}
+
+double QuoteCache::quoteLocked(const Flight& flight, int classIndex, time_t now) {
+    const PricingTable& rules = PricingRules::active();
+    time_t secondsUntilDeparture = flight.getDepartureTimestamp() - now;
+    uint64_t key = internPair(flight.getFlightNumberId(), flight.getDateId());
+
+    if (flights.size() >= MAX_FLIGHTS && flights.find(key) == flights.end()) {
+        flights.clear();
+    }
+    Entry& entry = flights[key].slots[classIndex][rules.advanceBucket(secondsUntilDeparture)];
+    if (entry.occupancyEpoch == flight.getOccupancyEpoch() && entry.rulesVersion == rules.version) {
+        hits++;
+        return entry.price;
+    }
+
+    misses++;
+    entry.price = flight.calculatePrice(Flight::seatClassName(classIndex), now);
+    entry.occupancyEpoch = flight.getOccupancyEpoch();
+    entry.rulesVersion = rules.version;
+    return entry.price;
+}
+
+double QuoteCache::quote(const Flight& flight, string_view seatClass, time_t now) {
+    lock_guard<mutex> guard(lock);
+    return quoteLocked(flight, Flight::seatClassIndex(seatClass), now);
+}
+
+PriceLock QuoteCache::lockPrice(const Flight& flight, string_view seatClass, time_t now) {
+    lock_guard<mutex> guard(lock);
+    pruneExpiredLocks(now);
+
+    int classIndex = Flight::seatClassIndex(seatClass);
+    PriceLock priceLock;
+    priceLock.price = quoteLocked(flight, classIndex, now);
+    priceLock.expiresAt = now + PRICE_LOCK_SECONDS;
+    do {
+        priceLock.token = tokenSource();
+    } while (priceLock.token == 0 || locks.count(priceLock.token));
+
+    locks[priceLock.token] = LockEntry{internPair(flight.getFlightNumberId(), flight.getDateId()), classIndex,
+                                       priceLock.price, priceLock.expiresAt};
+    return priceLock;
+}
+
+bool QuoteCache::redeemPriceLock(uint64_t token, const Flight& flight, string_view seatClass, time_t now,
+                                 double& price) {
+    lock_guard<mutex> guard(lock);
+    auto it = locks.find(token);
+    if (it == locks.end()) return false;
+
+    LockEntry entry = it->second;
+    locks.erase(it);
+    if (now >= entry.expiresAt || entry.classIndex != Flight::seatClassIndex(seatClass) ||
+        entry.flightKey != internPair(flight.getFlightNumberId(), flight.getDateId())) {
+        return false;
+    }
+    price = entry.price;
+    return true;
+}
+
+void QuoteCache::releasePriceLock(uint64_t token) {
+    if (token == 0) return;
+    lock_guard<mutex> guard(lock);
+    locks.erase(token);
+}
+
+void QuoteCache::clear() {
+    lock_guard<mutex> guard(lock);
+    flights.clear();
+    locks.clear();
+}
+
+uint64_t QuoteCache::getHits() const {
+    lock_guard<mutex> guard(lock);
+    return hits;
+}
+
+uint64_t QuoteCache::getMisses() const {
+    lock_guard<mutex> guard(lock);
+    return misses;
+}
+
+void QuoteCache::pruneExpiredLocks(time_t now) {
+    // Abandoned dialogs leave locks behind; sweep only once there are enough to matter
+    if (locks.size() < 256) return;
+    for (auto it = locks.begin(); it != locks.end();) {
+        if (now >= it->second.expiresAt) {
+            it = locks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,111 @@
+/**
+ * @file quote_cache.h
+ * @brief Cached seat quotes and price-lock tokens
+ *
+ * A quote depends on the flight, the seat class, the advance-purchase
+ * bucket, the flight's occupancy and the pricing rules. Entries are kept
+ * per (flight, class, bucket) and tagged with the flight's occupancy epoch
+ * and the rules version, so a booking, cancellation or rules reload
+ * invalidates them without any explicit eviction. Price locks pin the
+ * fare a passenger was shown until it is charged or the lock expires.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef QUOTE_CACHE_H
+#define QUOTE_CACHE_H
+
+#include <string_view>
+#include <unordered_map>
+#include <mutex>
+#include <random>
+#include <ctime>
+#include <cstdint>
+#include "pricing_rules.h"
+
+class Flight;
+
+using namespace std;
+
+/**
+ * @struct PriceLock
+ * @brief A quoted fare that will be charged as-is until expiresAt
+ */
+struct PriceLock {
+    uint64_t token;    ///< Never 0; pass to QuoteCache::redeemPriceLock()
+    double price;      ///< Locked fare in INR
+    time_t expiresAt;  ///< The lock is void from this time on
+};
+
+/**
+ * @class QuoteCache
+ * @brief Epoch-tagged quote cache plus price-lock registry; thread-safe
+ */
+class QuoteCache {
+public:
+    static const time_t PRICE_LOCK_SECONDS = 15 * 60;  ///< How long a shown fare is honored
+    static const size_t MAX_FLIGHTS = 4096;            ///< Cached flights before the cache starts over
+
+    QuoteCache();
+
+    /**
+     * @brief Current fare for one seat in a class; recomputed only when stale
+     */
+    double quote(const Flight& flight, string_view seatClass, time_t now);
+
+    /**
+     * @brief Quotes a fare and locks it for PRICE_LOCK_SECONDS
+     */
+    PriceLock lockPrice(const Flight& flight, string_view seatClass, time_t now);
+
+    /**
+     * @brief Consumes a price lock
+     * @param price Set to the locked fare on success
+     * @return false if the token is unknown, expired or was issued for another flight or class
+     */
+    bool redeemPriceLock(uint64_t token, const Flight& flight, string_view seatClass, time_t now, double& price);
+
+    /**
+     * @brief Drops a lock that will not be used (token 0 is ignored)
+     */
+    void releasePriceLock(uint64_t token);
+
+    /**
+     * @brief Forgets all cached quotes and locks
+     */
+    void clear();
+
+    uint64_t getHits() const;
+    uint64_t getMisses() const;
+
+private:
+    struct Entry {
+        uint64_t occupancyEpoch;  ///< 0 = empty; flight epochs start at 1
+        uint64_t rulesVersion;
+        double price;
+    };
+
+    struct FlightQuotes {
+        Entry slots[3][PricingTable::MAX_ADVANCE_EDGES + 1];  ///< [class][advance bucket]
+    };
+
+    struct LockEntry {
+        uint64_t flightKey;
+        int classIndex;
+        double price;
+        time_t expiresAt;
+    };
+
+    mutable mutex lock;
+    unordered_map<uint64_t, FlightQuotes> flights;  ///< internPair(number, date) -> quotes
+    unordered_map<uint64_t, LockEntry> locks;       ///< token -> locked fare
+    mt19937_64 tokenSource;
+    uint64_t hits;
+    uint64_t misses;
+
+    double quoteLocked(const Flight& flight, int classIndex, time_t now);
+    void pruneExpiredLocks(time_t now);
+};
+
+#endif // QUOTE_CACHE_H
@@ -0,0 +1,893 @@
+#include "reservation_service.h"
+#include <sqlite3.h>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+
+using namespace std;
+
+namespace {
+
+const char* SEARCH_SQL =
+    "SELECT f.flight_number, f.flight_name, f.departure_time, f.base_price, COUNT(b.seat_number), "
+    "SUM(b.seat_number < ?4), SUM(b.seat_number >= ?4 AND b.seat_number < ?5) "
+    "FROM flights f LEFT JOIN booked_seats b ON b.flight_number = f.flight_number AND b.flight_date = f.date "
+    "WHERE f.source = ?1 AND f.destination = ?2 AND f.date = ?3 "
+    "GROUP BY f.flight_number ORDER BY f.departure_time, f.flight_number;";
+
+const char* HOLDS_SQL =
+    "SELECT h.flight_number, SUM(h.seat_number < ?4), SUM(h.seat_number >= ?4 AND h.seat_number < ?5), COUNT(*) "
+    "FROM flights f JOIN seat_holds h ON h.flight_number = f.flight_number AND h.flight_date = f.date "
+    "WHERE f.source = ?1 AND f.destination = ?2 AND f.date = ?3 AND h.expires_at > ?6 "
+    "GROUP BY h.flight_number;";
+
+const char* FLIGHT_SQL =
+    "SELECT f.flight_name, f.source, f.destination, f.departure_time, f.base_price, "
+    "(SELECT COUNT(*) FROM booked_seats b WHERE b.flight_number = f.flight_number AND b.flight_date = f.date) "
+    "FROM flights f WHERE f.flight_number = ?1 AND f.date = ?2;";
+
+const char* SEATS_SQL =
+    "SELECT seat_number, 1 FROM booked_seats WHERE flight_number = ?1 AND flight_date = ?2 "
+    "UNION ALL "
+    "SELECT seat_number, 0 FROM seat_holds WHERE flight_number = ?1 AND flight_date = ?2 AND expires_at > ?3;";
+
+const int CLASS_COUNT = 3;
+
+int totalSeats() {
+    return Flight::seatClassCapacity(0) + Flight::seatClassCapacity(1) + Flight::seatClassCapacity(2);
+}
+
+int classOfSeat(int seatNumber) {
+    if (seatNumber >= Flight::seatClassFirstSeat(2)) return 2;
+    if (seatNumber >= Flight::seatClassFirstSeat(1)) return 1;
+    return 0;
+}
+
+/// Exact class name to index; unlike Flight::seatClassIndex, unknown names are rejected
+bool parseSeatClass(const string& name, int& index) {
+    for (int i = 0; i < CLASS_COUNT; i++) {
+        if (name == Flight::seatClassName(i)) {
+            index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+string columnText(sqlite3_stmt* stmt, int column) {
+    const unsigned char* text = sqlite3_column_text(stmt, column);
+    return text ? reinterpret_cast<const char*>(text) : "";
+}
+
+void appendJsonString(string& out, const string& text) {
+    out += '"';
+    for (unsigned char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += (char)c;
+                }
+        }
+    }
+    out += '"';
+}
+
+void appendPrice(string& out, double price) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.2f", price);
+    out += buffer;
+}
+
+void appendBooking(string& out, const Booking* booking) {
+    out += "{\"id\":";
+    out += to_string(booking->getBookingId());
+    out += ",\"flight\":";
+    appendJsonString(out, booking->getFlightNumber());
+    out += ",\"date\":";
+    appendJsonString(out, booking->getFlightDate());
+    out += ",\"seat\":";
+    out += to_string(booking->getSeatNumber());
+    out += ",\"class\":";
+    appendJsonString(out, booking->getSeatClass());
+    out += ",\"name\":";
+    appendJsonString(out, booking->getPassengerName());
+    out += ",\"price\":";
+    appendPrice(out, booking->getPrice());
+    out += '}';
+}
+
+HttpResponse jsonError(int status, const string& message) {
+    HttpResponse response;
+    response.status = status;
+    response.body = "{\"error\":";
+    appendJsonString(response.body, message);
+    response.body += '}';
+    return response;
+}
+
+void appendUtf8(string& out, uint32_t code) {
+    if (code < 0x80) {
+        out += (char)code;
+    } else if (code < 0x800) {
+        out += (char)(0xC0 | (code >> 6));
+        out += (char)(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += (char)(0xE0 | (code >> 12));
+        out += (char)(0x80 | ((code >> 6) & 0x3F));
+        out += (char)(0x80 | (code & 0x3F));
+    } else {
+        out += (char)(0xF0 | (code >> 18));
+        out += (char)(0x80 | ((code >> 12) & 0x3F));
+        out += (char)(0x80 | ((code >> 6) & 0x3F));
+        out += (char)(0x80 | (code & 0x3F));
+    }
+}
+
+bool parseHex4(const string& text, size_t at, uint32_t& code) {
+    if (at + 4 > text.size()) return false;
+    code = 0;
+    for (size_t i = at; i < at + 4; i++) {
+        char c = text[i];
+        code <<= 4;
+        if (c >= '0' && c <= '9') code |= c - '0';
+        else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+        else return false;
+    }
+    return true;
+}
+
+bool parseJsonString(const string& text, size_t& i, string& out) {
+    out.clear();
+    if (i >= text.size() || text[i] != '"') return false;
+    for (i++; i < text.size(); i++) {
+        char c = text[i];
+        if (c == '"') {
+            i++;
+            return true;
+        }
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+        if (++i >= text.size()) return false;
+        switch (text[i]) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                uint32_t code;
+                if (!parseHex4(text, i + 1, code)) return false;
+                i += 4;
+                uint32_t low;
+                if (code >= 0xD800 && code < 0xDC00 && i + 6 < text.size() && text[i + 1] == '\\' &&
+                    text[i + 2] == 'u' && parseHex4(text, i + 3, low) && low >= 0xDC00 && low < 0xE000) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                }
+                appendUtf8(out, code);
+                break;
+            }
+            default: return false;
+        }
+    }
+    return false;
+}
+
+/**
+ * Parses a JSON object whose values are strings, numbers, booleans or null.
+ * Non-string values are kept as their literal text; null members are dropped.
+ */
+bool parseFlatJsonObject(const string& text, unordered_map<string, string>& fields) {
+    auto skipSpace = [&text](size_t& i) {
+        while (i < text.size() && (text[i] == ' ' || text[i] == '\t' || text[i] == '\n' || text[i] == '\r')) i++;
+    };
+    size_t i = 0;
+    skipSpace(i);
+    if (i >= text.size() || text[i] != '{') return false;
+    i++;
+    skipSpace(i);
+    if (i < text.size() && text[i] == '}') {
+        i++;
+    } else {
+        string key, value;
+        while (true) {
+            skipSpace(i);
+            if (!parseJsonString(text, i, key)) return false;
+            skipSpace(i);
+            if (i >= text.size() || text[i] != ':') return false;
+            i++;
+            skipSpace(i);
+            bool isString = i < text.size() && text[i] == '"';
+            if (isString) {
+                if (!parseJsonString(text, i, value)) return false;
+            } else {
+                size_t start = i;
+                while (i < text.size() && (isalnum((unsigned char)text[i]) || text[i] == '-' || text[i] == '+' ||
+                                           text[i] == '.')) {
+                    i++;
+                }
+                if (i == start) return false;  // Nested objects and arrays are not accepted
+                value.assign(text, start, i - start);
+            }
+            if (!isString && value == "null") {
+                fields.erase(key);
+            } else {
+                fields[key] = value;
+            }
+            skipSpace(i);
+            if (i < text.size() && text[i] == ',') {
+                i++;
+                continue;
+            }
+            if (i < text.size() && text[i] == '}') {
+                i++;
+                break;
+            }
+            return false;
+        }
+    }
+    skipSpace(i);
+    return i == text.size();
+}
+
+/// Positive decimal integer without sign or trailing characters
+bool parseId(const string& text, long long& value) {
+    if (text.empty() || text.size() > 18) return false;
+    value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + (c - '0');
+    }
+    return value > 0;
+}
+
+vector<string> splitPath(const string& path) {
+    vector<string> parts;
+    size_t start = 1;
+    while (start <= path.size()) {
+        size_t end = path.find('/', start);
+        if (end == string::npos) end = path.size();
+        if (end > start) parts.push_back(path.substr(start, end - start));
+        start = end + 1;
+    }
+    return parts;
+}
+
+const string& queryValue(const HttpRequest& request, const char* name) {
+    static const string empty;
+    auto it = request.query.find(name);
+    return it == request.query.end() ? empty : it->second;
+}
+
+/// Per-class fares for a flight, from its booked-seat count
+void appendFares(string& out, double basePrice, int bookedSeats, const CivilTime& departure, time_t now) {
+    out += '{';
+    for (int c = 0; c < CLASS_COUNT; c++) {
+        if (c > 0) out += ',';
+        appendJsonString(out, Flight::seatClassName(c));
+        out += ':';
+        appendPrice(out, Flight::computePrice(basePrice, Flight::seatClassName(c), bookedSeats, totalSeats(),
+                                              departure.timestamp, departure.hour, now));
+    }
+    out += '}';
+}
+
+void appendTotals(string& out, const RollupTotals& totals) {
+    out += "{\"revenue\":";
+    appendPrice(out, totals.revenue());
+    out += ",\"bookings\":";
+    out += to_string(totals.bookings);
+    out += ",\"seatsBooked\":";
+    out += to_string(totals.seatsBooked);
+    out += ",\"seatsOffered\":";
+    out += to_string(totals.seatsOffered);
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.4f", totals.loadFactor());
+    out += ",\"loadFactor\":";
+    out += buffer;
+    out += ",\"averageFare\":";
+    appendPrice(out, totals.averageFare());
+    out += '}';
+}
+
+/// A rollup row: its key, the totals over all classes and the totals per class
+void appendRollupRow(string& out, const RollupRow& row) {
+    out += "{\"key\":";
+    appendJsonString(out, row.key);
+    out += ",\"total\":";
+    appendTotals(out, row.total());
+    out += ",\"classes\":{";
+    for (int c = 0; c < CLASS_COUNT; c++) {
+        if (c > 0) out += ',';
+        appendJsonString(out, Flight::seatClassName(c));
+        out += ':';
+        appendTotals(out, row.byClass[c]);
+    }
+    out += "}}";
+}
+
+} // namespace
+
+ReservationService::ReservationService(ReservationSystem& system, int workers)
+    : system(system), readers(workers > 0 ? workers : 1) {}
+
+ReservationService::~ReservationService() {
+    for (Reader& r : readers) {
+        sqlite3_finalize(r.search);
+        sqlite3_finalize(r.holds);
+        sqlite3_finalize(r.flight);
+        sqlite3_finalize(r.seats);
+        if (r.db) sqlite3_close(r.db);
+    }
+}
+
+ReservationService::Reader* ReservationService::reader(int worker) {
+    if (worker < 0 || worker >= (int)readers.size()) return nullptr;
+    Reader& r = readers[worker];
+    if (r.db) return &r;
+
+    if (sqlite3_open_v2(ReservationSystem::getDatabasePath(), &r.db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX,
+                        nullptr) != SQLITE_OK) {
+        cerr << "Failed to open database: " << sqlite3_errmsg(r.db) << endl;
+        sqlite3_close(r.db);
+        r.db = nullptr;
+        return nullptr;
+    }
+    sqlite3_busy_timeout(r.db, 5000);
+    if (sqlite3_prepare_v2(r.db, SEARCH_SQL, -1, &r.search, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(r.db, HOLDS_SQL, -1, &r.holds, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(r.db, FLIGHT_SQL, -1, &r.flight, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(r.db, SEATS_SQL, -1, &r.seats, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(r.db) << endl;
+        return nullptr;
+    }
+    // Class boundaries never change; bindings survive sqlite3_reset()
+    sqlite3_bind_int(r.search, 4, Flight::seatClassFirstSeat(1));
+    sqlite3_bind_int(r.search, 5, Flight::seatClassFirstSeat(2));
+    sqlite3_bind_int(r.holds, 4, Flight::seatClassFirstSeat(1));
+    sqlite3_bind_int(r.holds, 5, Flight::seatClassFirstSeat(2));
+    return &r;
+}
+
+HttpResponse ReservationService::handle(const HttpRequest& request, int worker) {
+    vector<string> parts = splitPath(request.path);
+    const string& method = request.method;
+    bool get = method == "GET";
+
+    if (parts.size() == 1 && parts[0] == "bookings") {
+        return method == "POST" ? book(request) : jsonError(405, "use POST");
+    }
+    if (parts.size() == 2 && parts[0] == "bookings") {
+        return method == "DELETE" ? cancel(parts[1]) : jsonError(405, "use DELETE");
+    }
+
+    if (parts.size() == 2 && parts[0] == "analytics") {
+        return get ? analytics(parts[1], request) : jsonError(405, "use GET");
+    }
+    if (parts.size() == 1 && parts[0] == "maintenance") {
+        return get ? maintenance() : jsonError(405, "use GET");
+    }
+    if (parts.size() == 1 && parts[0] == "events") {
+        return get ? events(request) : jsonError(405, "use GET");
+    }
+
+    bool searchPath = parts.size() == 1 && parts[0] == "search";
+    bool quotePath = parts.size() == 1 && parts[0] == "quote";
+    bool seatsPath = parts.size() == 4 && parts[0] == "flights" && parts[3] == "seats";
+    if (!searchPath && !quotePath && !seatsPath) {
+        return jsonError(404, "no such endpoint");
+    }
+    if (!get) {
+        return jsonError(405, "use GET");
+    }
+
+    Reader* r = reader(worker);
+    if (!r) {
+        return jsonError(503, "database unavailable");
+    }
+    if (searchPath) return search(request, *r);
+    if (quotePath) return quote(request, worker, *r);
+    return seatMap(parts[1], parts[2], worker, *r);
+}
+
+void ReservationService::tick() {
+    // Never stall the event loop behind a booking; the next tick catches up
+    unique_lock<mutex> guard(systemLock, try_to_lock);
+    if (guard.owns_lock()) {
+        system.expireHolds();
+    }
+}
+
+HttpResponse ReservationService::search(const HttpRequest& request, Reader& r) {
+    const string& from = queryValue(request, "from");
+    const string& to = queryValue(request, "to");
+    const string& date = queryValue(request, "date");
+    if (from.empty() || to.empty() || parseDayNumber(date) == INT32_MIN) {
+        return jsonError(400, "from, to and date (YYYY-MM-DD) are required");
+    }
+
+    struct Row {
+        string number;
+        string name;
+        string departureTime;
+        double basePrice;
+        int booked;
+        int unavailable[CLASS_COUNT];  ///< Booked or held, per class
+    };
+    vector<Row> rows;
+    time_t now = currentTime();
+
+    sqlite3_bind_text(r.search, 1, from.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(r.search, 2, to.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(r.search, 3, date.c_str(), -1, SQLITE_STATIC);
+    while (sqlite3_step(r.search) == SQLITE_ROW) {
+        Row row;
+        row.number = columnText(r.search, 0);
+        row.name = columnText(r.search, 1);
+        row.departureTime = columnText(r.search, 2);
+        row.basePrice = sqlite3_column_double(r.search, 3);
+        row.booked = sqlite3_column_int(r.search, 4);
+        row.unavailable[0] = sqlite3_column_int(r.search, 5);
+        row.unavailable[1] = sqlite3_column_int(r.search, 6);
+        row.unavailable[2] = row.booked - row.unavailable[0] - row.unavailable[1];
+        rows.push_back(move(row));
+    }
+    sqlite3_reset(r.search);
+
+    // Held seats are not for sale either, though unlike bookings they do not move the fare.
+    // Counted per flight of this route only, so the cost does not grow with holds elsewhere
+    if (!rows.empty()) {
+        sqlite3_bind_text(r.holds, 1, from.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(r.holds, 2, to.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(r.holds, 3, date.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(r.holds, 6, now);
+        while (sqlite3_step(r.holds) == SQLITE_ROW) {
+            const char* number = reinterpret_cast<const char*>(sqlite3_column_text(r.holds, 0));
+            for (Row& row : rows) {
+                if (number && row.number == number) {
+                    int first = sqlite3_column_int(r.holds, 1);
+                    int business = sqlite3_column_int(r.holds, 2);
+                    row.unavailable[0] += first;
+                    row.unavailable[1] += business;
+                    row.unavailable[2] += sqlite3_column_int(r.holds, 3) - first - business;
+                    break;
+                }
+            }
+        }
+        sqlite3_reset(r.holds);
+    }
+
+    HttpResponse response;
+    response.body.reserve(256 + rows.size() * 256);
+    string& body = response.body;
+    body += "{\"from\":";
+    appendJsonString(body, from);
+    body += ",\"to\":";
+    appendJsonString(body, to);
+    body += ",\"date\":";
+    appendJsonString(body, date);
+    body += ",\"flights\":[";
+    bool first = true;
+    for (const Row& row : rows) {
+        CivilTime departure;
+        if (!parseCivilTime(row.departureTime, departure)) continue;
+        if (!first) body += ',';
+        first = false;
+        body += "{\"flight\":";
+        appendJsonString(body, row.number);
+        body += ",\"name\":";
+        appendJsonString(body, row.name);
+        body += ",\"departure\":";
+        appendJsonString(body, row.departureTime);
+        body += ",\"available\":{";
+        for (int c = 0; c < CLASS_COUNT; c++) {
+            if (c > 0) body += ',';
+            appendJsonString(body, Flight::seatClassName(c));
+            body += ':';
+            body += to_string(Flight::seatClassCapacity(c) - row.unavailable[c]);
+        }
+        body += "},\"fares\":";
+        appendFares(body, row.basePrice, row.booked, departure, now);
+        body += '}';
+    }
+    body += "]}";
+    return response;
+}
+
+HttpResponse ReservationService::seatMap(const string& flightNumber, const string& date, int worker, Reader& r) {
+    string name, source, destination, departureTime;
+    // 0 free, 1 held, 2 booked
+    vector<char> status(totalSeats() + 1, 0);
+
+    // A flight the system has loaded is drawn from its published snapshot: one instant, no SQL
+    SeatInventory::Pin pin(system.getSeatInventory(), worker);
+    if (const SeatSnapshot* snapshot = pin.find(flightNumber, date)) {
+        name = snapshot->flightName;
+        source = snapshot->source;
+        destination = snapshot->destination;
+        departureTime = snapshot->departureTime;
+        for (int seat = 1; seat < (int)status.size(); seat++) {
+            status[seat] = snapshot->isBooked(seat) ? 2 : snapshot->isHeld(seat) ? 1 : 0;
+        }
+    } else {
+        sqlite3_bind_text(r.flight, 1, flightNumber.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(r.flight, 2, date.c_str(), -1, SQLITE_STATIC);
+        bool found = sqlite3_step(r.flight) == SQLITE_ROW;
+        if (found) {
+            name = columnText(r.flight, 0);
+            source = columnText(r.flight, 1);
+            destination = columnText(r.flight, 2);
+            departureTime = columnText(r.flight, 3);
+        }
+        sqlite3_reset(r.flight);
+        if (!found) {
+            return jsonError(404, "no such flight");
+        }
+
+        // A flight loaded by another process on this machine has a shared map instead
+        SharedSeats shared;
+        if (system.getSharedSeats().read(flightNumber, date, shared)) {
+            for (int seat = 1; seat < (int)status.size(); seat++) {
+                status[seat] = shared.isBooked(seat) ? 2 : shared.isHeld(seat) ? 1 : 0;
+            }
+        } else {
+            sqlite3_bind_text(r.seats, 1, flightNumber.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(r.seats, 2, date.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int64(r.seats, 3, currentTime());
+            while (sqlite3_step(r.seats) == SQLITE_ROW) {
+                int seat = sqlite3_column_int(r.seats, 0);
+                if (seat >= 1 && seat < (int)status.size()) {
+                    status[seat] = max(status[seat], (char)(sqlite3_column_int(r.seats, 1) ? 2 : 1));
+                }
+            }
+            sqlite3_reset(r.seats);
+        }
+    }
+
+    static const char* statusNames[3] = {"available", "held", "booked"};
+    HttpResponse response;
+    string& body = response.body;
+    body.reserve(4096);
+    body += "{\"flight\":";
+    appendJsonString(body, flightNumber);
+    body += ",\"date\":";
+    appendJsonString(body, date);
+    body += ",\"name\":";
+    appendJsonString(body, name);
+    body += ",\"from\":";
+    appendJsonString(body, source);
+    body += ",\"to\":";
+    appendJsonString(body, destination);
+    body += ",\"departure\":";
+    appendJsonString(body, departureTime);
+    body += ",\"seats\":[";
+    for (int seat = 1; seat < (int)status.size(); seat++) {
+        if (seat > 1) body += ',';
+        body += "{\"seat\":";
+        body += to_string(seat);
+        body += ",\"class\":\"";
+        body += Flight::seatClassName(classOfSeat(seat));
+        body += "\",\"status\":\"";
+        body += statusNames[(int)status[seat]];
+        body += "\"}";
+    }
+    body += "]}";
+    return response;
+}
+
+HttpResponse ReservationService::quote(const HttpRequest& request, int worker, Reader& r) {
+    const string& flightNumber = queryValue(request, "flight");
+    const string& date = queryValue(request, "date");
+    int seatClass;
+    if (flightNumber.empty() || date.empty() || !parseSeatClass(queryValue(request, "class"), seatClass)) {
+        return jsonError(400, "flight, date and class (First, Business or Economy) are required");
+    }
+
+    string departureTime;
+    double basePrice = 0.0;
+    int booked = 0;
+    bool found;
+    SeatInventory::Pin pin(system.getSeatInventory(), worker);
+    if (const SeatSnapshot* snapshot = pin.find(flightNumber, date)) {
+        // The occupancy the system itself prices from, even mid-way through a burst of bookings
+        found = true;
+        departureTime = snapshot->departureTime;
+        basePrice = snapshot->basePrice;
+        booked = snapshot->bookedCount;
+    } else {
+        sqlite3_bind_text(r.flight, 1, flightNumber.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(r.flight, 2, date.c_str(), -1, SQLITE_STATIC);
+        found = sqlite3_step(r.flight) == SQLITE_ROW;
+        if (found) {
+            departureTime = columnText(r.flight, 3);
+            basePrice = sqlite3_column_double(r.flight, 4);
+            booked = sqlite3_column_int(r.flight, 5);
+        }
+        sqlite3_reset(r.flight);
+    }
+    CivilTime departure;
+    if (!found || !parseCivilTime(departureTime, departure)) {
+        return jsonError(404, "no such flight");
+    }
+
+    // Same formula and inputs as ReservationSystem::quotePrice(), so the booking charges this fare
+    double price = Flight::computePrice(basePrice, Flight::seatClassName(seatClass), booked, totalSeats(),
+                                        departure.timestamp, departure.hour, currentTime());
+    HttpResponse response;
+    string& body = response.body;
+    body += "{\"flight\":";
+    appendJsonString(body, flightNumber);
+    body += ",\"date\":";
+    appendJsonString(body, date);
+    body += ",\"class\":\"";
+    body += Flight::seatClassName(seatClass);
+    body += "\",\"price\":";
+    appendPrice(body, price);
+    body += '}';
+    return response;
+}
+
+HttpResponse ReservationService::book(const HttpRequest& request) {
+    unordered_map<string, string> fields;
+    if (!parseFlatJsonObject(request.body, fields)) {
+        return jsonError(400, "body must be a flat JSON object");
+    }
+    const string& flightNumber = fields["flight"];
+    const string& date = fields["date"];
+    const string& name = fields["name"];
+    const string& email = fields["email"];
+    const string& phone = fields["phone"];
+    if (flightNumber.empty() || date.empty() || name.empty() || phone.empty()) {
+        return jsonError(400, "flight, date, name, email and phone are required");
+    }
+    if (email.find('@') == string::npos) {
+        return jsonError(400, "email is not valid");
+    }
+
+    // A requested seat decides the class; otherwise the first free seat of the class is taken
+    long long requestedSeat = 0;
+    int seatClass = -1;
+    auto seatField = fields.find("seat");
+    if (seatField != fields.end() && (!parseId(seatField->second, requestedSeat) || requestedSeat > totalSeats())) {
+        return jsonError(400, "seat must be a seat number");
+    }
+    auto classField = fields.find("class");
+    if (classField != fields.end() && !parseSeatClass(classField->second, seatClass)) {
+        return jsonError(400, "class must be First, Business or Economy");
+    }
+    if (requestedSeat > 0) {
+        if (seatClass >= 0 && seatClass != classOfSeat((int)requestedSeat)) {
+            return jsonError(400, "seat is not in the requested class");
+        }
+        seatClass = classOfSeat((int)requestedSeat);
+    }
+    if (seatClass < 0) {
+        return jsonError(400, "class or seat is required");
+    }
+    const string className = Flight::seatClassName(seatClass);
+    bool waitlist = fields["waitlist"] == "true";
+
+    lock_guard<mutex> guard(systemLock);
+    Flight* flight = system.loadFlight(flightNumber, date);
+    if (!flight) {
+        return jsonError(404, "no such flight");
+    }
+
+    // A seat picked here can still be lost to another process before it is held; try a few
+    for (int attempt = 0; attempt < 3; attempt++) {
+        int seatNumber = (int)requestedSeat;
+        if (seatNumber == 0) {
+            SeatRange available = flight->getAvailableSeatsByClass(className);
+            if (available.empty()) break;
+            seatNumber = (*available.begin())->getSeatNumber();
+        }
+
+        uint64_t holdId = system.holdSeat(flight, seatNumber);
+        if (holdId != 0) {
+            double price = system.quotePrice(flight, className);
+            Booking* booking = system.bookHeldSeat(holdId, name, email, phone, price);
+            if (booking) {
+                HttpResponse response;
+                response.status = 201;
+                appendBooking(response.body, booking);
+                return response;
+            }
+            system.releaseHold(holdId);
+        }
+        if (requestedSeat > 0) {
+            return jsonError(409, "seat " + to_string(requestedSeat) + " is not available");
+        }
+    }
+
+    if (!flight->getAvailableSeatsByClass(className).empty()) {
+        return jsonError(409, "seats changed while booking; try again");
+    }
+    if (!waitlist) {
+        return jsonError(409, className + " is fully booked; set \"waitlist\": true to queue");
+    }
+    int64_t entryId = system.joinWaitlist(flight, className, name, email, phone);
+    if (entryId == 0) {
+        return jsonError(500, "could not join the waitlist");
+    }
+    HttpResponse response;
+    response.status = 202;
+    response.body = "{\"waitlist\":" + to_string(entryId) +
+                    ",\"position\":" + to_string(system.getWaitlistPosition(entryId)) + "}";
+    return response;
+}
+
+HttpResponse ReservationService::cancel(const string& bookingId) {
+    long long id;
+    if (!parseId(bookingId, id) || id > INT32_MAX) {
+        return jsonError(400, "booking id must be a number");
+    }
+
+    lock_guard<mutex> guard(systemLock);
+    Booking* promoted = nullptr;
+    if (!system.cancelBooking((int)id, &promoted)) {
+        // A booking that was found stays cached when its rows could not be deleted
+        for (const Booking* booking : system.getBookings()) {
+            if (booking->getBookingId() == (int)id) {
+                if (system.isSealedDate(booking->getFlightDate())) {
+                    return jsonError(409, "the flight's month is sealed; its bookings can no longer be cancelled");
+                }
+                return jsonError(500, "could not cancel the booking");
+            }
+        }
+        return jsonError(404, "no such booking");
+    }
+    HttpResponse response;
+    response.body = "{\"cancelled\":" + to_string(id) + ",\"promoted\":";
+    if (promoted) {
+        appendBooking(response.body, promoted);
+    } else {
+        response.body += "null";
+    }
+    response.body += '}';
+    return response;
+}
+
+HttpResponse ReservationService::analytics(const string& rollup, const HttpRequest& request) {
+    if (rollup != "routes" && rollup != "days" && rollup != "carriers" && rollup != "classes") {
+        return jsonError(404, "rollups are routes, days, carriers and classes");
+    }
+    const string& from = queryValue(request, "from");
+    const string& to = queryValue(request, "to");
+    if ((!from.empty() && parseDayNumber(from) == INT32_MIN) || (!to.empty() && parseDayNumber(to) == INT32_MIN)) {
+        return jsonError(400, "from and to must be YYYY-MM-DD");
+    }
+
+    const BookingAnalytics* rollups;
+    {
+        // Only to build or refresh the rollups; reading them needs no lock
+        lock_guard<mutex> guard(systemLock);
+        rollups = &system.getAnalytics();
+    }
+
+    vector<RollupRow> rows;
+    if (rollup == "routes") {
+        rows = rollups->byRoute();
+    } else if (rollup == "days") {
+        rows = rollups->byDay(from, to);
+    } else if (rollup == "carriers") {
+        rows = rollups->byCarrier();
+    } else {
+        rows = rollups->byClass();
+    }
+
+    HttpResponse response;
+    string& body = response.body;
+    body.reserve(512 + rows.size() * 640);
+    body += "{\"overall\":";
+    appendRollupRow(body, rollups->overall());
+    body += ",\"";
+    body += rollup;
+    body += "\":[";
+    for (size_t i = 0; i < rows.size(); i++) {
+        if (i > 0) body += ',';
+        appendRollupRow(body, rows[i]);
+    }
+    body += "]}";
+    return response;
+}
+
+HttpResponse ReservationService::maintenance() {
+    // The maintainer guards its own statistics, so this never waits behind a booking
+    CompactionStats stats = system.getCompactionStats();
+
+    HttpResponse response;
+    string& body = response.body;
+    body += "{\"phase\":";
+    appendJsonString(body, stats.phase);
+    const pair<const char*, long long> fields[] = {
+        {"passes", stats.passes},
+        {"bookingsArchived", stats.bookingsArchived},
+        {"bookingsPending", stats.bookingsPending},
+        {"pagesReclaimed", stats.pagesReclaimed},
+        {"bytesReclaimed", stats.bytesReclaimed},
+        {"pageSize", stats.pageSize},
+        {"pageCount", stats.pageCount},
+        {"freePages", stats.freePages},
+        {"lastPass", (long long)stats.lastPass},
+        {"lastVacuum", (long long)stats.lastVacuum},
+        {"lastAnalyze", (long long)stats.lastAnalyze},
+    };
+    for (const auto& field : fields) {
+        body += ",\"";
+        body += field.first;
+        body += "\":";
+        body += to_string(field.second);
+    }
+    body += '}';
+    return response;
+}
+
+HttpResponse ReservationService::events(const HttpRequest& request) {
+    long long from = 0;
+    long long limit = DEFAULT_EVENT_LIMIT;
+    const string& fromText = queryValue(request, "from");
+    const string& limitText = queryValue(request, "limit");
+    if ((!fromText.empty() && fromText != "0" && !parseId(fromText, from)) ||
+        (!limitText.empty() && !parseId(limitText, limit))) {
+        return jsonError(400, "from and limit must be numbers");
+    }
+    if (limit > MAX_EVENT_LIMIT) limit = MAX_EVENT_LIMIT;
+    const BookingLog& log = system.getBookingLog();
+    if (!log.isOpen()) {
+        return jsonError(503, "booking log unavailable");
+    }
+
+    // The log is read with pread(), so this never waits behind a booking
+    vector<BookingEvent> events;
+    uint64_t next = log.read((uint64_t)from, (size_t)limit, events);
+
+    HttpResponse response;
+    string& body = response.body;
+    body.reserve(64 + events.size() * 192);
+    body += "{\"events\":[";
+    for (size_t i = 0; i < events.size(); i++) {
+        const BookingEvent& event = events[i];
+        if (i > 0) body += ',';
+        body += "{\"offset\":";
+        body += to_string(event.offset);
+        body += ",\"type\":";
+        appendJsonString(body, BookingEvent::typeName(event.type));
+        body += ",\"sequence\":";
+        body += to_string(event.sequence);
+        body += ",\"time\":";
+        body += to_string((long long)event.time);
+        body += ",\"id\":";
+        body += to_string(event.id);
+        body += ",\"flight\":";
+        appendJsonString(body, event.flightNumber);
+        body += ",\"date\":";
+        appendJsonString(body, event.date);
+        body += ",\"seat\":";
+        body += to_string(event.seatNumber);
+        body += ",\"price\":";
+        appendPrice(body, event.price);
+        body += '}';
+    }
+    body += "],\"next\":";
+    body += to_string(next);
+    body += ",\"size\":";
+    body += to_string(log.size());
+    body += '}';
+    return response;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file reservation_service.h
+ * @brief JSON endpoints of the reservation system, for HttpServer
+ *
+ * Reads (search, seat map, quote) run in parallel: every worker has its
+ * own read-only connection with prepared statements and prices flights
+ * from their booked-seat counts, so a search never materializes Flight
+ * objects or waits for a booking. Writes (book, cancel) go through the
+ * single ReservationSystem under one lock; its seat holds, waitlists and
+ * transactions keep them safe against the GUI and other servers sharing
+ * the database.
+ *
+ * Endpoints:
+ *   GET    /search?from=Mumbai&to=Delhi&date=YYYY-MM-DD
+ *   GET    /flights/{number}/{date}/seats
+ *   GET    /quote?flight=SP1001&date=YYYY-MM-DD&class=Economy
+ *   POST   /bookings        {"flight","date","class","seat"?,"name","email","phone","waitlist"?}
+ *   DELETE /bookings/{id}
+ *   GET    /analytics/{routes|days|carriers|classes}[?from=YYYY-MM-DD&to=YYYY-MM-DD]
+ *   GET    /maintenance
+ *   GET    /events?from=0&limit=100
+ *
+ * Seat maps and quotes of flights the system has loaded - every flight
+ * booked, held or cancelled through it - come from the SeatInventory
+ * snapshot it published last, pinned by the worker without any lock; other
+ * flights are read from the worker's connection.
+ *
+ * Analytics answer from BookingAnalytics rollups in memory; they take the
+ * system lock only to build the rollups on first use or after a schedule
+ * change.
+ *
+ * /events pages through the booking log from a byte offset; pass the
+ * returned "next" as the following "from" to tail it. It is not behind
+ * any access control, so passenger names are left out of the events.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef RESERVATION_SERVICE_H
+#define RESERVATION_SERVICE_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include "http_server.h"
+#include "flight_system.h"
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+using namespace std;
+
+/**
+ * @class ReservationService
+ * @brief Routes HTTP requests to read queries or to the shared ReservationSystem
+ */
+class ReservationService {
+public:
+    /**
+     * @param system Backend used for every write; must outlive the service
+     * @param workers Number of HttpServer workers calling handle()
+     */
+    ReservationService(ReservationSystem& system, int workers);
+    ~ReservationService();
+    ReservationService(const ReservationService&) = delete;
+    ReservationService& operator=(const ReservationService&) = delete;
+
+    /**
+     * @brief Handles one request; safe to call from all workers at once
+     */
+    HttpResponse handle(const HttpRequest& request, int worker);
+
+    /**
+     * @brief Housekeeping for the event loop: expires seat holds, skipping a beat if a write is running
+     */
+    void tick();
+
+private:
+    /// One worker's read-only connection, opened on first use
+    struct Reader {
+        sqlite3* db = nullptr;
+        sqlite3_stmt* search = nullptr;  ///< Route flights with booked seats per class
+        sqlite3_stmt* holds = nullptr;   ///< Live holds per class on the route's flights
+        sqlite3_stmt* flight = nullptr;  ///< One flight and its booked-seat count
+        sqlite3_stmt* seats = nullptr;   ///< Booked and held seats of one flight
+    };
+
+    static const long long DEFAULT_EVENT_LIMIT = 100;
+    static const long long MAX_EVENT_LIMIT = 1000;
+
+    ReservationSystem& system;
+    vector<Reader> readers;
+    mutex systemLock;  ///< Serializes every call into system
+
+    /**
+     * @brief The worker's reader, opened and prepared on first use
+     * @return nullptr if the database cannot be opened
+     */
+    Reader* reader(int worker);
+
+    HttpResponse search(const HttpRequest& request, Reader& reader);
+    HttpResponse seatMap(const string& flightNumber, const string& date, int worker, Reader& reader);
+    HttpResponse quote(const HttpRequest& request, int worker, Reader& reader);
+    HttpResponse book(const HttpRequest& request);
+    HttpResponse cancel(const string& bookingId);
+    HttpResponse analytics(const string& rollup, const HttpRequest& request);
+    HttpResponse maintenance();
+    HttpResponse events(const HttpRequest& request);
+};
+
+#endif // RESERVATION_SERVICE_H
@@ -0,0 +1,209 @@
+#include "revenue_simulator.h"
+#include "work_stealing_pool.h"
+#include "schedule_store.h"
+#include "flight_system.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+/// SplitMix64 stream: tiny state, identical sequence on every platform
+class SimRandom {
+public:
+    explicit SimRandom(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    /// Uniform in (0, 1]
+    double uniform() {
+        return ((next() >> 11) + 1) * (1.0 / 9007199254740992.0);
+    }
+
+    /// Standard normal (Box-Muller, one value per call)
+    double normal() {
+        double u1 = uniform();
+        double u2 = uniform();
+        return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+    }
+
+private:
+    uint64_t state;
+};
+
+uint64_t mix64(uint64_t x) {
+    return SimRandom(x).next();
+}
+
+struct Task {
+    size_t route;
+    size_t firstRow;
+    size_t endRow;
+};
+
+void addCount(vector<uint64_t>& histogram, size_t bin) {
+    if (bin >= histogram.size()) histogram.resize(bin + 1, 0);
+    histogram[bin]++;
+}
+
+double quantileBin(const vector<uint64_t>& histogram, uint64_t total, double q) {
+    if (total == 0) return 0.0;
+    uint64_t target = (uint64_t)ceil(q * total);
+    if (target == 0) target = 1;
+    uint64_t seen = 0;
+    for (size_t bin = 0; bin < histogram.size(); bin++) {
+        seen += histogram[bin];
+        if (seen >= target) return (double)bin;
+    }
+    return (double)(histogram.size() - 1);
+}
+
+} // namespace
+
+// ==================== ROUTE OUTCOME ====================
+
+double RouteOutcome::meanRevenue() const {
+    return flightScenarios ? revenuePaise / 100.0 / flightScenarios : 0.0;
+}
+
+double RouteOutcome::meanLoadFactor() const {
+    uint64_t seats = 0;
+    for (size_t sold = 0; sold < seatsHistogram.size(); sold++) {
+        seats += sold * seatsHistogram[sold];
+    }
+    return flightScenarios ? (double)seats / (100.0 * flightScenarios) : 0.0;
+}
+
+double RouteOutcome::revenueQuantile(double q) const {
+    return (quantileBin(revenueHistogram, flightScenarios, q) + 0.5) * REVENUE_BIN_PAISE / 100.0;
+}
+
+double RouteOutcome::loadFactorQuantile(double q) const {
+    return quantileBin(seatsHistogram, flightScenarios, q) / 100.0;
+}
+
+void RouteOutcome::merge(const RouteOutcome& other) {
+    flightScenarios += other.flightScenarios;
+    requests += other.requests;
+    declined += other.declined;
+    soldOut += other.soldOut;
+    revenuePaise += other.revenuePaise;
+    if (revenueHistogram.size() < other.revenueHistogram.size()) {
+        revenueHistogram.resize(other.revenueHistogram.size(), 0);
+    }
+    for (size_t bin = 0; bin < other.revenueHistogram.size(); bin++) {
+        revenueHistogram[bin] += other.revenueHistogram[bin];
+    }
+    if (seatsHistogram.size() < other.seatsHistogram.size()) {
+        seatsHistogram.resize(other.seatsHistogram.size(), 0);
+    }
+    for (size_t bin = 0; bin < other.seatsHistogram.size(); bin++) {
+        seatsHistogram[bin] += other.seatsHistogram[bin];
+    }
+}
+
+// ==================== REVENUE SIMULATOR ====================
+
+RevenueSimulator::RevenueSimulator(const SimulationConfig& cfg) : config(cfg) {}
+
+vector<RouteOutcome> RevenueSimulator::run(const ScheduleStore& schedule, WorkStealingPool& pool) const {
+    const double referenceClassFactor[3] = {3.0, 2.0, 1.0};  // Budgets follow the shipped fares, not the rules under test
+    const double tailWeight = exp(-config.horizonDays / config.arrivalDecayDays);
+    const double firstShare = config.classMix[0];
+    const double businessShare = config.classMix[0] + config.classMix[1];
+    const double mixTotal = businessShare + config.classMix[2];
+
+    // Route-aligned chunks so a task touches a single route's accumulators
+    vector<Task> tasks;
+    for (size_t r = 0; r < schedule.getRouteCount(); r++) {
+        const ScheduleStore::RouteSpan& span = schedule.getRoute(r);
+        for (size_t row = span.firstRow; row < span.firstRow + span.rowCount; row += FLIGHTS_PER_TASK) {
+            tasks.push_back(Task{r, row, min<size_t>(row + FLIGHTS_PER_TASK, span.firstRow + span.rowCount)});
+        }
+    }
+
+    // Histograms grow only for routes a worker actually simulates
+    vector<vector<RouteOutcome>> partial(pool.size(), vector<RouteOutcome>(schedule.getRouteCount()));
+
+    pool.run(tasks.size(), [&](size_t taskIndex, int worker) {
+        const Task& task = tasks[taskIndex];
+        RouteOutcome& outcome = partial[worker][task.route];
+        vector<int> soldSeats;
+        soldSeats.reserve(100);
+
+        for (size_t row = task.firstRow; row < task.endRow; row++) {
+            Flight flight(schedule.getFlightNumber(row), schedule.getFlightName(row), schedule.getSource(row),
+                          schedule.getDestination(row), schedule.getDepartureTime(row), schedule.getBasePrice(row),
+                          schedule.getDepartureTimestamp(row));
+            time_t departure = flight.getDepartureTimestamp();
+            uint64_t flightSeed = mix64(config.seed ^ mix64(row));
+
+            for (int scenario = 0; scenario < config.scenarios; scenario++) {
+                SimRandom random(flightSeed ^ mix64(((uint64_t)scenario << 1) | 1));
+                int classBooked[3] = {0, 0, 0};
+                int64_t revenue = 0;
+
+                // Poisson arrivals: unit-rate steps in cumulative intensity, mapped back to days out
+                double cumulative = 0.0;
+                while (true) {
+                    cumulative -= log(random.uniform());
+                    if (cumulative > config.demand) break;
+                    double x = cumulative * (1.0 - tailWeight) / config.demand + tailWeight;
+                    double daysOut = -config.arrivalDecayDays * log(x);
+                    time_t bookingTime = departure - (time_t)(daysOut * 86400.0);
+                    outcome.requests++;
+
+                    double pick = random.uniform() * mixTotal;
+                    int c = pick <= firstShare ? 0 : (pick <= businessShare ? 1 : 2);
+                    double budget = flight.getBasePrice() * referenceClassFactor[c] * config.willingnessToPay *
+                                    exp(config.willingnessSigma * random.normal());
+
+                    if (classBooked[c] >= Flight::seatClassCapacity(c)) {
+                        outcome.soldOut++;
+                        continue;
+                    }
+                    double price = flight.calculatePrice(Flight::seatClassName(c), bookingTime);
+                    if (price > budget) {
+                        outcome.declined++;
+                        continue;
+                    }
+
+                    SeatRange free = flight.getAvailableSeatsByClass(Flight::seatClassName(c));
+                    int seatNumber = (*free.begin())->getSeatNumber();
+                    flight.bookSeat(seatNumber, "Simulated");
+                    soldSeats.push_back(seatNumber);
+                    classBooked[c]++;
+                    revenue += llround(price * 100.0);
+                }
+
+                outcome.flightScenarios++;
+                outcome.revenuePaise += revenue;
+                addCount(outcome.revenueHistogram, (size_t)(revenue / RouteOutcome::REVENUE_BIN_PAISE));
+                addCount(outcome.seatsHistogram, soldSeats.size());
+
+                for (int seatNumber : soldSeats) {
+                    flight.cancelSeat(seatNumber);
+                }
+                soldSeats.clear();
+            }
+        }
+    });
+
+    // Integer statistics: the merge order cannot change the result
+    vector<RouteOutcome> routes(schedule.getRouteCount());
+    for (size_t r = 0; r < routes.size(); r++) {
+        size_t firstRow = schedule.getRoute(r).firstRow;
+        routes[r].source = schedule.getSource(firstRow);
+        routes[r].destination = schedule.getDestination(firstRow);
+        for (size_t w = 0; w < partial.size(); w++) {
+            routes[r].merge(partial[w][r]);
+        }
+    }
+    return routes;
+}
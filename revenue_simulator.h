@@ -0,0 +1,105 @@
+/**
+ * @file revenue_simulator.h
+ * @brief Monte Carlo revenue simulation over the live pricing model
+ *
+ * Every flight of the schedule is sold many times over. In each scenario
+ * booking requests arrive as a Poisson process whose intensity rises
+ * exponentially toward departure; each request picks a class, draws a
+ * lognormal willingness to pay and books the first free seat of that class
+ * if Flight::calculatePrice() at its arrival time is within budget. The
+ * real Flight seat inventory and the active PricingRules are used, so the
+ * effect of a rules file can be measured before it goes live.
+ *
+ * Each (flight, scenario) pair draws from its own SplitMix64 stream and
+ * all statistics are integers (revenue in paise, histogram counts), so
+ * results are identical for a given seed whatever the thread count or
+ * steal order.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef REVENUE_SIMULATOR_H
+#define REVENUE_SIMULATOR_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+class ScheduleStore;
+class WorkStealingPool;
+
+using namespace std;
+
+/**
+ * @struct SimulationConfig
+ * @brief Demand model and run size
+ */
+struct SimulationConfig {
+    int scenarios = 100;              ///< Sales horizons simulated per flight
+    uint64_t seed = 1;                ///< Same seed, same results
+    double demand = 120.0;            ///< Expected booking requests per flight
+    int horizonDays = 60;             ///< Sales open this many days before departure
+    double arrivalDecayDays = 14.0;   ///< Arrival intensity ~ exp(-daysOut / decay)
+    double classMix[3] = {0.05, 0.15, 0.80};  ///< First, Business, Economy request shares
+    double willingnessToPay = 1.3;    ///< Median budget relative to base price x class factor
+    double willingnessSigma = 0.35;   ///< Lognormal spread of budgets
+};
+
+/**
+ * @struct RouteOutcome
+ * @brief Revenue and load-factor distribution of one route over all its flight scenarios
+ */
+struct RouteOutcome {
+    static const int64_t REVENUE_BIN_PAISE = 100000;  ///< Revenue histogram resolution: INR 1,000
+
+    string source;
+    string destination;
+    uint64_t flightScenarios = 0;   ///< Flights x scenarios
+    uint64_t requests = 0;          ///< Booking requests generated
+    uint64_t declined = 0;          ///< Requests priced above the passenger's budget
+    uint64_t soldOut = 0;           ///< Requests for a class with no free seat
+    int64_t revenuePaise = 0;       ///< Sum over all flight scenarios
+    vector<uint64_t> revenueHistogram;   ///< Flight revenue in REVENUE_BIN_PAISE bins
+    vector<uint64_t> seatsHistogram;     ///< Seats sold per flight, 0..100
+
+    double meanRevenue() const;
+    double meanLoadFactor() const;
+
+    /**
+     * @brief Flight revenue (INR) at quantile q, to histogram resolution
+     */
+    double revenueQuantile(double q) const;
+
+    /**
+     * @brief Load factor (0..1) at quantile q
+     */
+    double loadFactorQuantile(double q) const;
+
+    /**
+     * @brief Adds another partial result for the same route
+     */
+    void merge(const RouteOutcome& other);
+};
+
+/**
+ * @class RevenueSimulator
+ * @brief Runs the simulation over a loaded schedule on a work-stealing pool
+ */
+class RevenueSimulator {
+public:
+    static const size_t FLIGHTS_PER_TASK = 32;  ///< Granularity of stealing
+
+    explicit RevenueSimulator(const SimulationConfig& config);
+
+    /**
+     * @brief Simulates every flight of schedule
+     * @return One outcome per route, in schedule route order
+     */
+    vector<RouteOutcome> run(const ScheduleStore& schedule, WorkStealingPool& pool) const;
+
+private:
+    SimulationConfig config;
+};
+
+#endif // REVENUE_SIMULATOR_H
@@ -0,0 +1,531 @@
+#include "schedule_csv.h"
+#include "schedule_store.h"
+#include "schedule_generator.h"
+#include "time_core.h"
+#include <sqlite3.h>
+#include <set>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+const size_t DROP_BYTES = 64 * 1024 * 1024;  ///< Consumed input released from memory at a time
+
+enum Column { FLIGHT_NUMBER, FLIGHT_NAME, SOURCE, DESTINATION, DATE, DEPARTURE_TIME, BASE_PRICE, COLUMN_COUNT };
+const char* COLUMN_NAMES[COLUMN_COUNT] = {"flight_number", "flight_name", "source", "destination",
+                                          "date", "departure_time", "base_price"};
+
+/// First ',', '\r' or '\n' at or after p, or end
+const char* findDelimiter(const char* p, const char* end) {
+#ifdef __SSE2__
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, comma),
+                                    _mm_or_si128(_mm_cmpeq_epi8(chunk, cr), _mm_cmpeq_epi8(chunk, lf)));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#endif
+    while (p < end && *p != ',' && *p != '\r' && *p != '\n') p++;
+    return p;
+}
+
+/**
+ * @class InputFile
+ * @brief Read-only view of a whole file: mapped on POSIX, read into memory elsewhere
+ */
+class InputFile {
+public:
+    InputFile() : bytes(nullptr), length(0), mapping(nullptr) {}
+    ~InputFile() {
+#ifndef _WIN32
+        if (mapping) munmap(mapping, length);
+#endif
+    }
+    InputFile(const InputFile&) = delete;
+    InputFile& operator=(const InputFile&) = delete;
+
+    bool open(const string& path) {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            return false;
+        }
+        length = info.st_size;
+        if (length > 0) {
+            mapping = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapping == MAP_FAILED) mapping = nullptr;
+        }
+        close(fd);  // The mapping keeps the file alive
+        if (length > 0 && !mapping) return false;
+        if (mapping) madvise(mapping, length, MADV_SEQUENTIAL);
+        bytes = static_cast<const char*>(mapping);
+        return true;
+#else
+        ifstream file(path, ios::binary);
+        if (!file) return false;
+        contents.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        bytes = contents.data();
+        length = contents.size();
+        return true;
+#endif
+    }
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+    /**
+     * @brief Lets the kernel reclaim pages wholly before offset; they are not read again
+     */
+    void release(size_t offset) {
+#ifndef _WIN32
+        static const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+        size_t upTo = offset / pageSize * pageSize;
+        if (mapping && upTo > 0) madvise(mapping, upTo, MADV_DONTNEED);
+#else
+        (void)offset;
+#endif
+    }
+
+private:
+    const char* bytes;
+    size_t length;
+    void* mapping;
+#ifdef _WIN32
+    string contents;
+#endif
+};
+
+/// Positive decimal ("4500", "4500.50") without exponent or sign
+bool parsePrice(string_view text, double& price) {
+    double value = 0.0;
+    double scale = 0.0;
+    bool digits = false;
+    for (char c : text) {
+        if (c >= '0' && c <= '9') {
+            digits = true;
+            if (scale == 0.0) {
+                value = value * 10.0 + (c - '0');
+            } else {
+                value += (c - '0') * scale;
+                scale /= 10.0;
+            }
+        } else if (c == '.' && scale == 0.0) {
+            scale = 0.1;
+        } else {
+            return false;
+        }
+    }
+    price = value;
+    return digits && value > 0.0 && isfinite(value);
+}
+
+/**
+ * @brief Checks one row and assembles its full departure time
+ * @param departure Receives "YYYY-MM-DD HH:MM"; at least 17 bytes
+ * @return nullptr if the row is valid, else the reason it is not
+ */
+const char* validateRow(const vector<string_view>& fields, const size_t* column, char* departure, double& price) {
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+        if (column[c] >= fields.size()) return "missing fields";
+        if (fields[column[c]].empty()) return "empty field";
+    }
+    string_view date = fields[column[DATE]];
+    if (date.size() != 10 || parseDayNumber(date) == INT32_MIN) return "bad date";
+    if (fields[column[SOURCE]] == fields[column[DESTINATION]]) return "source equals destination";
+
+    string_view time = fields[column[DEPARTURE_TIME]];
+    if (time.size() == 16) {
+        if (time.substr(0, 10) != date) return "departure_time not on date";
+        time.remove_prefix(11);
+    }
+    if (time.size() != 5) return "bad departure_time";
+    memcpy(departure, date.data(), 10);
+    departure[10] = ' ';
+    memcpy(departure + 11, time.data(), 5);
+    departure[16] = '\0';
+    CivilTime civil;
+    if (!parseCivilFields(string_view(departure, 16), civil)) return "bad departure_time";
+
+    if (!parsePrice(fields[column[BASE_PRICE]], price)) return "bad base_price";
+    return nullptr;
+}
+
+bool beginBatch(sqlite3* db) {
+    if (sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return false;
+    }
+    return true;
+}
+
+/// Lists the batch's dates in imported_days inside its transaction, so the maintainer leaves them alone
+bool recordImportedDays(sqlite3* db, const set<string>& dates) {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO imported_days VALUES (?);", -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return false;
+    }
+    bool ok = true;
+    for (const string& date : dates) {
+        sqlite3_bind_text(stmt, 1, date.c_str(), -1, SQLITE_STATIC);
+        ok = ok && sqlite3_step(stmt) == SQLITE_DONE;
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    if (!ok) {
+        cerr << "Failed to record imported days: " << sqlite3_errmsg(db) << endl;
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+    }
+    return ok;
+}
+
+bool commitBatch(sqlite3* db) {
+    if (sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        cerr << "Failed to commit import batch: " << sqlite3_errmsg(db) << endl;
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        return false;
+    }
+    return true;
+}
+
+/// Buffered CSV output with RFC 4180 quoting
+class CsvWriter {
+public:
+    explicit CsvWriter(const string& path) : file(fopen(path.c_str(), "wb")), buffer(1 << 20) {
+        if (file) setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+    }
+    ~CsvWriter() {
+        if (file) fclose(file);
+    }
+
+    bool isOpen() const { return file != nullptr; }
+
+    void field(const char* text, size_t length, bool first) {
+        if (!first) fputc(',', file);
+        if (!memchr(text, ',', length) && !memchr(text, '"', length) && !memchr(text, '\n', length) &&
+            !memchr(text, '\r', length)) {
+            fwrite(text, 1, length, file);
+            return;
+        }
+        fputc('"', file);
+        for (size_t i = 0; i < length; i++) {
+            if (text[i] == '"') fputc('"', file);
+            fputc(text[i], file);
+        }
+        fputc('"', file);
+    }
+
+    void endRow() { fputc('\n', file); }
+
+    /// Writes a preformatted line, e.g. the header
+    void line(const char* text) {
+        fputs(text, file);
+        endRow();
+    }
+
+    /// Writes every row of stmt, one column per field; returns rows written or -1
+    long long rows(sqlite3_stmt* stmt) {
+        long long written = 0;
+        int columns = sqlite3_column_count(stmt);
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            for (int c = 0; c < columns; c++) {
+                const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, c));
+                field(text ? text : "", text ? sqlite3_column_bytes(stmt, c) : 0, c == 0);
+            }
+            endRow();
+            written++;
+        }
+        return rc == SQLITE_DONE ? written : -1;
+    }
+
+    /// Flushes and closes; false if anything failed to write
+    bool finish() {
+        bool ok = fflush(file) == 0 && !ferror(file);
+        ok = fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+
+private:
+    FILE* file;
+    vector<char> buffer;
+};
+
+long long exportQuery(sqlite3* db, const string& path, const char* header, const char* sql) {
+    if (!db) return -1;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return -1;
+    }
+    CsvWriter writer(path);
+    if (!writer.isOpen()) {
+        cerr << "Cannot write " << path << endl;
+        sqlite3_finalize(stmt);
+        return -1;
+    }
+    writer.line(header);
+    long long written = writer.rows(stmt);
+    if (written < 0) {
+        cerr << "Export failed: " << sqlite3_errmsg(db) << endl;
+    }
+    sqlite3_finalize(stmt);
+    if (!writer.finish()) {
+        cerr << "Failed to write " << path << endl;
+        return -1;
+    }
+    return written;
+}
+
+} // namespace
+
+// ==================== CSV READER ====================
+
+CsvReader::CsvReader(const char* data, size_t size)
+    : begin(data), position(data), end(data + size), recordStart(data), recordEnd(data) {}
+
+bool CsvReader::next(vector<string_view>& fields) {
+    fields.clear();
+    escapedFields.clear();
+    if (position >= end) return false;
+
+    const char* p = position;
+    recordStart = p;
+    while (true) {
+        if (p < end && *p == '"') {
+            // Quoted field: runs to the first quote not doubled
+            const char* content = p + 1;
+            const char* q = content;
+            bool doubled = false;
+            while (true) {
+                q = static_cast<const char*>(memchr(q, '"', end - q));
+                if (!q) {
+                    q = end;
+                    break;
+                }
+                if (q + 1 < end && q[1] == '"') {
+                    doubled = true;
+                    q += 2;
+                    continue;
+                }
+                break;
+            }
+            fields.push_back(string_view(content, q - content));
+            if (doubled) escapedFields.push_back(fields.size() - 1);
+            // Anything between the closing quote and the delimiter is dropped
+            p = findDelimiter(q < end ? q + 1 : end, end);
+        } else {
+            const char* delimiter = findDelimiter(p, end);
+            fields.push_back(string_view(p, delimiter - p));
+            p = delimiter;
+        }
+
+        if (p < end && *p == ',') {
+            p++;
+            continue;
+        }
+        recordEnd = p;
+        if (p < end && *p == '\r') p++;
+        if (p < end && *p == '\n') p++;
+        break;
+    }
+    position = p;
+
+    if (!escapedFields.empty()) {
+        // Reserve once so earlier views into scratch stay valid
+        size_t total = 0;
+        for (size_t index : escapedFields) total += fields[index].size();
+        scratch.clear();
+        scratch.reserve(total);
+        for (size_t index : escapedFields) {
+            size_t start = scratch.size();
+            string_view raw = fields[index];
+            for (size_t i = 0; i < raw.size(); i++) {
+                scratch += raw[i];
+                if (raw[i] == '"') i++;  // Skip the second quote of ""
+            }
+            fields[index] = string_view(scratch.data() + start, scratch.size() - start);
+        }
+    }
+    return true;
+}
+
+// ==================== IMPORT / EXPORT ====================
+
+bool ScheduleCsv::importFlights(sqlite3* db, const string& path, CsvImportStats& stats, size_t rowsPerTransaction,
+                                ostream* rejects) {
+    stats = CsvImportStats();
+    if (!db) return false;
+
+    InputFile input;
+    if (!input.open(path)) {
+        cerr << "Cannot read " << path << endl;
+        return false;
+    }
+    stats.bytes = input.size();
+    CsvReader reader(input.data(), input.size());
+    vector<string_view> fields;
+
+    // Header: locate the required columns by name
+    if (!reader.next(fields)) {
+        cerr << path << " is empty" << endl;
+        return false;
+    }
+    if (!fields.empty() && fields[0].substr(0, 3) == "\xEF\xBB\xBF") {
+        fields[0].remove_prefix(3);  // UTF-8 byte order mark
+    }
+    size_t column[COLUMN_COUNT];
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+        column[c] = SIZE_MAX;
+        for (size_t f = 0; f < fields.size(); f++) {
+            if (fields[f] == COLUMN_NAMES[c]) column[c] = f;
+        }
+        if (column[c] == SIZE_MAX) {
+            cerr << path << ": header lacks column " << COLUMN_NAMES[c] << endl;
+            return false;
+        }
+    }
+    if (rejects) {
+        *rejects << reader.record() << '\n';
+    }
+
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql =
+        "INSERT INTO flights (flight_number, flight_name, source, destination, date, departure_time, base_price) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?) ON CONFLICT(flight_number, date) DO UPDATE SET "
+        "flight_name = excluded.flight_name, source = excluded.source, destination = excluded.destination, "
+        "departure_time = excluded.departure_time, base_price = excluded.base_price;";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return false;
+    }
+
+    size_t batchRows = max<size_t>(rowsPerTransaction, 1);
+    size_t inBatch = 0;
+    size_t released = 0;
+    char departure[17];
+    double price = 0.0;
+    set<string> batchDates;  ///< Dates written by the open batch
+    string lastDate;         ///< Rows usually arrive grouped by date; saves a set lookup per row
+    string firstImported;    ///< Date range of committed batches
+    string lastImported;
+    // Commits the open batch with its dates and moves its rows into the imported count
+    auto finishBatch = [&]() {
+        bool committed = recordImportedDays(db, batchDates) && commitBatch(db);
+        if (committed) {
+            stats.rowsImported += inBatch;
+            if (!batchDates.empty()) {
+                if (firstImported.empty() || *batchDates.begin() < firstImported) firstImported = *batchDates.begin();
+                if (*batchDates.rbegin() > lastImported) lastImported = *batchDates.rbegin();
+            }
+        } else {
+            stats.rowsFailed += inBatch;
+        }
+        batchDates.clear();
+        lastDate.clear();
+        inBatch = 0;
+        return committed;
+    };
+    bool ok = beginBatch(db);
+    while (ok) {
+        if (reader.offset() - released >= DROP_BYTES) {
+            released = reader.offset();
+            input.release(released);
+        }
+        if (!reader.next(fields)) break;
+        if (fields.size() == 1 && fields[0].empty()) continue;  // Blank line
+        stats.rowsRead++;
+
+        const char* problem = validateRow(fields, column, departure, price);
+        if (problem) {
+            if (stats.rowsRejected < 10) {
+                cerr << path << " row " << stats.rowsRead << ": " << problem << endl;
+            }
+            stats.rowsRejected++;
+            if (rejects) *rejects << reader.record() << '\n';
+            continue;
+        }
+
+        // Views point into the mapping and stay valid until the statement is reset
+        const Column textColumns[5] = {FLIGHT_NUMBER, FLIGHT_NAME, SOURCE, DESTINATION, DATE};
+        for (int i = 0; i < 5; i++) {
+            string_view value = fields[column[textColumns[i]]];
+            sqlite3_bind_text(stmt, i + 1, value.data(), (int)value.size(), SQLITE_STATIC);
+        }
+        sqlite3_bind_text(stmt, 6, departure, 16, SQLITE_STATIC);
+        sqlite3_bind_double(stmt, 7, price);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            cerr << "Import failed at row " << stats.rowsRead << ": " << sqlite3_errmsg(db) << endl;
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            stats.rowsFailed += inBatch + 1;
+            ok = false;
+            break;
+        }
+        sqlite3_reset(stmt);
+        string_view date = fields[column[DATE]];
+        if (date != lastDate) {
+            lastDate.assign(date.data(), date.size());
+            batchDates.insert(lastDate);
+        }
+
+        // Rows count as imported only once their batch has committed
+        if (++inBatch == batchRows) {
+            ok = finishBatch() && beginBatch(db);
+        }
+    }
+    sqlite3_finalize(stmt);
+    if (ok) {
+        ok = finishBatch();
+    }
+    if (stats.rowsImported > 0) {
+        // Without this the first start would adopt the rows as an old generated schedule and rewrite them
+        if (!ScheduleGenerator::coverImportedDays(db, ScheduleStore::dayNumberFromDate(firstImported),
+                                                  ScheduleStore::dayNumberFromDate(lastImported))) {
+            cerr << "Failed to record the imported schedule window: " << sqlite3_errmsg(db) << endl;
+            ok = false;
+        }
+        ScheduleStore::bumpGeneration(db);
+    }
+    if (stats.rowsRejected > 10) {
+        cerr << "... " << stats.rowsRejected - 10 << " more rows rejected" << endl;
+    }
+    return ok;
+}
+
+long long ScheduleCsv::exportFlights(sqlite3* db, const string& path) {
+    // Primary key order, so rows stream from the index without a sort
+    return exportQuery(db, path, "flight_number,flight_name,source,destination,date,departure_time,base_price",
+                       "SELECT flight_number, flight_name, source, destination, date, departure_time, base_price "
+                       "FROM flights ORDER BY flight_number, date;");
+}
+
+long long ScheduleCsv::exportBookings(sqlite3* db, const string& path) {
+    return exportQuery(db, path,
+                       "id,passenger_name,passenger_email,passenger_phone,flight_number,flight_date,seat_number,"
+                       "seat_class,price,booking_time",
+                       "SELECT id, passenger_name, passenger_email, passenger_phone, flight_number, flight_date, "
+                       "seat_number, seat_class, price, booking_time FROM bookings ORDER BY id;");
+}
@@ -0,0 +1,126 @@
+/**
+ * @file schedule_csv.h
+ * @brief Streaming CSV import of partner schedules and CSV export of flights and bookings
+ *
+ * The importer maps the input file and parses it in place: fields are
+ * string_views into the mapping, delimiters are found 16 bytes at a time
+ * with SSE2 where available, and values are bound to the insert statement
+ * without copying. Only quoted fields containing "" are copied, into a
+ * per-row scratch buffer. Pages behind the parser are dropped as it goes,
+ * so memory stays flat however large the file is.
+ *
+ * Import format (RFC 4180, header row required, columns in any order,
+ * unknown columns ignored):
+ *
+ *   flight_number,flight_name,source,destination,date,departure_time,base_price
+ *   SP1001,Sky Express,Mumbai,Delhi,2025-11-20,06:00,4500
+ *
+ * departure_time is "HH:MM" or "YYYY-MM-DD HH:MM" on the same date.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef SCHEDULE_CSV_H
+#define SCHEDULE_CSV_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+
+struct sqlite3;  // Forward declaration for SQLite database handle
+
+using namespace std;
+
+/**
+ * @class CsvReader
+ * @brief RFC 4180 record splitter over a caller-owned buffer
+ */
+class CsvReader {
+public:
+    CsvReader(const char* data, size_t size);
+
+    /**
+     * @brief Splits the next record into fields
+     * @param fields Set to one view per field; valid until the next call
+     * @return false at end of input
+     *
+     * Accepts LF and CRLF line ends and quoted fields spanning lines.
+     * An unterminated quote runs to the end of the input.
+     */
+    bool next(vector<string_view>& fields);
+
+    /**
+     * @brief Raw bytes of the last record, without its line end
+     */
+    string_view record() const { return string_view(recordStart, recordEnd - recordStart); }
+
+    /**
+     * @brief Bytes consumed so far
+     */
+    size_t offset() const { return position - begin; }
+
+private:
+    const char* begin;
+    const char* position;
+    const char* end;
+    const char* recordStart;
+    const char* recordEnd;
+    string scratch;                ///< Unescaped copies of quoted fields with doubled quotes
+    vector<size_t> escapedFields;  ///< Fields of the current record that need unescaping
+};
+
+/**
+ * @struct CsvImportStats
+ * @brief Outcome of one import
+ */
+struct CsvImportStats {
+    long long rowsRead = 0;      ///< Data rows, excluding the header
+    long long rowsImported = 0;  ///< Inserted or replaced flights, counted once their batch commits
+    long long rowsRejected = 0;  ///< Rows failing validation; see the rejects stream
+    long long rowsFailed = 0;    ///< Valid rows lost when a write failed and their batch was rolled back
+    uint64_t bytes = 0;          ///< Input size
+};
+
+/**
+ * @class ScheduleCsv
+ * @brief Bulk CSV transfer of the flights and bookings tables
+ */
+class ScheduleCsv {
+public:
+    static const size_t DEFAULT_BATCH_ROWS = 50000;  ///< Rows per import transaction
+
+    /**
+     * @brief Upserts the flights of a CSV file, keyed by (flight_number, date)
+     * @param db Open database with the schema already created
+     * @param path CSV file to import
+     * @param stats Filled in as the import runs
+     * @param rowsPerTransaction Rows committed together
+     * @param rejects If given, receives every rejected row verbatim, after the header
+     * @return false if the file cannot be read, lacks a required column, or a write fails;
+     *         transactions committed before a write failure are kept and the import stops there
+     *
+     * Lists the imported dates in imported_days and widens the schedule
+     * window over them, so the maintainer archives them when they depart but
+     * never generates over them. Bumps the schedule generation, so every
+     * process reloads its schedule store and the schedule snapshot is rebuilt.
+     */
+    static bool importFlights(sqlite3* db, const string& path, CsvImportStats& stats,
+                              size_t rowsPerTransaction = DEFAULT_BATCH_ROWS, ostream* rejects = nullptr);
+
+    /**
+     * @brief Writes the flights table as CSV in import format, ordered by flight number and date
+     * @return Rows written, or -1 on failure
+     */
+    static long long exportFlights(sqlite3* db, const string& path);
+
+    /**
+     * @brief Writes the bookings table as CSV, ordered by booking ID
+     * @return Rows written, or -1 on failure
+     */
+    static long long exportBookings(sqlite3* db, const string& path);
+};
+
+#endif // SCHEDULE_CSV_H
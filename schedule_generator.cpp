@@ -0,0 +1,424 @@
+#include "schedule_generator.h"
+#include "schedule_store.h"
+#include "booking_log.h"
+#include "time_core.h"
+#include <sqlite3.h>
+#include <iostream>
+#include <cstdlib>
+#include <thread>
+#include <future>
+#include <algorithm>
+
+using namespace std;
+
+const int ScheduleGenerator::SCHEDULE_VERSION = 2;
+
+namespace {
+
+/// SplitMix64 finalizer: cheap, well-mixed and identical on every platform
+uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+int hourOf(const string& hhmm) {
+    return atoi(hhmm.c_str());
+}
+
+}
+
+ScheduleGenerator::ScheduleGenerator(const GeneratorConfig& cfg) : config(cfg) {
+    const char* realCities[] = {
+        "Mumbai", "Delhi", "Bangalore", "Chennai", "Kolkata",
+        "Hyderabad", "Pune", "Goa", "Jaipur", "Kochi"
+    };
+    for (int i = 0; i < config.cityCount; i++) {
+        cities.push_back(i < 10 ? realCities[i] : "City" + to_string(i + 1));
+    }
+
+    // Every ordered city pair, in the same order as the original schedule
+    for (int i = 0; i < config.cityCount; i++) {
+        for (int j = 0; j < config.cityCount; j++) {
+            if (i != j) routes.push_back({i, j});
+        }
+    }
+
+    if (config.anchorDay != INT32_MIN) {
+        anchorDay = config.anchorDay;
+    } else {
+        anchorDay = localDayNumber(config.startTime ? config.startTime : currentTime());
+    }
+}
+
+int ScheduleGenerator::basePriceFor(int day, int route, int slot, long long serial, int weekday) const {
+    const string& source = cities[routes[route].first];
+    const string& destination = cities[routes[route].second];
+
+    // Calculate route-based pricing (distance approximation)
+    // Popular/longer routes cost more
+    int routeMultiplier = 100;
+    if (source == "Mumbai" || destination == "Mumbai" ||
+        source == "Delhi" || destination == "Delhi" ||
+        source == "Bangalore" || destination == "Bangalore") {
+        routeMultiplier = 150; // Metro cities cost more
+    }
+    if ((source == "Goa" && destination == "Mumbai") ||
+        (source == "Mumbai" && destination == "Goa") ||
+        (source == "Delhi" && destination == "Bangalore") ||
+        (source == "Bangalore" && destination == "Delhi")) {
+        routeMultiplier = 180; // Popular tourist/business routes
+    }
+
+    // Base price varies by route with some pseudo-randomness
+    int routeBase = 2000 + (route * 47) % 3000;
+
+    // Time-based pricing variation
+    int hour = hourOf(config.departureTimes[slot]);
+    double timeMultiplier = 1.0;
+    if (hour < 8) timeMultiplier = 0.85;       // Early morning: cheaper
+    else if (hour < 12) timeMultiplier = 1.1;  // Mid-morning: expensive
+    else if (hour < 16) timeMultiplier = 1.0;  // Afternoon: normal
+    else if (hour < 20) timeMultiplier = 1.15; // Evening: most expensive
+    else timeMultiplier = 0.95;                // Night: slightly cheaper
+
+    // Add carrier-specific variation
+    const string& name = config.carriers[slot % config.carriers.size()];
+    double carrierMultiplier = 1.0;
+    if (name == "Sky Express") carrierMultiplier = 0.9;        // Budget
+    else if (name == "Cloud Nine") carrierMultiplier = 1.1;    // Premium
+    else if (name == "Wind Jet") carrierMultiplier = 0.95;     // Low-cost
+    else if (name == "Star Flight") carrierMultiplier = 1.05;  // Mid-range
+
+    // Day-of-week variation (weekends slightly more expensive)
+    double dayMultiplier = 1.0;
+    if (weekday == 0 || weekday == 6) {
+        dayMultiplier = 1.08; // Weekend surcharge
+    }
+
+    // Calculate final base price with all factors
+    int basePrice = (int)(routeBase + routeMultiplier) *
+                    timeMultiplier * carrierMultiplier * dayMultiplier;
+
+    // Add small random variation (±5%); seed 0 keeps the original sequence
+    int randomVar;
+    if (config.seed == 0) {
+        randomVar = (int)((serial * 17 + day * 13 + slot * 7) % 11) - 5;
+    } else {
+        randomVar = (int)(mix64(config.seed ^ mix64((uint64_t)serial)) % 11) - 5;
+    }
+    basePrice = basePrice + (basePrice * randomVar / 100);
+
+    // Ensure minimum price
+    if (basePrice < 1500) basePrice = 1500;
+    return basePrice;
+}
+
+void ScheduleGenerator::generateDay(int day, DayBatch& batch) const {
+    int32_t dayNumber = anchorDay + day;
+    int weekday = weekdayFromDays(dayNumber);
+    int slots = (int)config.departureTimes.size();
+    long long routeCount = (long long)routes.size();
+
+    batch.date = ScheduleStore::dateFromDayNumber(dayNumber);
+    batch.rows.clear();
+    batch.bookedSeats.clear();
+    batch.rows.reserve(routeCount * slots);
+
+    // Pre-booking threshold on a 32-bit hash; 0 disables it entirely
+    uint64_t threshold = (uint64_t)(min(max(config.loadFactor, 0.0), 1.0) * 4294967296.0);
+
+    for (int r = 0; r < (int)routeCount; r++) {
+        for (int i = 0; i < slots; i++) {
+            FlightRow row;
+            row.serial = config.firstFlightNumber + ((long long)day * routeCount + r) * slots + i;
+            row.carrier = i % (int)config.carriers.size();
+            row.route = r;
+            row.slot = i;
+            row.basePrice = basePriceFor(day, r, i, row.serial, weekday);
+            batch.rows.push_back(row);
+
+            if (threshold == 0) continue;
+            for (int seat = 1; seat <= 100; seat++) {
+                uint64_t h = mix64(config.seed ^ mix64(((uint64_t)row.serial << 8) | seat));
+                if ((h & 0xFFFFFFFFULL) < threshold) {
+                    batch.bookedSeats.push_back({row.serial, seat});
+                }
+            }
+        }
+    }
+}
+
+bool ScheduleGenerator::insertRows(sqlite3* db, const DayBatch& day, size_t begin, size_t end,
+                                   long long& inserted) const {
+    sqlite3_stmt* flightStmt = nullptr;
+    sqlite3_stmt* seatStmt = nullptr;
+    if (sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO flights VALUES (?, ?, ?, ?, ?, ?, ?);",
+                           -1, &flightStmt, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO booked_seats VALUES (?, ?, ?, 'Load Test');",
+                           -1, &seatStmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        sqlite3_finalize(flightStmt);
+        return false;
+    }
+
+    string number, departure;
+    for (size_t r = begin; r < end; r++) {
+        const FlightRow& row = day.rows[r];
+        number = config.flightPrefix + to_string(row.serial);
+        departure = day.date + " " + config.departureTimes[row.slot];
+        sqlite3_bind_text(flightStmt, 1, number.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(flightStmt, 2, config.carriers[row.carrier].c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(flightStmt, 3, cities[routes[row.route].first].c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(flightStmt, 4, cities[routes[row.route].second].c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(flightStmt, 5, day.date.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(flightStmt, 6, departure.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_double(flightStmt, 7, row.basePrice);
+        sqlite3_step(flightStmt);
+        sqlite3_reset(flightStmt);
+        inserted += sqlite3_changes(db);
+    }
+
+    // Pre-booked seats are sorted by serial, so the slice matches the rows
+    if (begin < end && !day.bookedSeats.empty()) {
+        long long firstSerial = day.rows[begin].serial;
+        long long lastSerial = day.rows[end - 1].serial;
+        auto it = lower_bound(day.bookedSeats.begin(), day.bookedSeats.end(), make_pair(firstSerial, 0));
+        for (; it != day.bookedSeats.end() && it->first <= lastSerial; ++it) {
+            number = config.flightPrefix + to_string(it->first);
+            sqlite3_bind_text(seatStmt, 1, number.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(seatStmt, 2, day.date.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int(seatStmt, 3, it->second);
+            sqlite3_step(seatStmt);
+            sqlite3_reset(seatStmt);
+        }
+        // Pre-booked seats are not in the booking log; running systems rebuild from the table
+        BookingLog::invalidate(db);
+    }
+    sqlite3_finalize(flightStmt);
+    sqlite3_finalize(seatStmt);
+    return true;
+}
+
+static bool commitOrRollback(sqlite3* db) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, "COMMIT;", nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        cerr << "Failed to commit transaction: " << errMsg << endl;
+        sqlite3_free(errMsg);
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        return false;
+    }
+    return true;
+}
+
+bool ScheduleGenerator::writeBatch(sqlite3* db, const vector<DayBatch>& batch, long long& inserted) const {
+    sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
+    for (const DayBatch& day : batch) {
+        if (!insertRows(db, day, 0, day.rows.size(), inserted)) {
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            return false;
+        }
+    }
+    return commitOrRollback(db);
+}
+
+bool ScheduleGenerator::writeDay(sqlite3* db, int32_t dayNumber, size_t rowsPerTransaction,
+                                 const function<bool()>& pause) {
+    if (!db || dayNumber < anchorDay) return false;
+
+    DayBatch day;
+    generateDay(dayNumber - anchorDay, day);
+
+    long long inserted = 0;
+    size_t step = max<size_t>(rowsPerTransaction, 1);
+    for (size_t begin = 0; begin < day.rows.size(); begin += step) {
+        if (begin > 0 && pause && !pause()) return false;
+        size_t end = min(day.rows.size(), begin + step);
+        sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
+        if (!insertRows(db, day, begin, end, inserted)) {
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            return false;
+        }
+        if (!commitOrRollback(db)) return false;
+    }
+    return true;
+}
+
+static string joinList(const vector<string>& items) {
+    string joined;
+    for (size_t i = 0; i < items.size(); i++) {
+        if (i > 0) joined += ",";
+        joined += items[i];
+    }
+    return joined;
+}
+
+static vector<string> splitList(const string& value) {
+    vector<string> items;
+    size_t start = 0;
+    while (start <= value.size()) {
+        size_t comma = value.find(',', start);
+        if (comma == string::npos) comma = value.size();
+        if (comma > start) items.push_back(value.substr(start, comma - start));
+        start = comma + 1;
+    }
+    return items;
+}
+
+bool ScheduleGenerator::saveWindow(sqlite3* db, const ScheduleWindow& window) const {
+    if (!db) return false;
+
+    sqlite3_stmt* stmt;
+    const char* sql =
+        "INSERT OR REPLACE INTO schedule_window VALUES (1, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return false;
+    }
+    string carriers = joinList(config.carriers);
+    string times = joinList(config.departureTimes);
+    sqlite3_bind_int(stmt, 1, window.version);
+    sqlite3_bind_int(stmt, 2, anchorDay);
+    sqlite3_bind_int(stmt, 3, window.firstDay);
+    sqlite3_bind_int(stmt, 4, window.lastDay);
+    sqlite3_bind_int(stmt, 5, config.horizonDays);
+    sqlite3_bind_int(stmt, 6, config.cityCount);
+    sqlite3_bind_text(stmt, 7, carriers.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 8, times.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 9, (sqlite3_int64)config.seed);
+    sqlite3_bind_int(stmt, 10, config.firstFlightNumber);
+    sqlite3_bind_text(stmt, 11, config.flightPrefix.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 12, window.generated ? 1 : 0);
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+bool ScheduleGenerator::loadWindow(sqlite3* db, GeneratorConfig& config, ScheduleWindow& window) {
+    if (!db) return false;
+
+    sqlite3_stmt* stmt;
+    const char* sql =
+        "SELECT version, anchor_day, first_day, last_day, horizon_days, city_count, carriers, "
+        "departure_times, seed, first_flight_number, flight_prefix, generated FROM schedule_window WHERE id = 1;";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    bool found = sqlite3_step(stmt) == SQLITE_ROW;
+    if (found) {
+        window.version = sqlite3_column_int(stmt, 0);
+        config.anchorDay = sqlite3_column_int(stmt, 1);
+        window.firstDay = sqlite3_column_int(stmt, 2);
+        window.lastDay = sqlite3_column_int(stmt, 3);
+        config.horizonDays = sqlite3_column_int(stmt, 4);
+        config.cityCount = sqlite3_column_int(stmt, 5);
+        config.carriers = splitList(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6)));
+        config.departureTimes = splitList(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7)));
+        config.seed = (uint64_t)sqlite3_column_int64(stmt, 8);
+        config.firstFlightNumber = sqlite3_column_int(stmt, 9);
+        config.flightPrefix = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 10));
+        window.generated = sqlite3_column_int(stmt, 11) != 0;
+        config.loadFactor = 0.0;
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+bool ScheduleGenerator::coverImportedDays(sqlite3* db, int32_t firstDay, int32_t lastDay) {
+    GeneratorConfig config;
+    ScheduleWindow window;
+    if (!loadWindow(db, config, window)) {
+        window = {firstDay, lastDay, SCHEDULE_VERSION, false};
+        config.anchorDay = firstDay;
+    } else if (window.lastDay < window.firstDay) {
+        // Emptied after everything departed; a generated window keeps growing from its first day
+        window.firstDay = min(window.firstDay, firstDay);
+        if (!window.generated) window.lastDay = lastDay;
+    } else {
+        window.firstDay = min(window.firstDay, firstDay);
+        if (!window.generated) window.lastDay = max(window.lastDay, lastDay);
+    }
+    return ScheduleGenerator(config).saveWindow(db, window);
+}
+
+bool ScheduleGenerator::isImportedDay(sqlite3* db, const string& date) {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM imported_days WHERE date = ?;", -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, date.c_str(), -1, SQLITE_STATIC);
+    bool imported = sqlite3_step(stmt) == SQLITE_ROW;
+    sqlite3_finalize(stmt);
+    return imported;
+}
+
+long long ScheduleGenerator::generate(sqlite3* db) {
+    if (!db || config.cityCount < 2 || config.carriers.empty() ||
+        config.departureTimes.empty() || config.horizonDays <= 0) {
+        cerr << "Invalid schedule generator configuration" << endl;
+        return -1;
+    }
+
+    int threads = config.threads > 0 ? config.threads : (int)thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+
+    cout << "Generating " << config.expectedFlights() << " flights for " << routes.size()
+         << " routes over " << config.horizonDays << " days on " << threads << " threads..." << endl;
+
+    sqlite3_exec(db, "DELETE FROM flights;", nullptr, nullptr, nullptr);
+    sqlite3_exec(db, "DELETE FROM db_version;", nullptr, nullptr, nullptr);
+    sqlite3_exec(db, "DELETE FROM imported_days;", nullptr, nullptr, nullptr);
+
+    // Each batch holds one day per thread; days are independent, so any
+    // split yields the same rows. The next batch is generated while the
+    // current one is written, keeping SQLite (single writer) busy.
+    auto generateBatch = [this, threads](int firstDayIndex) {
+        int count = min(threads, config.horizonDays - firstDayIndex);
+        vector<DayBatch> batch(count);
+        vector<thread> workers;
+        for (int t = 0; t < count; t++) {
+            workers.emplace_back([this, &batch, firstDayIndex, t]() {
+                generateDay(firstDayIndex + t, batch[t]);
+            });
+        }
+        for (thread& w : workers) w.join();
+        return batch;
+    };
+
+    long long inserted = 0;
+    future<vector<DayBatch>> pending = async(launch::async, generateBatch, 0);
+    for (int day = 0; day < config.horizonDays; day += threads) {
+        vector<DayBatch> batch = pending.get();
+        if (day + threads < config.horizonDays) {
+            pending = async(launch::async, generateBatch, day + threads);
+        }
+        if (!writeBatch(db, batch, inserted)) {
+            if (pending.valid()) pending.wait();
+            return -1;
+        }
+    }
+
+    cout << "Successfully populated " << inserted << " flights" << endl;
+    cout << "Routes: " << routes.size() << " (all city pairs)" << endl;
+    cout << "Days covered: " << config.horizonDays << " (" << ScheduleStore::dateFromDayNumber(anchorDay)
+         << " - " << ScheduleStore::dateFromDayNumber(anchorDay + config.horizonDays - 1) << ")" << endl;
+
+    // Store version info
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO db_version VALUES (?, ?, ?, ?);",
+                           -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int(stmt, 1, SCHEDULE_VERSION);
+        sqlite3_bind_int64(stmt, 2, (sqlite3_int64)routes.size());
+        sqlite3_bind_int64(stmt, 3, inserted);
+        sqlite3_bind_int64(stmt, 4, currentTime());
+        sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+    }
+    ScheduleWindow window = {anchorDay, anchorDay + config.horizonDays - 1, SCHEDULE_VERSION, true};
+    saveWindow(db, window);
+    ScheduleStore::bumpGeneration(db);
+
+    cout << "Database version " << SCHEDULE_VERSION << " set successfully" << endl;
+    return inserted;
+}
@@ -0,0 +1,175 @@
+/**
+ * @file schedule_generator.h
+ * @brief Parameterized synthetic flight schedule generator
+ *
+ * Produces the same route and base-price heuristics as the original
+ * hardcoded populateFlights, but for any number of cities, carriers,
+ * daily departures and days. Rows are generated deterministically on
+ * several threads and written through a single prepared statement, so
+ * 1M-100M flight databases can be built for scale testing.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef SCHEDULE_GENERATOR_H
+#define SCHEDULE_GENERATOR_H
+
+#include <vector>
+#include <string>
+#include <ctime>
+#include <cstdint>
+#include <functional>
+
+struct sqlite3;  // Forward declaration for SQLite database handle
+
+using namespace std;
+
+/**
+ * @struct GeneratorConfig
+ * @brief Shape of a synthetic schedule
+ *
+ * Defaults reproduce the shipped schedule: 10 cities (90 routes),
+ * 5 carriers, 5 daily departures per route and 60 days.
+ */
+struct GeneratorConfig {
+    int cityCount = 10;               ///< First 10 are real cities, the rest are "City11", ...
+    vector<string> carriers = {"Sky Express", "Cloud Nine", "Wind Jet", "Star Flight", "Thunder Express"};
+    vector<string> departureTimes = {"06:00", "10:00", "14:00", "18:00", "21:00"};  ///< Daily frequencies
+    int horizonDays = 60;             ///< Days generated from startTime
+    uint64_t seed = 0;                ///< 0 reproduces the legacy price variation exactly
+    int threads = 0;                  ///< 0 = one per hardware thread
+    double loadFactor = 0.0;          ///< Fraction of seats to pre-book in booked_seats
+    time_t startTime = 0;             ///< 0 = now; first generated day is its local date
+    int32_t anchorDay = INT32_MIN;    ///< Day number of day index 0; INT32_MIN = local date of startTime
+    int firstFlightNumber = 1001;     ///< Serial of the first generated flight
+    string flightPrefix = "SP";       ///< Flight number prefix
+
+    int routeCount() const { return cityCount * (cityCount - 1); }
+    long long expectedFlights() const {
+        return (long long)routeCount() * departureTimes.size() * horizonDays;
+    }
+};
+
+/**
+ * @struct ScheduleWindow
+ * @brief Range of days currently held in the flights table
+ *
+ * Persisted in schedule_window together with the GeneratorConfig that
+ * produced it, so the schedule can be extended with the same flight numbers.
+ * Days written by a partner import are listed in imported_days; the
+ * maintainer archives them but never rewrites them or generates over them.
+ */
+struct ScheduleWindow {
+    int32_t firstDay;  ///< Earliest day still in flights (days since epoch)
+    int32_t lastDay;   ///< Last fully written day
+    int version;       ///< SCHEDULE_VERSION that wrote the rows
+    bool generated;    ///< false for a window recorded by a partner import; it is only archived
+};
+
+/**
+ * @class ScheduleGenerator
+ * @brief Deterministic multi-threaded writer of flights (and optional bookings)
+ */
+class ScheduleGenerator {
+public:
+    /// Recorded in db_version; bump when the generation logic changes
+    static const int SCHEDULE_VERSION;
+
+    explicit ScheduleGenerator(const GeneratorConfig& config);
+
+    /**
+     * @brief Generates the configured schedule into the flights table
+     * @param db Open database with the schema already created
+     * @return Number of flights inserted, or -1 on failure
+     *
+     * Days are generated in parallel batches; each batch is committed in
+     * one transaction while the next batch is being generated.
+     */
+    long long generate(sqlite3* db);
+
+    /**
+     * @brief Writes one day of flights without touching other days
+     * @param db Open database with the schema already created
+     * @param dayNumber Day to write (days since epoch, not before the anchor)
+     * @param rowsPerTransaction Upper bound on rows per committed transaction
+     * @param pause Called between transactions; returning false aborts
+     * @return true if the whole day was written
+     *
+     * Flight numbers depend only on the anchor day and the configuration,
+     * so a day written later gets the same numbers as a full generate().
+     */
+    bool writeDay(sqlite3* db, int32_t dayNumber, size_t rowsPerTransaction,
+                  const function<bool()>& pause);
+
+    /**
+     * @brief Records the configuration and day range in schedule_window
+     */
+    bool saveWindow(sqlite3* db, const ScheduleWindow& window) const;
+
+    /**
+     * @brief Reads the schedule_window row
+     * @param db Open database connection
+     * @param config Receives the stored generator configuration
+     * @param window Receives the stored day range
+     * @return false if no window has been recorded
+     */
+    static bool loadWindow(sqlite3* db, GeneratorConfig& config, ScheduleWindow& window);
+
+    /**
+     * @brief Widens the recorded window over days written by a partner import
+     * @param db Open database connection
+     * @param firstDay First imported day (days since epoch)
+     * @param lastDay Last imported day
+     * @return false if the window could not be written
+     *
+     * Without a window (or with an empty one) the imported range becomes a
+     * window that is not generated. A generated window only moves its first
+     * day back, so departed imported days are archived with the rest.
+     */
+    static bool coverImportedDays(sqlite3* db, int32_t firstDay, int32_t lastDay);
+
+    /**
+     * @brief True if a partner import wrote flights on the date
+     */
+    static bool isImportedDay(sqlite3* db, const string& date);
+
+    /**
+     * @brief Names of the generated cities in route order
+     */
+    const vector<string>& getCities() const { return cities; }
+
+    /**
+     * @brief Day number of day index 0 (the first flight number's day)
+     */
+    int32_t getAnchorDay() const { return anchorDay; }
+
+private:
+    /// One generated flight, ready to bind
+    struct FlightRow {
+        long long serial;
+        int carrier;
+        int route;
+        int slot;
+        int basePrice;
+    };
+
+    /// One generated day
+    struct DayBatch {
+        string date;
+        vector<FlightRow> rows;
+        vector<pair<long long, int>> bookedSeats;  ///< (flight serial, seat number)
+    };
+
+    GeneratorConfig config;
+    vector<string> cities;
+    vector<pair<int, int>> routes;  ///< (source, destination) city indices
+    int32_t anchorDay;              ///< Day number of day index 0
+
+    void generateDay(int day, DayBatch& batch) const;
+    int basePriceFor(int day, int route, int slot, long long serial, int weekday) const;
+    bool writeBatch(sqlite3* db, const vector<DayBatch>& batch, long long& inserted) const;
+    bool insertRows(sqlite3* db, const DayBatch& day, size_t begin, size_t end, long long& inserted) const;
+};
+
+#endif // SCHEDULE_GENERATOR_H
@@ -0,0 +1,276 @@
+#include "schedule_maintainer.h"
+#include "schedule_generator.h"
+#include "schedule_store.h"
+#include "month_partitions.h"
+#include "time_core.h"
+#include <sqlite3.h>
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+const char* ScheduleMaintainer::PARTITION_ARCHIVE_DIRECTORY = "archive";
+const char* ScheduleMaintainer::OWNER_LOCK_SUFFIX = ".maintainer.lock";
+
+ScheduleMaintainer::ScheduleMaintainer(bool archive) : archiveDeparted(archive), stopping(false), ownerLock(-1) {}
+
+ScheduleMaintainer::~ScheduleMaintainer() {
+    stop();
+}
+
+void ScheduleMaintainer::start(const string& dbPath) {
+    if (worker.joinable()) return;
+    stopping = false;
+    worker = thread(&ScheduleMaintainer::run, this, dbPath);
+}
+
+void ScheduleMaintainer::stop() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+bool ScheduleMaintainer::isBusinessHours(time_t now) {
+    int hour = civilTimeFromTimestamp(now).hour;
+    return hour >= BUSINESS_START_HOUR && hour < BUSINESS_END_HOUR;
+}
+
+bool ScheduleMaintainer::claimOwnership(const string& dbPath) {
+#ifndef _WIN32
+    if (ownerLock >= 0) return true;
+    // A separate file: SQLite holds its own POSIX locks on the database file itself.
+    // The kernel drops the lock when its holder exits, however it exits
+    string lockPath = dbPath + OWNER_LOCK_SUFFIX;
+    int file = ::open(lockPath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file < 0) {
+        cerr << "Schedule maintainer cannot open " << lockPath << endl;
+        return false;
+    }
+    if (flock(file, LOCK_EX | LOCK_NB) != 0) {
+        ::close(file);
+        return false;
+    }
+    ownerLock = file;
+    cout << "Schedule maintainer: this process (" << getpid() << ") now maintains " << dbPath << endl;
+    return true;
+#else
+    (void)dbPath;
+    return true;
+#endif
+}
+
+bool ScheduleMaintainer::pause() {
+    unique_lock<mutex> guard(lock);
+    if (isBusinessHours(currentTime())) {
+        wakeup.wait_for(guard, chrono::milliseconds(BUSINESS_PAUSE_MS), [this]() { return stopping; });
+    }
+    return !stopping;
+}
+
+void ScheduleMaintainer::run(string dbPath) {
+    sqlite3* db = nullptr;
+    if (sqlite3_open(dbPath.c_str(), &db) != SQLITE_OK) {
+        cerr << "Schedule maintainer failed to open database: " << sqlite3_errmsg(db) << endl;
+        sqlite3_close(db);
+        return;
+    }
+    sqlite3_busy_timeout(db, 5000);
+
+    unique_lock<mutex> guard(lock);
+    while (!stopping) {
+        guard.unlock();
+        // Other processes on the same database skip the pass and keep trying the lock
+        if (claimOwnership(dbPath)) {
+            runOnce(db, currentTime());
+        }
+        guard.lock();
+        wakeup.wait_for(guard, chrono::seconds(PASS_INTERVAL_SECONDS), [this]() { return stopping; });
+    }
+    guard.unlock();
+
+#ifndef _WIN32
+    if (ownerLock >= 0) {
+        ::close(ownerLock);
+        ownerLock = -1;
+    }
+#endif
+    sqlite3_close(db);
+}
+
+bool ScheduleMaintainer::removeDay(sqlite3* db, const string& date, bool archive, size_t rowsPerTransaction,
+                                   const function<bool()>& between) {
+    // The same ordered slice is copied and then deleted inside one transaction
+    const char* copySql =
+        "INSERT OR IGNORE INTO flights_archive SELECT * FROM flights WHERE rowid IN "
+        "(SELECT rowid FROM flights WHERE date = ?1 ORDER BY rowid LIMIT ?2);";
+    const char* deleteSql =
+        "DELETE FROM flights WHERE rowid IN "
+        "(SELECT rowid FROM flights WHERE date = ?1 ORDER BY rowid LIMIT ?2);";
+
+    sqlite3_stmt* copyStmt = nullptr;
+    sqlite3_stmt* deleteStmt = nullptr;
+    if ((archive && sqlite3_prepare_v2(db, copySql, -1, &copyStmt, nullptr) != SQLITE_OK) ||
+        sqlite3_prepare_v2(db, deleteSql, -1, &deleteStmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        sqlite3_finalize(copyStmt);
+        return false;
+    }
+
+    bool ok = true;
+    for (bool first = true; ; first = false) {
+        if (!first && !between()) {
+            ok = false;
+            break;
+        }
+        sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr);
+        if (copyStmt) {
+            sqlite3_bind_text(copyStmt, 1, date.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int64(copyStmt, 2, (sqlite3_int64)rowsPerTransaction);
+            ok = sqlite3_step(copyStmt) == SQLITE_DONE;
+            sqlite3_reset(copyStmt);
+        }
+        int removed = 0;
+        if (ok) {
+            sqlite3_bind_text(deleteStmt, 1, date.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int64(deleteStmt, 2, (sqlite3_int64)rowsPerTransaction);
+            ok = sqlite3_step(deleteStmt) == SQLITE_DONE;
+            removed = sqlite3_changes(db);
+            sqlite3_reset(deleteStmt);
+        }
+        if (!ok || sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            cerr << "Schedule maintainer failed on " << date << ": " << sqlite3_errmsg(db) << endl;
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            ok = false;
+            break;
+        }
+        if (removed == 0) break;
+    }
+
+    sqlite3_finalize(copyStmt);
+    sqlite3_finalize(deleteStmt);
+    return ok;
+}
+
+bool ScheduleMaintainer::runOnce(sqlite3* db, time_t now) {
+    if (!db) return false;
+
+    GeneratorConfig config;
+    ScheduleWindow window;
+    if (!ScheduleGenerator::loadWindow(db, config, window)) {
+        return false;
+    }
+    ScheduleGenerator generator(config);
+
+    int32_t today = localDayNumber(now);
+    int32_t horizonEnd = today + config.horizonDays - 1;
+
+    size_t rowsPerTransaction = isBusinessHours(now) ? BUSINESS_ROWS_PER_TRANSACTION
+                                                     : OFF_HOURS_ROWS_PER_TRANSACTION;
+    function<bool()> between = [this]() { return pause(); };
+
+    int archived = 0;
+    int rewritten = 0;
+    int appended = 0;
+
+    // 1. Departed days leave the live table, oldest first
+    bool archiveComplete = true;
+    int32_t lastDeparted = min(today - 1, window.lastDay);
+    for (int32_t day = window.firstDay; day <= lastDeparted; day++) {
+        if (!between() || !removeDay(db, ScheduleStore::dateFromDayNumber(day), archiveDeparted, rowsPerTransaction, between)) {
+            archiveComplete = false;
+            break;
+        }
+        window.firstDay = day + 1;
+        generator.saveWindow(db, window);
+        archived++;
+    }
+    if (archiveComplete && window.lastDay < today) {
+        // The whole window has departed; restart it empty at today
+        window.firstDay = today;
+        window.lastDay = today - 1;
+        generator.saveWindow(db, window);
+    }
+    if (archived > 0) {
+        sqlite3_stmt* forget;
+        if (sqlite3_prepare_v2(db, "DELETE FROM imported_days WHERE date < ?;", -1, &forget, nullptr) == SQLITE_OK) {
+            string firstDate = ScheduleStore::dateFromDayNumber(window.firstDay);
+            sqlite3_bind_text(forget, 1, firstDate.c_str(), -1, SQLITE_STATIC);
+            sqlite3_step(forget);
+            sqlite3_finalize(forget);
+        }
+    }
+
+    // 2. Rows written by an older generator are replaced one day at a time; imported days are left alone
+    if (archiveComplete && window.generated && window.version != ScheduleGenerator::SCHEDULE_VERSION) {
+        bool complete = true;
+        for (int32_t day = max(window.firstDay, generator.getAnchorDay()); day <= window.lastDay; day++) {
+            string date = ScheduleStore::dateFromDayNumber(day);
+            if (ScheduleGenerator::isImportedDay(db, date)) continue;
+            if (!between() ||
+                !removeDay(db, date, false, rowsPerTransaction, between) ||
+                !generator.writeDay(db, day, rowsPerTransaction, between)) {
+                complete = false;
+                break;
+            }
+            rewritten++;
+        }
+        if (complete) {
+            window.version = ScheduleGenerator::SCHEDULE_VERSION;
+            generator.saveWindow(db, window);
+        }
+    }
+
+    // 3. Missing future days are appended, except over days a partner import already filled;
+    //    an imported schedule is never extended with generated flights
+    int32_t appendFrom = archiveComplete && window.generated ? max(window.lastDay + 1, generator.getAnchorDay())
+                                                             : horizonEnd + 1;
+    for (int32_t day = appendFrom; day <= horizonEnd; day++) {
+        if (!ScheduleGenerator::isImportedDay(db, ScheduleStore::dateFromDayNumber(day))) {
+            if (!between() || !generator.writeDay(db, day, rowsPerTransaction, between)) break;
+            appended++;
+        }
+        window.lastDay = day;
+        generator.saveWindow(db, window);
+    }
+
+    // 4. Off hours, fully departed months move to their own files and old files to the archive;
+    //    the flights table itself is untouched, so neither bumps the generation
+    if (archiveComplete && !isBusinessHours(now)) {
+        MonthPartitions partitions;
+        int sealed = partitions.sealDeparted(db, now, rowsPerTransaction, between);
+        string month = MonthPartitions::shiftMonth(MonthPartitions::monthOf(ScheduleStore::dateFromDayNumber(today)),
+                                                   -ARCHIVE_AFTER_MONTHS);
+        string partitionPath = MonthPartitions::pathFor(db, month);
+        int moved = partitionPath.empty() ? 0 : partitions.archiveBefore(
+            db, month, (filesystem::path(partitionPath).parent_path() / PARTITION_ARCHIVE_DIRECTORY).string());
+        if (sealed > 0 || moved > 0) {
+            cout << "Month partitions: " << sealed << " sealed, " << moved << " archived" << endl;
+        }
+    }
+
+    // 5. Old bookings leave the hot table; off hours the freed pages go back to the file system
+    if (archiveComplete) {
+        compactor.runOnce(db, now, !isBusinessHours(now), rowsPerTransaction, between);
+    }
+
+    if (archived + rewritten + appended == 0) {
+        return false;
+    }
+
+    ScheduleStore::bumpGeneration(db);
+    cout << "Schedule window " << ScheduleStore::dateFromDayNumber(window.firstDay) << " - "
+         << ScheduleStore::dateFromDayNumber(window.lastDay) << ": " << archived << " day(s) "
+         << (archiveDeparted ? "archived" : "pruned") << ", " << rewritten << " rewritten, "
+         << appended << " appended" << endl;
+    return true;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file schedule_maintainer.h
+ * @brief Background upkeep of the rolling flight schedule window
+ *
+ * Keeps the flights table covering today plus the configured horizon:
+ * departed days are moved to flights_archive (or pruned) and missing future
+ * days are appended with the same flight numbers a full generation would
+ * assign. All work runs on its own connection in small transactions, and
+ * during business hours it writes a few hundred rows at a time with pauses
+ * so bookings never wait long for the write lock. Off hours it also seals
+ * fully departed months into their own files (month_partitions.h) and
+ * moves files older than ARCHIVE_AFTER_MONTHS into an archive directory.
+ * Every pass ends with a StorageCompactor pass: bookings past retention
+ * move to bookings_archive, and off hours free pages are reclaimed and the
+ * planner statistics refreshed.
+ *
+ * Every process that opens the database starts a maintainer, but only the
+ * one holding an advisory lock on a file beside the database runs passes;
+ * the others retry the lock each interval and take over if its holder exits.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef SCHEDULE_MAINTAINER_H
+#define SCHEDULE_MAINTAINER_H
+
+#include <string>
+#include <ctime>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "storage_compactor.h"
+
+struct sqlite3;  // Forward declaration for SQLite database handle
+
+using namespace std;
+
+/**
+ * @class ScheduleMaintainer
+ * @brief Archives departed days and appends future days on a worker thread
+ */
+class ScheduleMaintainer {
+public:
+    /**
+     * @param archiveDeparted Move departed flights to flights_archive (false deletes them)
+     */
+    explicit ScheduleMaintainer(bool archiveDeparted = true);
+    ~ScheduleMaintainer();
+    ScheduleMaintainer(const ScheduleMaintainer&) = delete;
+    ScheduleMaintainer& operator=(const ScheduleMaintainer&) = delete;
+
+    /**
+     * @brief Starts the worker: one pass now, then one per hour while this process owns maintenance
+     * @param dbPath Database file; the worker opens its own connection
+     */
+    void start(const string& dbPath);
+
+    /**
+     * @brief Stops the worker after its current transaction
+     */
+    void stop();
+
+    /**
+     * @brief Runs one maintenance pass on the calling thread
+     * @param db Open database connection
+     * @param now Current time; decides today and the transaction size
+     * @return true if the flights table changed (the generation was bumped)
+     */
+    bool runOnce(sqlite3* db, time_t now);
+
+    /**
+     * @brief Retention and compaction progress of this maintainer's passes
+     */
+    CompactionStats getCompactionStats() const { return compactor.getStats(); }
+
+    /**
+     * @brief True between 07:00 and 22:00 local time
+     */
+    static bool isBusinessHours(time_t now);
+
+private:
+    static const int BUSINESS_START_HOUR = 7;
+    static const int BUSINESS_END_HOUR = 22;
+    static const size_t BUSINESS_ROWS_PER_TRANSACTION = 500;
+    static const size_t OFF_HOURS_ROWS_PER_TRANSACTION = 50000;
+    static const int BUSINESS_PAUSE_MS = 25;
+    static const int PASS_INTERVAL_SECONDS = 60 * 60;
+    static const int ARCHIVE_AFTER_MONTHS = 24;   ///< Partitions older than this leave the database directory
+    static const char* PARTITION_ARCHIVE_DIRECTORY;  ///< Beside the database file
+    static const char* OWNER_LOCK_SUFFIX;            ///< Appended to the database path for the owner lock file
+
+    bool archiveDeparted;
+    StorageCompactor compactor;
+    thread worker;
+    mutex lock;
+    condition_variable wakeup;
+    bool stopping;
+    int ownerLock;  ///< Locked descriptor of the owner lock file, -1 while another process owns maintenance
+
+    void run(string dbPath);
+
+    /**
+     * @brief Tries to become the one process that maintains this database
+     * @return true if this process holds the owner lock (now or already)
+     */
+    bool claimOwnership(const string& dbPath);
+
+    /**
+     * @brief Sleeps between transactions during business hours
+     * @return false if stop() was requested
+     */
+    bool pause();
+
+    /**
+     * @brief Moves (or deletes) all flights of one date in bounded chunks
+     * @return false if interrupted or a statement failed
+     */
+    bool removeDay(sqlite3* db, const string& date, bool archive, size_t rowsPerTransaction,
+                   const function<bool()>& between);
+};
+
+#endif // SCHEDULE_MAINTAINER_H
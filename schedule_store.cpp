@@ -0,0 +1,578 @@
+#include "schedule_store.h"
+#include "flight_system.h"
+#include "time_core.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <numeric>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <atomic>
+#include <process.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+const uint32_t NO_SERIAL = UINT32_MAX;  ///< Flight number has no numeric suffix
+#ifdef _WIN32
+atomic<unsigned> snapshotWrites(0);     ///< Temp file names of concurrent writers in this process
+#endif
+
+template <typename Id>
+Id intern(const string& value, vector<string>& names, unordered_map<string, Id>& ids) {
+    auto it = ids.find(value);
+    if (it != ids.end()) return it->second;
+    Id id = (Id)names.size();
+    names.push_back(value);
+    ids.emplace(value, id);
+    return id;
+}
+
+const char SNAPSHOT_MAGIC[8] = {'S', 'P', 'Z', 'S', 'C', 'H', 'E', 'D'};
+const uint32_t SNAPSHOT_VERSION = 2;  ///< 2: base prices stored as double
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+const int SNAPSHOT_SECTIONS = 9;  ///< 8 columns + route index
+
+/**
+ * Fixed-size snapshot header. All offsets are from the start of the file
+ * and 8-byte aligned; integers are in host byte order (checked by the BOM).
+ */
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t headerSize;
+    uint32_t byteOrderMark;
+    uint32_t cityCount;
+    uint32_t carrierCount;
+    uint32_t prefixCount;
+    uint64_t rowCount;
+    uint64_t routeCount;
+    int64_t generation;
+    uint64_t fileSize;
+    uint64_t payloadChecksum;      ///< Hash of every byte after the header
+    uint64_t sectionOffset[SNAPSHOT_SECTIONS];
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+};
+
+/// FNV-1a style hash mixed 8 bytes at a time; streaming and one-shot agree
+class PayloadChecksum {
+public:
+    void update(const void* data, size_t length) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        while (length > 0 && pending > 0) {
+            addByte(*bytes++);
+            length--;
+        }
+        while (length >= 8) {
+            uint64_t word;
+            memcpy(&word, bytes, 8);
+            mix(word);
+            bytes += 8;
+            length -= 8;
+        }
+        while (length > 0) {
+            addByte(*bytes++);
+            length--;
+        }
+    }
+
+    uint64_t finish() {
+        if (pending > 0) {
+            mix(buffer);
+            buffer = 0;
+            pending = 0;
+        }
+        return hash;
+    }
+
+private:
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    uint64_t buffer = 0;
+    int pending = 0;
+
+    void mix(uint64_t word) {
+        hash ^= word;
+        hash *= 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+
+    void addByte(unsigned char byte) {
+        buffer |= (uint64_t)byte << (8 * pending);
+        if (++pending == 8) {
+            mix(buffer);
+            buffer = 0;
+            pending = 0;
+        }
+    }
+};
+
+size_t alignUp(size_t value) {
+    return (value + 7) & ~(size_t)7;
+}
+
+template <typename T>
+void applyPermutation(vector<T>& column, const vector<uint32_t>& order) {
+    vector<T> sorted(column.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        sorted[i] = column[order[i]];
+    }
+    column.swap(sorted);
+}
+
+} // namespace
+
+int32_t ScheduleStore::dayNumberFromDate(const string& dateStr) {
+    return parseDayNumber(dateStr);
+}
+
+string ScheduleStore::dateFromDayNumber(int32_t dayNumber) {
+    return formatDate(dayNumber);
+}
+
+ScheduleStore::ScheduleStore()
+    : routeKey(nullptr), dayNumber(nullptr), departure(nullptr), departureMinute(nullptr),
+      basePrice(nullptr), carrier(nullptr), flightPrefix(nullptr), flightSerial(nullptr),
+      routeIndex(nullptr), rowCount(0), routeCount(0), mapping(nullptr), mappingSize(0), generation(-1) {}
+
+ScheduleStore::~ScheduleStore() {
+    clear();
+}
+
+void ScheduleStore::clear() {
+#ifndef _WIN32
+    if (mapping) {
+        munmap(mapping, mappingSize);
+    }
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+
+    routeKeyData.clear();
+    dayNumberData.clear();
+    departureData.clear();
+    departureMinuteData.clear();
+    basePriceData.clear();
+    carrierData.clear();
+    flightPrefixData.clear();
+    flightSerialData.clear();
+    routeIndexData.clear();
+    cityNames.clear();
+    carrierNames.clear();
+    prefixNames.clear();
+    cityIds.clear();
+    carrierIds.clear();
+    prefixIds.clear();
+    bindOwnedColumns();
+}
+
+void ScheduleStore::bindOwnedColumns() {
+    routeKey = routeKeyData.data();
+    dayNumber = dayNumberData.data();
+    departure = departureData.data();
+    departureMinute = departureMinuteData.data();
+    basePrice = basePriceData.data();
+    carrier = carrierData.data();
+    flightPrefix = flightPrefixData.data();
+    flightSerial = flightSerialData.data();
+    routeIndex = routeIndexData.data();
+    rowCount = departureData.size();
+    routeCount = routeIndexData.size();
+}
+
+long long ScheduleStore::readGeneration(sqlite3* db) {
+    long long value = 0;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT generation FROM schedule_meta WHERE id = 1;", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            value = sqlite3_column_int64(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+    return value;
+}
+
+void ScheduleStore::bumpGeneration(sqlite3* db) {
+    if (!db) return;
+    sqlite3_exec(db,
+                 "INSERT INTO schedule_meta (id, generation) VALUES (1, 1) "
+                 "ON CONFLICT(id) DO UPDATE SET generation = generation + 1;",
+                 nullptr, nullptr, nullptr);
+}
+
+bool ScheduleStore::load(sqlite3* db) {
+    clear();
+    if (!db) return false;
+
+    // One read transaction so the generation matches the rows we copy
+    sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+    generation = readGeneration(db);
+
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM flights;", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            size_t rows = (size_t)sqlite3_column_int64(stmt, 0);
+            routeKeyData.reserve(rows);
+            dayNumberData.reserve(rows);
+            departureData.reserve(rows);
+            departureMinuteData.reserve(rows);
+            basePriceData.reserve(rows);
+            carrierData.reserve(rows);
+            flightPrefixData.reserve(rows);
+            flightSerialData.reserve(rows);
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    const char* sql = "SELECT flight_number, flight_name, source, destination, date, departure_time, base_price "
+                      "FROM flights;";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+        return false;
+    }
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        string number = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        string date = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+        string depTime = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
+
+        CivilTime civil;
+        int32_t day = dayNumberFromDate(date);
+        if (day == INT32_MIN || !parseCivilTime(depTime, civil)) {
+            continue;
+        }
+
+        // Split "SP1001" into an interned prefix and a numeric serial
+        size_t digits = number.find_first_of("0123456789");
+        uint32_t serial = NO_SERIAL;
+        string prefix = number;
+        if (digits != string::npos && number[digits] != '0' && number.size() - digits <= 9 &&
+            number.find_first_not_of("0123456789", digits) == string::npos) {
+            serial = (uint32_t)stoul(number.substr(digits));
+            prefix = number.substr(0, digits);
+        }
+
+        uint16_t src = intern<uint16_t>(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)), cityNames, cityIds);
+        uint16_t dst = intern<uint16_t>(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3)), cityNames, cityIds);
+
+        routeKeyData.push_back(((uint32_t)src << 16) | dst);
+        dayNumberData.push_back(day);
+        departureData.push_back(civil.timestamp);
+        departureMinuteData.push_back((uint16_t)civil.minuteOfDay());
+        basePriceData.push_back(sqlite3_column_double(stmt, 6));
+        carrierData.push_back(intern<uint16_t>(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                                           carrierNames, carrierIds));
+        flightPrefixData.push_back(intern<uint32_t>(prefix, prefixNames, prefixIds));
+        flightSerialData.push_back(serial);
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+
+    sortRows();
+    buildRouteIndex();
+    bindOwnedColumns();
+    cout << "Schedule store loaded " << size() << " flights (" << memoryUsage() / 1024 << " KB)" << endl;
+    return true;
+}
+
+bool ScheduleStore::refreshIfStale(sqlite3* db) {
+    if (!db || readGeneration(db) == generation) {
+        return false;
+    }
+    return load(db);
+}
+
+void ScheduleStore::sortRows() {
+    vector<uint32_t> order(departureData.size());
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        if (routeKeyData[a] != routeKeyData[b]) return routeKeyData[a] < routeKeyData[b];
+        if (dayNumberData[a] != dayNumberData[b]) return dayNumberData[a] < dayNumberData[b];
+        return departureData[a] < departureData[b];
+    });
+
+    applyPermutation(routeKeyData, order);
+    applyPermutation(dayNumberData, order);
+    applyPermutation(departureData, order);
+    applyPermutation(departureMinuteData, order);
+    applyPermutation(basePriceData, order);
+    applyPermutation(carrierData, order);
+    applyPermutation(flightPrefixData, order);
+    applyPermutation(flightSerialData, order);
+}
+
+void ScheduleStore::buildRouteIndex() {
+    routeIndexData.clear();
+    for (size_t row = 0; row < routeKeyData.size(); row++) {
+        if (routeIndexData.empty() || routeIndexData.back().routeKey != routeKeyData[row]) {
+            routeIndexData.push_back({routeKeyData[row], 0, (uint64_t)row});
+        }
+        routeIndexData.back().rowCount++;
+    }
+}
+
+bool ScheduleStore::writeSnapshot(const string& path) const {
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.formatVersion = SNAPSHOT_VERSION;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.byteOrderMark = BYTE_ORDER_MARK;
+    header.cityCount = cityNames.size();
+    header.carrierCount = carrierNames.size();
+    header.prefixCount = prefixNames.size();
+    header.rowCount = rowCount;
+    header.routeCount = routeCount;
+    header.generation = generation;
+
+    const void* sections[SNAPSHOT_SECTIONS] = {routeKey, dayNumber, departure, departureMinute, basePrice,
+                                               carrier, flightPrefix, flightSerial, routeIndex};
+    size_t sectionBytes[SNAPSHOT_SECTIONS] = {
+        rowCount * sizeof(uint32_t), rowCount * sizeof(int32_t), rowCount * sizeof(int64_t),
+        rowCount * sizeof(uint16_t), rowCount * sizeof(double), rowCount * sizeof(uint16_t),
+        rowCount * sizeof(uint32_t), rowCount * sizeof(uint32_t), routeCount * sizeof(RouteSpan)};
+
+    // String table: cities, carriers, prefixes as (uint32 length, bytes) records
+    string strings;
+    for (const auto* names : {&cityNames, &carrierNames, &prefixNames}) {
+        for (const string& name : *names) {
+            uint32_t length = name.size();
+            strings.append(reinterpret_cast<const char*>(&length), sizeof(length));
+            strings.append(name);
+        }
+    }
+
+    size_t offset = alignUp(sizeof(SnapshotHeader));
+    for (int i = 0; i < SNAPSHOT_SECTIONS; i++) {
+        header.sectionOffset[i] = offset;
+        offset = alignUp(offset + sectionBytes[i]);
+    }
+    header.stringsOffset = offset;
+    header.stringsSize = strings.size();
+    header.fileSize = alignUp(offset + strings.size());
+
+    // A temp file of our own: the GUI, the server and their maintainers may all write at once
+#ifndef _WIN32
+    string tmpPath = path + ".XXXXXX";
+    int fd = mkstemp(&tmpPath[0]);
+    FILE* file = nullptr;
+    if (fd >= 0 && fchmod(fd, 0644) == 0) {
+        file = fdopen(fd, "wb");
+    }
+    if (fd >= 0 && !file) {
+        close(fd);
+        remove(tmpPath.c_str());
+    }
+#else
+    string tmpPath = path + ".tmp" + to_string(_getpid()) + "-" + to_string(snapshotWrites.fetch_add(1));
+    FILE* file = fopen(tmpPath.c_str(), "wb");
+#endif
+    if (!file) {
+        cerr << "Cannot write schedule snapshot " << tmpPath << endl;
+        return false;
+    }
+
+    static const char zeros[8] = {0};
+    PayloadChecksum checksum;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    size_t written = sizeof(header);
+    auto writeBlock = [&](const void* data, size_t length) {
+        if (length > 0 && ok) {
+            ok = fwrite(data, 1, length, file) == length;
+            checksum.update(data, length);
+            written += length;
+        }
+        size_t padding = alignUp(written) - written;
+        if (padding > 0 && ok) {
+            ok = fwrite(zeros, 1, padding, file) == padding;
+            checksum.update(zeros, padding);
+            written += padding;
+        }
+    };
+    writeBlock(nullptr, 0);  // Pad the header to its aligned size
+    for (int i = 0; i < SNAPSHOT_SECTIONS; i++) {
+        writeBlock(sections[i], sectionBytes[i]);
+    }
+    writeBlock(strings.data(), strings.size());
+
+    header.payloadChecksum = checksum.finish();
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = fflush(file) == 0 && ok;
+#ifndef _WIN32
+    ok = ok && fsync(fileno(file)) == 0;
+#endif
+    fclose(file);
+
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        cerr << "Failed to write schedule snapshot " << path << endl;
+        remove(tmpPath.c_str());
+        return false;
+    }
+    cout << "Schedule snapshot written: " << path << " (" << header.fileSize / 1024 << " KB)" << endl;
+    return true;
+}
+
+bool ScheduleStore::openSnapshot(const string& path, bool verifyChecksum) {
+    clear();
+#ifdef _WIN32
+    (void)path;
+    (void)verifyChecksum;
+    return false;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(SnapshotHeader)) {
+        close(fd);
+        return false;
+    }
+    void* base = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping keeps the file alive
+    if (base == MAP_FAILED) return false;
+
+    mapping = base;
+    mappingSize = info.st_size;
+    const char* bytes = static_cast<const char*>(base);
+    const SnapshotHeader* header = static_cast<const SnapshotHeader*>(base);
+
+    auto reject = [&](const char* reason) {
+        cerr << "Ignoring schedule snapshot " << path << ": " << reason << endl;
+        clear();
+        return false;
+    };
+
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) return reject("bad magic");
+    if (header->formatVersion != SNAPSHOT_VERSION) return reject("unsupported version");
+    if (header->byteOrderMark != BYTE_ORDER_MARK) return reject("foreign byte order");
+    if (header->headerSize != sizeof(SnapshotHeader) || header->fileSize != mappingSize) return reject("truncated");
+
+    size_t n = header->rowCount;
+    size_t elementSize[SNAPSHOT_SECTIONS] = {sizeof(uint32_t), sizeof(int32_t), sizeof(int64_t), sizeof(uint16_t),
+                                             sizeof(double), sizeof(uint16_t), sizeof(uint32_t), sizeof(uint32_t),
+                                             sizeof(RouteSpan)};
+    for (int i = 0; i < SNAPSHOT_SECTIONS; i++) {
+        size_t count = (i == SNAPSHOT_SECTIONS - 1) ? header->routeCount : n;
+        if (header->sectionOffset[i] % 8 != 0 || header->sectionOffset[i] > mappingSize ||
+            count > (mappingSize - header->sectionOffset[i]) / elementSize[i]) {
+            return reject("section out of bounds");
+        }
+    }
+    if (header->stringsOffset > mappingSize || header->stringsSize > mappingSize - header->stringsOffset) {
+        return reject("string table out of bounds");
+    }
+
+    if (verifyChecksum) {
+        PayloadChecksum checksum;
+        checksum.update(bytes + sizeof(SnapshotHeader), mappingSize - sizeof(SnapshotHeader));
+        if (checksum.finish() != header->payloadChecksum) return reject("checksum mismatch");
+    }
+
+    // Only the tiny string table is parsed; columns are used in place
+    const char* cursor = bytes + header->stringsOffset;
+    const char* stringsEnd = cursor + header->stringsSize;
+    uint32_t counts[3] = {header->cityCount, header->carrierCount, header->prefixCount};
+    vector<string>* tables[3] = {&cityNames, &carrierNames, &prefixNames};
+    for (int t = 0; t < 3; t++) {
+        for (uint32_t i = 0; i < counts[t]; i++) {
+            uint32_t length;
+            if (stringsEnd - cursor < (ptrdiff_t)sizeof(length)) return reject("corrupt string table");
+            memcpy(&length, cursor, sizeof(length));
+            cursor += sizeof(length);
+            if ((size_t)(stringsEnd - cursor) < length) return reject("corrupt string table");
+            tables[t]->emplace_back(cursor, length);
+            cursor += length;
+        }
+    }
+    for (size_t i = 0; i < cityNames.size(); i++) cityIds.emplace(cityNames[i], (uint16_t)i);
+    for (size_t i = 0; i < carrierNames.size(); i++) carrierIds.emplace(carrierNames[i], (uint16_t)i);
+    for (size_t i = 0; i < prefixNames.size(); i++) prefixIds.emplace(prefixNames[i], (uint32_t)i);
+
+    routeKey = reinterpret_cast<const uint32_t*>(bytes + header->sectionOffset[0]);
+    dayNumber = reinterpret_cast<const int32_t*>(bytes + header->sectionOffset[1]);
+    departure = reinterpret_cast<const int64_t*>(bytes + header->sectionOffset[2]);
+    departureMinute = reinterpret_cast<const uint16_t*>(bytes + header->sectionOffset[3]);
+    basePrice = reinterpret_cast<const double*>(bytes + header->sectionOffset[4]);
+    carrier = reinterpret_cast<const uint16_t*>(bytes + header->sectionOffset[5]);
+    flightPrefix = reinterpret_cast<const uint32_t*>(bytes + header->sectionOffset[6]);
+    flightSerial = reinterpret_cast<const uint32_t*>(bytes + header->sectionOffset[7]);
+    routeIndex = reinterpret_cast<const RouteSpan*>(bytes + header->sectionOffset[8]);
+    rowCount = n;
+    routeCount = header->routeCount;
+    generation = header->generation;
+
+    cout << "Schedule snapshot mapped: " << rowCount << " flights (generation " << generation << ")" << endl;
+    return true;
+#endif
+}
+
+ScheduleStore::Range ScheduleStore::findRoute(const string& source, const string& destination,
+                                              const string& dateStr) const {
+    Range empty = {0, 0};
+    auto src = cityIds.find(source);
+    auto dst = cityIds.find(destination);
+    int32_t day = dayNumberFromDate(dateStr);
+    if (src == cityIds.end() || dst == cityIds.end() || day == INT32_MIN) {
+        return empty;
+    }
+
+    // Offset index narrows to the route, then binary search on the day
+    uint32_t key = ((uint32_t)src->second << 16) | dst->second;
+    const RouteSpan* routeEnd = routeIndex + routeCount;
+    const RouteSpan* span = lower_bound(routeIndex, routeEnd, key,
+                                        [](const RouteSpan& r, uint32_t k) { return r.routeKey < k; });
+    if (span == routeEnd || span->routeKey != key) {
+        return empty;
+    }
+
+    const int32_t* first = dayNumber + span->firstRow;
+    const int32_t* last = first + span->rowCount;
+    auto days = equal_range(first, last, day);
+    return {(size_t)(days.first - dayNumber), (size_t)(days.second - dayNumber)};
+}
+
+string ScheduleStore::getFlightNumber(size_t row) const {
+    const string& prefix = prefixNames[flightPrefix[row]];
+    if (flightSerial[row] == NO_SERIAL) return prefix;
+    return prefix + to_string(flightSerial[row]);
+}
+
+string ScheduleStore::getDate(size_t row) const {
+    return dateFromDayNumber(dayNumber[row]);
+}
+
+string ScheduleStore::getDepartureTime(size_t row) const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), " %02d:%02d", departureMinute[row] / 60, departureMinute[row] % 60);
+    return getDate(row) + buffer;
+}
+
+vector<string> ScheduleStore::getCities() const {
+    vector<string> cities = cityNames;
+    sort(cities.begin(), cities.end());
+    return cities;
+}
+
+size_t ScheduleStore::memoryUsage() const {
+    size_t bytes = routeKeyData.capacity() * sizeof(uint32_t) + dayNumberData.capacity() * sizeof(int32_t) +
+                   departureData.capacity() * sizeof(int64_t) + departureMinuteData.capacity() * sizeof(uint16_t) +
+                   basePriceData.capacity() * sizeof(double) + carrierData.capacity() * sizeof(uint16_t) +
+                   flightPrefixData.capacity() * sizeof(uint32_t) + flightSerialData.capacity() * sizeof(uint32_t) +
+                   routeIndexData.capacity() * sizeof(RouteSpan);
+    for (const auto* names : {&cityNames, &carrierNames, &prefixNames}) {
+        for (const string& name : *names) {
+            bytes += sizeof(string) + name.capacity();
+        }
+    }
+    return bytes;
+}
@@ -0,0 +1,201 @@
+/**
+ * @file schedule_store.h
+ * @brief Columnar in-memory copy of the flights table
+ *
+ * Holds the whole schedule as parallel arrays sorted by (route, date,
+ * departure). Cities, carriers and flight-number prefixes are interned to
+ * small integer ids, so a search is a binary search plus a contiguous slice
+ * and schedule-wide scans never touch SQLite.
+ *
+ * The same columns can be written to a versioned, checksummed binary
+ * snapshot and opened again with mmap. Fixed-width columns and the route
+ * offset index are then used in place, straight from the page cache.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef SCHEDULE_STORE_H
+#define SCHEDULE_STORE_H
+
+#include <vector>
+#include <string>
+#include <ctime>
+#include <cstdint>
+#include <unordered_map>
+
+struct sqlite3;  // Forward declaration for SQLite database handle
+
+using namespace std;
+
+/**
+ * @class ScheduleStore
+ * @brief Sorted struct-of-arrays schedule with O(log n) route/date lookup
+ *
+ * Row layout is 38 bytes (plus interned strings), so 10M flights fit in
+ * roughly 380 MB. The store tracks the schedule generation recorded in
+ * schedule_meta and reloads when a writer bumps it.
+ */
+class ScheduleStore {
+public:
+    /// Half-open row range [begin, end) into the store
+    struct Range {
+        size_t begin;
+        size_t end;
+    };
+
+    /// Offset index entry: all rows of one route are contiguous
+    struct RouteSpan {
+        uint32_t routeKey;   ///< (source id << 16) | destination id
+        uint32_t rowCount;   ///< Rows belonging to the route
+        uint64_t firstRow;   ///< First row of the route
+    };
+
+    ScheduleStore();
+    ~ScheduleStore();
+    ScheduleStore(const ScheduleStore&) = delete;
+    ScheduleStore& operator=(const ScheduleStore&) = delete;
+
+    /**
+     * @brief Loads every row of the flights table
+     * @param db Open database connection
+     * @return true on success
+     */
+    bool load(sqlite3* db);
+
+    /**
+     * @brief Reloads if another writer changed the flights table
+     * @param db Open database connection
+     * @return true if the store was reloaded
+     */
+    bool refreshIfStale(sqlite3* db);
+
+    /**
+     * @brief Writes the current columns to a binary snapshot file
+     * @param path Destination file; written to a unique temp file beside it and renamed
+     * @return true on success
+     */
+    bool writeSnapshot(const string& path) const;
+
+    /**
+     * @brief Maps a snapshot file and serves rows from it in place
+     * @param path Snapshot file produced by writeSnapshot()
+     * @param verifyChecksum Hash the whole payload before accepting it. This reads every page,
+     *                       so startup leaves it off: snapshots are replaced by rename, never
+     *                       rewritten in place, and the header and bounds checks still run
+     * @return true if the file was valid; the store is left empty otherwise
+     */
+    bool openSnapshot(const string& path, bool verifyChecksum);
+
+    /**
+     * @brief True when columns are served from a mapped snapshot
+     */
+    bool isMapped() const { return mapping != nullptr; }
+
+    /**
+     * @brief Marks the flights table as changed for every ScheduleStore
+     * @param db Open database connection
+     *
+     * Writers of the flights table call this once per committed batch.
+     */
+    static void bumpGeneration(sqlite3* db);
+
+    /**
+     * @brief Reads the current schedule generation
+     * @return Generation counter, or 0 if none was recorded yet
+     */
+    static long long readGeneration(sqlite3* db);
+
+    /**
+     * @brief Finds all flights of a route on one day
+     * @param source Departure city
+     * @param destination Arrival city
+     * @param dateStr Date in YYYY-MM-DD format
+     * @return Rows sorted by departure time (empty if none)
+     */
+    Range findRoute(const string& source, const string& destination, const string& dateStr) const;
+
+    size_t size() const { return rowCount; }
+    bool empty() const { return rowCount == 0; }
+    size_t getRouteCount() const { return routeCount; }
+    const RouteSpan& getRoute(size_t index) const { return routeIndex[index]; }
+    long long getGeneration() const { return generation; }
+
+    /**
+     * @brief Approximate heap bytes held by the columns and string tables
+     *
+     * Mapped snapshot pages live in the shared page cache and are not counted.
+     */
+    size_t memoryUsage() const;
+
+    // Row accessors
+    string getFlightNumber(size_t row) const;
+    const string& getFlightName(size_t row) const { return carrierNames[carrier[row]]; }
+    const string& getSource(size_t row) const { return cityNames[routeKey[row] >> 16]; }
+    const string& getDestination(size_t row) const { return cityNames[routeKey[row] & 0xFFFF]; }
+    string getDate(size_t row) const;
+    string getDepartureTime(size_t row) const;
+    time_t getDepartureTimestamp(size_t row) const { return departure[row]; }
+    int getDepartureHour(size_t row) const { return departureMinute[row] / 60; }
+    double getBasePrice(size_t row) const { return basePrice[row]; }
+
+    /**
+     * @brief All interned cities, sorted alphabetically
+     */
+    vector<string> getCities() const;
+
+    /**
+     * @brief Days since 1970-01-01 for a YYYY-MM-DD date, or INT32_MIN if malformed
+     */
+    static int32_t dayNumberFromDate(const string& dateStr);
+
+    /**
+     * @brief YYYY-MM-DD for a day number
+     */
+    static string dateFromDayNumber(int32_t dayNumber);
+
+private:
+    // Column views, indexed by row and sorted by (routeKey, dayNumber, departure).
+    // They point into the owned vectors below or into a mapped snapshot.
+    const uint32_t* routeKey;         ///< (source id << 16) | destination id
+    const int32_t* dayNumber;         ///< Local flight date as days since epoch
+    const int64_t* departure;         ///< Departure Unix timestamp
+    const uint16_t* departureMinute;  ///< Local minutes after midnight
+    const double* basePrice;          ///< Base price in INR, as stored in flights.base_price
+    const uint16_t* carrier;          ///< Index into carrierNames
+    const uint32_t* flightPrefix;     ///< Index into prefixNames
+    const uint32_t* flightSerial;     ///< Numeric part of the flight number
+    const RouteSpan* routeIndex;      ///< One entry per route, sorted by routeKey
+    size_t rowCount;
+    size_t routeCount;
+
+    // Owned storage when loaded from SQLite
+    vector<uint32_t> routeKeyData;
+    vector<int32_t> dayNumberData;
+    vector<int64_t> departureData;
+    vector<uint16_t> departureMinuteData;
+    vector<double> basePriceData;
+    vector<uint16_t> carrierData;
+    vector<uint32_t> flightPrefixData;
+    vector<uint32_t> flightSerialData;
+    vector<RouteSpan> routeIndexData;
+
+    vector<string> cityNames;
+    vector<string> carrierNames;
+    vector<string> prefixNames;
+    unordered_map<string, uint16_t> cityIds;
+    unordered_map<string, uint16_t> carrierIds;
+    unordered_map<string, uint32_t> prefixIds;
+
+    void* mapping;       ///< mmap base of an open snapshot, or nullptr
+    size_t mappingSize;
+
+    long long generation;  ///< schedule_meta generation this copy reflects
+
+    void clear();
+    void sortRows();
+    void buildRouteIndex();
+    void bindOwnedColumns();
+};
+
+#endif // SCHEDULE_STORE_H
@@ -0,0 +1,154 @@
+#include "seat_holds.h"
+#include <sqlite3.h>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+SeatHolds::SeatHolds() : idSource(random_device{}()) {}
+
+uint64_t SeatHolds::acquire(sqlite3* db, InternId flightNumber, InternId flightDate, int seatNumber, time_t now) {
+    if (!db) return 0;
+
+    // Positive 63-bit ids so the value round-trips through an SQLite INTEGER
+    uint64_t holdId;
+    do {
+        holdId = idSource() >> 1;
+    } while (holdId == 0 || holds.count(holdId));
+    time_t expiresAt = now + HOLD_SECONDS;
+    const string& number = internedText(flightNumber);
+    const string& date = internedText(flightDate);
+
+    const char* clearSql =
+        "DELETE FROM seat_holds WHERE flight_number = ?1 AND flight_date = ?2 AND seat_number = ?3 "
+        "AND expires_at <= ?4;";
+    const char* holdSql =
+        "INSERT INTO seat_holds SELECT ?1, ?2, ?3, ?4, ?5 WHERE NOT EXISTS ("
+        "SELECT 1 FROM booked_seats WHERE flight_number = ?1 AND flight_date = ?2 AND seat_number = ?3);";
+    if (sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return 0;
+    }
+
+    sqlite3_stmt* clearStmt = nullptr;
+    sqlite3_stmt* holdStmt = nullptr;
+    bool held = false;
+    bool ok = sqlite3_prepare_v2(db, clearSql, -1, &clearStmt, nullptr) == SQLITE_OK &&
+              sqlite3_prepare_v2(db, holdSql, -1, &holdStmt, nullptr) == SQLITE_OK;
+    if (ok) {
+        sqlite3_bind_text(clearStmt, 1, number.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(clearStmt, 2, date.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(clearStmt, 3, seatNumber);
+        sqlite3_bind_int64(clearStmt, 4, now);
+        ok = sqlite3_step(clearStmt) == SQLITE_DONE;
+    }
+    if (ok) {
+        // A live hold on the seat fails the primary key; a booking makes the SELECT empty
+        sqlite3_bind_text(holdStmt, 1, number.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(holdStmt, 2, date.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(holdStmt, 3, seatNumber);
+        sqlite3_bind_int64(holdStmt, 4, (sqlite3_int64)holdId);
+        sqlite3_bind_int64(holdStmt, 5, expiresAt);
+        int rc = sqlite3_step(holdStmt);
+        held = rc == SQLITE_DONE && sqlite3_changes(db) == 1;
+        ok = rc == SQLITE_DONE || (rc & 0xFF) == SQLITE_CONSTRAINT;
+    }
+    if (!ok) {
+        cerr << "Seat hold failed: " << sqlite3_errmsg(db) << endl;
+    }
+    sqlite3_finalize(clearStmt);
+    sqlite3_finalize(holdStmt);
+
+    if (!held || sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        return 0;
+    }
+
+    SeatHold& hold = holds[holdId];
+    hold = SeatHold{holdId, flightNumber, flightDate, seatNumber, expiresAt, true, 0};
+    schedule(hold, now);
+    return holdId;
+}
+
+bool SeatHolds::track(uint64_t holdId, InternId flightNumber, InternId flightDate, int seatNumber,
+                      time_t expiresAt, time_t now) {
+    if (holdId == 0 || expiresAt <= now || holds.count(holdId)) return false;
+    SeatHold& hold = holds[holdId];
+    hold = SeatHold{holdId, flightNumber, flightDate, seatNumber, expiresAt, false, 0};
+    schedule(hold, now);
+    return true;
+}
+
+bool SeatHolds::release(sqlite3* db, uint64_t holdId) {
+    auto it = holds.find(holdId);
+    if (it == holds.end() || !it->second.own) return false;
+    wheel.cancel(it->second.timer);
+    holds.erase(it);
+
+    if (db) {
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db, "DELETE FROM seat_holds WHERE hold_id = ?;", -1, &stmt, nullptr) == SQLITE_OK) {
+            sqlite3_bind_int64(stmt, 1, (sqlite3_int64)holdId);
+            sqlite3_step(stmt);
+        }
+        sqlite3_finalize(stmt);
+    }
+    return true;
+}
+
+void SeatHolds::releaseAll(sqlite3* db, const function<void(const SeatHold&)>& onReleased) {
+    vector<SeatHold> own;
+    for (const auto& entry : holds) {
+        if (entry.second.own) own.push_back(entry.second);
+    }
+    if (own.empty()) return;
+
+    bool transaction = db && sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) == SQLITE_OK;
+    for (const SeatHold& hold : own) {
+        release(db, hold.holdId);
+    }
+    if (transaction) {
+        sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+    }
+    if (onReleased) {
+        for (const SeatHold& hold : own) onReleased(hold);
+    }
+}
+
+void SeatHolds::forget(uint64_t holdId) {
+    auto it = holds.find(holdId);
+    if (it == holds.end()) return;
+    wheel.cancel(it->second.timer);
+    holds.erase(it);
+}
+
+const SeatHold* SeatHolds::find(uint64_t holdId) const {
+    auto it = holds.find(holdId);
+    return it == holds.end() ? nullptr : &it->second;
+}
+
+size_t SeatHolds::expire(sqlite3* db, time_t now, const function<void(const SeatHold&)>& onExpired) {
+    size_t expired = wheel.advance(now, [&](uint64_t holdId) {
+        auto it = holds.find(holdId);
+        if (it == holds.end()) return;
+        onExpired(it->second);
+        holds.erase(it);
+    });
+
+    if (expired > 0 && db) {
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db, "DELETE FROM seat_holds WHERE expires_at <= ?;", -1, &stmt, nullptr) == SQLITE_OK) {
+            sqlite3_bind_int64(stmt, 1, now);
+            sqlite3_step(stmt);
+        }
+        sqlite3_finalize(stmt);
+    }
+    return expired;
+}
+
+void SeatHolds::schedule(SeatHold& hold, time_t now) {
+    if (wheel.empty()) {
+        wheel.advance(now, [](uint64_t) {});
+    }
+    hold.timer = wheel.schedule(hold.expiresAt, hold.holdId);
+}
@@ -0,0 +1,116 @@
+/**
+ * @file seat_holds.h
+ * @brief Temporary seat holds shared through the seat_holds table
+ *
+ * A hold reserves one seat while a passenger fills in the booking form.
+ * The seat_holds row (keyed by seat, like booked_seats) is what other
+ * sessions see; a row past its expires_at is dead everywhere and may be
+ * taken over without asking its owner. In process, every hold this
+ * session placed or loaded sits in a TimingWheel keyed on its expiry
+ * second, so abandoned holds are released in O(1) per tick no matter how
+ * many are outstanding.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef SEAT_HOLDS_H
+#define SEAT_HOLDS_H
+
+#include <unordered_map>
+#include <functional>
+#include <random>
+#include <ctime>
+#include <cstdint>
+#include "timing_wheel.h"
+#include "string_interner.h"
+
+struct sqlite3;
+
+using namespace std;
+
+/**
+ * @struct SeatHold
+ * @brief One held seat
+ */
+struct SeatHold {
+    uint64_t holdId;               ///< Never 0; unique across sessions
+    InternId flightNumber;
+    InternId flightDate;
+    int seatNumber;
+    time_t expiresAt;              ///< The hold is void from this second on
+    bool own;                      ///< Placed by this session (false: loaded from another)
+    TimingWheel::TimerId timer;
+};
+
+/**
+ * @class SeatHolds
+ * @brief Places, tracks and expires seat holds; not thread-safe
+ */
+class SeatHolds {
+public:
+    static const time_t HOLD_SECONDS = 10 * 60;  ///< How long a seat stays held without a booking
+
+    SeatHolds();
+
+    /**
+     * @brief Holds a seat in seat_holds for HOLD_SECONDS
+     * @return The hold id, or 0 if the seat is booked, held by a live hold or the write failed
+     *
+     * Dead holds on the seat are replaced; the check and the insert are one transaction.
+     */
+    uint64_t acquire(sqlite3* db, InternId flightNumber, InternId flightDate, int seatNumber, time_t now);
+
+    /**
+     * @brief Starts tracking a hold read from seat_holds so its seat is freed on expiry
+     * @return false if the hold is already tracked or has expired
+     */
+    bool track(uint64_t holdId, InternId flightNumber, InternId flightDate, int seatNumber, time_t expiresAt,
+               time_t now);
+
+    /**
+     * @brief Ends one of this session's holds and deletes its row (id 0 is ignored)
+     * @return false if the hold is not one of ours or already expired
+     */
+    bool release(sqlite3* db, uint64_t holdId);
+
+    /**
+     * @brief Releases all of this session's holds, e.g. on shutdown
+     * @param onReleased If given, called for each released hold once the rows are deleted
+     */
+    void releaseAll(sqlite3* db, const function<void(const SeatHold&)>& onReleased = nullptr);
+
+    /**
+     * @brief Stops tracking a hold whose row was removed elsewhere (e.g. by the booking that used it)
+     */
+    void forget(uint64_t holdId);
+
+    /**
+     * @brief The tracked hold with this id, or nullptr
+     */
+    const SeatHold* find(uint64_t holdId) const;
+
+    /**
+     * @brief Expires every hold due by now
+     * @param onExpired Called for each expired hold before it is forgotten
+     * @return Number of holds expired
+     *
+     * Dead rows of every session are purged in one statement, so holds
+     * abandoned by a crashed process disappear too.
+     */
+    size_t expire(sqlite3* db, time_t now, const function<void(const SeatHold&)>& onExpired);
+
+    size_t size() const { return holds.size(); }
+
+private:
+    TimingWheel wheel;                        ///< One tick per second
+    unordered_map<uint64_t, SeatHold> holds;  ///< holdId -> hold
+    mt19937_64 idSource;
+
+    /**
+     * @brief Puts a hold on the wheel; an idle wheel is first moved to now
+     */
+    void schedule(SeatHold& hold, time_t now);
+};
+
+#endif // SEAT_HOLDS_H
@@ -0,0 +1,165 @@
+#include "seat_inventory.h"
+#include "flight_system.h"
+#include <algorithm>
+
+using namespace std;
+
+SeatInventory::SeatInventory() : slots(new Slot[CAPACITY]), globalEpoch(1), used(0), published(0) {
+    for (size_t i = 0; i < CAPACITY; i++) {
+        slots[i].key.store(0);
+        slots[i].snapshot.store(nullptr);
+    }
+    for (ReaderEpoch& reader : readers) {
+        reader.epoch.store(0);
+    }
+}
+
+SeatInventory::~SeatInventory() {
+    // No reader may outlive the inventory, so everything can go at once
+    for (size_t i = 0; i < CAPACITY; i++) {
+        delete slots[i].snapshot.load();
+    }
+    for (const Retired& r : retired) {
+        delete r.snapshot;
+    }
+}
+
+uint64_t SeatInventory::hash(string_view flightNumber, string_view date) {
+    // FNV-1a over "number|date"; 0 marks a free slot
+    uint64_t h = 1469598103934665603ULL;
+    auto mix = [&h](string_view text) {
+        for (unsigned char c : text) {
+            h ^= c;
+            h *= 1099511628211ULL;
+        }
+    };
+    mix(flightNumber);
+    mix("|");
+    mix(date);
+    return h == 0 ? 1 : h;
+}
+
+SeatInventory::Slot* SeatInventory::probe(uint64_t key) const {
+    size_t index = key & (CAPACITY - 1);
+    for (size_t step = 0; step < CAPACITY; step++) {
+        Slot& slot = slots[(index + step) & (CAPACITY - 1)];
+        uint64_t found = slot.key.load();
+        if (found == key || found == 0) return &slot;
+    }
+    return nullptr;
+}
+
+SeatInventory::Pin::Pin(const SeatInventory& inv, int readerId) : inventory(inv), reader(readerId) {
+    if (reader >= 0 && reader < MAX_READERS) {
+        inventory.readers[reader].epoch.store(inventory.globalEpoch.load());
+    }
+}
+
+SeatInventory::Pin::~Pin() {
+    if (reader >= 0 && reader < MAX_READERS) {
+        inventory.readers[reader].epoch.store(0);
+    }
+}
+
+const SeatSnapshot* SeatInventory::Pin::find(string_view flightNumber, string_view date) const {
+    if (reader < 0 || reader >= MAX_READERS) return nullptr;
+    uint64_t key = hash(flightNumber, date);
+    Slot* slot = inventory.probe(key);
+    if (!slot || slot->key.load() != key) return nullptr;
+    // A slot can be cleared and reused between the key and snapshot loads; the snapshot names its flight
+    const SeatSnapshot* snapshot = slot->snapshot.load();
+    if (!snapshot || snapshot->flightNumber != flightNumber || snapshot->date != date) return nullptr;
+    return snapshot;
+}
+
+void SeatInventory::publish(const Flight& flight) {
+    SeatSnapshot* snapshot = new SeatSnapshot();
+    snapshot->flightNumber = flight.getFlightNumber();
+    snapshot->date = flight.getDate();
+    snapshot->flightName = flight.getFlightName();
+    snapshot->source = flight.getSource();
+    snapshot->destination = flight.getDestination();
+    snapshot->departureTime = flight.getDepartureTime();
+    snapshot->basePrice = flight.getBasePrice();
+    snapshot->departureTimestamp = flight.getDepartureTimestamp();
+    snapshot->departureHour = flight.getDepartureHour();
+    snapshot->occupancyEpoch = flight.getOccupancyEpoch();
+    snapshot->bookedCount = 0;
+    fill(begin(snapshot->bookedByClass), end(snapshot->bookedByClass), 0);
+    fill(begin(snapshot->bookedBits), end(snapshot->bookedBits), 0);
+    fill(begin(snapshot->heldBits), end(snapshot->heldBits), 0);
+    for (int c = 0; c < 3; c++) {
+        for (const Seat* seat : flight.getSeatsByClass(Flight::seatClassName(c))) {
+            int bit = seat->getSeatNumber() - 1;
+            if (bit < 0 || bit >= 128) continue;
+            if (seat->getIsBooked()) {
+                snapshot->bookedBits[bit / 64] |= 1ULL << (bit % 64);
+                snapshot->bookedByClass[c]++;
+                snapshot->bookedCount++;
+            } else if (seat->isHeld()) {
+                snapshot->heldBits[bit / 64] |= 1ULL << (bit % 64);
+            }
+        }
+    }
+
+    uint64_t key = hash(snapshot->flightNumber, snapshot->date);
+    Slot* slot = probe(key);
+    if (!slot || (slot->key.load() == 0 && used >= CAPACITY * 3 / 4)) {
+        // Full: readers fall back to the database for this flight
+        delete snapshot;
+        return;
+    }
+    if (slot->key.load() == 0) {
+        // Snapshot before key, so a reader that sees the key finds something to check
+        slot->snapshot.store(snapshot);
+        slot->key.store(key);
+        used++;
+    } else {
+        replace(*slot, snapshot);
+    }
+    published++;
+}
+
+void SeatInventory::remove(string_view flightNumber, string_view date) {
+    uint64_t key = hash(flightNumber, date);
+    Slot* slot = probe(key);
+    if (slot && slot->key.load() == key) {
+        replace(*slot, nullptr);
+    }
+}
+
+void SeatInventory::clear() {
+    for (size_t i = 0; i < CAPACITY; i++) {
+        if (slots[i].key.load() == 0) continue;
+        replace(slots[i], nullptr);
+        slots[i].key.store(0);
+    }
+    used = 0;
+}
+
+void SeatInventory::replace(Slot& slot, const SeatSnapshot* snapshot) {
+    const SeatSnapshot* old = slot.snapshot.exchange(snapshot);
+    if (!old) return;
+    // Readers pinned after this increment load the new pointer; older pins may still hold old
+    retired.push_back(Retired{old, globalEpoch.fetch_add(1)});
+    if (retired.size() >= RECLAIM_BATCH) {
+        reclaim();
+    }
+}
+
+void SeatInventory::reclaim() {
+    uint64_t oldestPinned = UINT64_MAX;
+    for (const ReaderEpoch& reader : readers) {
+        uint64_t epoch = reader.epoch.load();
+        if (epoch != 0) oldestPinned = min(oldestPinned, epoch);
+    }
+    size_t kept = 0;
+    for (const Retired& r : retired) {
+        if (r.epoch < oldestPinned) {
+            delete r.snapshot;
+        } else {
+            retired[kept++] = r;
+        }
+    }
+    retired.resize(kept);
+}
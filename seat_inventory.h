@@ -0,0 +1,172 @@
+/**
+ * @file seat_inventory.h
+ * @brief Immutable seat-state versions of loaded flights, read without locks
+ *
+ * The writer (the owning ReservationSystem) publishes a new SeatSnapshot of
+ * a flight after every change to its seats and swaps it in with one atomic
+ * store. Readers on other threads pin the current epoch, look the flight up
+ * and read the snapshot they found; everything in it - seat map, booked
+ * counts per class, fare inputs - describes one instant, however many
+ * bookings land meanwhile. Reading takes no lock and never waits: a pin
+ * is one load and one store, a lookup a bounded probe of a flat table.
+ *
+ * Replaced snapshots are reclaimed by epochs: each retirement advances
+ * the global epoch, and a snapshot is freed once no reader is pinned at
+ * or before the epoch it was retired in.
+ *
+ * Publishing, removing and clearing must come from one thread at a time.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef SEAT_INVENTORY_H
+#define SEAT_INVENTORY_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <ctime>
+#include <cstdint>
+
+class Flight;
+
+using namespace std;
+
+/**
+ * @struct SeatSnapshot
+ * @brief One flight's seats and fare inputs at one instant; never modified once published
+ */
+struct SeatSnapshot {
+    string flightNumber;
+    string date;
+    string flightName;
+    string source;
+    string destination;
+    string departureTime;
+    double basePrice;
+    time_t departureTimestamp;
+    int departureHour;
+    uint64_t occupancyEpoch;   ///< Flight::getOccupancyEpoch() when published
+    int bookedCount;           ///< Booked seats; holds are not counted, as in demand pricing
+    int bookedByClass[3];      ///< First (0), Business (1), Economy (2)
+    uint64_t bookedBits[2];    ///< Bit n-1 set while seat n is booked
+    uint64_t heldBits[2];      ///< Bit n-1 set while seat n is held
+
+    bool isBooked(int seatNumber) const { return testBit(bookedBits, seatNumber); }
+    bool isHeld(int seatNumber) const { return testBit(heldBits, seatNumber); }
+
+private:
+    static bool testBit(const uint64_t* bits, int seatNumber) {
+        return seatNumber >= 1 && seatNumber <= 128 && ((bits[(seatNumber - 1) / 64] >> ((seatNumber - 1) % 64)) & 1);
+    }
+};
+
+/**
+ * @class SeatInventory
+ * @brief Single-writer table of current seat snapshots with wait-free readers
+ */
+class SeatInventory {
+public:
+    static const int MAX_READERS = 64;        ///< Reader ids 0..MAX_READERS-1, one per reading thread
+    static const size_t CAPACITY = 16384;     ///< Flights the table can hold; a full table skips new flights
+    static const size_t RECLAIM_BATCH = 64;   ///< Retired snapshots collected before a reclamation scan
+
+    SeatInventory();
+    ~SeatInventory();
+    SeatInventory(const SeatInventory&) = delete;
+    SeatInventory& operator=(const SeatInventory&) = delete;
+
+    /**
+     * @class Pin
+     * @brief Keeps every snapshot found through it alive until destroyed
+     *
+     * Create one per read on the reading thread; two live pins must not
+     * share a reader id.
+     */
+    class Pin {
+    public:
+        /**
+         * @param reader Reader id of the calling thread; outside 0..MAX_READERS-1 every find() misses
+         */
+        Pin(const SeatInventory& inventory, int reader);
+        ~Pin();
+        Pin(const Pin&) = delete;
+        Pin& operator=(const Pin&) = delete;
+
+        /**
+         * @brief Current snapshot of a flight, or nullptr if it is not published
+         */
+        const SeatSnapshot* find(string_view flightNumber, string_view date) const;
+
+    private:
+        const SeatInventory& inventory;
+        int reader;
+    };
+
+    /**
+     * @brief Publishes the flight's current seats, replacing its previous snapshot
+     */
+    void publish(const Flight& flight);
+
+    /**
+     * @brief Withdraws a flight, e.g. when its seats changed without a loaded copy
+     */
+    void remove(string_view flightNumber, string_view date);
+
+    /**
+     * @brief Withdraws every flight
+     */
+    void clear();
+
+    /// Snapshots published over the lifetime of this object
+    uint64_t getPublished() const { return published; }
+
+    /// Replaced snapshots not yet freed because a reader may still hold them
+    size_t getRetiredPending() const { return retired.size(); }
+
+private:
+    /// One table entry; a key, once set, stays until clear()
+    struct Slot {
+        atomic<uint64_t> key;                 ///< Hash of number and date; 0 when free
+        atomic<const SeatSnapshot*> snapshot; ///< nullptr once withdrawn
+    };
+
+    /// A reader's pinned epoch on its own cache line; 0 when not reading
+    struct alignas(64) ReaderEpoch {
+        atomic<uint64_t> epoch;
+    };
+
+    struct Retired {
+        const SeatSnapshot* snapshot;
+        uint64_t epoch;  ///< Global epoch when it was replaced
+    };
+
+    unique_ptr<Slot[]> slots;
+    mutable ReaderEpoch readers[MAX_READERS];
+    atomic<uint64_t> globalEpoch;
+    vector<Retired> retired;   ///< Writer only
+    size_t used;               ///< Slots with a key; writer only
+    uint64_t published;
+
+    static uint64_t hash(string_view flightNumber, string_view date);
+
+    /**
+     * @brief Slot holding key, or the free slot where it would go; nullptr if the table is full
+     */
+    Slot* probe(uint64_t key) const;
+
+    /**
+     * @brief Replaces a slot's snapshot and retires the old one
+     */
+    void replace(Slot& slot, const SeatSnapshot* snapshot);
+
+    /**
+     * @brief Frees retired snapshots no pinned reader can still see
+     */
+    void reclaim();
+};
+
+#endif // SEAT_INVENTORY_H
@@ -0,0 +1,624 @@
+#include "shared_seat_map.h"
+#include "flight_system.h"
+#include "time_core.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+const char SEGMENT_MAGIC[8] = {'S', 'P', 'Z', 'S', 'E', 'A', 'T', 'S'};
+const uint32_t SEGMENT_VERSION = 1;
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+const size_t STRIPES = 1024;               ///< Change counters, by flight key
+const int SEATS = 128;                     ///< Seats per map, as in SeatSnapshot
+const uint64_t KEY_SEED = 1469598103934665603ULL;   ///< FNV offset basis
+const uint64_t CHECK_SEED = 0x9e3779b97f4a7c15ULL;
+const size_t HEADER_BYTES = 8192;
+const size_t SLOT_BYTES = 64;
+const size_t ENTRY_BYTES = 1152;
+const int INIT_WAIT_MS = 2000;             ///< Longest wait for another process to lay out the segment
+
+// Entry states
+const uint32_t EMPTY = 0;
+const uint32_t FILLING = 1;
+const uint32_t READY = 2;
+const uint32_t DROPPED = 3;                ///< Keeps its key for probing; filled again on the next load
+
+// Low byte of a seat word; the other 56 bits are the booking log sequence of its last change
+const uint64_t FREE = 0;
+const uint64_t EXTERNAL = 254;             ///< Held when the map was filled, by a process of unknown slot
+const uint64_t BOOKED = 255;
+const uint64_t STATE_MASK = 0xff;
+
+// Initialisation states of the header
+const uint32_t UNINITIALISED = 0;
+const uint32_t INITIALISING = 1;
+const uint32_t INITIALISED = 2;
+
+static_assert(atomic<uint64_t>::is_always_lock_free, "shared seat maps need lock-free 64-bit atomics");
+static_assert(atomic<uint32_t>::is_always_lock_free, "shared seat maps need lock-free 32-bit atomics");
+
+/**
+ * Random registration token. Owner tokens are even, reclaim tokens odd, so
+ * a slot being reclaimed is never mistaken for a live registration.
+ */
+uint64_t newToken(bool reclaiming) {
+    static mt19937_64 source(random_device{}() ^ (uint64_t)chrono::steady_clock::now().time_since_epoch().count());
+    uint64_t value = source() & ~1ULL;
+    if (value == 0) {
+        value = 2;
+    }
+    return reclaiming ? value | 1 : value;
+}
+
+uint64_t withState(uint64_t word, uint64_t state) {
+    return (word & ~STATE_MASK) | state;
+}
+
+} // namespace
+
+struct SharedSeatMap::Header {
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t byteOrderMark;
+    uint32_t capacity;
+    uint32_t maxProcesses;
+    atomic<uint32_t> initState;
+    atomic<uint32_t> used;                  ///< Entries with a key
+    atomic<uint32_t> stripes[STRIPES];      ///< Bumped before each seat change, read around each fill
+};
+
+struct alignas(64) SharedSeatMap::ProcessSlot {
+    atomic<uint64_t> token;                 ///< 0 while free
+    atomic<int64_t> pid;                    ///< 0 until registration is complete
+    atomic<int64_t> heartbeat;
+    atomic<uint64_t> writing;               ///< Key of the flight being written, or 0
+};
+
+struct alignas(64) SharedSeatMap::FlightEntry {
+    atomic<uint64_t> key;                   ///< 0 while free; never reset while attached processes run
+    atomic<uint64_t> check;                 ///< Second hash, guards against a key left by an earlier run
+    atomic<uint32_t> state;
+    atomic<uint32_t> version;               ///< Bumped by every change, for read()
+    atomic<int32_t> filler;                 ///< Slot filling the map
+    atomic<int64_t> externalUntil;          ///< EXTERNAL seats count as free from then on
+    atomic<uint64_t> seats[SEATS];
+};
+
+SharedSeatMap::SharedSeatMap() : base(nullptr), size(0), slot(-1), token(0), reclaimed(0) {
+    static_assert(sizeof(Header) <= HEADER_BYTES, "header outgrew its pages");
+    static_assert(sizeof(ProcessSlot) == SLOT_BYTES, "process slots are one cache line");
+    static_assert(sizeof(FlightEntry) <= ENTRY_BYTES, "flight entry outgrew its stride");
+}
+
+SharedSeatMap::~SharedSeatMap() {
+    detach();
+}
+
+SharedSeatMap::Header* SharedSeatMap::header() const {
+    return reinterpret_cast<Header*>(base);
+}
+
+SharedSeatMap::ProcessSlot* SharedSeatMap::process(int index) const {
+    return reinterpret_cast<ProcessSlot*>(base + HEADER_BYTES + (size_t)index * SLOT_BYTES);
+}
+
+SharedSeatMap::FlightEntry* SharedSeatMap::entry(size_t index) const {
+    return reinterpret_cast<FlightEntry*>(base + HEADER_BYTES + MAX_PROCESSES * SLOT_BYTES + index * ENTRY_BYTES);
+}
+
+uint64_t SharedSeatMap::hash(string_view flightNumber, string_view date, uint64_t seed) {
+    // FNV-1a over "number|date"; 0 marks a free entry
+    uint64_t h = seed;
+    auto mix = [&h](string_view text) {
+        for (unsigned char c : text) {
+            h ^= c;
+            h *= 1099511628211ULL;
+        }
+    };
+    mix(flightNumber);
+    mix("|");
+    mix(date);
+    return h == 0 ? 1 : h;
+}
+
+atomic<uint32_t>& SharedSeatMap::stripe(uint64_t key) const {
+    return header()->stripes[key % STRIPES];
+}
+
+bool SharedSeatMap::attach(const char* databasePath) {
+#ifdef _WIN32
+    (void)databasePath;
+    cerr << "Shared seat maps are not supported on this platform" << endl;
+    return false;
+#else
+    if (base) {
+        return true;
+    }
+    // Named after the database file itself, so every path to it finds the same segment
+    struct stat file;
+    if (stat(databasePath, &file) != 0) {
+        cerr << "Shared seat map: cannot stat " << databasePath << ": " << strerror(errno) << endl;
+        return false;
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "/spaazm-%016llx",
+             (unsigned long long)hash(to_string(file.st_dev), to_string(file.st_ino), KEY_SEED));
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        cerr << "Shared seat map " << name << " unavailable: " << strerror(errno) << endl;
+        return false;
+    }
+    size_t wanted = HEADER_BYTES + MAX_PROCESSES * SLOT_BYTES + CAPACITY * ENTRY_BYTES;
+    struct stat segment;
+    bool sized = fstat(fd, &segment) == 0 &&
+                 ((size_t)segment.st_size == wanted || (segment.st_size == 0 && ftruncate(fd, (off_t)wanted) == 0));
+    void* mapping = sized ? mmap(nullptr, wanted, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        cerr << "Shared seat map " << name << " has another size or cannot be mapped" << endl;
+        return false;
+    }
+    base = static_cast<unsigned char*>(mapping);
+    size = wanted;
+
+    // The first process to arrive lays the segment out; the others wait for it
+    Header* h = header();
+    uint32_t expected = UNINITIALISED;
+    if (h->initState.compare_exchange_strong(expected, INITIALISING)) {
+        memcpy(h->magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+        h->formatVersion = SEGMENT_VERSION;
+        h->byteOrderMark = BYTE_ORDER_MARK;
+        h->capacity = (uint32_t)CAPACITY;
+        h->maxProcesses = (uint32_t)MAX_PROCESSES;
+        h->initState.store(INITIALISED);
+    } else {
+        for (int waited = 0; waited < INIT_WAIT_MS && h->initState.load() != INITIALISED; waited++) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+    }
+    if (h->initState.load() != INITIALISED || memcmp(h->magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0 ||
+        h->formatVersion != SEGMENT_VERSION || h->byteOrderMark != BYTE_ORDER_MARK || h->capacity != CAPACITY ||
+        h->maxProcesses != (uint32_t)MAX_PROCESSES) {
+        cerr << "Shared seat map " << name << " has another layout; remove it from /dev/shm once no process uses it" << endl;
+        munmap(base, size);
+        base = nullptr;
+        return false;
+    }
+
+    time_t now = currentTime();
+    if (!registerProcess(now)) {
+        cerr << "Shared seat map " << name << ": all " << MAX_PROCESSES << " process slots are taken" << endl;
+        munmap(base, size);
+        base = nullptr;
+        return false;
+    }
+    // Slots of processes that crashed are freed first; if no one else is left, nothing
+    // kept the maps current since they went, so they start over empty
+    heartbeat(now);
+    bool alone = true;
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (i != slot && process(i)->token.load() != 0) {
+            alone = false;
+        }
+    }
+    if (alone) {
+        for (size_t i = 0; i < CAPACITY; i++) {
+            FlightEntry* e = entry(i);
+            e->state.store(EMPTY);
+            e->check.store(0);
+            e->key.store(0);
+        }
+        h->used.store(0);
+    }
+    cout << "Shared seat map " << name << " attached in slot " << slot << (alone ? " (first process)" : "") << endl;
+    return true;
+#endif
+}
+
+void SharedSeatMap::detach() {
+#ifndef _WIN32
+    if (!base) {
+        return;
+    }
+    if (slot >= 0) {
+        ProcessSlot* p = process(slot);
+        if (p->token.load() == token) {
+            // Claims this process still has die with their maps, as on a crash
+            uint64_t mine = token;
+            reclaim(slot, mine, currentTime());
+        }
+    }
+    munmap(base, size);
+    base = nullptr;
+    size = 0;
+    slot = -1;
+    token = 0;
+#endif
+}
+
+bool SharedSeatMap::registerProcess(time_t now) {
+    token = newToken(false);
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        ProcessSlot* p = process(i);
+        uint64_t expected = 0;
+        if (p->token.compare_exchange_strong(expected, token)) {
+            // Heartbeat before pid: others skip a slot without a pid, then judge it by its heartbeat
+            p->writing.store(0);
+            p->heartbeat.store(now);
+            p->pid.store((int64_t)getpid());
+            slot = i;
+            return true;
+        }
+    }
+    slot = -1;
+    return false;
+}
+
+bool SharedSeatMap::ensureRegistered() {
+    if (!base) {
+        return false;
+    }
+    if (slot >= 0 && process(slot)->token.load() == token) {
+        return true;
+    }
+    if (slot >= 0) {
+        cout << "Shared seat map: slot " << slot << " was reclaimed while this process stalled; registering again" << endl;
+    }
+    return registerProcess(currentTime());
+}
+
+void SharedSeatMap::heartbeat(time_t now) {
+#ifndef _WIN32
+    if (!ensureRegistered()) {
+        return;
+    }
+    ProcessSlot* me = process(slot);
+    me->heartbeat.store(now);
+
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (i == slot) {
+            continue;
+        }
+        ProcessSlot* p = process(i);
+        uint64_t observed = p->token.load();
+        int64_t pid = p->pid.load();
+        if (observed == 0 || pid == 0) {
+            continue;
+        }
+        bool gone = kill((pid_t)pid, 0) != 0 && errno == ESRCH;
+        if (gone || now - p->heartbeat.load() > LEASE_SECONDS) {
+            reclaim(i, observed, now);
+        }
+    }
+#else
+    (void)now;
+#endif
+}
+
+void SharedSeatMap::reclaim(int index, uint64_t observedToken, time_t now) {
+#ifndef _WIN32
+    ProcessSlot* p = process(index);
+    // Only one process reclaims a slot; a reclaimer that dies midway is reclaimed in turn
+    uint64_t reclaimToken = newToken(true);
+    if (index != slot && !p->token.compare_exchange_strong(observedToken, reclaimToken)) {
+        return;
+    }
+    int64_t pid = p->pid.load();
+    if (index != slot) {
+        p->heartbeat.store(now);
+        p->pid.store((int64_t)getpid());
+    }
+    uint64_t writing = p->writing.load();
+    uint64_t holder = (uint64_t)index + 1;
+    size_t dropped = 0;
+    for (size_t i = 0; i < CAPACITY; i++) {
+        FlightEntry* e = entry(i);
+        uint64_t key = e->key.load();
+        if (key == 0) {
+            continue;
+        }
+        uint32_t state = e->state.load();
+        bool drop = false;
+        if (state == FILLING) {
+            drop = e->filler.load() == index;
+        } else if (state == READY) {
+            drop = key == writing;
+            for (int s = 0; s < SEATS && !drop; s++) {
+                drop = (e->seats[s].load() & STATE_MASK) == holder;
+            }
+        }
+        if (drop && e->state.compare_exchange_strong(state, DROPPED)) {
+            e->version.fetch_add(1);
+            dropped++;
+        }
+    }
+    p->writing.store(0);
+    p->pid.store(0);
+    p->heartbeat.store(0);
+    p->token.store(0);
+    if (index != slot) {
+        reclaimed++;
+        cout << "Shared seat map: reclaimed slot " << index << " of process " << pid << ", dropped " << dropped
+             << " flight maps" << endl;
+    }
+#else
+    (void)index;
+    (void)observedToken;
+    (void)now;
+#endif
+}
+
+SharedSeatMap::FlightEntry* SharedSeatMap::find(string_view flightNumber, string_view date, bool create) const {
+    if (!base) {
+        return nullptr;
+    }
+    uint64_t key = hash(flightNumber, date, KEY_SEED);
+    uint64_t check = hash(flightNumber, date, CHECK_SEED);
+    for (size_t step = 0; step < CAPACITY; step++) {
+        FlightEntry* e = entry((key + step) & (CAPACITY - 1));
+        uint64_t found = e->key.load();
+        if (found == 0) {
+            if (!create || header()->used.load() >= CAPACITY * 3 / 4) {
+                // Full: this flight is left to the database
+                return nullptr;
+            }
+            if (e->key.compare_exchange_strong(found, key)) {
+                // A map of an earlier run may linger in the entry; DROPPED makes it fillable
+                e->state.store(DROPPED);
+                e->check.store(check);
+                header()->used.fetch_add(1);
+                return e;
+            }
+            // Lost the entry to another process; found now holds its key
+        }
+        if (found == key) {
+            if (create) {
+                return e;
+            }
+            return e->state.load() == READY && e->check.load() == check ? e : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+uint32_t SharedSeatMap::fillTicket(string_view flightNumber, string_view date) const {
+    if (!base) {
+        return 0;
+    }
+    return stripe(hash(flightNumber, date, KEY_SEED)).load();
+}
+
+bool SharedSeatMap::publish(const Flight& flight, uint32_t ticket, time_t holdsExpireBy) {
+    if (!ensureRegistered()) {
+        return false;
+    }
+    const string& flightNumber = flight.getFlightNumber();
+    const string& date = flight.getDate();
+    FlightEntry* e = find(flightNumber, date, true);
+    if (!e) {
+        return false;
+    }
+    uint64_t key = e->key.load();
+    uint64_t check = hash(flightNumber, date, CHECK_SEED);
+    uint32_t state = e->state.load();
+    if (state == READY && e->check.load() == check) {
+        return true;
+    }
+    if (state == FILLING || !e->state.compare_exchange_strong(state, FILLING)) {
+        // Someone else is filling it
+        return false;
+    }
+    e->filler.store(slot);
+    e->check.store(check);
+    e->externalUntil.store((int64_t)holdsExpireBy);
+    uint64_t words[SEATS] = {};
+    for (const Seat* seat : flight.getAllSeats()) {
+        int number = seat->getSeatNumber();
+        if (number < 1 || number > SEATS) {
+            continue;
+        }
+        words[number - 1] = seat->getIsBooked() ? BOOKED : seat->isHeld() ? EXTERNAL : FREE;
+    }
+    for (int s = 0; s < SEATS; s++) {
+        e->seats[s].store(words[s]);
+    }
+    e->version.fetch_add(1);
+    uint32_t filling = FILLING;
+    if (!e->state.compare_exchange_strong(filling, READY)) {
+        // Dropped under us by a reclaim that took this process for dead
+        return false;
+    }
+    // A change landed while the seats were read: they may predate it
+    if (stripe(key).load() != ticket) {
+        uint32_t ready = READY;
+        e->state.compare_exchange_strong(ready, DROPPED);
+        return false;
+    }
+    return true;
+}
+
+bool SharedSeatMap::isPublished(string_view flightNumber, string_view date) const {
+    return find(flightNumber, date) != nullptr;
+}
+
+int SharedSeatMap::claim(string_view flightNumber, string_view date, int seatNumber) {
+    if (seatNumber < 1 || seatNumber > SEATS || !ensureRegistered()) {
+        return UNKNOWN;
+    }
+    FlightEntry* e = find(flightNumber, date);
+    if (!e) {
+        return UNKNOWN;
+    }
+    atomic<uint64_t>& word = e->seats[seatNumber - 1];
+    uint64_t mine = (uint64_t)slot + 1;
+    uint64_t current = word.load();
+    while (true) {
+        uint64_t state = current & STATE_MASK;
+        if (state == mine) {
+            return CLAIMED;
+        }
+        bool lapsed = state == EXTERNAL && (int64_t)currentTime() >= e->externalUntil.load();
+        if (state != FREE && !lapsed) {
+            return TAKEN;
+        }
+        if (word.compare_exchange_weak(current, withState(current, mine))) {
+            e->version.fetch_add(1);
+            return CLAIMED;
+        }
+    }
+}
+
+void SharedSeatMap::markHeld(string_view flightNumber, string_view date, int seatNumber) {
+    if (seatNumber < 1 || seatNumber > SEATS || !ensureRegistered()) {
+        return;
+    }
+    stripe(hash(flightNumber, date, KEY_SEED)).fetch_add(1);
+    FlightEntry* e = find(flightNumber, date);
+    if (!e) {
+        return;
+    }
+    atomic<uint64_t>& word = e->seats[seatNumber - 1];
+    uint64_t mine = (uint64_t)slot + 1;
+    uint64_t current = word.load();
+    while (true) {
+        uint64_t state = current & STATE_MASK;
+        if (state == mine || (state != FREE && state != EXTERNAL)) {
+            return;
+        }
+        if (word.compare_exchange_weak(current, withState(current, mine))) {
+            e->version.fetch_add(1);
+            return;
+        }
+    }
+}
+
+void SharedSeatMap::markReleased(string_view flightNumber, string_view date, int seatNumber, bool own) {
+    if (seatNumber < 1 || seatNumber > SEATS || !ensureRegistered()) {
+        return;
+    }
+    stripe(hash(flightNumber, date, KEY_SEED)).fetch_add(1);
+    FlightEntry* e = find(flightNumber, date);
+    if (!e) {
+        return;
+    }
+    atomic<uint64_t>& word = e->seats[seatNumber - 1];
+    uint64_t mine = (uint64_t)slot + 1;
+    uint64_t current = word.load();
+    while (true) {
+        uint64_t state = current & STATE_MASK;
+        if (state != EXTERNAL && !(own && state == mine)) {
+            return;
+        }
+        if (word.compare_exchange_weak(current, withState(current, FREE))) {
+            e->version.fetch_add(1);
+            return;
+        }
+    }
+}
+
+void SharedSeatMap::markBooked(string_view flightNumber, string_view date, int seatNumber, int64_t sequence) {
+    markChange(flightNumber, date, seatNumber, sequence, true);
+}
+
+void SharedSeatMap::markCancelled(string_view flightNumber, string_view date, int seatNumber, int64_t sequence) {
+    markChange(flightNumber, date, seatNumber, sequence, false);
+}
+
+void SharedSeatMap::markChange(string_view flightNumber, string_view date, int seatNumber, int64_t sequence, bool booked) {
+    if (seatNumber < 1 || seatNumber > SEATS || !ensureRegistered()) {
+        return;
+    }
+    // Bumped before the map is looked at, so a fill that read the seats earlier is discarded
+    stripe(hash(flightNumber, date, KEY_SEED)).fetch_add(1);
+    FlightEntry* e = find(flightNumber, date);
+    if (!e) {
+        return;
+    }
+    atomic<uint64_t>& word = e->seats[seatNumber - 1];
+    uint64_t change = (uint64_t)max<int64_t>(sequence, 0);
+    uint64_t current = word.load();
+    while (true) {
+        if (change < (current >> 8)) {
+            return;
+        }
+        uint64_t state = current & STATE_MASK;
+        // A cancellation leaves a newer hold of the freed seat alone
+        uint64_t next = booked ? BOOKED : state == BOOKED ? FREE : state;
+        if (word.compare_exchange_weak(current, (change << 8) | next)) {
+            e->version.fetch_add(1);
+            return;
+        }
+    }
+}
+
+void SharedSeatMap::beginWrite(string_view flightNumber, string_view date) {
+    if (ensureRegistered()) {
+        process(slot)->writing.store(hash(flightNumber, date, KEY_SEED));
+    }
+}
+
+void SharedSeatMap::endWrite() {
+    if (base && slot >= 0 && process(slot)->token.load() == token) {
+        process(slot)->writing.store(0);
+    }
+}
+
+bool SharedSeatMap::read(string_view flightNumber, string_view date, SharedSeats& seats) const {
+    FlightEntry* e = find(flightNumber, date);
+    if (!e) {
+        return false;
+    }
+    int64_t now = (int64_t)currentTime();
+    for (int attempt = 0; attempt < 3; attempt++) {
+        uint32_t before = e->version.load();
+        fill(begin(seats.booked), end(seats.booked), 0);
+        fill(begin(seats.held), end(seats.held), 0);
+        bool externalLapsed = now >= e->externalUntil.load();
+        for (int s = 0; s < SEATS; s++) {
+            uint64_t state = e->seats[s].load() & STATE_MASK;
+            if (state == BOOKED) {
+                seats.booked[s / 64] |= 1ULL << (s % 64);
+            } else if (state != FREE && !(state == EXTERNAL && externalLapsed)) {
+                seats.held[s / 64] |= 1ULL << (s % 64);
+            }
+        }
+        if (e->version.load() == before) {
+            break;
+        }
+    }
+    // The map may have been dropped or refilled for another flight while it was read
+    return e->state.load() == READY && e->check.load() == hash(flightNumber, date, CHECK_SEED);
+}
+
+void SharedSeatMap::clear() {
+    if (!base) {
+        return;
+    }
+    // Fills under way read the seats before this, so they are discarded too
+    for (atomic<uint32_t>& counter : header()->stripes) {
+        counter.fetch_add(1);
+    }
+    for (size_t i = 0; i < CAPACITY; i++) {
+        FlightEntry* e = entry(i);
+        uint32_t state = e->state.load();
+        if (state == READY && e->state.compare_exchange_strong(state, DROPPED)) {
+            e->version.fetch_add(1);
+        }
+    }
+}
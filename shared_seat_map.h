@@ -0,0 +1,218 @@
+/**
+ * @file shared_seat_map.h
+ * @brief Seat states of active flights in shared memory, for processes on one machine
+ *
+ * Kiosk and server processes on the same database can attach to one POSIX
+ * shared-memory segment named after the database file. It keeps a seat map
+ * per active flight - every seat free, booked, or held by a named process -
+ * so a seat taken in one process is visible to the others at once, without
+ * a query or a log read. Holding a seat starts with an atomic claim here:
+ * of two kiosks picking the same seat, one wins the compare-and-swap and
+ * the other is turned away before it opens a write transaction.
+ *
+ * SQLite stays the store of record. Maps are filled from flights a process
+ * has just loaded, and every booking, cancellation, hold and release is
+ * applied here after it commits; a claim that then loses in SQLite is given
+ * back. Each seat word carries the booking log sequence of its last booking
+ * or cancellation, so two processes' stores to one seat settle on the later
+ * change whatever order they land in. A map filled while the flight changed
+ * elsewhere is discarded rather than published.
+ *
+ * Ownership is crash-safe. Each process registers in a slot with its pid
+ * and renews a heartbeat about once a second. Held seats name the holder's
+ * slot, and a process names the flight it is about to write before each
+ * transaction. When a process is found dead - its pid gone, or silent for
+ * LEASE_SECONDS - every map it held seats in, was writing or was filling is
+ * dropped, and the next process to load the flight fills it again from the
+ * database. A process that finds its slot reclaimed after a stall registers
+ * again.
+ *
+ * read() is safe from any thread. Everything else must come from one
+ * thread at a time.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef SHARED_SEAT_MAP_H
+#define SHARED_SEAT_MAP_H
+
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <ctime>
+#include <cstdint>
+
+class Flight;
+
+using namespace std;
+
+/**
+ * @struct SharedSeats
+ * @brief Booked and held seats of one flight as read from the shared map
+ */
+struct SharedSeats {
+    uint64_t booked[2];  ///< Bit n-1 set while seat n is booked
+    uint64_t held[2];    ///< Bit n-1 set while seat n is held by any process
+
+    bool isBooked(int seatNumber) const { return testBit(booked, seatNumber); }
+    bool isHeld(int seatNumber) const { return testBit(held, seatNumber); }
+
+private:
+    static bool testBit(const uint64_t* bits, int seatNumber) {
+        return seatNumber >= 1 && seatNumber <= 128 && ((bits[(seatNumber - 1) / 64] >> ((seatNumber - 1) % 64)) & 1);
+    }
+};
+
+/**
+ * @class SharedSeatMap
+ * @brief This process's attachment to the shared seat maps
+ */
+class SharedSeatMap {
+public:
+    static const int MAX_PROCESSES = 62;     ///< Processes attached at once; seat words name them 1..62
+    static const size_t CAPACITY = 8192;     ///< Flights the segment can hold; a full segment skips new flights
+    static const int LEASE_SECONDS = 30;     ///< A process silent this long is presumed dead
+
+    static const int CLAIMED = 1;            ///< claim(): the seat is now held by this process
+    static const int TAKEN = 0;              ///< claim(): booked or held elsewhere
+    static const int UNKNOWN = -1;           ///< claim(): the flight has no map; ask the database
+
+    SharedSeatMap();
+    ~SharedSeatMap();
+    SharedSeatMap(const SharedSeatMap&) = delete;
+    SharedSeatMap& operator=(const SharedSeatMap&) = delete;
+
+    /**
+     * @brief Opens or creates the segment of a database and registers this process
+     * @param databasePath The database file; processes on the same file share one segment
+     * @return false if shared memory is unavailable or every slot is taken; nothing else then works
+     */
+    bool attach(const char* databasePath);
+
+    /**
+     * @brief Gives up this process's slot; its remaining claims are dropped with their maps
+     */
+    void detach();
+
+    bool isAttached() const { return base != nullptr; }
+
+    /**
+     * @brief Renews this process's lease and reclaims slots of dead processes; call about once a second
+     */
+    void heartbeat(time_t now);
+
+    /**
+     * @brief Change counter to read before a flight's seats are read for publish()
+     */
+    uint32_t fillTicket(string_view flightNumber, string_view date) const;
+
+    /**
+     * @brief Fills the flight's map from its loaded seats unless it already has one
+     * @param ticket fillTicket() from before the seats were read; the map is discarded if
+     *               the flight changed since
+     * @param holdsExpireBy Latest expiry of the flight's held seats; past it they count as free
+     *                      unless their holder released them first
+     * @return true if the flight has a current map afterwards
+     */
+    bool publish(const Flight& flight, uint32_t ticket, time_t holdsExpireBy);
+
+    /**
+     * @brief True if the flight has a current map
+     */
+    bool isPublished(string_view flightNumber, string_view date) const;
+
+    /**
+     * @brief Atomically holds a free seat for this process
+     * @return CLAIMED, TAKEN or UNKNOWN
+     */
+    int claim(string_view flightNumber, string_view date, int seatNumber);
+
+    /**
+     * @brief Records a hold of this process committed to seat_holds, claimed or not
+     */
+    void markHeld(string_view flightNumber, string_view date, int seatNumber);
+
+    /**
+     * @brief Frees a seat whose hold ended, or gives back a claim that lost in the database
+     * @param own false for another process's hold; a seat claimed by a live process is then kept
+     */
+    void markReleased(string_view flightNumber, string_view date, int seatNumber, bool own = true);
+
+    /**
+     * @brief Records a committed booking or cancellation
+     * @param sequence Its booking log sequence; an older change than the seat's last is ignored
+     */
+    void markBooked(string_view flightNumber, string_view date, int seatNumber, int64_t sequence);
+    void markCancelled(string_view flightNumber, string_view date, int seatNumber, int64_t sequence);
+
+    /**
+     * @brief Names the flight this process is about to write, until endWrite()
+     *
+     * Should the process die before endWrite(), the flight's map is dropped.
+     */
+    void beginWrite(string_view flightNumber, string_view date);
+    void endWrite();
+
+    /**
+     * @brief Current booked and held seats of a flight
+     * @return false if the flight has no map
+     */
+    bool read(string_view flightNumber, string_view date, SharedSeats& seats) const;
+
+    /**
+     * @brief Drops every map, e.g. after seats were written without going through this segment
+     */
+    void clear();
+
+    int getProcessSlot() const { return slot; }
+
+    /// Dead processes whose slots this process reclaimed
+    uint64_t getReclaimed() const { return reclaimed; }
+
+private:
+    struct Header;
+    struct ProcessSlot;
+    struct FlightEntry;
+
+    unsigned char* base;   ///< The mapped segment; nullptr when detached
+    size_t size;
+    int slot;              ///< This process's slot, or -1
+    uint64_t token;        ///< This process's registration in its slot
+    uint64_t reclaimed;
+
+    Header* header() const;
+    ProcessSlot* process(int index) const;
+    FlightEntry* entry(size_t index) const;
+
+    static uint64_t hash(string_view flightNumber, string_view date, uint64_t seed);
+
+    /**
+     * @brief The flight's entry if it is current (or, with create, a new or dropped one to fill)
+     */
+    FlightEntry* find(string_view flightNumber, string_view date, bool create = false) const;
+
+    atomic<uint32_t>& stripe(uint64_t key) const;
+
+    /**
+     * @brief Takes a free slot for this process
+     */
+    bool registerProcess(time_t now);
+
+    /**
+     * @brief Re-registers if this process's slot was reclaimed while it stalled
+     */
+    bool ensureRegistered();
+
+    /**
+     * @brief Drops every map that names the slot as holder, filler or writer, then frees the slot
+     */
+    void reclaim(int index, uint64_t observedToken, time_t now);
+
+    /**
+     * @brief Stores a booking or cancellation unless the seat already reflects a later change
+     */
+    void markChange(string_view flightNumber, string_view date, int seatNumber, int64_t sequence, bool booked);
+};
+
+#endif // SHARED_SEAT_MAP_H
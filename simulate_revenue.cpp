@@ -0,0 +1,160 @@
+/**
+ * @file simulate_revenue.cpp
+ * @brief Command-line Monte Carlo revenue simulator
+ *
+ * Usage:
+ *   simulate_revenue --db spaazm_flights.db [--scenarios 100] [--seed 1] [--threads 8]
+ *                    [--rules candidate.conf] [--demand 120] [--horizon 60] [--decay 14]
+ *                    [--wtp 1.3] [--wtp-sigma 0.35] [--csv routes.csv]
+ *
+ * Sells every flight of the schedule --scenarios times with the pricing
+ * rules in effect (defaults, overlaid with --rules if given) and prints the
+ * revenue and load-factor distribution of each route. Run once with and
+ * once without --rules, same seed, to compare a candidate rules file.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#include "revenue_simulator.h"
+#include "work_stealing_pool.h"
+#include "schedule_store.h"
+#include "pricing_rules.h"
+#include <sqlite3.h>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+
+using namespace std;
+
+static void printUsage(const char* program) {
+    cerr << "Usage: " << program << " [options]\n"
+         << "  --db PATH            Schedule database (default spaazm_flights.db)\n"
+         << "  --scenarios N        Sales horizons simulated per flight (default 100)\n"
+         << "  --seed N             Random seed; same seed, same results (default 1)\n"
+         << "  --threads N          Worker threads (default: hardware threads)\n"
+         << "  --rules PATH         Pricing rules file to evaluate instead of the defaults\n"
+         << "  --demand F           Expected booking requests per flight (default 120)\n"
+         << "  --horizon N          Days before departure that sales open (default 60)\n"
+         << "  --decay F            Arrival intensity decay in days (default 14)\n"
+         << "  --wtp F              Median budget relative to base fare x class (default 1.3)\n"
+         << "  --wtp-sigma F        Lognormal spread of budgets (default 0.35)\n"
+         << "  --csv PATH           Also write per-route results as CSV\n";
+}
+
+int main(int argc, char* argv[]) {
+    SimulationConfig config;
+    string dbPath = "spaazm_flights.db";
+    string rulesPath;
+    string csvPath;
+    int threads = 0;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            cerr << "Missing value for " << arg << endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+        string value = argv[++i];
+        if (arg == "--db") dbPath = value;
+        else if (arg == "--scenarios") config.scenarios = atoi(value.c_str());
+        else if (arg == "--seed") config.seed = strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--threads") threads = atoi(value.c_str());
+        else if (arg == "--rules") rulesPath = value;
+        else if (arg == "--demand") config.demand = atof(value.c_str());
+        else if (arg == "--horizon") config.horizonDays = atoi(value.c_str());
+        else if (arg == "--decay") config.arrivalDecayDays = atof(value.c_str());
+        else if (arg == "--wtp") config.willingnessToPay = atof(value.c_str());
+        else if (arg == "--wtp-sigma") config.willingnessSigma = atof(value.c_str());
+        else if (arg == "--csv") csvPath = value;
+        else {
+            cerr << "Unknown option " << arg << endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (config.scenarios < 1 || config.demand <= 0 || config.horizonDays < 1 || config.arrivalDecayDays <= 0) {
+        cerr << "--scenarios, --demand, --horizon and --decay must be positive" << endl;
+        return 1;
+    }
+
+    if (!rulesPath.empty()) {
+        PricingTable table = PricingTable::defaults();
+        string error;
+        ifstream file(rulesPath);
+        if (!file || !PricingRules::parse(file, table, error)) {
+            cerr << "Cannot use rules file " << rulesPath << ": " << (file ? error : "not readable") << endl;
+            return 1;
+        }
+        PricingRules::install(table);
+    }
+
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(dbPath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        cerr << "Failed to open database: " << sqlite3_errmsg(db) << endl;
+        sqlite3_close(db);
+        return 1;
+    }
+    ScheduleStore schedule;
+    bool loaded = schedule.load(db);
+    sqlite3_close(db);
+    if (!loaded || schedule.empty()) {
+        cerr << "No flights in " << dbPath << endl;
+        return 1;
+    }
+
+    WorkStealingPool pool(threads);
+    auto start = chrono::steady_clock::now();
+    vector<RouteOutcome> routes = RevenueSimulator(config).run(schedule, pool);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    RouteOutcome total;
+    cout << fixed << setprecision(0);
+    cout << left << setw(28) << "Route" << right << setw(12) << "Mean INR" << setw(12) << "P5" << setw(12) << "P50"
+         << setw(12) << "P95" << setw(9) << "Mean LF" << setw(8) << "P5 LF" << setw(8) << "P95 LF" << setw(9)
+         << "Spill %" << endl;
+    for (const RouteOutcome& route : routes) {
+        double spill = route.requests ? 100.0 * route.soldOut / route.requests : 0.0;
+        cout << left << setw(28) << (route.source + " -> " + route.destination) << right << setw(12)
+             << route.meanRevenue() << setw(12) << route.revenueQuantile(0.05) << setw(12)
+             << route.revenueQuantile(0.5) << setw(12) << route.revenueQuantile(0.95) << setprecision(2)
+             << setw(9) << route.meanLoadFactor() << setw(8) << route.loadFactorQuantile(0.05) << setw(8)
+             << route.loadFactorQuantile(0.95) << setprecision(1) << setw(9) << spill << setprecision(0) << endl;
+        total.merge(route);
+    }
+
+    cout << "\n" << total.flightScenarios << " flight scenarios (" << schedule.size() << " flights x "
+         << config.scenarios << ") in " << setprecision(2) << seconds << " s on " << pool.size() << " threads, "
+         << pool.getSteals() << " tasks stolen" << endl;
+    cout << "Mean revenue per flight INR " << setprecision(0) << total.meanRevenue() << ", mean load factor "
+         << setprecision(3) << total.meanLoadFactor() << ", requests declined on price "
+         << setprecision(1) << (total.requests ? 100.0 * total.declined / total.requests : 0.0) << "%" << endl;
+
+    if (!csvPath.empty()) {
+        ofstream csv(csvPath);
+        if (!csv) {
+            cerr << "Cannot write " << csvPath << endl;
+            return 1;
+        }
+        csv << fixed << setprecision(2);
+        csv << "source,destination,flight_scenarios,requests,declined,sold_out,mean_revenue,p5_revenue,"
+               "p50_revenue,p95_revenue,mean_load_factor,p5_load_factor,p50_load_factor,p95_load_factor\n";
+        for (const RouteOutcome& route : routes) {
+            csv << route.source << "," << route.destination << "," << route.flightScenarios << ","
+                << route.requests << "," << route.declined << "," << route.soldOut << "," << route.meanRevenue()
+                << "," << route.revenueQuantile(0.05) << "," << route.revenueQuantile(0.5) << ","
+                << route.revenueQuantile(0.95) << "," << route.meanLoadFactor() << ","
+                << route.loadFactorQuantile(0.05) << "," << route.loadFactorQuantile(0.5) << ","
+                << route.loadFactorQuantile(0.95) << "\n";
+        }
+    }
+    return 0;
+}
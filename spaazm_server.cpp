@@ -0,0 +1,118 @@
+/**
+ * @file spaazm_server.cpp
+ * @brief HTTP/JSON front end of the reservation system
+ *
+ * Usage:
+ *   spaazm_server [--host 127.0.0.1] [--port 8080] [--threads 8] [--shared-seats]
+ *
+ * Serves the endpoints of ReservationService on the database in the
+ * working directory, the same one the GUI uses, so both see the same
+ * inventory. For example:
+ *
+ *   curl 'http://127.0.0.1:8080/search?from=Mumbai&to=Delhi&date=2025-11-20'
+ *   curl -X POST http://127.0.0.1:8080/bookings \
+ *        -d '{"flight":"SP1001","date":"2025-11-20","class":"Economy","name":"A. Rao",
+ *             "email":"a@example.com","phone":"9800000000"}'
+ *
+ * With --shared-seats the server shares seat maps in shared memory with
+ * kiosks and servers on the same machine started the same way: seats are
+ * claimed there before a hold is written, and seat maps of flights any of
+ * them has loaded are served without SQL.
+ *
+ * Stops cleanly on SIGINT or SIGTERM, releasing its seat holds.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#include "http_server.h"
+#include "reservation_service.h"
+#include "flight_system.h"
+#include <iostream>
+#include <csignal>
+#include <cstdlib>
+
+using namespace std;
+
+static HttpServer* runningServer = nullptr;
+
+static void onSignal(int) {
+    if (runningServer) runningServer->stop();
+}
+
+static void printUsage(const char* program) {
+    cerr << "Usage: " << program << " [options]\n"
+         << "  --host ADDRESS       IPv4 address to listen on (default 127.0.0.1)\n"
+         << "  --port N             TCP port; 0 picks a free one (default 8080)\n"
+         << "  --threads N          Worker threads (default: hardware threads)\n"
+         << "  --shared-seats       Share seat maps with other processes on this machine\n";
+}
+
+int main(int argc, char* argv[]) {
+    string host = "127.0.0.1";
+    int port = 8080;
+    int threads = 0;
+    bool sharedSeats = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (arg == "--shared-seats") {
+            sharedSeats = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            cerr << "Missing value for " << arg << endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+        string value = argv[++i];
+        if (arg == "--host") host = value;
+        else if (arg == "--port") port = atoi(value.c_str());
+        else if (arg == "--threads") threads = atoi(value.c_str());
+        else {
+            cerr << "Unknown option " << arg << endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (port < 0 || port > 65535 || threads < 0) {
+        cerr << "--port must be 0-65535 and --threads not negative" << endl;
+        return 1;
+    }
+
+    ReservationSystem system;
+    if (sharedSeats && !system.attachSharedSeats()) {
+        cerr << "Running without shared seat maps" << endl;
+    }
+    HttpServer* server = nullptr;
+    ReservationService* service = nullptr;
+    // The handler is bound before the service exists; both live until main returns
+    server = new HttpServer([&service](const HttpRequest& request, int worker) {
+        return service->handle(request, worker);
+    }, threads);
+    service = new ReservationService(system, server->getThreadCount());
+
+    if (!server->listen(host, port)) {
+        delete server;
+        delete service;
+        return 1;
+    }
+
+    runningServer = server;
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    cout << "Listening on http://" << host << ":" << server->getPort() << " with " << server->getThreadCount()
+         << " workers" << endl;
+
+    server->run([service] { service->tick(); });
+
+    cout << "Stopped after " << server->getRequestCount() << " requests" << endl;
+    runningServer = nullptr;
+    delete server;
+    delete service;
+    return 0;
+}
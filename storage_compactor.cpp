@@ -0,0 +1,182 @@
+#include "storage_compactor.h"
+#include "time_core.h"
+#include <sqlite3.h>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+/// First column of a single-row PRAGMA or query, or -1
+long long queryInt(sqlite3* db, const char* sql) {
+    sqlite3_stmt* stmt = nullptr;
+    long long value = -1;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+        value = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+bool exec(sqlite3* db, const char* sql) {
+    if (sqlite3_exec(db, sql, nullptr, nullptr, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+CompactionStats StorageCompactor::getStats() const {
+    lock_guard<mutex> guard(lock);
+    return stats;
+}
+
+void StorageCompactor::setPhase(const char* phase) {
+    lock_guard<mutex> guard(lock);
+    stats.phase = phase;
+}
+
+bool StorageCompactor::runOnce(sqlite3* db, time_t now, bool idle, size_t rowsPerTransaction,
+                               const function<bool()>& between) {
+    if (!db || rowsPerTransaction == 0) return false;
+
+    setPhase("retention");
+    long long moved = 0;
+    bool ok = archiveBookings(db, formatDate(localDayNumber(now) - BOOKING_RETENTION_DAYS), rowsPerTransaction,
+                              between, moved);
+
+    // Compaction rewrites pages other connections read; it waits for quiet hours
+    long long reclaimed = 0;
+    if (ok && idle) {
+        setPhase("vacuum");
+        ok = reclaimPages(db, between, reclaimed);
+    }
+    bool analyzed = false;
+    if (ok && idle && (stats.lastAnalyze == 0 || now - stats.lastAnalyze >= ANALYZE_INTERVAL_SECONDS)) {
+        setPhase("analyze");
+        ok = analyzed = analyze(db);
+    }
+
+    long long pageSize = queryInt(db, "PRAGMA page_size;");
+    long long pageCount = queryInt(db, "PRAGMA page_count;");
+    long long freePages = queryInt(db, "PRAGMA freelist_count;");
+    {
+        lock_guard<mutex> guard(lock);
+        stats.phase = "idle";
+        stats.passes++;
+        stats.lastPass = now;
+        stats.pageSize = pageSize;
+        stats.pageCount = pageCount;
+        stats.freePages = freePages;
+        stats.pagesReclaimed += reclaimed;
+        stats.bytesReclaimed += reclaimed * pageSize;
+        if (reclaimed > 0) stats.lastVacuum = now;
+        if (analyzed) stats.lastAnalyze = now;
+    }
+    if (moved > 0 || reclaimed > 0) {
+        cout << "Compaction: " << moved << " booking(s) archived, " << reclaimed * pageSize / 1024
+             << " KB reclaimed, file now " << pageCount * pageSize / 1024 << " KB" << endl;
+    }
+    return ok;
+}
+
+bool StorageCompactor::archiveBookings(sqlite3* db, const string& cutoff, size_t rowsPerTransaction,
+                                       const function<bool()>& between, long long& moved) {
+    // Ids are collected first so each transaction touches only its own slice of the table
+    vector<int64_t> ids;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT id FROM bookings WHERE flight_date < ? ORDER BY id;", -1, &stmt,
+                           nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, cutoff.c_str(), -1, SQLITE_STATIC);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        ids.push_back(sqlite3_column_int64(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+
+    sqlite3_stmt* copyStmt = nullptr;
+    sqlite3_stmt* deleteStmt = nullptr;
+    if (sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO bookings_archive SELECT * FROM bookings WHERE id = ?;", -1,
+                           &copyStmt, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, "DELETE FROM bookings WHERE id = ?;", -1, &deleteStmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        sqlite3_finalize(copyStmt);
+        return false;
+    }
+
+    bool ok = true;
+    for (size_t begin = 0; ok && begin < ids.size(); begin += rowsPerTransaction) {
+        if (begin > 0 && !between()) {
+            ok = false;
+            break;
+        }
+        ok = sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) == SQLITE_OK;
+        size_t end = min(ids.size(), begin + rowsPerTransaction);
+        for (size_t i = begin; ok && i < end; i++) {
+            sqlite3_bind_int64(copyStmt, 1, ids[i]);
+            sqlite3_bind_int64(deleteStmt, 1, ids[i]);
+            ok = sqlite3_step(copyStmt) == SQLITE_DONE && sqlite3_step(deleteStmt) == SQLITE_DONE;
+            sqlite3_reset(copyStmt);
+            sqlite3_reset(deleteStmt);
+        }
+        if (!ok || sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            cerr << "Booking retention failed: " << sqlite3_errmsg(db) << endl;
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            ok = false;
+            break;
+        }
+        moved += (long long)(end - begin);
+        lock_guard<mutex> guard(lock);
+        stats.bookingsArchived += (long long)(end - begin);
+    }
+    sqlite3_finalize(copyStmt);
+    sqlite3_finalize(deleteStmt);
+
+    lock_guard<mutex> guard(lock);
+    stats.bookingsPending = (long long)ids.size() - moved;
+    return ok;
+}
+
+bool StorageCompactor::reclaimPages(sqlite3* db, const function<bool()>& between, long long& reclaimed) {
+    long long autoVacuum = queryInt(db, "PRAGMA auto_vacuum;");
+    long long freePages = queryInt(db, "PRAGMA freelist_count;");
+    long long pageCount = queryInt(db, "PRAGMA page_count;");
+    if (freePages <= 0) return true;
+
+    if (autoVacuum == 0) {
+        // Files from before incremental mode are rebuilt once, and only when it pays off
+        if (freePages * 4 < pageCount) return true;
+        cout << "Compaction: rebuilding database with incremental auto-vacuum (" << freePages << " of "
+             << pageCount << " pages free)" << endl;
+        if (!exec(db, "PRAGMA auto_vacuum = INCREMENTAL;") || !exec(db, "VACUUM;")) return false;
+        reclaimed = pageCount - queryInt(db, "PRAGMA page_count;");
+    } else if (autoVacuum == 2) {
+        // A slice of pages per transaction, pausing between slices like every other writer here
+        for (bool first = true; freePages > 0; first = false) {
+            if (!first && !between()) return false;
+            string sql = "PRAGMA incremental_vacuum(" + to_string(VACUUM_PAGES_PER_STEP) + ");";
+            if (!exec(db, sql.c_str())) return false;
+            long long remaining = queryInt(db, "PRAGMA freelist_count;");
+            if (remaining < 0 || remaining >= freePages) break;
+            reclaimed += freePages - remaining;
+            freePages = remaining;
+        }
+    }
+
+    // In WAL mode the file shrinks only when the log is checkpointed
+    if (reclaimed > 0) {
+        sqlite3_exec(db, "PRAGMA wal_checkpoint(TRUNCATE);", nullptr, nullptr, nullptr);
+    }
+    return true;
+}
+
+bool StorageCompactor::analyze(sqlite3* db) {
+    string sql = "PRAGMA analysis_limit = " + to_string(ANALYZE_ROW_LIMIT) + "; ANALYZE main;";
+    return exec(db, sql.c_str());
+}
@@ -0,0 +1,108 @@
+/**
+ * @file storage_compactor.h
+ * @brief Booking retention, free-page reclamation and planner statistics
+ *
+ * Bookings of flights that departed more than BOOKING_RETENTION_DAYS ago
+ * move to bookings_archive in bounded transactions, so the bookings table
+ * and its pages hold only trips that can still change. When the database is
+ * idle (outside business hours) the compactor then returns free pages left
+ * by those deletes, by day archiving and by schedule regeneration with
+ * PRAGMA incremental_vacuum, a slice at a time, truncates the WAL and
+ * refreshes the query planner's statistics with a bounded ANALYZE.
+ *
+ * Databases created before incremental auto-vacuum was enabled are
+ * converted once, by a full VACUUM, when at least a quarter of the file is
+ * free pages.
+ *
+ * The schedule maintainer runs one compactor pass after each of its own
+ * passes, on its connection; getStats() may be called from any thread.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef STORAGE_COMPACTOR_H
+#define STORAGE_COMPACTOR_H
+
+#include <string>
+#include <ctime>
+#include <mutex>
+#include <functional>
+
+struct sqlite3;  // Forward declaration for SQLite database handle
+
+using namespace std;
+
+/**
+ * @struct CompactionStats
+ * @brief Progress and reclaimed space, cumulative since the compactor was created
+ */
+struct CompactionStats {
+    string phase = "idle";            ///< "idle", "retention", "vacuum" or "analyze"
+    long long passes = 0;
+    long long bookingsArchived = 0;   ///< Bookings moved to bookings_archive
+    long long bookingsPending = 0;    ///< Bookings past retention still in bookings after the last pass
+    long long pagesReclaimed = 0;     ///< Pages returned to the file system
+    long long bytesReclaimed = 0;
+    long long pageSize = 0;           ///< Database file, as of the last pass
+    long long pageCount = 0;
+    long long freePages = 0;
+    time_t lastPass = 0;
+    time_t lastVacuum = 0;            ///< Last pass that reclaimed pages
+    time_t lastAnalyze = 0;
+};
+
+/**
+ * @class StorageCompactor
+ * @brief Moves old bookings to a cold table and compacts the file when idle
+ */
+class StorageCompactor {
+public:
+    static const int BOOKING_RETENTION_DAYS = 90;         ///< Days after departure a booking stays hot
+    static const int VACUUM_PAGES_PER_STEP = 2048;        ///< Free pages released per incremental_vacuum
+    static const int ANALYZE_ROW_LIMIT = 1000;            ///< PRAGMA analysis_limit: rows sampled per index
+    static const int ANALYZE_INTERVAL_SECONDS = 24 * 60 * 60;
+
+    StorageCompactor() = default;
+    StorageCompactor(const StorageCompactor&) = delete;
+    StorageCompactor& operator=(const StorageCompactor&) = delete;
+
+    /**
+     * @brief Runs one retention and compaction pass
+     * @param db Open database connection, outside a transaction
+     * @param now Current time
+     * @param idle True when compaction may run (vacuum and ANALYZE are skipped otherwise)
+     * @param rowsPerTransaction Bookings moved per transaction
+     * @param between Called between transactions; returning false stops early
+     * @return false on error or if stopped; the next pass resumes
+     */
+    bool runOnce(sqlite3* db, time_t now, bool idle, size_t rowsPerTransaction, const function<bool()>& between);
+
+    /**
+     * @brief Copy of the current statistics
+     */
+    CompactionStats getStats() const;
+
+private:
+    mutable mutex lock;  ///< Guards stats against getStats() from other threads
+    CompactionStats stats;
+
+    void setPhase(const char* phase);
+
+    /**
+     * @brief Moves bookings of flights departed before cutoff to bookings_archive
+     * @param moved Set to the bookings moved
+     */
+    bool archiveBookings(sqlite3* db, const string& cutoff, size_t rowsPerTransaction,
+                         const function<bool()>& between, long long& moved);
+
+    /**
+     * @brief Returns free pages to the file system
+     * @param reclaimed Set to the pages released
+     */
+    bool reclaimPages(sqlite3* db, const function<bool()>& between, long long& reclaimed);
+
+    bool analyze(sqlite3* db);
+};
+
+#endif // STORAGE_COMPACTOR_H
@@ -0,0 +1,48 @@
+#include "string_interner.h"
+#include <mutex>
+
+using namespace std;
+
+StringInterner::StringInterner() {
+    // Id 0 is the empty string so default-constructed ids read as ""
+    strings.emplace_back();
+    ids.emplace(string_view(strings.back()), 0);
+}
+
+StringInterner& StringInterner::global() {
+    static StringInterner table;
+    return table;
+}
+
+InternId StringInterner::intern(string_view value) {
+    {
+        shared_lock<shared_mutex> reader(lock);
+        auto it = ids.find(value);
+        if (it != ids.end()) return it->second;
+    }
+
+    unique_lock<shared_mutex> writer(lock);
+    auto it = ids.find(value);
+    if (it != ids.end()) return it->second;
+
+    InternId id = (InternId)strings.size();
+    strings.emplace_back(value);
+    ids.emplace(string_view(strings.back()), id);
+    return id;
+}
+
+InternId StringInterner::find(string_view value) const {
+    shared_lock<shared_mutex> reader(lock);
+    auto it = ids.find(value);
+    return it == ids.end() ? NO_ID : it->second;
+}
+
+const string& StringInterner::text(InternId id) const {
+    shared_lock<shared_mutex> reader(lock);
+    return strings[id];
+}
+
+size_t StringInterner::size() const {
+    shared_lock<shared_mutex> reader(lock);
+    return strings.size();
+}
@@ -0,0 +1,92 @@
+/**
+ * @file string_interner.h
+ * @brief Process-wide intern table for repeated backend strings
+ *
+ * Cities, carriers, flight numbers, dates and seat classes recur across
+ * every Flight and Booking. Interning stores each distinct value once and
+ * hands out a 32-bit id, so objects hold ids, comparisons are integer
+ * compares and the text is looked up only at the GUI boundary.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef STRING_INTERNER_H
+#define STRING_INTERNER_H
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <unordered_map>
+#include <shared_mutex>
+#include <cstdint>
+
+using namespace std;
+
+typedef uint32_t InternId;  ///< Id of an interned string
+
+/**
+ * @class StringInterner
+ * @brief Append-only string table; ids and returned references stay valid
+ *
+ * Safe to use from several threads: lookups take a shared lock and only
+ * the first intern() of a new value takes the exclusive lock.
+ */
+class StringInterner {
+public:
+    static const InternId NO_ID = 0xFFFFFFFF;  ///< Returned by find() for unknown values
+
+    /**
+     * @brief The table shared by the whole backend
+     */
+    static StringInterner& global();
+
+    /**
+     * @brief Returns the id of value, adding it if it is new
+     */
+    InternId intern(string_view value);
+
+    /**
+     * @brief Returns the id of value, or NO_ID if it was never interned
+     */
+    InternId find(string_view value) const;
+
+    /**
+     * @brief Text of an id; the reference lives as long as the table
+     */
+    const string& text(InternId id) const;
+
+    size_t size() const;
+
+private:
+    StringInterner();
+    StringInterner(const StringInterner&) = delete;
+    StringInterner& operator=(const StringInterner&) = delete;
+
+    mutable shared_mutex lock;
+    deque<string> strings;                       ///< Deque keeps element addresses stable
+    unordered_map<string_view, InternId> ids;    ///< Views into strings
+};
+
+/**
+ * @brief Shorthand for StringInterner::global().intern()
+ */
+inline InternId intern(string_view value) {
+    return StringInterner::global().intern(value);
+}
+
+/**
+ * @brief Shorthand for StringInterner::global().text()
+ */
+inline const string& internedText(InternId id) {
+    return StringInterner::global().text(id);
+}
+
+/**
+ * @brief Packs two ids into one hash key, e.g. (flight number, date)
+ */
+inline uint64_t internPair(InternId first, InternId second) {
+    return ((uint64_t)first << 32) | second;
+}
+
+#endif // STRING_INTERNER_H
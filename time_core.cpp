@@ -0,0 +1,113 @@
+#include "time_core.h"
+#include <mutex>
+#include <unordered_map>
+#include <cstdio>
+
+using namespace std;
+
+namespace {
+
+SystemClock systemClock;
+atomic<const Clock*> activeClock(&systemClock);
+
+/// UTC offsets (seconds east of UTC) at the start and end of one local day
+struct DayOffsets {
+    long atStart;
+    long atEnd;
+};
+
+mutex offsetLock;
+unordered_map<int32_t, DayOffsets> offsetCache;
+
+time_t mktimeLocal(int32_t dayNumber, int minuteOfDay) {
+    CivilDate date = civilFromDays(dayNumber);
+    struct tm tm = {};
+    tm.tm_year = date.year - 1900;
+    tm.tm_mon = date.month - 1;
+    tm.tm_mday = date.day;
+    tm.tm_hour = minuteOfDay / 60;
+    tm.tm_min = minuteOfDay % 60;
+    tm.tm_isdst = -1;
+    return mktime(&tm);
+}
+
+long offsetAt(int32_t dayNumber, int minuteOfDay) {
+    time_t asUtc = (time_t)dayNumber * 86400 + minuteOfDay * 60;
+    return (long)(asUtc - mktimeLocal(dayNumber, minuteOfDay));
+}
+
+} // namespace
+
+bool parseCivilFields(string_view text, CivilTime& out) {
+    int32_t day = parseDayNumber(text);
+    int hour = 0, minute = 0;
+    if (day == INT32_MIN || text.size() < 16 || text[10] != ' ' || text[13] != ':' ||
+        !parseDigits(text, 11, 2, hour) || !parseDigits(text, 14, 2, minute) || hour > 23 || minute > 59) {
+        return false;
+    }
+    out.dayNumber = day;
+    out.hour = hour;
+    out.minute = minute;
+    out.weekday = weekdayFromDays(day);
+    out.timestamp = 0;
+    return true;
+}
+
+bool parseCivilTime(string_view text, CivilTime& out) {
+    if (!parseCivilFields(text, out)) return false;
+    out.timestamp = localTimestamp(out.dayNumber, out.minuteOfDay());
+    return true;
+}
+
+time_t localTimestamp(int32_t dayNumber, int minuteOfDay) {
+    DayOffsets offsets;
+    {
+        lock_guard<mutex> guard(offsetLock);
+        auto it = offsetCache.find(dayNumber);
+        if (it == offsetCache.end()) {
+            it = offsetCache.emplace(dayNumber, DayOffsets{offsetAt(dayNumber, 0),
+                                                           offsetAt(dayNumber, 23 * 60 + 59)}).first;
+        }
+        offsets = it->second;
+        if (offsets.atStart != offsets.atEnd) {
+            // DST changes during this day; let the C library resolve the exact minute
+            return mktimeLocal(dayNumber, minuteOfDay);
+        }
+    }
+    return (time_t)dayNumber * 86400 + minuteOfDay * 60 - offsets.atStart;
+}
+
+CivilTime civilTimeFromTimestamp(time_t timestamp) {
+    struct tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &timestamp);
+#else
+    localtime_r(&timestamp, &tm);
+#endif
+    CivilTime civil;
+    civil.dayNumber = daysFromCivil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+    civil.hour = tm.tm_hour;
+    civil.minute = tm.tm_min;
+    civil.weekday = tm.tm_wday;
+    civil.timestamp = timestamp;
+    return civil;
+}
+
+int32_t localDayNumber(time_t timestamp) {
+    return civilTimeFromTimestamp(timestamp).dayNumber;
+}
+
+string formatDate(int32_t dayNumber) {
+    CivilDate date = civilFromDays(dayNumber);
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", date.year, date.month, date.day);
+    return buffer;
+}
+
+const Clock& Clock::current() {
+    return *activeClock.load();
+}
+
+void Clock::install(const Clock* clock) {
+    activeClock.store(clock ? clock : &systemClock);
+}
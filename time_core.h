@@ -0,0 +1,206 @@
+/**
+ * @file time_core.h
+ * @brief Calendar math, departure-time parsing and the injectable clock
+ *
+ * Dates are handled as day numbers (days since 1970-01-01) with constexpr
+ * civil-calendar arithmetic, so parsing a "YYYY-MM-DD HH:MM" departure
+ * needs no sscanf, mktime or localtime. The local UTC offset is looked up
+ * once per day and cached. All backend code reads the current time through
+ * Clock::current(), which simulations and benchmarks can replace.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef TIME_CORE_H
+#define TIME_CORE_H
+
+#include <string>
+#include <string_view>
+#include <ctime>
+#include <cstdint>
+#include <atomic>
+
+using namespace std;
+
+/**
+ * @struct CivilDate
+ * @brief Proleptic Gregorian calendar date
+ */
+struct CivilDate {
+    int year;
+    int month;  ///< 1-12
+    int day;    ///< 1-31
+};
+
+/**
+ * @struct CivilTime
+ * @brief A local departure time broken down once, at parse time
+ */
+struct CivilTime {
+    int32_t dayNumber;  ///< Local date as days since 1970-01-01
+    int hour;           ///< 0-23
+    int minute;         ///< 0-59
+    int weekday;        ///< 0 = Sunday ... 6 = Saturday
+    time_t timestamp;   ///< Unix timestamp of this local time
+
+    int minuteOfDay() const { return hour * 60 + minute; }
+};
+
+/**
+ * @brief Days since 1970-01-01 for a civil date (H. Hinnant's algorithm)
+ */
+constexpr int32_t daysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yoe = year - era * 400;
+    int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+/**
+ * @brief Civil date for a day number; inverse of daysFromCivil()
+ */
+constexpr CivilDate civilFromDays(int32_t dayNumber) {
+    int z = dayNumber + 719468;
+    int era = (z >= 0 ? z : z - 146096) / 146097;
+    int doe = z - era * 146097;
+    int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int mp = (5 * doy + 2) / 153;
+    int day = doy - (153 * mp + 2) / 5 + 1;
+    int month = mp + (mp < 10 ? 3 : -9);
+    return CivilDate{yoe + era * 400 + (month <= 2), month, day};
+}
+
+/**
+ * @brief Day of week for a day number, 0 = Sunday (1970-01-01 was a Thursday)
+ */
+constexpr int weekdayFromDays(int32_t dayNumber) {
+    return dayNumber >= -4 ? (dayNumber + 4) % 7 : (dayNumber + 5) % 7 + 6;
+}
+
+/**
+ * @brief Reads count decimal digits starting at pos
+ */
+constexpr bool parseDigits(string_view text, size_t pos, size_t count, int& value) {
+    if (pos + count > text.size()) return false;
+    value = 0;
+    for (size_t i = pos; i < pos + count; i++) {
+        if (text[i] < '0' || text[i] > '9') return false;
+        value = value * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+/**
+ * @brief Day number for "YYYY-MM-DD", or INT32_MIN if malformed
+ */
+constexpr int32_t parseDayNumber(string_view date) {
+    int year = 0, month = 0, day = 0;
+    if (!parseDigits(date, 0, 4, year) || date.size() < 10 || date[4] != '-' || date[7] != '-' ||
+        !parseDigits(date, 5, 2, month) || !parseDigits(date, 8, 2, day) ||
+        month < 1 || month > 12 || day < 1 || day > 31) {
+        return INT32_MIN;
+    }
+    return daysFromCivil(year, month, day);
+}
+
+static_assert(daysFromCivil(1970, 1, 1) == 0, "epoch");
+static_assert(parseDayNumber("2025-12-01") == 20423, "parseDayNumber");
+static_assert(weekdayFromDays(20423) == 1, "2025-12-01 was a Monday");
+static_assert(civilFromDays(20423).month == 12 && civilFromDays(20423).day == 1, "civilFromDays");
+
+/**
+ * @brief Fills every CivilTime field except timestamp from "YYYY-MM-DD HH:MM"
+ * @return false if malformed; pure arithmetic, no timezone access
+ */
+bool parseCivilFields(string_view text, CivilTime& out);
+
+/**
+ * @brief Parses a local "YYYY-MM-DD HH:MM" departure including its timestamp
+ * @return false if malformed
+ */
+bool parseCivilTime(string_view text, CivilTime& out);
+
+/**
+ * @brief Unix timestamp of a local date and minute of day
+ *
+ * The UTC offset is computed once per day and cached; only days with a
+ * DST transition fall back to mktime. Thread-safe.
+ */
+time_t localTimestamp(int32_t dayNumber, int minuteOfDay);
+
+/**
+ * @brief Local broken-down time for a timestamp (thread-safe)
+ */
+CivilTime civilTimeFromTimestamp(time_t timestamp);
+
+/**
+ * @brief Local date of a timestamp as a day number
+ */
+int32_t localDayNumber(time_t timestamp);
+
+/**
+ * @brief "YYYY-MM-DD" for a day number
+ */
+string formatDate(int32_t dayNumber);
+
+/**
+ * @class Clock
+ * @brief Source of the current time for pricing, bookings and maintenance
+ *
+ * The system clock is active by default. Install a ManualClock to make
+ * quotes, bookings and simulations reproducible.
+ */
+class Clock {
+public:
+    virtual ~Clock() {}
+    virtual time_t now() const = 0;
+
+    /**
+     * @brief The clock the backend currently reads
+     */
+    static const Clock& current();
+
+    /**
+     * @brief Replaces the active clock; nullptr restores the system clock
+     *
+     * The clock must outlive its installation.
+     */
+    static void install(const Clock* clock);
+};
+
+/**
+ * @class SystemClock
+ * @brief Wall-clock time from time(nullptr)
+ */
+class SystemClock : public Clock {
+public:
+    time_t now() const override { return time(nullptr); }
+};
+
+/**
+ * @class ManualClock
+ * @brief Clock that only moves when told to
+ */
+class ManualClock : public Clock {
+public:
+    explicit ManualClock(time_t start) : value(start) {}
+    time_t now() const override { return value.load(); }
+    void set(time_t t) { value.store(t); }
+    void advance(time_t seconds) { value.fetch_add(seconds); }
+
+private:
+    atomic<time_t> value;
+};
+
+/**
+ * @brief Shorthand for Clock::current().now()
+ */
+inline time_t currentTime() {
+    return Clock::current().now();
+}
+
+#endif // TIME_CORE_H
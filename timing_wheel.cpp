@@ -0,0 +1,126 @@
+#include "timing_wheel.h"
+
+using namespace std;
+
+TimingWheel::TimingWheel(int64_t startTick) : freeHead(NONE), currentTick(startTick), liveCount(0) {
+    for (uint32_t& head : slotHeads) {
+        head = NONE;
+    }
+}
+
+TimingWheel::TimerId TimingWheel::schedule(int64_t tick, uint64_t payload) {
+    uint32_t index;
+    if (freeHead != NONE) {
+        index = freeHead;
+        freeHead = nodes[index].next;
+    } else {
+        index = (uint32_t)nodes.size();
+        nodes.push_back(Node{0, 0, NONE, NONE, 0, NONE});
+    }
+    nodes[index].tick = tick;
+    nodes[index].payload = payload;
+    place(index);
+    liveCount++;
+    return ((uint64_t)nodes[index].generation << 32) | (index + 1);
+}
+
+bool TimingWheel::cancel(TimerId id) {
+    uint32_t index = (uint32_t)id - 1;
+    if (id == 0 || index >= nodes.size()) return false;
+    Node& node = nodes[index];
+    if (node.slot == NONE || node.generation != (uint32_t)(id >> 32)) return false;
+    unlink(index);
+    release(index);
+    return true;
+}
+
+size_t TimingWheel::advance(int64_t tick, const function<void(uint64_t)>& expired) {
+    size_t fired = 0;
+    while (currentTick < tick) {
+        if (liveCount == 0) {
+            currentTick = tick;
+            break;
+        }
+        currentTick++;
+
+        // Upper wheels first, so a timer can fall through several wheels in one tick
+        for (int level = LEVELS - 1; level >= 1; level--) {
+            if ((currentTick & ((1LL << (SLOT_BITS * level)) - 1)) == 0) {
+                cascade(level);
+            }
+        }
+
+        uint32_t slot = (uint32_t)(currentTick & (SLOTS - 1));
+        while (slotHeads[slot] != NONE) {
+            uint32_t index = slotHeads[slot];
+            uint64_t payload = nodes[index].payload;
+            unlink(index);
+            release(index);
+            fired++;
+            expired(payload);
+        }
+    }
+    return fired;
+}
+
+void TimingWheel::place(uint32_t index) {
+    // Overdue timers go in the next tick's slot
+    int64_t due = nodes[index].tick > currentTick ? nodes[index].tick : currentTick + 1;
+    int64_t delta = due - currentTick;
+    for (int level = 0; level < LEVELS; level++) {
+        int shift = SLOT_BITS * level;
+        if (level == LEVELS - 1 && delta >= (1LL << (shift + SLOT_BITS))) {
+            // Beyond the top wheel: park one turn out and re-place when it comes down
+            due = currentTick + (1LL << (shift + SLOT_BITS)) - 1;
+        }
+        if (delta < (1LL << (shift + SLOT_BITS)) || level == LEVELS - 1) {
+            link(index, (uint32_t)(level * SLOTS + ((due >> shift) & (SLOTS - 1))));
+            return;
+        }
+    }
+}
+
+void TimingWheel::link(uint32_t index, uint32_t slot) {
+    Node& node = nodes[index];
+    node.slot = slot;
+    node.prev = NONE;
+    node.next = slotHeads[slot];
+    if (node.next != NONE) nodes[node.next].prev = index;
+    slotHeads[slot] = index;
+}
+
+void TimingWheel::unlink(uint32_t index) {
+    Node& node = nodes[index];
+    if (node.prev != NONE) {
+        nodes[node.prev].next = node.next;
+    } else {
+        slotHeads[node.slot] = node.next;
+    }
+    if (node.next != NONE) nodes[node.next].prev = node.prev;
+}
+
+void TimingWheel::release(uint32_t index) {
+    Node& node = nodes[index];
+    node.generation++;
+    node.slot = NONE;
+    node.prev = NONE;
+    node.next = freeHead;
+    freeHead = index;
+    liveCount--;
+}
+
+void TimingWheel::cascade(int level) {
+    uint32_t slot = (uint32_t)(level * SLOTS + ((currentTick >> (SLOT_BITS * level)) & (SLOTS - 1)));
+    uint32_t index = slotHeads[slot];
+    slotHeads[slot] = NONE;
+    while (index != NONE) {
+        uint32_t next = nodes[index].next;
+        if (nodes[index].tick <= currentTick) {
+            // Due this very tick: the level-0 slot is drained right after cascading
+            link(index, (uint32_t)(currentTick & (SLOTS - 1)));
+        } else {
+            place(index);
+        }
+        index = next;
+    }
+}
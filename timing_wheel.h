@@ -0,0 +1,96 @@
+/**
+ * @file timing_wheel.h
+ * @brief Hierarchical timing wheel for large numbers of expiring entries
+ *
+ * Four wheels of 256 slots each cover 2^32 ticks. A timer sits in the
+ * lowest wheel whose span reaches its deadline and drops one wheel down
+ * each time the wheel above turns over onto its slot, so every timer is
+ * touched at most four times before it fires. Scheduling and cancelling
+ * are O(1) through intrusive slot lists; a tick costs O(1) plus the timers
+ * that fire or cascade in it, however many are outstanding.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * @class TimingWheel
+ * @brief Fires a payload once its tick has passed; not thread-safe
+ */
+class TimingWheel {
+public:
+    typedef uint64_t TimerId;  ///< 0 is never issued
+
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 8;
+    static const int SLOTS = 1 << SLOT_BITS;
+
+    /**
+     * @param startTick Tick the wheel starts at; earlier deadlines fire on the next tick
+     */
+    explicit TimingWheel(int64_t startTick = 0);
+
+    /**
+     * @brief Schedules payload to fire once the wheel reaches tick
+     * @return Handle for cancel(); stays unique after the timer fires
+     */
+    TimerId schedule(int64_t tick, uint64_t payload);
+
+    /**
+     * @brief Removes a pending timer
+     * @return false if it already fired or was cancelled
+     */
+    bool cancel(TimerId id);
+
+    /**
+     * @brief Moves the wheel to tick, calling expired(payload) for every timer due by then
+     * @return Number of timers fired
+     *
+     * Timers fire in deadline order across ticks. The callback may schedule
+     * and cancel timers. An empty wheel jumps straight to tick.
+     */
+    size_t advance(int64_t tick, const function<void(uint64_t)>& expired);
+
+    int64_t getCurrentTick() const { return currentTick; }
+    size_t size() const { return liveCount; }
+    bool empty() const { return liveCount == 0; }
+
+private:
+    static const uint32_t NONE = 0xFFFFFFFFu;
+
+    struct Node {
+        int64_t tick;
+        uint64_t payload;
+        uint32_t prev;
+        uint32_t next;       ///< Next node in the slot, or next free node
+        uint32_t generation; ///< Bumped on release so stale handles miss
+        uint32_t slot;       ///< level * SLOTS + slot index, NONE while free
+    };
+
+    vector<Node> nodes;          ///< Pool; freed nodes are reused
+    uint32_t freeHead;
+    uint32_t slotHeads[LEVELS * SLOTS];
+    int64_t currentTick;
+    size_t liveCount;
+
+    void place(uint32_t index);
+    void link(uint32_t index, uint32_t slot);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+
+    /**
+     * @brief Redistributes one upper-wheel slot into the wheels below
+     */
+    void cascade(int level);
+};
+
+#endif // TIMING_WHEEL_H
@@ -0,0 +1,128 @@
+/**
+ * @file transfer_schedule.cpp
+ * @brief Command-line CSV import of partner schedules and export of flights and bookings
+ *
+ * Usage:
+ *   transfer_schedule import partner.csv [--db spaazm_flights.db] [--batch 50000] [--rejects bad.csv]
+ *   transfer_schedule export-flights flights.csv [--db spaazm_flights.db]
+ *   transfer_schedule export-bookings bookings.csv [--db spaazm_flights.db]
+ *
+ * Imports upsert by (flight_number, date) and may run while the GUI or
+ * the HTTP service is open; they pick the new schedule up on their next
+ * search. See schedule_csv.h for the file format.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#include "schedule_csv.h"
+#include "flight_system.h"
+#include <sqlite3.h>
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstdlib>
+
+using namespace std;
+
+static void printUsage(const char* program) {
+    cerr << "Usage: " << program << " import|export-flights|export-bookings FILE [options]\n"
+         << "  --db PATH            Database (default spaazm_flights.db)\n"
+         << "  --batch N            Import rows per transaction (default 50000)\n"
+         << "  --rejects PATH       Import: write rejected rows here, with the header\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || string(argv[1]) == "--help" || string(argv[1]) == "-h") {
+        printUsage(argv[0]);
+        return argc < 2 ? 1 : 0;
+    }
+    string command = argv[1];
+    if (command != "import" && command != "export-flights" && command != "export-bookings") {
+        cerr << "Unknown command " << command << endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (argc < 3) {
+        cerr << "Missing file for " << command << endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+    string filePath = argv[2];
+    string dbPath = "spaazm_flights.db";
+    string rejectsPath;
+    long long batch = ScheduleCsv::DEFAULT_BATCH_ROWS;
+
+    for (int i = 3; i < argc; i++) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Missing value for " << arg << endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+        string value = argv[++i];
+        if (arg == "--db") dbPath = value;
+        else if (arg == "--batch") batch = atoll(value.c_str());
+        else if (arg == "--rejects") rejectsPath = value;
+        else {
+            cerr << "Unknown option " << arg << endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (batch < 1) {
+        cerr << "--batch must be positive" << endl;
+        return 1;
+    }
+
+    sqlite3* db = nullptr;
+    if (sqlite3_open(dbPath.c_str(), &db) != SQLITE_OK) {
+        cerr << "Failed to open database: " << sqlite3_errmsg(db) << endl;
+        sqlite3_close(db);
+        return 1;
+    }
+    // Other processes may be booking: WAL keeps them reading, the timeout lets batches wait for their writes
+    sqlite3_exec(db, "PRAGMA journal_mode = WAL;", nullptr, nullptr, nullptr);
+    sqlite3_exec(db, "PRAGMA synchronous = NORMAL;", nullptr, nullptr, nullptr);
+    sqlite3_exec(db, "PRAGMA cache_size = -262144;", nullptr, nullptr, nullptr);
+    sqlite3_busy_timeout(db, 5000);
+    if (!ReservationSystem::createSchema(db)) {
+        sqlite3_close(db);
+        return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+    bool ok;
+    if (command == "import") {
+        ofstream rejects;
+        if (!rejectsPath.empty()) {
+            rejects.open(rejectsPath, ios::binary);
+            if (!rejects) {
+                cerr << "Cannot write " << rejectsPath << endl;
+                sqlite3_close(db);
+                return 1;
+            }
+        }
+        CsvImportStats stats;
+        ok = ScheduleCsv::importFlights(db, filePath, stats, (size_t)batch, rejects.is_open() ? &rejects : nullptr);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "Imported " << stats.rowsImported << " of " << stats.rowsRead << " rows (" << stats.rowsRejected
+             << " rejected, " << stats.bytes / (1024 * 1024) << " MB) in " << seconds << " s ("
+             << (long long)(stats.rowsImported / (seconds > 0 ? seconds : 1)) << " rows/s)" << endl;
+        if (stats.rowsFailed > 0) {
+            cout << stats.rowsFailed << " rows were rolled back when a write failed; the import stopped at row "
+                 << stats.rowsRead << ". Rerun it to load the remaining rows" << endl;
+        }
+    } else {
+        long long rows = command == "export-flights" ? ScheduleCsv::exportFlights(db, filePath)
+                                                     : ScheduleCsv::exportBookings(db, filePath);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        ok = rows >= 0;
+        if (ok) {
+            cout << "Wrote " << rows << " rows to " << filePath << " in " << seconds << " s" << endl;
+        }
+    }
+
+    sqlite3_close(db);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#include "waitlist.h"
+#include <sqlite3.h>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+string columnText(sqlite3_stmt* stmt, int column) {
+    const unsigned char* text = sqlite3_column_text(stmt, column);
+    return text ? reinterpret_cast<const char*>(text) : "";
+}
+
+} // namespace
+
+bool Waitlist::join(sqlite3* db, WaitlistEntry& entry) {
+    if (!db) return false;
+
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql =
+        "INSERT INTO waitlist (flight_number, flight_date, seat_class, requested_at, passenger_name, "
+        "passenger_email, passenger_phone, price) VALUES (?, ?, ?, ?, ?, ?, ?, ?);";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, entry.flightNumber.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, entry.flightDate.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, entry.seatClass.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 4, entry.requestedAt);
+    sqlite3_bind_text(stmt, 5, entry.passengerName.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 6, entry.email.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 7, entry.phone.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_double(stmt, 8, entry.price);
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    if (ok) {
+        entry.id = sqlite3_last_insert_rowid(db);
+    } else {
+        cerr << "Waitlist join failed: " << sqlite3_errmsg(db) << endl;
+    }
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+bool Waitlist::leave(sqlite3* db, int64_t id) {
+    if (!db) return false;
+
+    sqlite3_stmt* stmt = nullptr;
+    bool ok = false;
+    if (sqlite3_prepare_v2(db, "DELETE FROM waitlist WHERE id = ?;", -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, id);
+        ok = sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) == 1;
+    }
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+int Waitlist::popNext(sqlite3* db, const string& flightNumber, const string& flightDate, const string& seatClass,
+                      WaitlistEntry& entry) {
+    if (!db) return -1;
+
+    // Served by idx_waitlist_queue: one descent to the head, one to delete it
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql =
+        "SELECT id, requested_at, passenger_name, passenger_email, passenger_phone, price FROM waitlist "
+        "WHERE flight_number = ? AND flight_date = ? AND seat_class = ? "
+        "ORDER BY requested_at, id LIMIT 1;";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "SQL error: " << sqlite3_errmsg(db) << endl;
+        return -1;
+    }
+    sqlite3_bind_text(stmt, 1, flightNumber.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, flightDate.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, seatClass.c_str(), -1, SQLITE_STATIC);
+    int step = sqlite3_step(stmt);
+    bool found = step == SQLITE_ROW;
+    if (found) {
+        entry.id = sqlite3_column_int64(stmt, 0);
+        entry.flightNumber = flightNumber;
+        entry.flightDate = flightDate;
+        entry.seatClass = seatClass;
+        entry.requestedAt = sqlite3_column_int64(stmt, 1);
+        entry.passengerName = columnText(stmt, 2);
+        entry.email = columnText(stmt, 3);
+        entry.phone = columnText(stmt, 4);
+        entry.price = sqlite3_column_double(stmt, 5);
+    }
+    sqlite3_finalize(stmt);
+
+    if (!found) {
+        return step == SQLITE_DONE ? 0 : -1;
+    }
+    // The row was just read in the caller's transaction, so failing to delete it is an error
+    return leave(db, entry.id) ? 1 : -1;
+}
+
+int Waitlist::position(sqlite3* db, int64_t id) {
+    if (!db) return 0;
+
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql =
+        "SELECT COUNT(*) FROM waitlist w, (SELECT * FROM waitlist WHERE id = ?) e "
+        "WHERE w.flight_number = e.flight_number AND w.flight_date = e.flight_date AND w.seat_class = e.seat_class "
+        "AND (w.requested_at < e.requested_at OR (w.requested_at = e.requested_at AND w.id <= e.id));";
+    int place = 0;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, id);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            place = sqlite3_column_int(stmt, 0);
+        }
+    }
+    sqlite3_finalize(stmt);
+    return place;
+}
+
+int Waitlist::length(sqlite3* db, const string& flightNumber, const string& flightDate, const string& seatClass) {
+    if (!db) return 0;
+
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql =
+        "SELECT COUNT(*) FROM waitlist WHERE flight_number = ? AND flight_date = ? AND seat_class = ?;";
+    int count = 0;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, flightNumber.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, flightDate.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, seatClass.c_str(), -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            count = sqlite3_column_int(stmt, 0);
+        }
+    }
+    sqlite3_finalize(stmt);
+    return count;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file waitlist.h
+ * @brief Persistent per-flight, per-class waitlists
+ *
+ * Waiting passengers are rows of the waitlist table. The index on
+ * (flight_number, flight_date, seat_class, requested_at) orders each
+ * flight's queue by seat class first and request time second, so finding
+ * and removing the head of a queue is a B-tree descent: O(log n) however
+ * many passengers wait on a hot flight. Every operation runs on the
+ * caller's connection, so popping the head can share a transaction with
+ * the cancellation that freed the seat.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef WAITLIST_H
+#define WAITLIST_H
+
+#include <string>
+#include <ctime>
+#include <cstdint>
+
+struct sqlite3;  // Forward declaration for SQLite database handle
+
+using namespace std;
+
+/**
+ * @struct WaitlistEntry
+ * @brief One waiting passenger
+ */
+struct WaitlistEntry {
+    int64_t id = 0;          ///< Row id; 0 until joined
+    string flightNumber;
+    string flightDate;
+    string seatClass;        ///< "Economy", "Business", or "First"
+    string passengerName;
+    string email;
+    string phone;
+    double price = 0.0;      ///< Fare quoted when joining; charged on promotion
+    time_t requestedAt = 0;  ///< Queue order within the class
+};
+
+/**
+ * @class Waitlist
+ * @brief Queue operations on the waitlist table
+ */
+class Waitlist {
+public:
+    /**
+     * @brief Appends a passenger to the queue of entry's flight and class
+     * @param entry Filled in by the caller; id is set on success
+     * @return false if the row could not be written
+     */
+    static bool join(sqlite3* db, WaitlistEntry& entry);
+
+    /**
+     * @brief Removes a waiting passenger
+     * @return false if no such entry is waiting
+     */
+    static bool leave(sqlite3* db, int64_t id);
+
+    /**
+     * @brief Takes the head of one queue off the waitlist
+     * @param entry Set to the passenger removed
+     * @return 1 if a passenger was taken off, 0 if nobody waits for this flight and class,
+     *         -1 on a database error
+     *
+     * Run inside the transaction that frees the seat, so the seat and the
+     * waiting passenger are never lost or handed out twice.
+     */
+    static int popNext(sqlite3* db, const string& flightNumber, const string& flightDate, const string& seatClass,
+                        WaitlistEntry& entry);
+
+    /**
+     * @brief 1-based place of an entry in its queue, or 0 if it is not waiting
+     */
+    static int position(sqlite3* db, int64_t id);
+
+    /**
+     * @brief Passengers waiting for a flight and class
+     */
+    static int length(sqlite3* db, const string& flightNumber, const string& flightDate, const string& seatClass);
+};
+
+#endif // WAITLIST_H
@@ -0,0 +1,118 @@
+#include "work_stealing_pool.h"
+
+using namespace std;
+
+WorkStealingPool::WorkStealingPool(int threads)
+    : job(nullptr), jobGeneration(0), busyWorkers(0), stopping(false), steals(0) {
+    if (threads <= 0) {
+        threads = (int)thread::hardware_concurrency();
+        if (threads <= 0) threads = 1;
+    }
+    for (int i = 0; i < threads; i++) {
+        queues.emplace_back();
+        queues.back().begin = queues.back().end = 0;
+    }
+    for (int i = 1; i < threads; i++) {
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::run(size_t taskCount, const function<void(size_t, int)>& body) {
+    size_t workerCount = queues.size();
+    for (size_t i = 0; i < workerCount; i++) {
+        lock_guard<mutex> guard(queues[i].lock);
+        queues[i].begin = taskCount * i / workerCount;
+        queues[i].end = taskCount * (i + 1) / workerCount;
+    }
+
+    {
+        lock_guard<mutex> guard(lock);
+        job = &body;
+        steals = 0;
+        busyWorkers = (int)workers.size();
+        jobGeneration++;
+    }
+    wake.notify_all();
+
+    drain(0);
+
+    unique_lock<mutex> guard(lock);
+    finished.wait(guard, [this]() { return busyWorkers == 0; });
+    job = nullptr;
+}
+
+void WorkStealingPool::workerLoop(int index) {
+    uint64_t seenGeneration = 0;
+    unique_lock<mutex> guard(lock);
+    while (true) {
+        wake.wait(guard, [&]() { return stopping || jobGeneration != seenGeneration; });
+        if (stopping) return;
+        seenGeneration = jobGeneration;
+
+        guard.unlock();
+        drain(index);
+        guard.lock();
+
+        if (--busyWorkers == 0) {
+            finished.notify_all();
+        }
+    }
+}
+
+void WorkStealingPool::drain(int index) {
+    const function<void(size_t, int)>& body = *job;
+    size_t task;
+    while (popLocal(index, task) || steal(index, task)) {
+        body(task, index);
+    }
+}
+
+bool WorkStealingPool::popLocal(int index, size_t& task) {
+    Queue& own = queues[index];
+    lock_guard<mutex> guard(own.lock);
+    if (own.begin == own.end) return false;
+    task = own.begin++;
+    return true;
+}
+
+bool WorkStealingPool::steal(int index, size_t& task) {
+    // Tasks are never added during a run, so one empty sweep means the job is done
+    int workerCount = (int)queues.size();
+    for (int offset = 1; offset < workerCount; offset++) {
+        Queue& victim = queues[(index + offset) % workerCount];
+        size_t first, last;
+        {
+            lock_guard<mutex> guard(victim.lock);
+            size_t remaining = victim.end - victim.begin;
+            if (remaining == 0) continue;
+            last = victim.end;
+            first = last - (remaining + 1) / 2;
+            victim.end = first;
+        }
+
+        Queue& own = queues[index];
+        {
+            lock_guard<mutex> guard(own.lock);
+            own.begin = first + 1;
+            own.end = last;
+        }
+        {
+            lock_guard<mutex> guard(lock);
+            steals += last - first;
+        }
+        task = first;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file work_stealing_pool.h
+ * @brief Fixed thread pool that balances index ranges by work stealing
+ *
+ * run() splits [0, taskCount) into one contiguous range per worker. Each
+ * worker takes tasks from the front of its own range; an idle worker steals
+ * the back half of the next non-empty range. Uneven tasks (long routes,
+ * sold-out flights) therefore even out without a shared queue.
+ *
+ * @author Spaazm Flights Development Team
+ * @date November 2025
+ */
+
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * @class WorkStealingPool
+ * @brief Runs index-range jobs on all cores; the calling thread is worker 0
+ */
+class WorkStealingPool {
+public:
+    /**
+     * @param threads Worker count including the caller; 0 uses every hardware thread
+     */
+    explicit WorkStealingPool(int threads = 0);
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /**
+     * @brief Number of workers, including the calling thread
+     */
+    int size() const { return (int)queues.size(); }
+
+    /**
+     * @brief Calls body(task, worker) once for every task in [0, taskCount) and waits
+     *
+     * worker is in [0, size()) and never runs two tasks at once, so per-worker
+     * accumulators need no locking. Not reentrant.
+     */
+    void run(size_t taskCount, const function<void(size_t, int)>& body);
+
+    /**
+     * @brief Tasks taken from another worker during the last run()
+     */
+    uint64_t getSteals() const { return steals; }
+
+private:
+    /// Remaining tasks [begin, end) of one worker
+    struct Queue {
+        mutex lock;
+        size_t begin;
+        size_t end;
+    };
+
+    deque<Queue> queues;  ///< Deque: Queue holds a mutex and must not move
+    vector<thread> workers;
+
+    mutex lock;
+    condition_variable wake;
+    condition_variable finished;
+    const function<void(size_t, int)>* job;
+    uint64_t jobGeneration;
+    int busyWorkers;
+    bool stopping;
+    uint64_t steals;
+
+    void workerLoop(int index);
+
+    /**
+     * @brief Runs tasks until no queue has any left
+     */
+    void drain(int index);
+
+    bool popLocal(int index, size_t& task);
+
+    /**
+     * @brief Moves the back half of another worker's range into this worker's queue
+     * @param task Set to the first stolen task, which the caller runs
+     */
+    bool steal(int index, size_t& task);
+};
+
+#endif // WORK_STEALING_POOL_H